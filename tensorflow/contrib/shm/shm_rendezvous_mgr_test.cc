@@ -0,0 +1,133 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_rendezvous_mgr.h"
+
+#include "tensorflow/contrib/shm/shm_transport.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/distributed_runtime/graph_mgr.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/test_utils.h"
+#include "tensorflow/core/distributed_runtime/worker_session.h"
+#include "tensorflow/core/framework/control_flow.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kSrcWorker[] = "/job:worker/replica:0/task:0";
+constexpr char kDstWorker[] = "/job:worker/replica:0/task:1";
+
+Tensor Iota() {
+  Tensor t(DT_FLOAT, TensorShape({64, 64}));
+  test::FillIota<float>(&t, 0.0f);
+  return t;
+}
+
+// Serves RecvTensor like ShmWorker does, from a single tensor.
+class FakeShmWorker : public TestWorkerInterface {
+ public:
+  FakeShmWorker(ShmTransport* shm_transport, const Tensor& tensor)
+      : shm_transport_(shm_transport), tensor_(tensor) {}
+
+  void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                       TensorResponse* response, StatusCallback done) override {
+    RecvTensorResponse proto;
+    if (request->dma_ok() &&
+        shm_transport_->MaybeWriteTensor(request->transport_options(),
+                                         tensor_,
+                                         proto.mutable_transport_options())) {
+      ++num_shm_responses_;
+      proto.mutable_tensor()->set_dtype(tensor_.dtype());
+      tensor_.shape().AsProto(proto.mutable_tensor()->mutable_tensor_shape());
+    } else {
+      tensor_.AsProtoTensorContent(proto.mutable_tensor());
+    }
+    done(response->InitFrom(&proto));
+  }
+
+  int num_shm_responses() const { return num_shm_responses_; }
+
+ private:
+  ShmTransport* shm_transport_;  // Not owned
+  const Tensor tensor_;
+  int num_shm_responses_ = 0;
+};
+
+class ShmRendezvousMgrTest : public ::testing::Test {
+ protected:
+  ShmRendezvousMgrTest()
+      : sender_transport_(1 << 20),
+        receiver_transport_(1 << 20),
+        tensor_(Iota()),
+        worker_(&sender_transport_, tensor_),
+        rmgr_(&env_, &receiver_transport_) {
+    env_.env = Env::Default();
+    TestWorkerCache* cache = new TestWorkerCache;
+    cache->AddWorker(kSrcWorker, &worker_);
+    worker_session_.reset(new WorkerSession(
+        "shm_session", kDstWorker,
+        std::unique_ptr<WorkerCacheInterface>(cache),
+        std::unique_ptr<DeviceMgr>(new DeviceMgr(
+            DeviceFactory::NewDevice("CPU", {}, kDstWorker))),
+        std::unique_ptr<GraphMgr>(), nullptr));
+  }
+
+  Status RecvRemote(int64 step_id, Tensor* val) {
+    const string key = Rendezvous::CreateKey(
+        strings::StrCat(kSrcWorker, "/device:CPU:0"), 1,
+        strings::StrCat(kDstWorker, "/device:CPU:0"), "foo",
+        FrameAndIter(0, 0));
+    Rendezvous::ParsedKey parsed;
+    TF_RETURN_IF_ERROR(Rendezvous::ParseKey(key, &parsed));
+    RemoteRendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_RETURN_IF_ERROR(rendez->Initialize(worker_session_.get()));
+    bool is_dead = false;
+    Status s = rendez->Recv(parsed, Rendezvous::Args(), val, &is_dead);
+    rmgr_.Cleanup(step_id);
+    return s;
+  }
+
+  ShmTransport sender_transport_;
+  ShmTransport receiver_transport_;
+  const Tensor tensor_;
+  FakeShmWorker worker_;
+  WorkerEnv env_;
+  ShmRendezvousMgr rmgr_;
+  std::unique_ptr<WorkerSession> worker_session_;
+};
+
+TEST_F(ShmRendezvousMgrTest, RecvsThroughSharedMemory) {
+  for (int64 step_id = 1; step_id <= 3; ++step_id) {
+    Tensor val;
+    TF_ASSERT_OK(RecvRemote(step_id, &val));
+    test::ExpectTensorEqual<float>(tensor_, val);
+  }
+  if (receiver_transport_.host_id().empty()) {
+    EXPECT_EQ(0, worker_.num_shm_responses());
+  } else {
+    EXPECT_EQ(3, worker_.num_shm_responses());
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
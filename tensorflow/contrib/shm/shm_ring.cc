@@ -0,0 +1,374 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/posix/error.h"
+
+namespace tensorflow {
+
+// Both ends of a ring keep their synchronization state in the segment, so
+// the atomics must work across address spaces.
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Shared-memory rings need lock-free 32 and 64 bit atomics");
+
+struct ShmSegmentHeader {
+  uint64 magic;
+  uint64 capacity;
+  // Futex word, incremented by readers whenever they release a slot.
+  std::atomic<uint32> releases;
+  // Number of writer threads waiting on `releases`. Readers skip the wake-up
+  // system call while it is zero.
+  std::atomic<uint32> waiters;
+};
+
+namespace {
+
+constexpr uint64 kShmRingMagic = 0x676e69726d687366ull;
+constexpr uint64 kSlotAlignment = 64;
+constexpr uint64 kSegmentHeaderBytes = kSlotAlignment;
+constexpr uint32 kSlotFree = 0;
+constexpr uint32 kSlotBusy = 1;
+
+// Upper bound on a single wait for space, after which the writer checks for
+// abandoned slots again.
+constexpr int64 kMaxWaitMicros = 10000;
+
+// Precedes every slot in the ring. Padding slots written when a blob does not
+// fit before the end of the ring are free from the start.
+struct SlotHeader {
+  // Set by the writer; swapped to 0 by whichever of the reader and the writer
+  // (when reclaiming an abandoned slot) gets to the slot first.
+  std::atomic<uint64> sequence;
+  std::atomic<uint32> state;
+  uint32 unused;
+  // Bytes taken by the slot, including this header.
+  uint64 size;
+  uint64 write_micros;
+};
+
+static_assert(sizeof(ShmSegmentHeader) <= kSegmentHeaderBytes,
+              "ShmSegmentHeader does not fit its reserved space");
+static_assert(sizeof(SlotHeader) <= kSlotAlignment,
+              "SlotHeader does not fit a single alignment unit");
+
+uint64 RoundUpToSlotAlignment(uint64 n) {
+  return (n + kSlotAlignment - 1) / kSlotAlignment * kSlotAlignment;
+}
+
+// Sleeps until `*word` no longer holds `observed`, or at most
+// `timeout_micros`.
+void WaitForRelease(std::atomic<uint32>* word, uint32 observed,
+                    int64 timeout_micros) {
+#if defined(__linux__)
+  struct timespec timeout;
+  timeout.tv_sec = timeout_micros / 1000000;
+  timeout.tv_nsec = (timeout_micros % 1000000) * 1000;
+  // Not FUTEX_PRIVATE_FLAG: the word is shared with other processes.
+  syscall(SYS_futex, reinterpret_cast<uint32*>(word), FUTEX_WAIT, observed,
+          &timeout, nullptr, 0);
+#else
+  if (word->load() == observed) {
+    Env::Default()->SleepForMicroseconds(timeout_micros);
+  }
+#endif
+}
+
+void WakeWriters(std::atomic<uint32>* word) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32*>(word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+#endif
+}
+
+// Maps `num_bytes` of the segment open as `fd`, and closes `fd`.
+Status MapSegment(const string& name, int fd, uint64 num_bytes, char** base) {
+  void* addr =
+      mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int err = errno;
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return IOError(strings::StrCat("mapping shared-memory segment ", name),
+                   err);
+  }
+  *base = static_cast<char*>(addr);
+  return Status::OK();
+}
+
+}  // namespace
+
+/* static */
+Status ShmRingWriter::Create(const string& name, uint64 capacity,
+                             int64 abandon_micros,
+                             std::unique_ptr<ShmRingWriter>* writer) {
+  capacity = capacity / kSlotAlignment * kSlotAlignment;
+  if (capacity < 4 * kSlotAlignment) {
+    return errors::InvalidArgument("Capacity of shared-memory ring ", name,
+                                   " is too small: ", capacity);
+  }
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    // Left behind by a process that died without unlinking it.
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  }
+  if (fd < 0) {
+    return IOError(strings::StrCat("creating shared-memory segment ", name),
+                   errno);
+  }
+  const uint64 mapped_bytes = kSegmentHeaderBytes + capacity;
+#if defined(__linux__)
+  // Reserve the pages now. A segment that is only truncated to size is
+  // backed lazily, and touching a page that /dev/shm has no room for raises
+  // SIGBUS instead of returning an error.
+  const int err = posix_fallocate(fd, 0, mapped_bytes);
+#else
+  const int err = ftruncate(fd, mapped_bytes) == 0 ? 0 : errno;
+#endif
+  if (err != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    if (err == ENOSPC) {
+      return errors::ResourceExhausted("Not enough shared memory for ",
+                                       mapped_bytes, " bytes of segment ",
+                                       name);
+    }
+    return IOError(strings::StrCat("sizing shared-memory segment ", name),
+                   err);
+  }
+  char* base;
+  Status s = MapSegment(name, fd, mapped_bytes, &base);
+  if (!s.ok()) {
+    shm_unlink(name.c_str());
+    return s;
+  }
+  // The segment starts out zeroed, which is also the initial value of every
+  // atomic in it.
+  ShmSegmentHeader* header = new (base) ShmSegmentHeader;
+  header->capacity = capacity;
+  header->releases.store(0);
+  header->waiters.store(0);
+  header->magic = kShmRingMagic;
+  writer->reset(new ShmRingWriter(name, base, mapped_bytes, abandon_micros));
+  return Status::OK();
+}
+
+ShmRingWriter::ShmRingWriter(const string& name, char* base,
+                             uint64 mapped_bytes, int64 abandon_micros)
+    : name_(name),
+      base_(base),
+      mapped_bytes_(mapped_bytes),
+      header_(reinterpret_cast<ShmSegmentHeader*>(base)),
+      capacity_(header_->capacity),
+      abandon_micros_(abandon_micros) {}
+
+ShmRingWriter::~ShmRingWriter() {
+  munmap(base_, mapped_bytes_);
+  shm_unlink(name_.c_str());
+}
+
+uint64 ShmRingWriter::max_write_bytes() const {
+  return capacity_ / 2 / kSlotAlignment * kSlotAlignment - sizeof(SlotHeader);
+}
+
+void ShmRingWriter::ReclaimLocked(uint64 now_micros) {
+  while (tail_ < head_) {
+    SlotHeader* slot = reinterpret_cast<SlotHeader*>(
+        base_ + kSegmentHeaderBytes + tail_ % capacity_);
+    if (slot->state.load(std::memory_order_acquire) != kSlotFree) {
+      if (abandon_micros_ <= 0 ||
+          now_micros < slot->write_micros + abandon_micros_) {
+        break;
+      }
+      const uint64 sequence = slot->sequence.exchange(0);
+      if (sequence == 0) {
+        // A reader has claimed the slot and is about to release it.
+        break;
+      }
+      LOG(WARNING) << "Reclaiming slot " << sequence
+                   << " of shared-memory ring " << name_
+                   << ", which was not released within " << abandon_micros_
+                   << "us";
+    }
+    tail_ += slot->size;
+  }
+}
+
+bool ShmRingWriter::Empty() {
+  mutex_lock l(mu_);
+  ReclaimLocked(Env::Default()->NowMicros());
+  return tail_ == head_;
+}
+
+Status ShmRingWriter::Write(const void* data, uint64 num_bytes,
+                            int64 timeout_micros, ShmSlot* slot) {
+  if (num_bytes > max_write_bytes()) {
+    return errors::ResourceExhausted(
+        "Blob of ", num_bytes, " bytes does not fit shared-memory ring ",
+        name_, ", which accepts at most ", max_write_bytes(), " bytes");
+  }
+  const uint64 slot_bytes = RoundUpToSlotAlignment(sizeof(SlotHeader) +
+                                                   num_bytes);
+  Env* env = Env::Default();
+  {
+    mutex_lock l(mu_);
+    const uint64 start_micros = env->NowMicros();
+    uint64 now_micros = start_micros;
+    uint64 padding;
+    while (true) {
+      // Read the futex word before looking for space, so that a release
+      // after the check makes the wait below return immediately.
+      const uint32 releases = header_->releases.load();
+      ReclaimLocked(now_micros);
+      const uint64 to_end = capacity_ - head_ % capacity_;
+      padding = slot_bytes > to_end ? to_end : 0;
+      if (head_ - tail_ + padding + slot_bytes <= capacity_) break;
+      const int64 remaining_micros =
+          timeout_micros - static_cast<int64>(now_micros - start_micros);
+      if (remaining_micros <= 0) {
+        return errors::ResourceExhausted("Shared-memory ring ", name_,
+                                         " is full");
+      }
+      header_->waiters.fetch_add(1);
+      WaitForRelease(&header_->releases, releases,
+                     std::min(remaining_micros, kMaxWaitMicros));
+      header_->waiters.fetch_sub(1);
+      now_micros = env->NowMicros();
+    }
+
+    if (padding > 0) {
+      SlotHeader* pad = reinterpret_cast<SlotHeader*>(
+          base_ + kSegmentHeaderBytes + head_ % capacity_);
+      pad->size = padding;
+      pad->write_micros = now_micros;
+      pad->sequence.store(0, std::memory_order_relaxed);
+      pad->state.store(kSlotFree, std::memory_order_relaxed);
+      head_ += padding;
+    }
+    SlotHeader* header = reinterpret_cast<SlotHeader*>(
+        base_ + kSegmentHeaderBytes + head_ % capacity_);
+    slot->offset = kSegmentHeaderBytes + head_ % capacity_ + sizeof(SlotHeader);
+    slot->num_bytes = num_bytes;
+    slot->sequence = next_sequence_++;
+    header->size = slot_bytes;
+    header->write_micros = now_micros;
+    header->state.store(kSlotBusy, std::memory_order_relaxed);
+    header->sequence.store(slot->sequence, std::memory_order_release);
+    head_ += slot_bytes;
+  }
+  // The copy needs no lock: nothing else touches the slot until its location
+  // has been handed to the reader.
+  memcpy(base_ + slot->offset, data, num_bytes);
+  std::atomic_thread_fence(std::memory_order_release);
+  return Status::OK();
+}
+
+/* static */
+Status ShmRingReader::Open(const string& name,
+                           std::unique_ptr<ShmRingReader>* reader) {
+  const int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return IOError(strings::StrCat("opening shared-memory segment ", name),
+                   errno);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    const int err = errno;
+    close(fd);
+    return IOError(strings::StrCat("inspecting shared-memory segment ", name),
+                   err);
+  }
+  const uint64 mapped_bytes = st.st_size;
+  if (mapped_bytes <= kSegmentHeaderBytes) {
+    close(fd);
+    return errors::DataLoss("Shared-memory segment ", name,
+                            " is not a ring: too small");
+  }
+  char* base;
+  TF_RETURN_IF_ERROR(MapSegment(name, fd, mapped_bytes, &base));
+  const ShmSegmentHeader* header =
+      reinterpret_cast<const ShmSegmentHeader*>(base);
+  if (header->magic != kShmRingMagic ||
+      header->capacity + kSegmentHeaderBytes != mapped_bytes) {
+    munmap(base, mapped_bytes);
+    return errors::DataLoss("Shared-memory segment ", name,
+                            " is not a ring: bad header");
+  }
+  reader->reset(new ShmRingReader(name, base, mapped_bytes));
+  return Status::OK();
+}
+
+ShmRingReader::ShmRingReader(const string& name, char* base,
+                             uint64 mapped_bytes)
+    : name_(name),
+      base_(base),
+      mapped_bytes_(mapped_bytes),
+      header_(reinterpret_cast<ShmSegmentHeader*>(base)) {}
+
+ShmRingReader::~ShmRingReader() { munmap(base_, mapped_bytes_); }
+
+Status ShmRingReader::Read(const ShmSlot& slot, void* dst) {
+  const uint64 first_offset = kSegmentHeaderBytes + sizeof(SlotHeader);
+  if (slot.offset < first_offset || slot.offset > mapped_bytes_ ||
+      slot.num_bytes > mapped_bytes_ - slot.offset ||
+      (slot.offset - first_offset) % kSlotAlignment != 0 ||
+      slot.sequence == 0) {
+    return errors::InvalidArgument("Invalid slot at offset ", slot.offset,
+                                   " with ", slot.num_bytes,
+                                   " bytes in shared-memory ring ", name_);
+  }
+  SlotHeader* header =
+      reinterpret_cast<SlotHeader*>(base_ + slot.offset - sizeof(SlotHeader));
+  if (header->sequence.load(std::memory_order_acquire) != slot.sequence) {
+    return errors::DataLoss("Slot ", slot.sequence, " of shared-memory ring ",
+                            name_, " was reclaimed before it was read");
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  memcpy(dst, base_ + slot.offset, slot.num_bytes);
+  uint64 expected = slot.sequence;
+  if (!header->sequence.compare_exchange_strong(expected, 0)) {
+    return errors::DataLoss("Slot ", slot.sequence, " of shared-memory ring ",
+                            name_, " was reclaimed while it was read");
+  }
+  header->state.store(kSlotFree, std::memory_order_release);
+  header_->releases.fetch_add(1);
+  if (header_->waiters.load() > 0) {
+    WakeWriters(&header_->releases);
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
+#define TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+struct ShmSegmentHeader;
+
+// Location of a blob written to a shared-memory ring.
+struct ShmSlot {
+  // Offset of the blob from the start of the segment.
+  uint64 offset = 0;
+  uint64 num_bytes = 0;
+  uint64 sequence = 0;
+};
+
+// Writing end of a ring buffer in a POSIX shared-memory segment, through
+// which one process hands byte blobs to another process on the same host.
+//
+// The writer copies a blob into a new slot and passes the returned ShmSlot to
+// the reader out of band, e.g. in an RPC response. The reader copies the blob
+// out and releases the slot. Slots may be released in any order; space is
+// reused once every slot before it has been released. While the ring is full
+// the writer sleeps on a futex in the segment that readers signal on release.
+//
+// A slot that is never released, e.g. because the response carrying its
+// location was lost, is reclaimed after `abandon_micros` (never if that is not
+// positive). The reader detects this through the slot's sequence number and
+// fails the read.
+//
+// Thread-safe.
+class ShmRingWriter {
+ public:
+  // Creates a new segment called `name`, which must start with '/', holding
+  // `capacity` bytes of slots. The segment is unlinked when the writer is
+  // destroyed; readers that have it mapped keep it alive until they close.
+  // Returns ResourceExhausted if the host does not have that much shared
+  // memory available.
+  static Status Create(const string& name, uint64 capacity,
+                       int64 abandon_micros,
+                       std::unique_ptr<ShmRingWriter>* writer);
+
+  ~ShmRingWriter();
+
+  const string& name() const { return name_; }
+
+  // Largest blob that Write() accepts. Larger blobs would let a single slot
+  // stall the whole ring.
+  uint64 max_write_bytes() const;
+
+  // Returns true if every slot written has been released, or reclaimed
+  // because it was abandoned.
+  bool Empty();
+
+  // Copies `num_bytes` from `data` into a new slot and fills `slot`. Waits up
+  // to `timeout_micros` for space, and returns ResourceExhausted if none
+  // becomes available or if the blob is too large.
+  Status Write(const void* data, uint64 num_bytes, int64 timeout_micros,
+               ShmSlot* slot);
+
+ private:
+  ShmRingWriter(const string& name, char* base, uint64 mapped_bytes,
+                int64 abandon_micros);
+
+  // Advances tail_ past released and abandoned slots.
+  void ReclaimLocked(uint64 now_micros) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string name_;
+  char* const base_;
+  const uint64 mapped_bytes_;
+  ShmSegmentHeader* const header_;
+  const uint64 capacity_;
+  const int64 abandon_micros_;
+
+  mutex mu_;
+  // Monotonic positions of the oldest unreclaimed slot and of the next slot
+  // to write. The ring holds the slots in [tail_, head_).
+  uint64 head_ GUARDED_BY(mu_) = 0;
+  uint64 tail_ GUARDED_BY(mu_) = 0;
+  uint64 next_sequence_ GUARDED_BY(mu_) = 1;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRingWriter);
+};
+
+// Reading end of a ring created by ShmRingWriter, possibly in another process.
+//
+// Thread-safe.
+class ShmRingReader {
+ public:
+  static Status Open(const string& name,
+                     std::unique_ptr<ShmRingReader>* reader);
+
+  ~ShmRingReader();
+
+  const string& name() const { return name_; }
+
+  // Copies the blob at `slot` to `dst`, which must hold `slot.num_bytes`
+  // bytes, and releases the slot. Returns DataLoss if the writer reclaimed the
+  // slot before or while it was read.
+  Status Read(const ShmSlot& slot, void* dst);
+
+ private:
+  ShmRingReader(const string& name, char* base, uint64 mapped_bytes);
+
+  const string name_;
+  char* const base_;
+  const uint64 mapped_bytes_;
+  ShmSegmentHeader* const header_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmRingReader);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_SHM_SHM_RING_H_
@@ -0,0 +1,186 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_ring.h"
+
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string SegmentName(const string& test_name) {
+  return strings::StrCat("/tf_shm_ring_test_", getpid(), "_", test_name);
+}
+
+std::vector<char> Blob(size_t size, char fill) {
+  return std::vector<char>(size, fill);
+}
+
+class ShmRingTest : public ::testing::Test {
+ protected:
+  void Init(const string& test_name, uint64 capacity, int64 abandon_micros) {
+    const string name = SegmentName(test_name);
+    TF_ASSERT_OK(
+        ShmRingWriter::Create(name, capacity, abandon_micros, &writer_));
+    TF_ASSERT_OK(ShmRingReader::Open(name, &reader_));
+  }
+
+  void ExpectRead(const ShmSlot& slot, const std::vector<char>& expected) {
+    std::vector<char> actual(slot.num_bytes);
+    TF_EXPECT_OK(reader_->Read(slot, actual.data()));
+    EXPECT_EQ(expected, actual);
+  }
+
+  std::unique_ptr<ShmRingWriter> writer_;
+  std::unique_ptr<ShmRingReader> reader_;
+};
+
+TEST_F(ShmRingTest, WriteThenRead) {
+  Init("WriteThenRead", 1 << 16, 0);
+  const std::vector<char> a = Blob(100, 'a');
+  const std::vector<char> b = Blob(5000, 'b');
+  ShmSlot slot_a, slot_b;
+  TF_ASSERT_OK(writer_->Write(a.data(), a.size(), 0, &slot_a));
+  TF_ASSERT_OK(writer_->Write(b.data(), b.size(), 0, &slot_b));
+  EXPECT_NE(slot_a.sequence, slot_b.sequence);
+  ExpectRead(slot_b, b);
+  ExpectRead(slot_a, a);
+
+  // A slot can only be read once.
+  std::vector<char> again(a.size());
+  EXPECT_TRUE(errors::IsDataLoss(reader_->Read(slot_a, again.data())));
+}
+
+TEST_F(ShmRingTest, ReleasesOutOfOrderAndWraps) {
+  Init("ReleasesOutOfOrderAndWraps", 4096, 0);
+  for (int round = 0; round < 20; ++round) {
+    std::vector<ShmSlot> slots(3);
+    std::vector<std::vector<char>> blobs;
+    for (int i = 0; i < 3; ++i) {
+      blobs.push_back(Blob(300 + 100 * i, 'a' + (round + i) % 26));
+      TF_ASSERT_OK(writer_->Write(blobs[i].data(), blobs[i].size(), 0,
+                                  &slots[i]));
+    }
+    for (int i = 2; i >= 0; --i) {
+      ExpectRead(slots[i], blobs[i]);
+    }
+  }
+}
+
+TEST_F(ShmRingTest, RejectsBlobsLargerThanHalfTheRing) {
+  Init("RejectsBlobsLargerThanHalfTheRing", 4096, 0);
+  const std::vector<char> blob = Blob(writer_->max_write_bytes() + 1, 'x');
+  ShmSlot slot;
+  EXPECT_TRUE(errors::IsResourceExhausted(
+      writer_->Write(blob.data(), blob.size(), 0, &slot)));
+}
+
+TEST_F(ShmRingTest, FullRingTimesOutUntilReleased) {
+  Init("FullRingTimesOutUntilReleased", 4096, 0);
+  const std::vector<char> blob = Blob(1000, 'f');
+  std::vector<ShmSlot> slots;
+  Status s;
+  while (s.ok()) {
+    ShmSlot slot;
+    s = writer_->Write(blob.data(), blob.size(), 1000, &slot);
+    if (s.ok()) slots.push_back(slot);
+  }
+  EXPECT_TRUE(errors::IsResourceExhausted(s));
+  ASSERT_FALSE(slots.empty());
+
+  ExpectRead(slots[0], blob);
+  ShmSlot slot;
+  TF_EXPECT_OK(writer_->Write(blob.data(), blob.size(), 0, &slot));
+}
+
+TEST_F(ShmRingTest, WriterWaitsForRelease) {
+  Init("WriterWaitsForRelease", 4096, 0);
+  const std::vector<char> blob = Blob(1000, 'w');
+  std::vector<ShmSlot> slots;
+  Status s;
+  while (s.ok()) {
+    ShmSlot slot;
+    s = writer_->Write(blob.data(), blob.size(), 0, &slot);
+    if (s.ok()) slots.push_back(slot);
+  }
+  ASSERT_FALSE(slots.empty());
+
+  Notification written;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      ThreadOptions(), "writer", [this, &blob, &written]() {
+        ShmSlot slot;
+        TF_EXPECT_OK(writer_->Write(blob.data(), blob.size(),
+                                    60 * 1000 * 1000, &slot));
+        written.Notify();
+      }));
+  Env::Default()->SleepForMicroseconds(20 * 1000);
+  EXPECT_FALSE(written.HasBeenNotified());
+  ExpectRead(slots[0], blob);
+  written.WaitForNotification();
+}
+
+TEST_F(ShmRingTest, ReclaimsAbandonedSlots) {
+  Init("ReclaimsAbandonedSlots", 4096, 1000);
+  const std::vector<char> blob = Blob(1000, 'r');
+  ShmSlot abandoned;
+  TF_ASSERT_OK(writer_->Write(blob.data(), blob.size(), 0, &abandoned));
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+
+  // Cycle enough data through the ring to need the abandoned slot's space.
+  for (int i = 0; i < 10; ++i) {
+    ShmSlot slot;
+    TF_ASSERT_OK(writer_->Write(blob.data(), blob.size(), 0, &slot));
+    ExpectRead(slot, blob);
+  }
+  std::vector<char> lost(blob.size());
+  EXPECT_TRUE(errors::IsDataLoss(reader_->Read(abandoned, lost.data())));
+}
+
+TEST_F(ShmRingTest, RejectsSlotsOutsideTheSegment) {
+  Init("RejectsSlotsOutsideTheSegment", 4096, 0);
+  ShmSlot slot;
+  slot.offset = 1 << 20;
+  slot.num_bytes = 1;
+  slot.sequence = 1;
+  char byte;
+  EXPECT_TRUE(errors::IsInvalidArgument(reader_->Read(slot, &byte)));
+}
+
+#if defined(__linux__)
+TEST(ShmRingWriterTest, RejectsRingsLargerThanSharedMemory) {
+  struct statvfs st;
+  ASSERT_EQ(0, statvfs("/dev/shm", &st));
+  const uint64 free_bytes = static_cast<uint64>(st.f_bavail) * st.f_frsize;
+  std::unique_ptr<ShmRingWriter> writer;
+  Status s = ShmRingWriter::Create(
+      SegmentName("RejectsRingsLargerThanSharedMemory"), 2 * free_bytes + 4096,
+      0, &writer);
+  EXPECT_TRUE(errors::IsResourceExhausted(s)) << s;
+  EXPECT_EQ(nullptr, writer);
+}
+#endif  // defined(__linux__)
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,228 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_transport.h"
+
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "absl/strings/ascii.h"
+#include "tensorflow/contrib/shm/shm.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/host_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Smaller tensors are cheaper to send in-band than to pass through a ring.
+constexpr uint64 kMinShmTensorBytes = 1024;
+
+// Bounds of the size of the rings sized from the free shared memory, each
+// of which takes this fraction of it.
+constexpr uint64 kMaxDefaultRingBytes = 256ULL << 20;
+constexpr uint64 kMinDefaultRingBytes = 1ULL << 20;
+constexpr uint64 kDefaultRingFreeFraction = 8;
+
+// How long a sender waits for space in a full ring before giving up and
+// sending the tensor in-band.
+constexpr int64 kWriteTimeoutMicros = 1000;
+
+string ComputeHostId() {
+#if defined(__linux__)
+  string boot_id;
+  if (!ReadFileToString(Env::Default(), "/proc/sys/kernel/random/boot_id",
+                        &boot_id)
+           .ok()) {
+    return "";
+  }
+  // POSIX shared-memory segments live in /dev/shm. Processes in different
+  // containers may share a kernel without sharing this mount.
+  struct stat st;
+  if (stat("/dev/shm", &st) != 0) {
+    return "";
+  }
+  return strings::StrCat(port::Hostname(), "/",
+                         absl::StripAsciiWhitespace(boot_id), "/", st.st_dev,
+                         ":", st.st_ino);
+#else
+  return "";
+#endif
+}
+
+// Returns the size of a new ring that leaves most of the free shared memory
+// to the rings created after it, or 0 if there is too little left.
+uint64 DefaultRingBytes() {
+  struct statvfs st;
+  if (statvfs("/dev/shm", &st) != 0) {
+    return 0;
+  }
+  const uint64 free_bytes = static_cast<uint64>(st.f_bavail) * st.f_frsize;
+  const uint64 ring_bytes =
+      std::min(kMaxDefaultRingBytes, free_bytes / kDefaultRingFreeFraction);
+  return ring_bytes < kMinDefaultRingBytes ? 0 : ring_bytes;
+}
+
+}  // namespace
+
+constexpr int64 ShmTransport::kDefaultAbandonMicros;
+
+ShmTransport::ShmTransport(uint64 ring_bytes, int64 abandon_micros)
+    : host_id_(ComputeHostId()),
+      client_id_(strings::StrCat(getpid(), ":", random::New64())),
+      ring_bytes_(ring_bytes),
+      abandon_micros_(abandon_micros) {
+  if (host_id_.empty()) {
+    LOG(WARNING) << "Shared memory is not supported on this host; all "
+                 << "tensors will be sent through gRPC.";
+  }
+}
+
+ShmTransport::~ShmTransport() {}
+
+void ShmTransport::FillRecvTensorOptions(
+    ::google::protobuf::Any* options) const {
+  ShmRecvTensorOptions shm_options;
+  shm_options.set_host_id(host_id_);
+  shm_options.set_client_id(client_id_);
+  options->PackFrom(shm_options);
+}
+
+bool ShmTransport::MaybeWriteTensor(
+    const ::google::protobuf::Any& request_options, const Tensor& tensor,
+    ::google::protobuf::Any* response_options) {
+  if (host_id_.empty() || !DataTypeCanUseMemcpy(tensor.dtype()) ||
+      tensor.TotalBytes() < kMinShmTensorBytes) {
+    return false;
+  }
+  ShmRecvTensorOptions shm_options;
+  if (!request_options.UnpackTo(&shm_options) ||
+      shm_options.host_id() != host_id_) {
+    return false;
+  }
+  std::shared_ptr<ShmRingWriter> writer = GetWriter(shm_options.client_id());
+  if (writer == nullptr || tensor.TotalBytes() > writer->max_write_bytes()) {
+    return false;
+  }
+  StringPiece buf = tensor.tensor_data();
+  ShmSlot slot;
+  Status s = writer->Write(buf.data(), buf.size(), kWriteTimeoutMicros, &slot);
+  if (!s.ok()) {
+    VLOG(1) << "Sending tensor in-band: " << s;
+    return false;
+  }
+  ShmTensorLocation location;
+  location.set_segment(writer->name());
+  location.set_offset(slot.offset);
+  location.set_num_bytes(slot.num_bytes);
+  location.set_sequence(slot.sequence);
+  response_options->PackFrom(location);
+  return true;
+}
+
+Status ShmTransport::ReadTensor(
+    const string& sender, const ::google::protobuf::Any& response_options,
+    Tensor* tensor) {
+  ShmTensorLocation location;
+  if (!response_options.UnpackTo(&location)) {
+    return errors::Internal("Unexpected transport options of type ",
+                            response_options.type_url());
+  }
+  StringPiece buf = tensor->tensor_data();
+  if (location.num_bytes() != buf.size()) {
+    return errors::Internal("Received ", location.num_bytes(),
+                            " bytes through shared memory for a tensor of ",
+                            buf.size(), " bytes");
+  }
+  std::shared_ptr<ShmRingReader> reader;
+  TF_RETURN_IF_ERROR(GetReader(sender, location.segment(), &reader));
+  ShmSlot slot;
+  slot.offset = location.offset();
+  slot.num_bytes = location.num_bytes();
+  slot.sequence = location.sequence();
+  return reader->Read(slot, const_cast<char*>(buf.data()));
+}
+
+std::shared_ptr<ShmRingWriter> ShmTransport::GetWriter(
+    const string& client_id) {
+  mutex_lock l(mu_);
+  const uint64 now_micros = Env::Default()->NowMicros();
+  if (abandon_micros_ > 0 && now_micros >= next_eviction_micros_) {
+    EvictIdleWritersLocked(now_micros);
+    next_eviction_micros_ = now_micros + abandon_micros_;
+  }
+  auto it = writers_.find(client_id);
+  if (it != writers_.end()) {
+    it->second.last_use_micros = now_micros;
+    return it->second.ring;
+  }
+  // The random part keeps readers from mistaking a segment for one of the
+  // same name that belonged to an earlier process.
+  const string name =
+      strings::StrCat("/tf_shm_", getpid(), "_", random::New64());
+  const uint64 ring_bytes = ring_bytes_ > 0 ? ring_bytes_ : DefaultRingBytes();
+  std::unique_ptr<ShmRingWriter> ring;
+  Status s;
+  if (ring_bytes == 0) {
+    s = errors::ResourceExhausted("Not enough free shared memory for a ring");
+  } else {
+    s = ShmRingWriter::Create(name, ring_bytes, abandon_micros_, &ring);
+  }
+  if (!s.ok()) {
+    LOG(WARNING) << "Sending tensors to " << client_id
+                 << " through gRPC: " << s;
+  }
+  Writer& writer = writers_[client_id];
+  writer.ring = std::move(ring);
+  writer.last_use_micros = now_micros;
+  return writer.ring;
+}
+
+void ShmTransport::EvictIdleWritersLocked(uint64 now_micros) {
+  for (auto it = writers_.begin(); it != writers_.end();) {
+    const Writer& writer = it->second;
+    if (now_micros - writer.last_use_micros >= abandon_micros_ &&
+        (writer.ring == nullptr || writer.ring->Empty())) {
+      VLOG(1) << "Destroying the idle shared-memory ring for " << it->first;
+      it = writers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+Status ShmTransport::GetReader(const string& sender, const string& segment,
+                               std::shared_ptr<ShmRingReader>* reader) {
+  mutex_lock l(mu_);
+  std::shared_ptr<ShmRingReader>& current = readers_[sender];
+  if (current == nullptr || current->name() != segment) {
+    // Reads in progress keep the previous ring mapped until they finish.
+    std::unique_ptr<ShmRingReader> new_reader;
+    TF_RETURN_IF_ERROR(ShmRingReader::Open(segment, &new_reader));
+    current = std::move(new_reader);
+  }
+  *reader = current;
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,125 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CONTRIB_SHM_SHM_TRANSPORT_H_
+#define TENSORFLOW_CONTRIB_SHM_SHM_TRANSPORT_H_
+
+#include <memory>
+#include <unordered_map>
+
+#include "google/protobuf/any.pb.h"
+#include "tensorflow/contrib/shm/shm_ring.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Moves the contents of RecvTensor responses between processes on the same
+// host through shared-memory rings, leaving gRPC to carry only the metadata.
+//
+// A receiver attaches FillRecvTensorOptions() to its requests. A sender on
+// the same host writes eligible tensors to a ring it keeps for that receiver,
+// and returns the location in the response; other requests, and tensors that
+// are small, not memcpy-able, or do not fit, are sent in-band as usual.
+//
+// A sender keeps one ring per receiving process, so with N co-located tasks
+// that all exchange tensors the host holds N * (N - 1) rings. A ring that
+// has not been written to for a while, and whose slots have all been
+// released or abandoned, is destroyed, so that the rings of receivers that
+// restarted or went away do not pile up in /dev/shm.
+//
+// Thread-safe.
+class ShmTransport {
+ public:
+  static constexpr int64 kDefaultAbandonMicros = 60LL * 1000 * 1000;
+
+  // Each ring holds `ring_bytes` bytes. If 0, each ring takes a fraction of
+  // the shared memory free when it is created. Slots that are not released
+  // within `abandon_micros` are assumed to have been lost along with the
+  // response that carried their location, and rings that are not written to
+  // for that long are destroyed once they are empty.
+  explicit ShmTransport(uint64 ring_bytes,
+                        int64 abandon_micros = kDefaultAbandonMicros);
+  ~ShmTransport();
+
+  // Identifies the host and shared-memory namespace of this process. It is
+  // empty if shared memory is not supported here.
+  const string& host_id() const { return host_id_; }
+
+  // Fills `options` with the transport options of a RecvTensorRequest that
+  // asks for the contents to be sent through shared memory.
+  void FillRecvTensorOptions(::google::protobuf::Any* options) const;
+
+  // Called by the sender. If `request_options` come from a receiver on this
+  // host and `tensor` is eligible, writes the contents of `tensor` to the ring
+  // kept for that receiver, fills `response_options` with their location and
+  // returns true. Otherwise returns false, and the tensor must be sent
+  // in-band.
+  bool MaybeWriteTensor(const ::google::protobuf::Any& request_options,
+                        const Tensor& tensor,
+                        ::google::protobuf::Any* response_options);
+
+  // Called by the receiver. Copies the contents located by `response_options`
+  // into `tensor`, which must already have the dtype and shape that were sent.
+  // `sender` names the task that sent the response. Each sender writes to a
+  // single ring for this process at a time, so the ring it used before is
+  // unmapped once a response names another one.
+  Status ReadTensor(const string& sender,
+                    const ::google::protobuf::Any& response_options,
+                    Tensor* tensor);
+
+ private:
+  struct Writer {
+    // Null if the ring could not be created.
+    std::shared_ptr<ShmRingWriter> ring;
+    uint64 last_use_micros = 0;
+  };
+
+  // Returns the ring for `client_id`, creating it if needed, or nullptr if
+  // it could not be created.
+  std::shared_ptr<ShmRingWriter> GetWriter(const string& client_id);
+
+  // Destroys the rings that have not been used for `abandon_micros_` and
+  // are empty.
+  void EvictIdleWritersLocked(uint64 now_micros)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Status GetReader(const string& sender, const string& segment,
+                   std::shared_ptr<ShmRingReader>* reader);
+
+  const string host_id_;
+  const string client_id_;
+  const uint64 ring_bytes_;
+  const int64 abandon_micros_;
+
+  mutex mu_;
+  // Keyed by client id. Clients whose ring could not be created are kept
+  // too, so that creation is not retried for every tensor.
+  std::unordered_map<string, Writer> writers_ GUARDED_BY(mu_);
+  uint64 next_eviction_micros_ GUARDED_BY(mu_) = 0;
+  // The ring each sender last wrote to, keyed by sender.
+  std::unordered_map<string, std::shared_ptr<ShmRingReader>> readers_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShmTransport);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CONTRIB_SHM_SHM_TRANSPORT_H_
@@ -0,0 +1,127 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_transport.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "tensorflow/contrib/shm/shm.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kSender[] = "/job:worker/replica:0/task:0";
+
+Tensor Iota(int64 num_elements) {
+  Tensor t(DT_FLOAT, TensorShape({num_elements}));
+  test::FillIota<float>(&t, 1.0f);
+  return t;
+}
+
+bool SegmentExists(const string& segment) {
+  const int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    EXPECT_EQ(ENOENT, errno);
+    return false;
+  }
+  close(fd);
+  return true;
+}
+
+bool SegmentMapped(const string& segment) {
+  string maps;
+  TF_CHECK_OK(ReadFileToString(Env::Default(), "/proc/self/maps", &maps));
+  return maps.find(segment) != string::npos;
+}
+
+class ShmTransportTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    receiver_.FillRecvTensorOptions(&request_options_);
+  }
+
+  // Sends `tensor` from `sender` to `receiver_` and returns the segment it
+  // was written to.
+  string RoundTrip(ShmTransport* sender, const Tensor& tensor) {
+    ::google::protobuf::Any response_options;
+    EXPECT_TRUE(
+        sender->MaybeWriteTensor(request_options_, tensor, &response_options));
+    ShmTensorLocation location;
+    EXPECT_TRUE(response_options.UnpackTo(&location));
+    Tensor received(tensor.dtype(), tensor.shape());
+    TF_EXPECT_OK(receiver_.ReadTensor(kSender, response_options, &received));
+    test::ExpectTensorEqual<float>(tensor, received);
+    return location.segment();
+  }
+
+  ShmTransport receiver_{1 << 16};
+  ::google::protobuf::Any request_options_;
+};
+
+TEST_F(ShmTransportTest, RoundTrip) {
+  if (receiver_.host_id().empty()) return;
+  ShmTransport sender(1 << 16);
+  const string segment = RoundTrip(&sender, Iota(1000));
+  // Later tensors reuse the ring.
+  EXPECT_EQ(segment, RoundTrip(&sender, Iota(2000)));
+}
+
+TEST_F(ShmTransportTest, SendsSmallTensorsInBand) {
+  ShmTransport sender(1 << 16);
+  ::google::protobuf::Any response_options;
+  EXPECT_FALSE(
+      sender.MaybeWriteTensor(request_options_, Iota(10), &response_options));
+}
+
+TEST_F(ShmTransportTest, SendsInBandToOtherHosts) {
+  ShmTransport sender(1 << 16);
+  ShmRecvTensorOptions options;
+  options.set_host_id(strings::StrCat(sender.host_id(), "-elsewhere"));
+  options.set_client_id("client");
+  ::google::protobuf::Any request_options, response_options;
+  request_options.PackFrom(options);
+  EXPECT_FALSE(
+      sender.MaybeWriteTensor(request_options, Iota(1000), &response_options));
+}
+
+TEST_F(ShmTransportTest, EvictsIdleRingsAndUnmapsStaleReaders) {
+  if (receiver_.host_id().empty()) return;
+  ShmTransport sender(1 << 16, /*abandon_micros=*/1000);
+  const string segment = RoundTrip(&sender, Iota(1000));
+  EXPECT_TRUE(SegmentExists(segment));
+  EXPECT_TRUE(SegmentMapped(segment));
+
+  // Once the ring has been empty and unused for longer than the abandon
+  // time, the next write destroys it and starts a new one.
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  const string new_segment = RoundTrip(&sender, Iota(1000));
+  EXPECT_NE(segment, new_segment);
+  EXPECT_FALSE(SegmentExists(segment));
+  // The receiver stopped mapping the old ring once the sender moved on.
+  EXPECT_FALSE(SegmentMapped(segment));
+  EXPECT_TRUE(SegmentMapped(new_segment));
+}
+
+}  // namespace
+}  // namespace tensorflow
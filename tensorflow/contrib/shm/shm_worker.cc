@@ -0,0 +1,77 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/shm/shm_worker.h"
+
+#include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+ShmWorker::ShmWorker(WorkerEnv* worker_env, const ConfigProto& config,
+                     ShmTransport* shm_transport)
+    : GrpcWorker(worker_env, config), shm_transport_(shm_transport) {}
+
+void ShmWorker::GrpcRecvTensorAsync(CallOptions* opts,
+                                    const RecvTensorRequest* request,
+                                    ::grpc::ByteBuffer* response,
+                                    StatusCallback done) {
+  if (!request->dma_ok() || !request->has_transport_options()) {
+    GrpcWorker::GrpcRecvTensorAsync(opts, request, response, std::move(done));
+    return;
+  }
+
+  Status s = recent_request_ids_.TrackUnique(
+      request->request_id(), "RecvTensor (ShmWorker)", *request);
+  if (!s.ok()) {
+    done(s);
+    return;
+  }
+
+  // As in GrpcWorker, log the cancellation but leave it to the client to
+  // abort the step.
+  const int64 step_id = request->step_id();
+  opts->SetCancelCallback(
+      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  RecvLocalTensorAsync(
+      step_id, request->rendezvous_key(),
+      [this, opts, request, response, done](const Tensor& val, bool is_dead,
+                                            const Status& status) {
+        opts->ClearCancelCallback();
+        if (!status.ok()) {
+          done(status);
+          return;
+        }
+        RecvTensorResponse proto;
+        if (!is_dead && shm_transport_->MaybeWriteTensor(
+                            request->transport_options(), val,
+                            proto.mutable_transport_options())) {
+          proto.set_send_start_micros(env_->env->NowMicros());
+          TensorProto* tensor_proto = proto.mutable_tensor();
+          tensor_proto->set_dtype(val.dtype());
+          val.shape().AsProto(tensor_proto->mutable_tensor_shape());
+          grpc::EncodeRecvTensorResponseToByteBuffer(proto, response);
+        } else {
+          grpc::EncodeTensorToByteBuffer(is_dead, val, false, response);
+        }
+        done(Status::OK());
+      });
+}
+
+}  // namespace tensorflow
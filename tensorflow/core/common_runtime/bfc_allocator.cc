@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -30,11 +31,16 @@ limitations under the License.
 namespace tensorflow {
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-                           bool allow_growth, const string& name)
+                           bool allow_growth, const string& name,
+                           bool enable_thread_cache)
     : sub_allocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      num_cache_shards_(enable_thread_cache ? port::MaxParallelism() : 0) {
+  if (num_cache_shards_ > 0) {
+    cache_shards_.reset(new CacheShard[num_cache_shards_]);
+  }
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -148,6 +154,9 @@ bool BFCAllocator::Extend(size_t alignment, size_t rounded_bytes) {
   VLOG(1) << "Allocated memory at " << mem_addr << " to "
           << static_cast<void*>(static_cast<char*>(mem_addr) + bytes);
   region_manager_.AddAllocationRegion(mem_addr, bytes);
+  if (cache_shards_ != nullptr) {
+    AddCacheRegion(mem_addr, bytes);
+  }
 
   // Create one large chunk for the whole memory space that will
   // be chunked later.
@@ -273,6 +282,32 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (cache_shards_ == nullptr) {
+    return AllocateRawFromBins(unused_alignment, rounded_bytes, num_bytes,
+                               dump_log_on_failure, freed_before);
+  }
+  if (freed_before == 0 && timing_counter_ == nullptr) {
+    void* ptr = AllocateFromCache(rounded_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+  void* ptr = AllocateRawFromBins(unused_alignment, rounded_bytes, num_bytes,
+                                  false, freed_before);
+  if (ptr == nullptr) {
+    // Chunks held by the caches may coalesce into a large enough free chunk.
+    FlushCaches();
+    ptr = AllocateRawFromBins(unused_alignment, rounded_bytes, num_bytes,
+                              dump_log_on_failure, freed_before);
+  }
+  return ptr;
+}
+
+void* BFCAllocator::AllocateRawFromBins(size_t unused_alignment,
+                                        size_t rounded_bytes,
+                                        size_t num_bytes,
+                                        bool dump_log_on_failure,
+                                        uint64 freed_before) {
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
@@ -359,6 +394,17 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         // chunk as being in use.
         chunk->allocation_id = next_allocation_id_++;
 
+        // Record whether the chunk may be kept in a thread cache when freed.
+        if (cache_shards_ != nullptr) {
+          std::atomic<uint8>* slot = CacheSizeClassSlot(chunk->ptr);
+          if (slot != nullptr) {
+            const int size_class = chunk->size == rounded_bytes
+                                       ? CacheSizeClass(rounded_bytes)
+                                       : -1;
+            slot->store(size_class + 1, std::memory_order_relaxed);
+          }
+        }
+
         // Update stats.
         ++stats_.num_allocs;
         stats_.bytes_in_use += chunk->size;
@@ -420,6 +466,11 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(1) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
+  if (ptr != nullptr && cache_shards_ != nullptr &&
+      timing_counter_ == nullptr && DeallocateToCache(ptr)) {
+    // The chunk stays in use; there is nothing new for retrying allocations.
+    return;
+  }
   DeallocateRawInternal(ptr);
   retry_helper_.NotifyDealloc();
 }
@@ -430,7 +481,10 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     return;
   }
   mutex_lock l(lock_);
+  ReleaseChunk(ptr);
+}
 
+void BFCAllocator::ReleaseChunk(void* ptr) {
   // Find the chunk from the ptr.
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
@@ -825,15 +879,154 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
 }
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
-  mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats;
+  {
+    mutex_lock l(lock_);
+    stats = stats_;
+  }
+  for (int i = 0; i < num_cache_shards_; ++i) {
+    CacheShard* shard = &cache_shards_[i];
+    mutex_lock l(shard->mu);
+    // Chunks held by a cache are in use as far as the bins are concerned,
+    // but not from the point of view of the allocator's clients.
+    stats.bytes_in_use -= shard->bytes_cached;
+    stats.num_allocs += shard->num_hits;
+    stats.num_cache_hits += shard->num_hits;
+    stats.num_cache_misses += shard->num_misses;
+  }
+  return stats;
 }
 
 void BFCAllocator::ClearStats() {
-  mutex_lock l(lock_);
-  stats_.num_allocs = 0;
-  stats_.peak_bytes_in_use = stats_.bytes_in_use;
-  stats_.largest_alloc_size = 0;
+  {
+    mutex_lock l(lock_);
+    stats_.num_allocs = 0;
+    stats_.peak_bytes_in_use = stats_.bytes_in_use;
+    stats_.largest_alloc_size = 0;
+  }
+  for (int i = 0; i < num_cache_shards_; ++i) {
+    CacheShard* shard = &cache_shards_[i];
+    mutex_lock l(shard->mu);
+    shard->num_hits = 0;
+    shard->num_misses = 0;
+  }
+}
+
+// static
+int BFCAllocator::CacheSizeClass(size_t rounded_bytes) {
+  const size_t size_class = rounded_bytes / kMinAllocationSize - 1;
+  return size_class < static_cast<size_t>(kCacheNumSizeClasses)
+             ? static_cast<int>(size_class)
+             : -1;
+}
+
+BFCAllocator::CacheShard* BFCAllocator::CurrentCacheShard() {
+  static std::atomic<int> next_thread_index(0);
+  thread_local const int thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return &cache_shards_[thread_index % num_cache_shards_];
+}
+
+void BFCAllocator::AddCacheRegion(void* ptr, size_t memory_size) {
+  const int n = num_cache_regions_.load(std::memory_order_relaxed);
+  if (n == kCacheMaxRegions) {
+    VLOG(1) << "Not caching chunks of region " << ptr << " of allocator "
+            << Name();
+    return;
+  }
+  CacheRegion* region = &cache_regions_[n];
+  const size_t n_slots = memory_size / kMinAllocationSize;
+  region->size_classes.reset(new std::atomic<uint8>[n_slots]);
+  for (size_t i = 0; i < n_slots; ++i) {
+    region->size_classes[i].store(0, std::memory_order_relaxed);
+  }
+  region->ptr = static_cast<const char*>(ptr);
+  region->end_ptr = region->ptr + memory_size;
+  // Publish the region to readers that do not hold lock_.
+  num_cache_regions_.store(n + 1, std::memory_order_release);
+}
+
+std::atomic<uint8>* BFCAllocator::CacheSizeClassSlot(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  const int n = num_cache_regions_.load(std::memory_order_acquire);
+  for (int i = 0; i < n; ++i) {
+    CacheRegion* region = &cache_regions_[i];
+    if (p >= region->ptr && p < region->end_ptr) {
+      return &region->size_classes[(p - region->ptr) / kMinAllocationSize];
+    }
+  }
+  return nullptr;
+}
+
+void* BFCAllocator::AllocateFromCache(size_t rounded_bytes) {
+  const int size_class = CacheSizeClass(rounded_bytes);
+  if (size_class < 0) return nullptr;
+  CacheShard* shard = CurrentCacheShard();
+  mutex_lock l(shard->mu);
+  std::vector<void*>* free_ptrs = &shard->free_ptrs[size_class];
+  if (free_ptrs->empty()) {
+    ++shard->num_misses;
+    return nullptr;
+  }
+  void* ptr = free_ptrs->back();
+  free_ptrs->pop_back();
+  shard->bytes_cached -= rounded_bytes;
+  ++shard->num_hits;
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToCache(void* ptr) {
+  std::atomic<uint8>* slot = CacheSizeClassSlot(ptr);
+  if (slot == nullptr) return false;
+  const int size_class = slot->load(std::memory_order_relaxed) - 1;
+  if (size_class < 0) return false;
+
+  std::vector<void*> to_release;
+  CacheShard* shard = CurrentCacheShard();
+  {
+    mutex_lock l(shard->mu);
+    std::vector<void*>* free_ptrs = &shard->free_ptrs[size_class];
+    free_ptrs->push_back(ptr);
+    shard->bytes_cached += CacheSizeClassBytes(size_class);
+    if (free_ptrs->size() > kCacheMaxChunksPerClass ||
+        shard->bytes_cached > kCacheMaxBytesPerShard) {
+      // Return the least recently cached half of the chunks of this size.
+      const size_t n = (free_ptrs->size() + 1) / 2;
+      to_release.assign(free_ptrs->begin(), free_ptrs->begin() + n);
+      free_ptrs->erase(free_ptrs->begin(), free_ptrs->begin() + n);
+      shard->bytes_cached -= n * CacheSizeClassBytes(size_class);
+    }
+  }
+  if (!to_release.empty()) {
+    ReleaseCachedChunks(to_release);
+  }
+  return true;
+}
+
+void BFCAllocator::ReleaseCachedChunks(const std::vector<void*>& ptrs) {
+  {
+    mutex_lock l(lock_);
+    for (void* ptr : ptrs) {
+      ReleaseChunk(ptr);
+    }
+  }
+  retry_helper_.NotifyDealloc();
+}
+
+void BFCAllocator::FlushCaches() {
+  std::vector<void*> to_release;
+  for (int i = 0; i < num_cache_shards_; ++i) {
+    CacheShard* shard = &cache_shards_[i];
+    mutex_lock l(shard->mu);
+    for (std::vector<void*>& free_ptrs : shard->free_ptrs) {
+      to_release.insert(to_release.end(), free_ptrs.begin(), free_ptrs.end());
+      free_ptrs.clear();
+    }
+    shard->bytes_cached = 0;
+  }
+  if (!to_release.empty()) {
+    ReleaseCachedChunks(to_release);
+  }
 }
 
 std::array<BFCAllocator::BinDebugInfo, BFCAllocator::kNumBins>
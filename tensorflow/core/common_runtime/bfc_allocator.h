@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <string>
@@ -43,11 +44,22 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'enable_thread_cache' is true, small chunks freed by a thread are kept
+// in a cache local to a shard of threads, still marked in use, and handed back
+// to later requests of the same rounded size from that shard without taking
+// the allocator-wide lock.  Each shard holds a bounded number of bytes and
+// returns chunks to the bins in batches.  Cached chunks are returned to the
+// bins before an allocation is allowed to fail.  Note that RequestedSize()
+// and AllocationId() for a chunk reused from a cache report the values of the
+// allocation that first took it from the bins.  The cache is not used for
+// allocations with a freed_by_func, nor when a timing counter is set.
 class BFCAllocator : public Allocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-               bool allow_growth, const string& name);
+               bool allow_growth, const string& name,
+               bool enable_thread_cache = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -84,12 +96,20 @@ class BFCAllocator : public Allocator {
                             bool dump_log_on_failure,
                             uint64 freed_before_count);
 
+  // Allocates 'rounded_bytes' from the bins, bypassing the thread cache.
+  void* AllocateRawFromBins(size_t unused_alignment, size_t rounded_bytes,
+                            size_t num_bytes, bool dump_log_on_failure,
+                            uint64 freed_before);
+
   void* AllocateRawInternalWithRetry(
       size_t alignment, size_t num_bytes,
       const AllocationAttributes& allocation_attr);
 
   void DeallocateRawInternal(void* ptr);
 
+  // Returns the chunk holding 'ptr' to the bins.
+  void ReleaseChunk(void* ptr) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // Chunks whose freed_at_count is later than the safe frontier value are kept
   // on a special list and not subject to merging immediately upon being freed.
   //
@@ -403,6 +423,57 @@ class BFCAllocator : public Allocator {
   ChunkHandle TryToCoalesce(ChunkHandle h, bool ignore_freed_at)
       EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // The thread cache holds chunks of up to kCacheNumSizeClasses *
+  // kMinAllocationSize bytes.  Size class 'k' holds chunks of exactly
+  // (k + 1) * kMinAllocationSize bytes.
+  static const int kCacheNumSizeClasses = 64;
+  // A shard returns half of the chunks of a size class to the bins once it
+  // holds more than kCacheMaxChunksPerClass of them, or more than
+  // kCacheMaxBytesPerShard bytes in total.
+  static const size_t kCacheMaxChunksPerClass = 64;
+  static const size_t kCacheMaxBytesPerShard = 1 << 20;
+  // Only pointers within the first kCacheMaxRegions regions are cached.
+  static const int kCacheMaxRegions = 64;
+
+  struct CacheShard {
+    mutex mu;
+    std::vector<void*> free_ptrs[kCacheNumSizeClasses] GUARDED_BY(mu);
+    size_t bytes_cached GUARDED_BY(mu) = 0;
+    int64 num_hits GUARDED_BY(mu) = 0;
+    int64 num_misses GUARDED_BY(mu) = 0;
+  };
+
+  // Maps the pointers handed out from a region to the cache size class of
+  // their chunk, without taking lock_.  Written under lock_ when a chunk is
+  // handed out of the bins; read when the owner of the chunk frees it.
+  struct CacheRegion {
+    const char* ptr = nullptr;
+    const char* end_ptr = nullptr;
+    // One entry per kMinAllocationSize bytes: 0 if the chunk starting there
+    // is not cacheable, else its size class plus one.
+    std::unique_ptr<std::atomic<uint8>[]> size_classes;
+  };
+
+  // Returns the cache size class for chunks of 'rounded_bytes', or -1.
+  static int CacheSizeClass(size_t rounded_bytes);
+  static size_t CacheSizeClassBytes(int size_class) {
+    return (size_class + 1) * kMinAllocationSize;
+  }
+
+  CacheShard* CurrentCacheShard();
+  void AddCacheRegion(void* ptr, size_t memory_size)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  std::atomic<uint8>* CacheSizeClassSlot(const void* ptr);
+
+  // Returns a cached chunk of 'rounded_bytes', or nullptr on a miss.
+  void* AllocateFromCache(size_t rounded_bytes);
+  // Caches the chunk holding 'ptr'.  Returns false if it is not cacheable.
+  bool DeallocateToCache(void* ptr);
+  // Returns the given cached chunks to the bins.
+  void ReleaseCachedChunks(const std::vector<void*>& ptrs);
+  // Returns all cached chunks to the bins.
+  void FlushCaches();
+
   // Information about a Bin that is useful for debugging.
   struct BinDebugInfo {
     size_t total_bytes_in_use = 0;
@@ -492,6 +563,12 @@ class BFCAllocator : public Allocator {
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // Thread cache state; cache_shards_ is null if the cache is disabled.
+  const int num_cache_shards_;
+  std::unique_ptr<CacheShard[]> cache_shards_;
+  std::array<CacheRegion, kCacheMaxRegions> cache_regions_;
+  std::atomic<int> num_cache_regions_{0};
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
@@ -0,0 +1,216 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/pool_allocator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+BFCAllocator* NewCPUBFCAllocator(size_t total_memory, bool allow_growth,
+                                 bool enable_thread_cache) {
+  SubAllocator* sub_allocator =
+      new BasicCPUAllocator(port::kNUMANoAffinity, {}, {});
+  return new BFCAllocator(sub_allocator, total_memory, allow_growth,
+                          "cpu_bfc", enable_thread_cache);
+}
+
+static void CheckCacheStats(Allocator* a, int64 num_allocs, int64 bytes_in_use,
+                            int64 num_cache_hits, int64 num_cache_misses) {
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  EXPECT_TRUE(stats);
+  if (!stats) {
+    return;
+  }
+  LOG(INFO) << "Alloc stats: " << std::endl << stats->DebugString();
+  EXPECT_EQ(stats->num_allocs, num_allocs);
+  EXPECT_EQ(stats->bytes_in_use, bytes_in_use);
+  EXPECT_EQ(stats->num_cache_hits, num_cache_hits);
+  EXPECT_EQ(stats->num_cache_misses, num_cache_misses);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheDisabledByDefault) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 30, true, false /*enable_thread_cache*/));
+  for (int i = 0; i < 10; ++i) {
+    void* p = a->AllocateRaw(1, 1024);
+    a->DeallocateRaw(p);
+  }
+  CheckCacheStats(a.get(), 10, 0, 0, 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesChunks) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 30, true, true /*enable_thread_cache*/));
+  void* first = a->AllocateRaw(1, 1024);
+  CheckCacheStats(a.get(), 1, 1024, 0, 1);
+  a->DeallocateRaw(first);
+  CheckCacheStats(a.get(), 1, 0, 0, 1);
+
+  for (int i = 0; i < 9; ++i) {
+    void* p = a->AllocateRaw(1, 1000);
+    // 1000 bytes round up to the same size class as 1024 bytes.
+    EXPECT_EQ(first, p);
+    a->DeallocateRaw(p);
+  }
+  CheckCacheStats(a.get(), 10, 0, 9, 1);
+
+  a->ClearStats();
+  CheckCacheStats(a.get(), 0, 0, 0, 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheSkipsLargeAllocations) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 30, true, true /*enable_thread_cache*/));
+  for (int i = 0; i < 10; ++i) {
+    void* p = a->AllocateRaw(1, 1 << 20);
+    a->DeallocateRaw(p);
+  }
+  CheckCacheStats(a.get(), 10, 0, 0, 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheNoDups) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 30, true, true /*enable_thread_cache*/));
+  std::vector<void*> ptrs;
+  for (int round = 0; round < 3; ++round) {
+    for (int s = 1; s <= 64 * 256; s += 97) {
+      ptrs.push_back(a->AllocateRaw(1, s));
+    }
+    std::sort(ptrs.begin(), ptrs.end());
+    for (size_t i = 1; i < ptrs.size(); i++) {
+      ASSERT_NE(ptrs[i], ptrs[i - 1]);
+    }
+    for (void* p : ptrs) {
+      a->DeallocateRaw(p);
+    }
+    ptrs.clear();
+  }
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->bytes_in_use, 0);
+  EXPECT_GT(stats->num_cache_hits, 0);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheFlushedBeforeFailing) {
+  // 1MB, allocated up front.
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 20, false, true /*enable_thread_cache*/));
+  // Fill the region with the largest cacheable chunks and free them all into
+  // the cache.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 64; ++i) {
+    void* p = a->AllocateRaw(1, 64 * 256);
+    ASSERT_NE(p, nullptr);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  CheckCacheStats(a.get(), 64, 0, 0, 64);
+
+  // Only satisfiable once the cached chunks are coalesced again.
+  void* p = a->AllocateRaw(1, 1 << 19);
+  EXPECT_NE(p, nullptr);
+  a->DeallocateRaw(p);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheThreaded) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1 << 30, true, true /*enable_thread_cache*/));
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 1000; ++i) {
+          ptrs.push_back(a->AllocateRaw(1, 256 * (1 + (i + t) % 80)));
+          if (ptrs.size() == 16) {
+            for (void* p : ptrs) {
+              a->DeallocateRaw(p);
+            }
+            ptrs.clear();
+          }
+        }
+        for (void* p : ptrs) {
+          a->DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  absl::optional<AllocatorStats> stats = a->GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_allocs, 8000);
+  EXPECT_EQ(stats->bytes_in_use, 0);
+}
+
+static void BM_AllocationThreaded(int iters, int num_threads,
+                                  bool enable_thread_cache) {
+  std::unique_ptr<BFCAllocator> a(
+      NewCPUBFCAllocator(1uLL << 33, true, enable_thread_cache));
+  thread::ThreadPool pool(Env::Default(), "test", num_threads);
+  std::atomic_int_fast32_t count(iters);
+  mutex done_lock;
+  condition_variable done;
+  bool done_flag = false;
+
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &count, &done_lock, &done, &done_flag, iters]() {
+      // Exercise a few different allocation sizes, mostly small.
+      std::vector<int> sizes = {256, 4096, 1024, 16384, 512, 1048576};
+      int size_index = 0;
+      for (int i = 0; i < iters; i++) {
+        int bytes = sizes[size_index++ % sizes.size()];
+        void* p = a->AllocateRaw(1, bytes);
+        a->DeallocateRaw(p);
+        if (count.fetch_sub(1) == 1) {
+          mutex_lock l(done_lock);
+          done_flag = true;
+          done.notify_all();
+          break;
+        }
+      }
+    });
+  }
+  mutex_lock l(done_lock);
+  if (!done_flag) {
+    done.wait(l);
+  }
+}
+
+static void BM_AllocationThreadedNoCache(int iters, int num_threads) {
+  BM_AllocationThreaded(iters, num_threads, false);
+}
+BENCHMARK(BM_AllocationThreadedNoCache)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_AllocationThreadedCache(int iters, int num_threads) {
+  BM_AllocationThreaded(iters, num_threads, true);
+}
+BENCHMARK(BM_AllocationThreadedCache)->Arg(1)->Arg(4)->Arg(16);
+
+}  // namespace
+}  // namespace tensorflow
@@ -56,6 +56,33 @@ void CollectiveParamResolverLocal::CompleteGroupAsync(
 }
 
 namespace {
+// Reductions of tensors up to this size are latency bound, and use recursive
+// halving-doubling rather than the ring algorithm.
+constexpr int64 kMaxHalvingDoublingReduceBytes = 1 << 20;
+// Smaller groups take about as many steps in the ring algorithm.
+constexpr int kMinHalvingDoublingReduceGroupSize = 4;
+
+string GetReductionName(const CollectiveParams* cp) {
+  // Only the ring algorithm encodes the values it sends.
+  if (cp->instance.compression != "none" ||
+      cp->group.device_type != DEVICE_CPU ||
+      cp->group.group_size < kMinHalvingDoublingReduceGroupSize) {
+    return "RingReduce";
+  }
+  const int64 num_bytes = cp->instance.shape.num_elements() *
+                          DataTypeSize(cp->instance.data_type);
+  if (num_bytes > kMaxHalvingDoublingReduceBytes) {
+    return "RingReduce";
+  }
+  // With several devices per task, reduce within each task first so that a
+  // single device per task sends over the network.  `num_tasks` is not known
+  // yet when the group is being completed.
+  if (cp->group.num_tasks > 1 && cp->group.group_size > cp->group.num_tasks) {
+    return "HierarchicalReduce";
+  }
+  return "HalvingDoublingReduce";
+}
+
 string GetCollectiveName(const CollectiveParams* cp, bool nccl) {
   switch (cp->instance.type) {
     case BROADCAST_COLLECTIVE:
@@ -65,7 +92,7 @@ string GetCollectiveName(const CollectiveParams* cp, bool nccl) {
       if (nccl) {
         return "NcclReduce";
       } else {
-        return "RingReduce";
+        return GetReductionName(cp);
       }
     }
 
@@ -658,8 +685,8 @@ void CollectiveParamResolverLocal::CompleteInstanceAsync(
                        "intended only for non-distributed deployment."));
 }
 
-// TODO(b/111897089): we need a better way to pick the collective
-// implementation.  The ideal way would depend upon the topology and link
+// TODO(b/111897089): reductions are picked by tensor size, group size and
+// number of tasks.  A better way would also depend upon the topology and link
 // strength before picking a particular implementation.
 void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
   cp->instance.impl_details.collective_name = GetCollectiveName(cp, nccl_);
@@ -697,11 +724,27 @@ void CollectiveParamResolverLocal::CompleteInstanceFromInitializedIRec(
     const string& device, const GroupRec* gr, CollectiveParams* cp,
     InstanceRec* ir, bool is_source, const StatusCallback& done) {
   // Populate the fields common across instance.
+  Status status;
   {
     mutex_lock l(ir->out_mu);
     ir->WaitForOutMu(l);
-    // custom operator= does a deep copy.
-    cp->instance = ir->shared.instance;
+    const CollInstanceParams& shared = ir->shared.instance;
+    if (cp->instance.compression != shared.compression ||
+        cp->instance.topk_ratio != shared.topk_ratio) {
+      status = errors::InvalidArgument(
+          "Collective ", cp->name, " on ", device, " uses compression ",
+          cp->instance.compression, " (topk_ratio ", cp->instance.topk_ratio,
+          ") but other members of instance ", cp->instance.instance_key,
+          " use ", shared.compression, " (topk_ratio ", shared.topk_ratio,
+          ")");
+    } else {
+      // custom operator= does a deep copy.
+      cp->instance = shared;
+    }
+  }
+  if (!status.ok()) {
+    done(status);
+    return;
   }
   // Populate the fields common across task.
   AssignCollectiveType(cp);
@@ -709,7 +752,7 @@ void CollectiveParamResolverLocal::CompleteInstanceFromInitializedIRec(
   CompleteTaskIsLocal(task_name_, cp);
 
   CollectiveImplementationInterface* col_impl;
-  Status status = CollectiveRegistry::LookupParamResolverInstance(
+  status = CollectiveRegistry::LookupParamResolverInstance(
       cp->instance.impl_details.collective_name, &col_impl);
   if (!status.ok()) {
     done(status);
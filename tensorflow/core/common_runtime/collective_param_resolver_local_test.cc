@@ -197,9 +197,56 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
     EXPECT_FALSE(cps[i].is_source);
     EXPECT_EQ(cps[i].default_rank, i);
     EXPECT_TRUE(cps[i].instance.same_num_devices_per_task);
+    // Groups of 3 devices are too small for recursive halving-doubling.
+    EXPECT_EQ("RingReduce", cps[i].instance.impl_details.collective_name);
   }
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteParamsCompressionMismatch) {
+  CollectiveParams cps[NUM_DEVS];
+  Status statuses[NUM_DEVS];
+  Notification note[NUM_DEVS];
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    CollectiveParams* cp = &cps[i];
+    cp->group.group_key = 1;
+    cp->group.group_size = 3;
+    cp->group.device_type = DeviceType("CPU");
+    cp->group.num_tasks = 1;
+    cp->instance.instance_key = 7;
+    cp->instance.type = REDUCTION_COLLECTIVE;
+    cp->instance.data_type = DataType(DT_FLOAT);
+    cp->instance.shape = TensorShape({5});
+    // Only the first device compresses the values it sends.
+    cp->instance.compression = i == 0 ? "bf16" : "none";
+    cp->instance.device_names.push_back(
+        strings::StrCat("/job:localhost/replica:0/task:0/device:CPU:", i));
+    cp->instance.impl_details.subdiv_offsets.push_back(0);
+    cp->is_source = false;
+    Env::Default()->SchedClosure([this, i, cp, &note, &statuses]() {
+      prl_->CompleteParamsAsync(cp->instance.device_names[0], cp,
+                                nullptr /*CancellationManager*/,
+                                [&statuses, &note, i](const Status& s) {
+                                  statuses[i] = s;
+                                  note[i].Notify();
+                                });
+    });
+  }
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    note[i].WaitForNotification();
+  }
+  // Whichever device initializes the instance, the devices that disagree
+  // with it fail.
+  int num_failed = 0;
+  for (int i = 0; i < NUM_DEVS; ++i) {
+    if (!statuses[i].ok()) {
+      EXPECT_TRUE(errors::IsInvalidArgument(statuses[i])) << statuses[i];
+      ++num_failed;
+    }
+  }
+  EXPECT_GE(num_failed, 1);
+  EXPECT_LT(num_failed, NUM_DEVS);
+}
+
 void InitializeCollectiveParamsForBroadcast(int instance_key, int device_idx,
                                             bool is_source,
                                             CollectiveParams* cp) {
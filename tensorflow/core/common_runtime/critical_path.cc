@@ -0,0 +1,81 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/critical_path.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/graph/algorithm.h"
+
+namespace tensorflow {
+
+// static
+NodeCostEstimatorFactory* NodeCostEstimatorRegistry::factory_ = nullptr;
+
+// static
+void NodeCostEstimatorRegistry::RegisterFactory(
+    const NodeCostEstimatorFactory& factory) {
+  delete factory_;
+  factory_ = new NodeCostEstimatorFactory(factory);
+}
+
+// static
+std::unique_ptr<NodeCostEstimatorInterface>
+NodeCostEstimatorRegistry::CreateEstimator(const string& device_name) {
+  if (factory_ == nullptr || *factory_ == nullptr) return nullptr;
+  return (*factory_)(device_name);
+}
+
+void EstimateNodeCosts(const Graph& graph, const string& device_name,
+                       std::vector<int64>* costs) {
+  costs->assign(graph.num_node_ids(), kNodeDispatchCostNsec);
+
+  std::unique_ptr<NodeCostEstimatorInterface> estimator =
+      NodeCostEstimatorRegistry::CreateEstimator(device_name);
+  if (estimator == nullptr) return;
+  ShapeRefiner refiner(graph.versions(), graph.op_registry());
+  refiner.set_require_shape_inference_fns(false);
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (const Node* n : order) {
+    // Nodes downstream of a node that could not be added, e.g. of a loop,
+    // keep the dispatch cost only.
+    if (!n->IsOp() || !refiner.AddNode(n).ok()) continue;
+    const int64 nsec = estimator->EstimateNsec(*n, refiner.GetContext(n));
+    if (nsec > 0) (*costs)[n->id()] += nsec;
+  }
+}
+
+void ComputeCriticalPathPriorities(const Graph& graph,
+                                   const std::vector<int64>& costs,
+                                   std::vector<int64>* priorities) {
+  priorities->assign(graph.num_node_ids(), 0);
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const Node* n = *it;
+    int64 path = 0;
+    // The consumers of "n" come after it in the order, except across the
+    // back edges out of NextIteration nodes.
+    if (!n->IsNextIteration()) {
+      for (const Edge* e : n->out_edges()) {
+        path = std::max(path, (*priorities)[e->dst()->id()]);
+      }
+    }
+    (*priorities)[n->id()] = costs[n->id()] + path;
+  }
+}
+
+}  // namespace tensorflow
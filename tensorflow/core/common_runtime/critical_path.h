@@ -0,0 +1,90 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_CRITICAL_PATH_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_CRITICAL_PATH_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The fixed cost of dispatching one node, in nanoseconds.  It is added to
+// every estimate, so that nodes without a cost model still weigh in by the
+// number of hops to the end of the graph.
+constexpr int64 kNodeDispatchCostNsec = 1000;
+
+namespace shape_inference {
+class InferenceContext;
+}  // namespace shape_inference
+
+// An abstract interface for estimating the execution time of single nodes.
+class NodeCostEstimatorInterface {
+ public:
+  virtual ~NodeCostEstimatorInterface() {}
+
+  // Returns an estimate in nanoseconds of one execution of "n", whose input
+  // and output shapes, as far as they are statically known, are in "c".
+  // Returns a non-positive value if there is no estimate.
+  virtual int64 EstimateNsec(const Node& n,
+                             shape_inference::InferenceContext* c) = 0;
+};
+
+typedef std::function<std::unique_ptr<NodeCostEstimatorInterface>(
+    const string& device_name)>
+    NodeCostEstimatorFactory;
+
+// Contains only static methods for registering NodeCostEstimatorFactory.
+// The estimators are implemented outside of the core runtime, e.g. on top of
+// grappler's cost models, which register a factory at initialization time.
+class NodeCostEstimatorRegistry {
+ public:
+  static void RegisterFactory(const NodeCostEstimatorFactory& factory);
+
+  // Returns an estimator for the device named "device_name", or null if no
+  // factory has been registered.
+  static std::unique_ptr<NodeCostEstimatorInterface> CreateEstimator(
+      const string& device_name);
+
+ private:
+  static NodeCostEstimatorFactory* factory_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NodeCostEstimatorRegistry);
+};
+
+// Returns in "*costs", indexed by node id, an estimate in nanoseconds of one
+// execution of every node of "graph" on the device named "device_name".
+// The estimates come from the registered NodeCostEstimatorInterface, given
+// the shapes that shape inference can determine statically.  Without one,
+// every node costs kNodeDispatchCostNsec.
+void EstimateNodeCosts(const Graph& graph, const string& device_name,
+                       std::vector<int64>* costs);
+
+// Returns in "*priorities", indexed by node id, the cost of the most
+// expensive path from every node of "graph" to the end of the graph,
+// including the node itself.  Running the ready node with the highest
+// priority first runs the critical path as early as possible.  Back edges
+// of loops are ignored.
+void ComputeCriticalPathPriorities(const Graph& graph,
+                                   const std::vector<int64>& costs,
+                                   std::vector<int64>* priorities);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_CRITICAL_PATH_H_
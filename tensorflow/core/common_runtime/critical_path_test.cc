@@ -0,0 +1,76 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/critical_path.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char kCPU[] = "/job:localhost/replica:0/task:0/device:CPU:0";
+
+Tensor Matrix(int64 n) {
+  Tensor t(DT_FLOAT, TensorShape({n, n}));
+  t.flat<float>().setZero();
+  return t;
+}
+
+TEST(CriticalPathTest, Priorities) {
+  Graph g(OpRegistry::Global());
+  Node* x = test::graph::Constant(&g, Matrix(2));
+  // A short expensive branch and a long cheap one.
+  Node* a = test::graph::Identity(&g, x);
+  Node* b1 = test::graph::Identity(&g, x);
+  Node* b2 = test::graph::Identity(&g, b1);
+  Node* b3 = test::graph::Identity(&g, b2);
+  Node* out = test::graph::Add(&g, a, b3);
+  FixupSourceAndSinkEdges(&g);
+
+  std::vector<int64> costs(g.num_node_ids(), 1);
+  costs[a->id()] = 10;
+  std::vector<int64> priorities;
+  ComputeCriticalPathPriorities(g, costs, &priorities);
+  EXPECT_EQ(1, priorities[out->id()]);
+  EXPECT_EQ(2, priorities[b3->id()]);
+  EXPECT_EQ(4, priorities[b1->id()]);
+  EXPECT_EQ(11, priorities[a->id()]);
+  EXPECT_EQ(12, priorities[x->id()]);
+  EXPECT_GT(priorities[a->id()], priorities[b1->id()]);
+
+  costs[a->id()] = 1;
+  ComputeCriticalPathPriorities(g, costs, &priorities);
+  EXPECT_LT(priorities[a->id()], priorities[b1->id()]);
+}
+
+TEST(CriticalPathTest, EstimatedCosts) {
+  Graph g(OpRegistry::Global());
+  Node* x = test::graph::Constant(&g, Matrix(512));
+  Node* matmul = test::graph::Matmul(&g, x, x, false, false);
+  Node* identity = test::graph::Identity(&g, x);
+  FixupSourceAndSinkEdges(&g);
+
+  std::vector<int64> costs;
+  EstimateNodeCosts(g, kCPU, &costs);
+  ASSERT_EQ(g.num_node_ids(), costs.size());
+  EXPECT_GE(costs[identity->id()], kNodeDispatchCostNsec);
+  EXPECT_GT(costs[matmul->id()], costs[identity->id()]);
+}
+
+}  // namespace
+}  // namespace tensorflow
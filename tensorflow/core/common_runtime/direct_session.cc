@@ -96,7 +96,7 @@ Status NewThreadPoolFromThreadPoolOptions(
             << pool_number << ": " << num_threads;
     *pool = new thread::ThreadPool(
         options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
+        num_threads, InterOpSchedulingPolicyFromSessionOptions(options),
         /*allocator=*/nullptr);
     *owned = true;
     return Status::OK();
@@ -113,7 +113,7 @@ Status NewThreadPoolFromThreadPoolOptions(
     mvalue->first = thread_pool_options.num_threads();
     mvalue->second = new thread::ThreadPool(
         options.env, ThreadOptions(), strings::StrCat("Compute", pool_number),
-        num_threads, !options.config.experimental().disable_thread_spinning(),
+        num_threads, InterOpSchedulingPolicyFromSessionOptions(options),
         /*allocator=*/nullptr);
   } else {
     if (mvalue->first != thread_pool_options.num_threads()) {
@@ -591,9 +591,11 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
 
   std::unique_ptr<RunHandler> handler;
   if (ShouldUseRunHandlerPool(run_options) &&
-      run_options.experimental().use_run_handler_pool()) {
+      (run_options.experimental().use_run_handler_pool() ||
+       options_.config.experimental().use_run_handler_pool())) {
     VLOG(1) << "Using RunHandler to scheduler inter-op closures.";
-    handler = GetOrCreateRunHandlerPool(options_)->Get();
+    handler = GetOrCreateRunHandlerPool(options_)->Get(
+        run_options.experimental().run_handler_priority());
   }
   auto* handler_ptr = handler.get();
 
@@ -619,13 +621,34 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
         item.device->tensorflow_device_thread_pool();
     // TODO(crk): Investigate usage of RunHandlerPool when using device specific
     // thread pool(s).
+    args.batch_runner = nullptr;
     if (!device_thread_pool) {
       args.runner = default_runner;
+      if (pool != nullptr && handler_ptr == nullptr &&
+          pool->scheduling_policy().wake_batch_size > 1) {
+        args.batch_runner =
+            [pool](std::vector<Executor::Args::Closure> closures) {
+              pool->ScheduleBatch(std::move(closures));
+            };
+      }
     } else {
       args.runner = [this, device_thread_pool](Executor::Args::Closure c) {
         device_thread_pool->Schedule(std::move(c));
       };
     }
+    args.user_intra_op_threadpool = nullptr;
+    args.user_intra_op_parallelism = 0;
+    if (handler_ptr != nullptr && !device_thread_pool &&
+        item.device->device_type() == DEVICE_CPU) {
+      // Give the request its share of the intra-op threads too, so that a
+      // large request does not occupy all of them.
+      const DeviceBase::CpuWorkerThreads* worker_threads =
+          item.device->tensorflow_cpu_worker_threads();
+      args.user_intra_op_threadpool =
+          handler_ptr->AsIntraThreadPoolInterface(worker_threads->workers);
+      args.user_intra_op_parallelism =
+          handler_ptr->IntraOpParallelism(worker_threads->num_threads);
+    }
     item.executor->RunAsync(args, barrier->Get());
   }
 
@@ -641,6 +664,11 @@ Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
     run_state.status.Update(errors::Cancelled("Run call was cancelled"));
   }
 
+  if (handler_ptr != nullptr) {
+    metrics::RecordRunHandlerQueueingDelay(
+        handler_ptr->wait_usecs(), handler_ptr->mean_queueing_delay_usecs());
+  }
+
   if (profiler_session) {
     TF_RETURN_IF_ERROR(profiler_session->CollectData(run_metadata));
   }
@@ -1267,6 +1295,8 @@ Status DirectSession::CreateExecutors(
       *r = new IntraProcessRendezvous(device_mgr);
       return Status::OK();
     };
+    params.adaptive_sharding =
+        options_.config.experimental().adaptive_sharding();
 
     optimizer.Optimize(lib, options_.env, device, &partition_graph,
                        /*shape_map=*/nullptr);
@@ -1529,6 +1559,8 @@ Status DirectSession::CreateGraphs(
   };
   popts.flib_def = &client_graph->graph.flib_def();
   popts.control_flow_added = false;
+  popts.assign_rendezvous_slots =
+      options_.config.experimental().use_rendezvous_slots();
 
   std::unordered_map<string, GraphDef> partitions;
   TF_RETURN_IF_ERROR(Partition(popts, &client_graph->graph, &partitions));
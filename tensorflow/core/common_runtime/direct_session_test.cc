@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -653,6 +654,173 @@ TEST_F(DirectSessionMinusAXTest, UseRunHandlerPool) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+// Records the intra-op worker threads that its kernel was given.  Stateful,
+// so that it is not constant-folded.
+REGISTER_OP("IntraOpThreadsProbe")
+    .Input("x: float")
+    .Output("y: float")
+    .SetIsStateful();
+
+static mutex intra_op_threads_probe_mu(LINKER_INITIALIZED);
+static std::vector<DeviceBase::CpuWorkerThreads>* intra_op_threads_seen
+    GUARDED_BY(intra_op_threads_probe_mu) =
+        new std::vector<DeviceBase::CpuWorkerThreads>;
+
+class IntraOpThreadsProbeOp : public OpKernel {
+ public:
+  explicit IntraOpThreadsProbeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  void Compute(OpKernelContext* ctx) override {
+    {
+      mutex_lock l(intra_op_threads_probe_mu);
+      intra_op_threads_seen->push_back(
+          *ctx->device()->tensorflow_cpu_worker_threads());
+    }
+    ctx->set_output(0, ctx->input(0));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("IntraOpThreadsProbe").Device(DEVICE_CPU),
+                        IntraOpThreadsProbeOp);
+
+TEST(DirectSessionTest, UseRunHandlerPoolForSession) {
+  Graph g(OpRegistry::Global());
+  Tensor x(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&x, {1, 2, 3, 4});
+  Node* y = test::graph::Unary(&g, "IntraOpThreadsProbe",
+                               test::graph::Constant(&g, x));
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options;
+  options.config.mutable_experimental()->set_use_run_handler_pool(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+  const DeviceMgr* device_mgr;
+  TF_ASSERT_OK(session->LocalDeviceManager(&device_mgr));
+  Device* cpu;
+  TF_ASSERT_OK(
+      device_mgr->LookupDevice("/job:localhost/replica:0/task:0/cpu:0", &cpu));
+  const DeviceBase::CpuWorkerThreads* device_threads =
+      cpu->tensorflow_cpu_worker_threads();
+  {
+    mutex_lock l(intra_op_threads_probe_mu);
+    intra_op_threads_seen->clear();
+  }
+
+  // Run the graph concurrently with different priorities, each run with its
+  // share of the inter-op and intra-op threads.
+  const int kThreads = 4;
+  const int kRuns = 100;
+  thread::ThreadPool* tp =
+      new thread::ThreadPool(Env::Default(), "test", kThreads);
+  std::vector<string> output_names = {y->name() + ":0"};
+  for (int t = 0; t < kThreads; ++t) {
+    tp->Schedule([&session, output_names, t]() {
+      RunOptions run_options;
+      run_options.mutable_experimental()->set_run_handler_priority(t % 2);
+      for (int i = 0; i < kRuns; ++i) {
+        std::vector<Tensor> outputs;
+        TF_ASSERT_OK(
+            session->Run(run_options, {}, output_names, {}, &outputs, nullptr));
+        ASSERT_EQ(1, outputs.size());
+        EXPECT_FLOAT_EQ(1.0, outputs[0].matrix<float>()(0, 0));
+      }
+    });
+  }
+
+  // Wait for the functions to finish.
+  delete tp;
+
+  // Every kernel got its request's share of the device's intra-op threads,
+  // instead of the device's own pool.
+  mutex_lock l(intra_op_threads_probe_mu);
+  ASSERT_EQ(kThreads * kRuns, intra_op_threads_seen->size());
+  for (const DeviceBase::CpuWorkerThreads& seen : *intra_op_threads_seen) {
+    EXPECT_NE(device_threads->workers, seen.workers);
+    EXPECT_EQ(device_threads->workers->NumThreads(),
+              seen.workers->NumThreads());
+    EXPECT_LE(1, seen.num_threads);
+    EXPECT_GE(device_threads->num_threads, seen.num_threads);
+  }
+}
+
+// Waits until kNumConcurrent of its kernels have started, and records whether
+// they did before it gave up and whether the thread it ran on was pinned to a
+// single CPU.  Stateful, so that it is not constant-folded.
+REGISTER_OP("WakeupProbe").SetIsStateful();
+
+struct WakeupProbeState {
+  static const int kNumConcurrent = 4;
+
+  mutex mu;
+  condition_variable cv;
+  int num_started GUARDED_BY(mu) = 0;
+  int num_timed_out GUARDED_BY(mu) = 0;
+  int num_unpinned GUARDED_BY(mu) = 0;
+};
+static WakeupProbeState* wakeup_probe_state = new WakeupProbeState;
+
+class WakeupProbeOp : public OpKernel {
+ public:
+  explicit WakeupProbeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  bool IsExpensive() override { return true; }
+  void Compute(OpKernelContext* ctx) override {
+    WakeupProbeState* state = wakeup_probe_state;
+    mutex_lock l(state->mu);
+    if (++state->num_started >= WakeupProbeState::kNumConcurrent) {
+      state->cv.notify_all();
+    }
+    while (state->num_started < WakeupProbeState::kNumConcurrent) {
+      if (WaitForMilliseconds(&l, &state->cv, 10000) == kCond_Timeout) {
+        ++state->num_timed_out;
+        break;
+      }
+    }
+#if defined(__linux__) && !defined(__ANDROID__)
+    if (port::NumSchedulableCPUs() != 1) ++state->num_unpinned;
+#endif
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("WakeupProbe").Device(DEVICE_CPU), WakeupProbeOp);
+
+TEST(DirectSessionTest, BatchedWakeupsAndPinnedThreads) {
+  // 16 probes become ready together.  The inter-op thread that finds them
+  // runs one itself and wakes up one thread per 4 of the others, so 4 of
+  // them run at once on the 4 inter-op threads, which are pinned.
+  Graph g(OpRegistry::Global());
+  std::vector<string> target_names;
+  for (int i = 0; i < 16; ++i) {
+    Node* probe;
+    TF_ASSERT_OK(NodeBuilder(g.NewName("probe"), "WakeupProbe")
+                     .Finalize(&g, &probe));
+    target_names.push_back(probe->name());
+  }
+  GraphDef def;
+  g.ToGraphDef(&def);
+
+  SessionOptions options;
+  options.config.set_use_per_session_threads(true);
+  options.config.set_inter_op_parallelism_threads(
+      WakeupProbeState::kNumConcurrent);
+  options.config.mutable_experimental()->set_inter_op_wake_batch_size(4);
+  options.config.mutable_experimental()->set_pin_threads_to_cores(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def));
+
+  for (int i = 0; i < 10; ++i) {
+    {
+      mutex_lock l(wakeup_probe_state->mu);
+      wakeup_probe_state->num_started = 0;
+    }
+    TF_ASSERT_OK(session->Run({}, {}, target_names, nullptr));
+    mutex_lock l(wakeup_probe_state->mu);
+    EXPECT_EQ(16, wakeup_probe_state->num_started);
+    EXPECT_EQ(0, wakeup_probe_state->num_timed_out);
+    EXPECT_EQ(0, wakeup_probe_state->num_unpinned);
+  }
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -15,18 +15,27 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <atomic>
 #include <deque>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/critical_path.h"
 #include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/common_runtime/static_memory_planner.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -47,6 +56,7 @@ limitations under the License.
 #include "tensorflow/core/graph/edgeset.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -57,12 +67,15 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/profile_utils/cpu_utils.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -70,6 +83,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/internal/traceme_recorder.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -168,6 +182,12 @@ struct NodeItem {
   bool is_sink : 1;             // True iff IsSink(node)
   // True iff IsEnter(node) || IsExit(node) || IsNextIteration(node)
   bool is_enter_exit_or_next_iter : 1;
+  // True iff the outputs and temporaries of the kernel may be allocated from
+  // the step arena.
+  bool uses_step_arena : 1;
+  // True iff inputs allocated from the step arena must be copied out of it
+  // before the kernel runs, because the kernel may keep them past the step.
+  bool copies_step_arena_inputs : 1;
 
   // Cached values of node->num_inputs() and node->num_outputs(), to
   // avoid levels of indirection.
@@ -183,6 +203,14 @@ struct NodeItem {
 
   PendingCounts::Handle pending_id;
 
+  // The estimated time from the start of this node to the end of the step,
+  // if the executor runs the ready nodes on the critical path first.
+  int64 priority = 0;
+
+  // The measured cost of the Shard() calls made by the kernel, if adaptive
+  // sharding is enabled.  Owned by the ExecutorImpl.
+  AdaptiveShardCost* shard_cost = nullptr;
+
   const EdgeInfo* output_edge_list() const { return output_edge_base(); }
 
   // ith output edge.
@@ -292,17 +320,52 @@ class GraphView {
 
 class ExecutorImpl : public Executor {
  public:
+  struct Options {
+    // If true, ready nodes are dispatched through per-thread deques with work
+    // stealing instead of being handed to the runner directly.
+    bool work_stealing = false;
+    // If true, the outputs and temporaries of kernels that cannot outlive a
+    // step are allocated from a per-step arena.
+    bool step_arena = false;
+    // If true, the outputs with statically known shapes are placed in a
+    // per-step slab according to a StaticMemoryPlan.
+    bool static_memory_plan = false;
+    // If true, the expensive ready nodes are run in order of decreasing
+    // length of their path to the end of the graph.
+    bool critical_path_priorities = false;
+  };
+
   ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g)
-      : params_(p), graph_(std::move(g)), gview_() {
+      : ExecutorImpl(p, std::move(g), Options()) {}
+
+  ExecutorImpl(const LocalExecutorParams& p, std::unique_ptr<const Graph> g,
+               const Options& options)
+      : params_(p),
+        graph_(std::move(g)),
+        gview_(),
+        work_stealing_(options.work_stealing),
+        prioritize_critical_path_(options.critical_path_priorities),
+        plan_static_memory_(options.static_memory_plan) {
     CHECK(p.create_kernel != nullptr);
     CHECK(p.delete_kernel != nullptr);
+    if (options.step_arena) {
+      step_arena_pool_.reset(new StepArenaAllocatorPool(
+          kMinStepArenaBlockSize, kMaxStepArenaBlockSize));
+    }
   }
 
   ~ExecutorImpl() override {
+    for (StaticMemorySlab* slab : free_slabs_) {
+      slab->Unref();
+    }
     for (int i = 0; i < graph_->num_node_ids(); i++) {
       NodeItem* item = gview_.node(i);
       if (item != nullptr) {
         params_.delete_kernel(item->kernel);
+        if (item->shard_cost != nullptr) {
+          AdaptiveShardCostRegistry::Global()->Unregister(item->shard_cost);
+          delete item->shard_cost;
+        }
       }
     }
     for (auto fiter : frame_info_) {
@@ -361,6 +424,28 @@ class ExecutorImpl : public Executor {
                                      ControlFlowInfo* cf_info);
   void InitializePending(const Graph* graph, const ControlFlowInfo& cf_info);
 
+  // Sets NodeItem::uses_step_arena for the nodes whose kernels cannot keep
+  // tensors past the step, and NodeItem::copies_step_arena_inputs for all
+  // other nodes.
+  void MarkStepArenaNodes();
+
+  // Computes static_memory_plan_, if the graph and device allow it.
+  void PlanStaticMemory();
+
+  // Sets NodeItem::priority from estimated, or measured if available, costs.
+  void ComputeNodePriorities();
+
+  // Returns a slab for one step run with static_memory_plan_, and takes it
+  // back at the end of the step.
+  StaticMemorySlab* GetStaticMemorySlab() const;
+  void ReleaseStaticMemorySlab(StaticMemorySlab* slab) const;
+
+  // Returns the device, owned by the executor, that runs kernels of
+  // params_.device with their intra-op work on "threadpool", using
+  // "parallelism" of its threads.
+  Device* GetUserIntraOpDevice(Eigen::ThreadPoolInterface* threadpool,
+                               int parallelism) const;
+
   FrameInfo* EnsureFrameInfo(const string& fname) {
     auto slot = &frame_info_[fname];
     if (*slot == nullptr) {
@@ -377,6 +462,36 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // If true, ready nodes are dispatched through per-thread deques with work
+  // stealing instead of being handed to the runner directly.
+  const bool work_stealing_;
+
+  // If true, ready nodes are dispatched through a queue ordered by
+  // NodeItem::priority.
+  const bool prioritize_critical_path_;
+
+  // Arenas for the tensors that do not outlive a step; null unless the
+  // executor runs in step-arena mode.
+  static const size_t kMinStepArenaBlockSize = 1 << 20;
+  static const size_t kMaxStepArenaBlockSize = 1 << 28;
+  std::unique_ptr<StepArenaAllocatorPool> step_arena_pool_;
+
+  // Placement of the outputs with statically known shapes; null unless the
+  // executor runs in static-memory-plan mode and the graph could be planned.
+  const bool plan_static_memory_;
+  std::unique_ptr<const StaticMemoryPlan> static_memory_plan_;
+  // Slabs no longer used by any step, ready for reuse.
+  mutable mutex slabs_mu_;
+  mutable std::vector<StaticMemorySlab*> free_slabs_ GUARDED_BY(slabs_mu_);
+
+  // Devices returned by GetUserIntraOpDevice().  The thread pools come from
+  // RunHandlers, which keep one per intra-op pool for as long as they live,
+  // so there are few distinct keys.
+  mutable mutex user_devices_mu_;
+  mutable std::map<std::pair<Eigen::ThreadPoolInterface*, int>,
+                   std::unique_ptr<Device>>
+      user_devices_ GUARDED_BY(user_devices_mu_);
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -600,6 +715,21 @@ void GetMaxPendingCounts(const Node* n, size_t* max_pending,
   *max_dead_count = num_in_edges;
 }
 
+// Returns true if the kernel of 'n' may keep its input or output tensors
+// beyond the step, or hand them to something outside the executor.
+bool MayRetainTensors(const Node* n) {
+  if (n->op_def().is_stateful() || n->IsSend() || n->IsRecv() || n->IsArg() ||
+      n->IsRetval() || n->IsCollective() || n->IsScopedAllocator() ||
+      n->IsPartitionedCall() || n->IsGetSessionHandle() ||
+      n->IsGetSessionTensor()) {
+    return true;
+  }
+  for (DataType dt : n->input_types()) {
+    if (IsRefType(dt)) return true;
+  }
+  return false;
+}
+
 Status ExecutorImpl::Initialize() {
   gview_.Initialize(graph_.get());
 
@@ -616,6 +746,10 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
+  // Kernels on a CPU device shard their work by measured costs if asked to.
+  const bool adaptive_sharding = params_.adaptive_sharding &&
+                                 params_.device->device_type() == DEVICE_CPU;
+
   // Preprocess every node in the graph to create an instance of op
   // kernel for each node.
   for (const Node* n : graph_->nodes()) {
@@ -658,6 +792,19 @@ Status ExecutorImpl::Initialize() {
     item->is_sink = IsSink(n);
     item->is_enter_exit_or_next_iter =
         (IsEnter(n) || IsExit(n) || IsNextIteration(n));
+    item->uses_step_arena = false;
+    item->copies_step_arena_inputs = false;
+    if (adaptive_sharding && !item->kernel_is_async) {
+      DataType dtype = DT_INVALID;
+      if (n->num_outputs() > 0) {
+        dtype = BaseType(n->output_type(0));
+      } else if (n->num_inputs() > 0) {
+        dtype = BaseType(n->input_type(0));
+      }
+      item->shard_cost = new AdaptiveShardCost;
+      AdaptiveShardCostRegistry::Global()->Register(
+          n->name(), n->type_string(), dtype, item->shard_cost);
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
@@ -681,7 +828,134 @@ Status ExecutorImpl::Initialize() {
   // all nodes.
   InitializePending(graph_.get(), cf_info);
 
-  return gview_.SetAllocAttrs(graph_.get(), params_.device);
+  if (step_arena_pool_ != nullptr) {
+    MarkStepArenaNodes();
+  }
+
+  TF_RETURN_IF_ERROR(gview_.SetAllocAttrs(graph_.get(), params_.device));
+
+  if (plan_static_memory_) {
+    PlanStaticMemory();
+  }
+
+  if (prioritize_critical_path_) {
+    ComputeNodePriorities();
+  }
+  return Status::OK();
+}
+
+void ExecutorImpl::ComputeNodePriorities() {
+  std::vector<int64> costs;
+  EstimateNodeCosts(*graph_, params_.device->name(), &costs);
+  std::vector<int64> priorities;
+  ComputeCriticalPathPriorities(*graph_, costs, &priorities);
+  for (const Node* n : graph_->nodes()) {
+    gview_.node(n->id())->priority = priorities[n->id()];
+  }
+}
+
+void ExecutorImpl::PlanStaticMemory() {
+  if (params_.device->device_type() != DEVICE_CPU) return;
+  for (const Node* n : graph_->op_nodes()) {
+    if (n->IsControlFlow()) return;
+  }
+
+  std::vector<std::vector<int64>> output_bytes;
+  InferStaticOutputBytes(*graph_, &output_bytes);
+  for (const Node* n : graph_->nodes()) {
+    std::vector<int64>* bytes = &output_bytes[n->id()];
+    // Outputs handed directly to a kernel that may retain them would keep
+    // their slab from being reused by the next step.  Outputs with special
+    // attributes need another allocator.
+    bool plannable = n->IsOp() && !MayRetainTensors(n);
+    for (const Edge* e : n->out_edges()) {
+      if (!e->IsControlEdge() && e->dst()->IsOp() &&
+          MayRetainTensors(e->dst())) {
+        plannable = false;
+      }
+    }
+    const NodeItem* item = gview_.node(n->id());
+    for (int i = 0; i < bytes->size(); ++i) {
+      if (!plannable || item->output_attrs()[i].value != 0 ||
+          item->output_attrs()[i].scope_id != 0) {
+        (*bytes)[i] = -1;
+      }
+    }
+  }
+
+  std::unique_ptr<StaticMemoryPlan> plan;
+  Status s = StaticMemoryPlan::Create(*graph_, output_bytes, &plan);
+  if (!s.ok()) {
+    VLOG(1) << "Not planning memory statically: " << s;
+    return;
+  }
+  if (plan->buffers().empty()) return;
+  VLOG(1) << "Planned " << plan->buffers().size() << " outputs in a slab of "
+          << plan->slab_size() << " bytes";
+  static_memory_plan_ = std::move(plan);
+}
+
+StaticMemorySlab* ExecutorImpl::GetStaticMemorySlab() const {
+  {
+    mutex_lock l(slabs_mu_);
+    if (!free_slabs_.empty()) {
+      StaticMemorySlab* slab = free_slabs_.back();
+      free_slabs_.pop_back();
+      return slab;
+    }
+  }
+  return new StaticMemorySlab(static_memory_plan_.get(),
+                              params_.device->GetAllocator(
+                                  AllocatorAttributes()));
+}
+
+void ExecutorImpl::ReleaseStaticMemorySlab(StaticMemorySlab* slab) const {
+  // A slab whose buffers are still referenced, e.g. by an output fetched
+  // from the step, stays alive through those references but is not reused.
+  if (slab->RefCountIsOne()) {
+    mutex_lock l(slabs_mu_);
+    free_slabs_.push_back(slab);
+  } else {
+    slab->Unref();
+  }
+}
+
+Device* ExecutorImpl::GetUserIntraOpDevice(
+    Eigen::ThreadPoolInterface* threadpool, int parallelism) const {
+  mutex_lock l(user_devices_mu_);
+  std::unique_ptr<Device>& device =
+      user_devices_[std::make_pair(threadpool, parallelism)];
+  if (device == nullptr) {
+    device = RenamedDevice::NewRenamedDevice(
+        params_.device->name(), params_.device, false /* owns_underlying */,
+        false /* isolate_session_state */, threadpool, parallelism);
+  }
+  return device.get();
+}
+
+void ExecutorImpl::MarkStepArenaNodes() {
+  if (params_.device->device_type() != DEVICE_CPU) return;
+  for (const Node* n : graph_->op_nodes()) {
+    // Loops make the graph cyclic; keep the analysis simple and skip them.
+    if (n->IsControlFlow()) return;
+  }
+
+  // A buffer allocated from the arena can only outlive the step if a kernel
+  // that keeps tensors, such as _Send, _Retval or a stateful op, receives it,
+  // possibly after other kernels forwarded it from input to output.  Rather
+  // than excluding every node from which such a kernel is reachable, the
+  // kernels that may keep tensors (or hide them inside non-memcpy types such
+  // as DT_VARIANT) copy arena-backed inputs out of the arena before they run,
+  // and all other kernels allocate their outputs and temporaries from it.
+  for (const Node* n : graph_->op_nodes()) {
+    bool uses_step_arena = !MayRetainTensors(n);
+    for (DataType dt : n->output_types()) {
+      if (!DataTypeCanUseMemcpy(dt)) uses_step_arena = false;
+    }
+    NodeItem* item = gview_.node(n->id());
+    item->uses_step_arena = uses_step_arena;
+    item->copies_step_arena_inputs = !uses_step_arena;
+  }
 }
 
 // If a Node has been marked to use a ScopedAllocator x for output i, then
@@ -1239,6 +1513,110 @@ class ExecutorState {
     int front_index_;
   };
 
+  // In work-stealing mode, the ready queue shared by all threads running
+  // this step. Each thread pushes the expensive nodes it makes ready onto its
+  // own deque and, once it runs out of inline work, pops them back in LIFO
+  // order so that consumers tend to run on the core that produced their
+  // inputs. Idle threads steal the oldest nodes from other deques, preferring
+  // deques last filled by a thread on their own NUMA node.
+  //
+  // Every pushed node is paired with one closure handed to the runner. A
+  // closure whose node was already taken by its owner finds nothing to do.
+  // Closures hold a reference on the queue (not on the ExecutorState) and
+  // only touch the ExecutorState after claiming a node, at which point the
+  // step is known to still be outstanding.
+  class WorkStealingQueue : public core::RefCounted {
+   public:
+    WorkStealingQueue(ExecutorState* state, int num_deques);
+
+    // Pushes "node" onto the calling thread's deque and dispatches a closure
+    // to the runner that will run it, or another queued node.
+    void Push(const TaggedNode& node, int64 scheduled_nsec);
+
+    // Moves the node most recently pushed by the calling thread into
+    // "inline_ready". Returns false if the calling thread's deque is empty.
+    bool PopLocal(TaggedNodeReadyQueue* inline_ready);
+
+   private:
+    struct QueuedNode {
+      TaggedNode node;
+      int64 scheduled_nsec;
+    };
+
+    struct Deque {
+      mutex mu;
+      std::vector<QueuedNode> nodes GUARDED_BY(mu);
+      size_t front GUARDED_BY(mu) = 0;
+      // Number of queued nodes, readable without "mu" to skip empty deques.
+      std::atomic<int> size{0};
+      // NUMA node of the thread that last pushed onto this deque.
+      std::atomic<int> numa_node{0};
+    };
+
+    // Runs one queued node, if any is left, on the calling thread.
+    void RunOne();
+
+    // Takes the oldest node from some deque, looking at deques filled from
+    // "numa_node" first. Returns false if all deques are empty.
+    bool Steal(int numa_node, QueuedNode* out);
+    bool StealFrom(Deque* d, QueuedNode* out);
+
+    Deque* LocalDeque() { return &deques_[CurrentSlot() % num_deques_]; }
+
+    // Returns a small integer identifying the calling thread.
+    static int CurrentSlot();
+    // Returns the NUMA node the calling thread is bound to, or 0.
+    static int CurrentNUMANode();
+
+    ExecutorState* const state_;  // Not owned.
+    const int num_deques_;
+    const bool numa_aware_;
+    std::unique_ptr<Deque[]> deques_;
+  };
+
+  // In critical-path mode, the ready queue shared by all threads running
+  // this step, ordered by NodeItem::priority and then by the order in which
+  // nodes became ready.  As in work-stealing mode, every pushed node is
+  // paired with one closure handed to the runner, which runs the node with
+  // the highest priority left, if any.
+  class PriorityQueue : public core::RefCounted {
+   public:
+    explicit PriorityQueue(ExecutorState* state) : state_(state) {}
+
+    // Queues "node" and dispatches a closure to the runner that will run it,
+    // or another queued node.
+    void Push(const TaggedNode& node, int64 scheduled_nsec);
+
+    // Moves the queued node with the highest priority into "inline_ready".
+    // Returns false if the queue is empty.
+    bool Pop(TaggedNodeReadyQueue* inline_ready);
+
+   private:
+    struct QueuedNode {
+      TaggedNode node;
+      int64 scheduled_nsec;
+      int64 priority;
+      int64 sequence;
+
+      bool operator<(const QueuedNode& other) const {
+        if (priority != other.priority) return priority < other.priority;
+        return sequence > other.sequence;
+      }
+    };
+
+    bool PopLocked(QueuedNode* out) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+    // Runs the queued node with the highest priority, if any is left, on the
+    // calling thread.
+    void RunOne();
+
+    ExecutorState* const state_;  // Not owned.
+    mutex mu_;
+    // A max-heap.
+    std::vector<QueuedNode> nodes_ GUARDED_BY(mu_);
+    int64 next_sequence_ GUARDED_BY(mu_) = 0;
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1267,6 +1645,20 @@ class ExecutorState {
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
+  Executor::Args::BatchRunner batch_runner_;
+  // Owned reference; null unless the executor runs in work-stealing mode.
+  WorkStealingQueue* work_stealing_queue_ = nullptr;
+  // Owned reference; null unless the executor runs in critical-path mode.
+  PriorityQueue* priority_queue_ = nullptr;
+  // Borrowed from impl_->step_arena_pool_ for the duration of the step; null
+  // unless the executor runs in step-arena mode.
+  StepArenaAllocator* step_arena_ = nullptr;
+  // Owned reference; null unless the executor has a static memory plan.
+  StaticMemorySlab* static_memory_slab_ = nullptr;
+  // The device given to the kernels of this step instead of
+  // impl_->params_.device, if they run their intra-op work on a thread pool
+  // given in Executor::Args.  Not owned.
+  Device* user_device_ = nullptr;
   bool sync_on_finish_;
   const bool trace_using_annotations_;
 
@@ -1321,6 +1713,10 @@ class ExecutorState {
   // Process a ready node in current thread.
   void Process(TaggedNode node, int64 scheduled_nsec);
 
+  // Replaces the inputs of 'item' that were allocated from step_arena_ with
+  // copies in device memory.
+  void CopyInputsOutOfStepArena(const NodeItem& item, Entry* first_input);
+
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
                        TensorValueVec* inputs,
@@ -1349,6 +1745,15 @@ class ExecutorState {
   void ScheduleReady(const TaggedNodeSeq& ready,
                      TaggedNodeReadyQueue* inline_ready);
 
+  // Runs "tagged_node" on some thread handed out by runner_, going through
+  // the work-stealing queue if there is one.  If "batch" is not null, the
+  // closure for runner_ is appended to it instead, for batch_runner_.
+  void RunOnRunner(const TaggedNode& tagged_node, int64 scheduled_nsec,
+                   std::vector<Executor::Args::Closure>* batch = nullptr);
+
+  // Dispatches the closures in "batch" through batch_runner_.
+  void FlushBatch(std::vector<Executor::Args::Closure>* batch);
+
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
 
@@ -1399,6 +1804,7 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       impl_(impl),
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
+      batch_runner_(args.batch_runner),
       sync_on_finish_(args.sync_on_finish),
       trace_using_annotations_(impl->params_.device->TraceUsingAnnotations()),
       num_outstanding_ops_(0) {
@@ -1415,9 +1821,33 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       root_frame_->pending_counts, root_frame_->total_input_tensors);
 
   outstanding_frames_.insert({root_frame_->frame_name, root_frame_});
+
+  if (impl_->work_stealing_) {
+    work_stealing_queue_ = new WorkStealingQueue(
+        this, std::min(port::MaxParallelism(), impl_->graph_->num_node_ids()));
+  } else if (impl_->prioritize_critical_path_) {
+    priority_queue_ = new PriorityQueue(this);
+  }
+  if (impl_->step_arena_pool_ != nullptr) {
+    step_arena_ = impl_->step_arena_pool_->Get();
+  }
+  if (impl_->static_memory_plan_ != nullptr) {
+    static_memory_slab_ = impl_->GetStaticMemorySlab();
+  }
+  if (args.user_intra_op_threadpool != nullptr &&
+      impl_->params_.device->device_type() == DEVICE_CPU) {
+    user_device_ = impl_->GetUserIntraOpDevice(args.user_intra_op_threadpool,
+                                               args.user_intra_op_parallelism);
+  }
 }
 
 ExecutorState::~ExecutorState() {
+  if (work_stealing_queue_ != nullptr) {
+    work_stealing_queue_->Unref();
+  }
+  if (priority_queue_ != nullptr) {
+    priority_queue_->Unref();
+  }
   for (auto name_frame : outstanding_frames_) {
     delete name_frame.second;
   }
@@ -1425,6 +1855,13 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  // All the tensors of the step have been released with the frames above.
+  if (step_arena_ != nullptr) {
+    impl_->step_arena_pool_->Release(step_arena_);
+  }
+  if (static_memory_slab_ != nullptr) {
+    impl_->ReleaseStaticMemorySlab(static_memory_slab_);
+  }
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1625,7 +2062,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
   OpKernelContext::Params params;
   params.step_id = step_id_;
   Device* device = impl_->params_.device;
-  params.device = device;
+  params.device = user_device_ != nullptr ? user_device_ : device;
   params.log_memory = log_memory_;
   params.record_tensor_accesses = impl_->device_record_tensor_accesses_;
   params.rendezvous = rendezvous_;
@@ -1721,6 +2158,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
     if (tagged_node.is_dead && !IsTransferNode(node)) {
       outputs.resize(item.num_outputs);
     } else {
+      if (step_arena_ != nullptr && item.copies_step_arena_inputs) {
+        CopyInputsOutOfStepArena(item, first_input);
+      }
       // Prepares inputs.
       bool is_input_dead = false;
       s = PrepareInputs(item, first_input, &inputs, &input_device_contexts,
@@ -1744,6 +2184,13 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
+      params.step_allocator = item.uses_step_arena ? step_arena_ : nullptr;
+      if (static_memory_slab_ != nullptr) {
+        const int base = impl_->static_memory_plan_->output_base(id);
+        params.output_allocator_array =
+            base < 0 ? nullptr
+                     : static_memory_slab_->output_allocators() + base;
+      }
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1804,6 +2251,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         nodestats::SetOpStart(stats);
+        ScopedAdaptiveShardCost adaptive_shard_cost(item.shard_cost);
 
         if (TF_PREDICT_FALSE(
                 MightTrace(item, event_collector_, trace_using_annotations_))) {
@@ -1879,12 +2327,44 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_nsec) {
       // Postprocess.
       completed = NodeDone(s, item.node, ready, stats, &inline_ready);
     }
+
+    if (inline_ready.empty() && work_stealing_queue_ != nullptr &&
+        !completed) {
+      // Keep running the consumers this thread made ready, rather than
+      // leaving them to whichever thread picks up their closures.
+      work_stealing_queue_->PopLocal(&inline_ready);
+    }
+    if (inline_ready.empty() && priority_queue_ != nullptr && !completed) {
+      // Run the most critical queued node rather than return to the runner,
+      // which would run the oldest closure.
+      priority_queue_->Pop(&inline_ready);
+    }
   }  // while !inline_ready.empty()
 
   // This thread of computation is done if completed = true.
   if (completed) ScheduleFinish();
 }
 
+void ExecutorState::CopyInputsOutOfStepArena(const NodeItem& item,
+                                             Entry* first_input) {
+  for (int i = 0; i < item.num_inputs; ++i) {
+    Entry* entry = first_input + i;
+    // Refs point to persistent tensors, which never live in the arena.
+    if (!entry->has_value || !entry->val_field_is_set) continue;
+    Tensor* val = entry->val.get();
+    if (!val->IsInitialized() || !DataTypeCanUseMemcpy(val->dtype()) ||
+        val->TotalBytes() == 0 ||
+        !step_arena_->Owns(val->tensor_data().data())) {
+      continue;
+    }
+    Tensor copy(impl_->params_.device->GetAllocator(entry->alloc_attr),
+                val->dtype(), val->shape());
+    memcpy(const_cast<char*>(copy.tensor_data().data()),
+           val->tensor_data().data(), val->TotalBytes());
+    *val = std::move(copy);
+  }
+}
+
 Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
                                     TensorValueVec* inputs,
                                     DeviceContextVec* input_device_contexts,
@@ -2275,15 +2755,36 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     scheduled_nsec = nodestats::NowInNsec();
   }
 
+  // The closures for runner_ are dispatched together, so that the thread pool
+  // can wake up fewer threads for them.
+  std::vector<Executor::Args::Closure> batch;
+  std::vector<Executor::Args::Closure>* batch_ptr =
+      batch_runner_ != nullptr ? &batch : nullptr;
+
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_nsec); });
+      RunOnRunner(tagged_node, scheduled_nsec, batch_ptr);
     }
+    FlushBatch(&batch);
     return;
   }
 
   const GraphView& gview = impl_->gview_;
+  if (priority_queue_ != nullptr) {
+    // Inline the inexpensive nodes, and leave it to the queue to pick the
+    // expensive node that this thread runs next.
+    for (auto& tagged_node : ready) {
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !item.kernel->IsExpensive()) {
+        inline_ready->push_back(tagged_node);
+      } else {
+        priority_queue_->Push(tagged_node, scheduled_nsec);
+      }
+    }
+    return;
+  }
+
   const TaggedNode* curr_expensive_node = nullptr;
   for (auto& tagged_node : ready) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
@@ -2294,8 +2795,7 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_nsec));
+        RunOnRunner(*curr_expensive_node, scheduled_nsec, batch_ptr);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2307,10 +2807,175 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_nsec));
+      RunOnRunner(*curr_expensive_node, scheduled_nsec, batch_ptr);
     }
   }
+  FlushBatch(&batch);
+}
+
+void ExecutorState::RunOnRunner(const TaggedNode& tagged_node,
+                                int64 scheduled_nsec,
+                                std::vector<Executor::Args::Closure>* batch) {
+  if (work_stealing_queue_ != nullptr) {
+    work_stealing_queue_->Push(tagged_node, scheduled_nsec);
+  } else if (priority_queue_ != nullptr) {
+    priority_queue_->Push(tagged_node, scheduled_nsec);
+  } else if (batch != nullptr) {
+    batch->push_back(std::bind(&ExecutorState::Process, this, tagged_node,
+                               scheduled_nsec));
+  } else {
+    runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                      scheduled_nsec));
+  }
+}
+
+void ExecutorState::FlushBatch(std::vector<Executor::Args::Closure>* batch) {
+  if (batch->size() == 1) {
+    runner_(std::move((*batch)[0]));
+  } else if (!batch->empty()) {
+    batch_runner_(std::move(*batch));
+  }
+  batch->clear();
+}
+
+ExecutorState::WorkStealingQueue::WorkStealingQueue(ExecutorState* state,
+                                                    int num_deques)
+    : state_(state),
+      num_deques_(std::max(num_deques, 1)),
+      numa_aware_(port::NUMAEnabled() && port::NUMANumNodes() > 1),
+      deques_(new Deque[num_deques_]) {}
+
+int ExecutorState::WorkStealingQueue::CurrentSlot() {
+  static std::atomic<int> next_slot(0);
+  thread_local const int slot =
+      next_slot.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+int ExecutorState::WorkStealingQueue::CurrentNUMANode() {
+  thread_local const int node =
+      std::max(port::NUMAGetThreadNodeAffinity(), 0);
+  return node;
+}
+
+void ExecutorState::WorkStealingQueue::Push(const TaggedNode& node,
+                                            int64 scheduled_nsec) {
+  Deque* d = LocalDeque();
+  {
+    mutex_lock l(d->mu);
+    d->nodes.push_back(QueuedNode{node, scheduled_nsec});
+    d->size.fetch_add(1, std::memory_order_release);
+  }
+  if (numa_aware_) {
+    d->numa_node.store(CurrentNUMANode(), std::memory_order_relaxed);
+  }
+  // The runner may invoke the closure inline, so "state_" must not be
+  // touched after this call.
+  Ref();
+  state_->runner_([this]() {
+    RunOne();
+    Unref();
+  });
+}
+
+bool ExecutorState::WorkStealingQueue::PopLocal(
+    TaggedNodeReadyQueue* inline_ready) {
+  Deque* d = LocalDeque();
+  if (d->size.load(std::memory_order_acquire) == 0) return false;
+  mutex_lock l(d->mu);
+  if (d->front == d->nodes.size()) return false;
+  inline_ready->push_back(d->nodes.back().node);
+  d->nodes.pop_back();
+  if (d->front == d->nodes.size()) {
+    d->nodes.clear();
+    d->front = 0;
+  }
+  d->size.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ExecutorState::WorkStealingQueue::StealFrom(Deque* d, QueuedNode* out) {
+  if (d->size.load(std::memory_order_acquire) == 0) return false;
+  mutex_lock l(d->mu);
+  if (d->front == d->nodes.size()) return false;
+  *out = d->nodes[d->front++];
+  if (d->front == d->nodes.size()) {
+    d->nodes.clear();
+    d->front = 0;
+  }
+  d->size.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ExecutorState::WorkStealingQueue::Steal(int numa_node, QueuedNode* out) {
+  // Start right after the caller's own deque so that concurrent thieves
+  // spread out over the victims.
+  const int start = CurrentSlot() % num_deques_;
+  if (numa_aware_) {
+    for (int i = 0; i < num_deques_; ++i) {
+      Deque* d = &deques_[(start + i) % num_deques_];
+      if (d->numa_node.load(std::memory_order_relaxed) == numa_node &&
+          StealFrom(d, out)) {
+        return true;
+      }
+    }
+  }
+  for (int i = 0; i < num_deques_; ++i) {
+    if (StealFrom(&deques_[(start + i) % num_deques_], out)) return true;
+  }
+  return false;
+}
+
+void ExecutorState::WorkStealingQueue::RunOne() {
+  QueuedNode queued{TaggedNode(nullptr, nullptr, -1, false), 0};
+  if (Steal(numa_aware_ ? CurrentNUMANode() : 0, &queued)) {
+    state_->Process(queued.node, queued.scheduled_nsec);
+  }
+}
+
+void ExecutorState::PriorityQueue::Push(const TaggedNode& node,
+                                        int64 scheduled_nsec) {
+  const int64 priority = state_->impl_->gview_.node(node.node->id())->priority;
+  {
+    mutex_lock l(mu_);
+    nodes_.push_back(
+        QueuedNode{node, scheduled_nsec, priority, next_sequence_++});
+    std::push_heap(nodes_.begin(), nodes_.end());
+  }
+  // The runner may invoke the closure inline, so "state_" must not be
+  // touched after this call.
+  Ref();
+  state_->runner_([this]() {
+    RunOne();
+    Unref();
+  });
+}
+
+bool ExecutorState::PriorityQueue::PopLocked(QueuedNode* out) {
+  if (nodes_.empty()) return false;
+  std::pop_heap(nodes_.begin(), nodes_.end());
+  *out = nodes_.back();
+  nodes_.pop_back();
+  return true;
+}
+
+bool ExecutorState::PriorityQueue::Pop(TaggedNodeReadyQueue* inline_ready) {
+  QueuedNode queued{TaggedNode(nullptr, nullptr, -1, false), 0, 0, 0};
+  {
+    mutex_lock l(mu_);
+    if (!PopLocked(&queued)) return false;
+  }
+  inline_ready->push_back(queued.node);
+  return true;
+}
+
+void ExecutorState::PriorityQueue::RunOne() {
+  QueuedNode queued{TaggedNode(nullptr, nullptr, -1, false), 0, 0, 0};
+  {
+    mutex_lock l(mu_);
+    if (!PopLocked(&queued)) return;
+  }
+  state_->Process(queued.node, queued.scheduled_nsec);
 }
 
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
@@ -2908,6 +3573,74 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+// Creates executors that run with a fixed set of ExecutorImpl::Options.
+class OptionsExecutorFactory : public ExecutorFactory {
+ public:
+  explicit OptionsExecutorFactory(const ExecutorImpl::Options& options)
+      : options_(options) {}
+
+  Status NewExecutor(const LocalExecutorParams& params,
+                     std::unique_ptr<const Graph> graph,
+                     std::unique_ptr<Executor>* out_executor) override {
+    std::unique_ptr<ExecutorImpl> impl(
+        new ExecutorImpl(params, std::move(graph), options_));
+    TF_RETURN_IF_ERROR(impl->Initialize());
+    *out_executor = std::move(impl);
+    return Status::OK();
+  }
+
+ private:
+  const ExecutorImpl::Options options_;
+};
+
+// Registers the default executor with each combination of the modes below,
+// under the names of the modes joined by '+' in this order, followed by
+// "_EXECUTOR". E.g. "WORK_STEALING_EXECUTOR" or
+// "WORK_STEALING+CRITICAL_PATH_EXECUTOR".
+class OptionsExecutorRegistrar {
+ public:
+  OptionsExecutorRegistrar() {
+    struct Mode {
+      const char* name;
+      void (*enable)(ExecutorImpl::Options*);
+    };
+    const std::vector<Mode> modes = {
+        // Ready nodes are dispatched through per-thread deques with work
+        // stealing.
+        {"WORK_STEALING",
+         [](ExecutorImpl::Options* o) { o->work_stealing = true; }},
+        // Kernel outputs and temporaries that cannot outlive the step are
+        // allocated from a step-scoped arena.
+        {"STEP_ARENA", [](ExecutorImpl::Options* o) { o->step_arena = true; }},
+        // As STEP_ARENA, and the outputs whose shapes are known are placed
+        // according to a static memory plan.
+        {"STATIC_MEMORY_PLAN",
+         [](ExecutorImpl::Options* o) {
+           o->step_arena = true;
+           o->static_memory_plan = true;
+         }},
+        // Ready nodes are run in order of their critical path to the end of
+        // the graph.
+        {"CRITICAL_PATH",
+         [](ExecutorImpl::Options* o) { o->critical_path_priorities = true; }},
+    };
+    for (uint32 mask = 1; mask < (1u << modes.size()); ++mask) {
+      ExecutorImpl::Options options;
+      std::vector<string> names;
+      for (size_t i = 0; i < modes.size(); ++i) {
+        if (mask & (1u << i)) {
+          modes[i].enable(&options);
+          names.push_back(modes[i].name);
+        }
+      }
+      ExecutorFactory::Register(
+          strings::StrCat(str_util::Join(names, "+"), "_EXECUTOR"),
+          new OptionsExecutorFactory(options));
+    }
+  }
+};
+static OptionsExecutorRegistrar options_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -28,6 +28,10 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 
+namespace Eigen {
+class ThreadPoolInterface;
+}  // namespace Eigen
+
 namespace tensorflow {
 
 class StepStatsCollector;
@@ -104,6 +108,18 @@ class Executor {
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
+
+    // If not null, the executor hands the closures that become runnable
+    // together to "batch_runner" at once instead of one by one to "runner",
+    // so that the thread pool can coalesce the wakeups of its threads.
+    typedef std::function<void(std::vector<Closure>)> BatchRunner;
+    BatchRunner batch_runner = nullptr;
+
+    // If not null, the kernels run on a CPU device schedule their intra-op
+    // work on this pool instead of the device's, using at most
+    // "user_intra_op_parallelism" of its threads at once.
+    Eigen::ThreadPoolInterface* user_intra_op_threadpool = nullptr;
+    int user_intra_op_parallelism = 0;
   };
   typedef std::function<void(const Status&)> DoneCallback;
   virtual void RunAsync(const Args& args, DoneCallback done) = 0;
@@ -141,6 +157,11 @@ struct LocalExecutorParams {
   std::function<void(OpKernel*)> delete_kernel;
 
   Executor::RendezvousFactory rendezvous_factory;
+
+  // If true, the Shard() calls of each kernel on a CPU device pick their
+  // number of shards from the measured cost of the kernel's earlier calls.
+  // See AdaptiveShardCost.
+  bool adaptive_sharding = false;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       std::unique_ptr<const Graph> graph,
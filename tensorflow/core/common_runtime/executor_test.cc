@@ -19,18 +19,24 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/tracing.h"
@@ -57,7 +63,8 @@ class ExecutorTest : public ::testing::Test {
   }
 
   // Resets executor_ with a new executor based on a graph 'gdef'.
-  void Create(std::unique_ptr<const Graph> graph) {
+  void Create(std::unique_ptr<const Graph> graph,
+              const string& executor_type = "") {
     const int version = graph->versions().producer();
     LocalExecutorParams params;
     params.device = device_.get();
@@ -77,7 +84,9 @@ class ExecutorTest : public ::testing::Test {
       return Status::OK();
     };
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, std::move(graph), &exec_));
+    std::unique_ptr<Executor> exec;
+    TF_CHECK_OK(NewExecutor(executor_type, params, std::move(graph), &exec));
+    exec_ = exec.release();
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -207,7 +216,7 @@ TEST_F(ExecutorTest, SelfAdd) {
 //     (a + a) + (a + a)
 //     ((a + a) + a) + a
 // are all possibly generated.
-void BuildTree(int N, Graph* g) {
+void BuildTree(int N, Graph* g, const string& leaf_op = "Identity") {
   CHECK_GT(N, 1);
   // A single input node "in".
   auto in = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
@@ -215,7 +224,7 @@ void BuildTree(int N, Graph* g) {
   int i = 0;
   // Duplicate "in" N times. Each copies is named as l0, l1, l2, ....
   for (; i < N; ++i) {
-    nodes.push_back(test::graph::Identity(g, in, 0));
+    nodes.push_back(test::graph::Unary(g, leaf_op, in));
   }
   random::PhiloxRandom philox(testing::RandomSeed(), 17);
   random::SimplePhilox rnd(&philox);
@@ -250,6 +259,158 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  Create(std::move(g), "WORK_STEALING_EXECUTOR");
+  Rendezvous::Args args;
+  for (int iters = 0; iters < 4; ++iters) {
+    TF_ASSERT_OK(
+        rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
+TEST_F(ExecutorTest, RandomTreeCriticalPath) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), "CRITICAL_PATH_EXECUTOR");
+  Rendezvous::Args args;
+  for (int iters = 0; iters < 4; ++iters) {
+    TF_ASSERT_OK(
+        rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
+TEST_F(ExecutorTest, RandomTreeCombinedModes) {
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(4096, g.get());
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), "WORK_STEALING+STEP_ARENA+CRITICAL_PATH_EXECUTOR");
+  Rendezvous::Args args;
+  for (int iters = 0; iters < 4; ++iters) {
+    TF_ASSERT_OK(
+        rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez_));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+  }
+}
+
+// Copies its input through a temporary into its output, and records the
+// names of the allocators that served both.
+REGISTER_OP("StepArenaProbe").Input("x: float").Output("y: float");
+
+static mutex step_arena_probe_mu(LINKER_INITIALIZED);
+static std::vector<string>* step_arena_probe_allocators
+    GUARDED_BY(step_arena_probe_mu) = new std::vector<string>;
+
+string AllocatorName(const Tensor& t) {
+  TensorDescription description;
+  t.FillDescription(&description);
+  return description.allocation_description().allocator_name();
+}
+
+class StepArenaProbeOp : public OpKernel {
+ public:
+  explicit StepArenaProbeOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& x = ctx->input(0);
+    Tensor tmp;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, x.shape(), &tmp));
+    tmp.flat<float>() = x.flat<float>();
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, x.shape(), &y));
+    y->flat<float>() = tmp.flat<float>();
+    mutex_lock l(step_arena_probe_mu);
+    step_arena_probe_allocators->push_back(AllocatorName(tmp));
+    step_arena_probe_allocators->push_back(AllocatorName(*y));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("StepArenaProbe").Device(DEVICE_CPU),
+                        StepArenaProbeOp);
+
+TEST_F(ExecutorTest, RandomTreeStepArena) {
+  const int N = 256;
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  BuildTree(N, g.get(), "StepArenaProbe");
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), "STEP_ARENA_EXECUTOR");
+  // Run without a stats collector: allocations are not served from the arena
+  // while they are being tracked.
+  Executor::Args exec_args;
+  exec_args.rendezvous = rendez_;
+  exec_args.runner = runner_;
+  Rendezvous::Args args;
+  for (int iters = 0; iters < 4; ++iters) {
+    {
+      mutex_lock l(step_arena_probe_mu);
+      step_arena_probe_allocators->clear();
+    }
+    TF_ASSERT_OK(
+        rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(exec_->Run(exec_args));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    EXPECT_EQ(static_cast<float>(N), V(out));
+    // The result was copied out of the arena before _Send handed it over.
+    EXPECT_NE("step_arena", AllocatorName(out));
+
+    mutex_lock l(step_arena_probe_mu);
+    ASSERT_EQ(2 * N, step_arena_probe_allocators->size());
+    for (const string& name : *step_arena_probe_allocators) {
+      EXPECT_EQ("step_arena", name);
+    }
+  }
+}
+
+TEST_F(ExecutorTest, StaticMemoryPlan) {
+  // A chain of ops with statically known shapes, whose outputs are planned.
+  std::unique_ptr<Graph> g(new Graph(OpRegistry::Global()));
+  Tensor t(DT_FLOAT, TensorShape({1024}));
+  t.flat<float>().setConstant(1.0);
+  Node* last = test::graph::Constant(g.get(), t);
+  for (int i = 0; i < 10; ++i) {
+    last = test::graph::Add(g.get(), last, last);
+  }
+  test::graph::Send(g.get(), last, "b", BOB, 1, ALICE);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g), "STATIC_MEMORY_PLAN_EXECUTOR");
+  Executor::Args exec_args;
+  exec_args.rendezvous = rendez_;
+  exec_args.runner = runner_;
+  Rendezvous::Args args;
+  for (int iters = 0; iters < 4; ++iters) {
+    TF_ASSERT_OK(exec_->Run(exec_args));
+    Tensor out;
+    bool is_dead = false;
+    TF_ASSERT_OK(rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out,
+                               &is_dead));
+    ASSERT_EQ(out.NumElements(), 1024);
+    EXPECT_EQ(1024.0, out.flat<float>()(0));
+    EXPECT_EQ(1024.0, out.flat<float>()(1023));
+    // The last Add wrote its output to the planned buffer.
+    EXPECT_EQ("static_memory_slab", AllocatorName(out));
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -420,7 +581,8 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
 // Create a graph that is 'depth' deep. At each level, fan-in and fan-out a
 // maximum of 'width' nodes. All nodes are no-ops and all dependencies are
 // control dependencies.
-static void BM_executor(int iters, int width, int depth) {
+static void RunExecutorBenchmark(int iters, int width, int depth,
+                                 const char* executor_type) {
 #ifdef PLATFORM_GOOGLE
   BenchmarkUseRealTime();
 #endif  // PLATFORM_GOOGLE
@@ -454,19 +616,33 @@ static void BM_executor(int iters, int width, int depth) {
   SetBenchmarkLabel(strings::StrCat("Nodes = ", cur));
   SetBenchmarkItemsProcessed(cur * static_cast<int64>(iters));
 #endif  // PLATFORM_GOOGLE
-  test::Benchmark("cpu", g).Run(iters);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, executor_type)
+      .Run(iters);
+}
+
+static void BM_executor(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "");
+}
+
+static void BM_executor_work_stealing(int iters, int width, int depth) {
+  RunExecutorBenchmark(iters, width, depth, "WORK_STEALING_EXECUTOR");
 }
 
 // Tall skinny graphs
 BENCHMARK(BM_executor)->ArgPair(16, 1024);
 BENCHMARK(BM_executor)->ArgPair(32, 8192);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(16, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(32, 8192);
 
 // Short fat graphs
 BENCHMARK(BM_executor)->ArgPair(1024, 16);
 BENCHMARK(BM_executor)->ArgPair(8192, 32);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 16);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(8192, 32);
 
 // Tall fat graph
 BENCHMARK(BM_executor)->ArgPair(1024, 1024);
+BENCHMARK(BM_executor_work_stealing)->ArgPair(1024, 1024);
 
 static void BM_FeedInputFetchOutput(int iters) {
   Graph* g = new Graph(OpRegistry::Global());
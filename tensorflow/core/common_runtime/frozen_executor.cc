@@ -0,0 +1,449 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/frozen_executor.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/gtl/manual_constructor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/tensor_slice_reader_cache.h"
+
+namespace tensorflow {
+namespace {
+
+typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
+typedef gtl::InlinedVector<DeviceContext*, 4> DeviceContextVec;
+typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
+
+class FrozenExecutorImpl : public Executor {
+ public:
+  explicit FrozenExecutorImpl(const LocalExecutorParams& params)
+      : params_(params) {}
+
+  ~FrozenExecutorImpl() override {
+    for (const KernelState& kernel_state : kernels_) {
+      if (kernel_state.kernel != nullptr) {
+        params_.delete_kernel(kernel_state.kernel);
+      }
+    }
+  }
+
+  // Computes the static schedule for `graph`. Returns an `Unimplemented`
+  // error if `graph` uses a feature this executor does not support.
+  Status Initialize(const Graph& graph);
+
+  // Takes ownership of the graph that was passed to `Initialize()`, whose
+  // nodes are referenced when collecting step stats.
+  void set_graph(std::unique_ptr<const Graph> graph) {
+    graph_ = std::move(graph);
+  }
+
+  void RunAsync(const Args& args, DoneCallback done) override;
+
+ private:
+  // Represents cached graph structure state for each kernel.
+  struct KernelState {
+    // Owned, but created and destroyed through `params_`.
+    OpKernel* kernel = nullptr;
+    const Node* node = nullptr;
+
+    // The inputs of `kernel` are `slots[input_start, input_start +
+    // num_inputs)` of the per-step `RunState`.
+    int input_start = 0;
+    int num_inputs = 0;
+    int num_outputs = 0;
+
+    // The `j`th output of `kernel` is copied to the slots listed in
+    // `output_locations_[output_offsets_[output_offset + j],
+    // output_offsets_[output_offset + j + 1])`, and is allocated with
+    // `output_alloc_attrs_[output_offset + j]`.
+    int output_offset = 0;
+  };
+
+  // Per-step buffers. They are returned to `free_run_states_` at the end of
+  // each step, so that concurrent steps each get their own and sequential
+  // steps reuse the same ones.
+  struct RunState {
+    explicit RunState(size_t num_slots) : slots(num_slots) {}
+
+    // One slot per kernel input, filled when the producer of the input runs
+    // and destroyed right after the consumer has run.
+    std::vector<ManualConstructor<Tensor>> slots;
+
+    TensorValueVec node_inputs;
+    DeviceContextVec input_device_contexts;
+    AllocatorAttributeVec input_alloc_attrs;
+  };
+
+  std::unique_ptr<RunState> AcquireRunState() {
+    {
+      mutex_lock l(mu_);
+      if (!free_run_states_.empty()) {
+        std::unique_ptr<RunState> state = std::move(free_run_states_.back());
+        free_run_states_.pop_back();
+        return state;
+      }
+    }
+    return absl::make_unique<RunState>(total_num_inputs_);
+  }
+
+  void ReleaseRunState(std::unique_ptr<RunState> state) {
+    mutex_lock l(mu_);
+    free_run_states_.push_back(std::move(state));
+  }
+
+  // Destroys the slots that were filled by kernels `[0, i)` but whose
+  // consumers have not run, i.e. the live slots after kernel `i` failed.
+  void DestroyLiveSlots(size_t i, RunState* state) const;
+
+  LocalExecutorParams params_;
+  std::unique_ptr<const Graph> graph_;
+
+  // All following members are read-only after Initialize().
+
+  // Kernels, in the order in which they are run.
+  std::vector<KernelState> kernels_;
+
+  // Flattened mapping from kernel outputs to input slots. See `KernelState`.
+  std::vector<int> output_offsets_;
+  std::vector<int> output_locations_;
+  std::vector<AllocatorAttributes> output_alloc_attrs_;
+
+  // Memory space information for each input slot.
+  std::vector<AllocatorAttributes> input_alloc_attrs_;
+
+  // The sum of the number of inputs for each node in the graph.
+  size_t total_num_inputs_ = 0;
+
+  mutex mu_;
+  std::vector<std::unique_ptr<RunState>> free_run_states_ GUARDED_BY(mu_);
+};
+
+Status FrozenExecutorImpl::Initialize(const Graph& graph) {
+  if (params_.device->device_type() != DEVICE_CPU) {
+    return errors::Unimplemented(
+        "Frozen executor only supports CPU devices, but got ",
+        params_.device->name());
+  }
+
+  // A reverse post-order keeps each producer close to its consumers, which
+  // keeps the lifetime of the slots between them short.
+  std::vector<Node*> ordered_nodes;
+  ordered_nodes.reserve(graph.num_nodes());
+  GetReversePostOrder(graph, &ordered_nodes);
+  if (ordered_nodes.size() != graph.num_nodes()) {
+    return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                   " but reverse post-order had ",
+                                   ordered_nodes.size());
+  }
+
+  for (Node* n : ordered_nodes) {
+    if (n->IsControlFlow()) {
+      return errors::Unimplemented(
+          "Frozen executor does not support control flow, but saw node ",
+          n->name());
+    }
+    if (n->IsSend() || n->IsHostSend() || n->IsRecv() || n->IsHostRecv()) {
+      return errors::Unimplemented(
+          "Frozen executor does not support partitioned graphs, but saw "
+          "send/recv node ",
+          n->name());
+    }
+    if (n->IsCollective()) {
+      return errors::Unimplemented(
+          "Frozen executor does not support collective ops, but saw node ",
+          n->name());
+    }
+    for (DataType dt : n->output_types()) {
+      if (IsRefType(dt)) {
+        return errors::Unimplemented(
+            "Frozen executor does not support reference-typed edges, but saw "
+            "type ",
+            DataTypeString(dt), " in outputs of node ", n->name());
+      }
+    }
+  }
+
+  std::unordered_map<const Node*, size_t> node_to_index_map;
+  kernels_.resize(ordered_nodes.size());
+  int input_start = 0;
+  int output_offset = 0;
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    Node* n = ordered_nodes[i];
+    node_to_index_map[n] = i;
+
+    KernelState& kernel_state = kernels_[i];
+    TF_RETURN_IF_ERROR(params_.create_kernel(n->def(), &kernel_state.kernel));
+    if (kernel_state.kernel->AsAsync() != nullptr) {
+      return errors::Unimplemented(
+          "Frozen executor does not support asynchronous kernels, but saw "
+          "node ",
+          n->name());
+    }
+    kernel_state.node = n;
+    kernel_state.num_inputs = n->num_inputs();
+    kernel_state.num_outputs = n->num_outputs();
+    kernel_state.input_start = input_start;
+    kernel_state.output_offset = output_offset;
+    input_start += kernel_state.num_inputs;
+    output_offset += kernel_state.num_outputs;
+  }
+  total_num_inputs_ = input_start;
+
+  // Flatten the mapping from each node output to the input slots of the
+  // corresponding destination nodes.
+  std::vector<std::vector<int>> locations(output_offset);
+  for (size_t i = 0; i < ordered_nodes.size(); ++i) {
+    const KernelState& kernel_state = kernels_[i];
+    for (const Edge* e : ordered_nodes[i]->out_edges()) {
+      if (e->IsControlEdge()) continue;
+      const KernelState& dst_state = kernels_[node_to_index_map[e->dst()]];
+      locations[kernel_state.output_offset + e->src_output()].push_back(
+          dst_state.input_start + e->dst_input());
+    }
+  }
+  output_offsets_.reserve(output_offset + 1);
+  output_offsets_.push_back(0);
+  for (const std::vector<int>& output_locations : locations) {
+    output_locations_.insert(output_locations_.end(), output_locations.begin(),
+                             output_locations.end());
+    output_offsets_.push_back(output_locations_.size());
+  }
+
+  // Compute allocator attributes for each node output, and corresponding
+  // node input.
+  output_alloc_attrs_.resize(output_offset);
+  input_alloc_attrs_.resize(total_num_inputs_);
+  for (const KernelState& kernel_state : kernels_) {
+    const OpKernel* op_kernel = kernel_state.kernel;
+    for (int j = 0; j < kernel_state.num_outputs; ++j) {
+      const int index = kernel_state.output_offset + j;
+      DCHECK_LT(j, op_kernel->output_memory_types().size());
+      if (op_kernel->output_memory_types()[j] == HOST_MEMORY) {
+        AllocatorAttributes h;
+        h.set_on_host(true);
+        output_alloc_attrs_[index].Merge(h);
+      }
+      for (int k = output_offsets_[index]; k < output_offsets_[index + 1];
+           ++k) {
+        input_alloc_attrs_[output_locations_[k]] = output_alloc_attrs_[index];
+      }
+    }
+  }
+  return Status::OK();
+}
+
+void FrozenExecutorImpl::DestroyLiveSlots(size_t i, RunState* state) const {
+  const int first_live_slot = kernels_[i].input_start;
+  for (size_t j = 0; j < i; ++j) {
+    const KernelState& executed_kernel_state = kernels_[j];
+    const int begin = output_offsets_[executed_kernel_state.output_offset];
+    const int end = output_offsets_[executed_kernel_state.output_offset +
+                                    executed_kernel_state.num_outputs];
+    for (int k = begin; k < end; ++k) {
+      // Only destroy a slot if it is an input to a kernel that has not yet
+      // executed (including kernel `i`, whose inputs are still live).
+      if (output_locations_[k] >= first_live_slot) {
+        state->slots[output_locations_[k]].Destroy();
+      }
+    }
+  }
+}
+
+void FrozenExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
+  std::unique_ptr<RunState> state = AcquireRunState();
+  checkpoint::TensorSliceReaderCacheWrapper slice_reader_cache;
+
+  // Prepare the parameters that will be the same for all kernels.
+  OpKernelContext::Params params;
+  params.step_id = args.step_id;
+  Device* device = params_.device;
+  params.device = device;
+  params.log_memory = false;
+  params.record_tensor_accesses = false;
+  params.rendezvous = args.rendezvous;
+  params.create_rendezvous = &params_.rendezvous_factory;
+  params.collective_executor = args.collective_executor;
+  params.session_state = args.session_state;
+  params.session_handle = args.session_handle;
+  params.tensor_store = args.tensor_store;
+  params.cancellation_manager = args.cancellation_manager;
+  params.call_frame = args.call_frame;
+  params.function_library = params_.function_library;
+  params.resource_manager = device->resource_manager();
+  params.step_container = args.step_container;
+  params.slice_reader_cache = &slice_reader_cache;
+  params.inputs = &state->node_inputs;
+  params.input_device_contexts = &state->input_device_contexts;
+  params.input_alloc_attrs = &state->input_alloc_attrs;
+  Args::Runner runner_copy = args.runner;
+  params.runner = &runner_copy;
+  params.stats_collector = args.stats_collector;
+
+  // The graph is loop-free and has no dead tensors.
+  params.frame_iter = FrameAndIter(0, 0);
+  params.is_input_dead = false;
+  params.op_device_context = nullptr;
+  params.forward_from_array = nullptr;
+
+  Status s;
+  for (size_t i = 0; i < kernels_.size(); ++i) {
+    const KernelState& kernel_state = kernels_[i];
+    const int input_start = kernel_state.input_start;
+    const int num_inputs = kernel_state.num_inputs;
+    const int num_outputs = kernel_state.num_outputs;
+
+    NodeExecStatsInterface* stats = nullptr;
+    params.track_allocations = false;
+    if (args.stats_collector != nullptr) {
+      stats = args.stats_collector->CreateNodeExecStats(kernel_state.node);
+      if (stats != nullptr) {
+        params.track_allocations = stats->TrackAllocations();
+        stats->SetScheduled(Env::Default()->NowNanos());
+        stats->RecordExecutorStarted();
+      }
+    }
+
+    state->node_inputs.clear();
+    state->node_inputs.resize(num_inputs);
+    state->input_alloc_attrs.clear();
+    state->input_alloc_attrs.resize(num_inputs);
+    state->input_device_contexts.clear();
+    state->input_device_contexts.resize(num_inputs);
+    for (int j = 0; j < num_inputs; ++j) {
+      state->node_inputs[j].tensor = state->slots[input_start + j].get();
+      state->input_alloc_attrs[j] = input_alloc_attrs_[input_start + j];
+    }
+    params.op_kernel = kernel_state.kernel;
+    params.output_attr_array =
+        output_alloc_attrs_.data() + kernel_state.output_offset;
+    OpKernelContext ctx(&params, num_outputs);
+
+    if (stats != nullptr) stats->RecordComputeStarted();
+    device->Compute(kernel_state.kernel, &ctx);
+    if (stats != nullptr) stats->RecordComputeEnded();
+
+    s = ctx.status();
+    for (int j = 0; s.ok() && j < num_outputs; ++j) {
+      const Tensor* output = ctx.mutable_output(j);
+      if (output == nullptr) {
+        s = errors::Internal("Missing ", j, "-th output from ",
+                             FormatNodeForError(*kernel_state.node));
+      } else if (output->dtype() != kernel_state.kernel->output_type(j)) {
+        s = errors::Internal("Output ", j, " of type ",
+                             DataTypeString(output->dtype()),
+                             " does not match declared output type ",
+                             DataTypeString(kernel_state.kernel->output_type(j)),
+                             " for node ",
+                             FormatNodeForError(*kernel_state.node));
+      }
+    }
+    if (!s.ok()) {
+      if (stats != nullptr) {
+        stats->RecordExecutorEnded();
+        stats->Done(device->name());
+      }
+      DestroyLiveSlots(i, state.get());
+      break;
+    }
+
+    // Free the inputs to the current kernel: this is the end of their
+    // planned lifetime.
+    for (int j = 0; j < num_inputs; ++j) {
+      state->slots[input_start + j].Destroy();
+    }
+
+    // Forward the outputs of the kernel to the slots of subsequent kernels.
+    for (int j = 0; j < num_outputs; ++j) {
+      TensorValue val = ctx.release_output(j);
+      const int index = kernel_state.output_offset + j;
+      if (stats != nullptr) stats->SetOutput(j, val.tensor);
+      for (int k = output_offsets_[index]; k < output_offsets_[index + 1];
+           ++k) {
+        state->slots[output_locations_[k]].Init(*val.tensor);
+      }
+      delete val.tensor;
+    }
+
+    if (stats != nullptr) {
+      stats->SetMemory(&ctx);
+      stats->RecordExecutorEnded();
+      stats->Done(device->name());
+    }
+  }
+
+  ReleaseRunState(std::move(state));
+  if (s.ok() && args.sync_on_finish && device->AllowsSyncOnCompletion()) {
+    s = device->Sync();
+  }
+  done(s);
+}
+
+class FrozenExecutorRegistrar {
+ public:
+  FrozenExecutorRegistrar() {
+    ExecutorFactory::Register("FROZEN_EXECUTOR", new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params,
+                       std::unique_ptr<const Graph> graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      std::unique_ptr<FrozenExecutorImpl> impl =
+          absl::make_unique<FrozenExecutorImpl>(params);
+      const Status s = impl->Initialize(*graph);
+      if (errors::IsUnimplemented(s)) {
+        VLOG(1) << "Using the default executor: " << s;
+        impl.reset();
+        return tensorflow::NewExecutor("", params, std::move(graph),
+                                       out_executor);
+      }
+      TF_RETURN_IF_ERROR(s);
+      impl->set_graph(std::move(graph));
+      *out_executor = std::move(impl);
+      return Status::OK();
+    }
+  };
+};
+static FrozenExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewFrozenExecutor(const LocalExecutorParams& params,
+                         std::unique_ptr<const Graph> graph,
+                         Executor** executor) {
+  std::unique_ptr<FrozenExecutorImpl> impl =
+      absl::make_unique<FrozenExecutorImpl>(params);
+  TF_RETURN_IF_ERROR(impl->Initialize(*graph));
+  impl->set_graph(std::move(graph));
+  *executor = impl.release();
+  return Status::OK();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,60 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that replays a schedule for `graph` computed once,
+// at construction time.
+//
+// The executor is aimed at small, loop-free graphs that are run many times,
+// e.g. by `DirectSession::Run()` in serving, where the per-step bookkeeping
+// of the default executor (pending counts, frame and iteration states, and
+// atomics on every edge) dominates the cost of running the kernels. On
+// construction it:
+//
+// 1. computes a topological order of the nodes,
+// 2. assigns every node input a slot in a flat array, and flattens the
+//    mapping from each node output to the slots it feeds, and
+// 3. plans the lifetime of every slot: a slot is filled when its producer
+//    runs and released as soon as its (only) consumer has run.
+//
+// Each step then runs the kernels in that order on the caller thread, with no
+// synchronization between nodes. Per-step buffers are pooled and reused across
+// steps, so that steady-state steps do not allocate in the executor.
+//
+// The following are not supported, and `NewFrozenExecutor()` returns an
+// `Unimplemented` error for graphs that use them:
+//
+// 1. Control flow ("Switch", "Merge", "Enter", "Exit" and "NextIteration").
+// 2. Reference-typed edges.
+// 3. Partitioned graphs ("_Send" and "_Recv" nodes) and collective ops.
+// 4. Asynchronous kernels.
+// 5. Devices other than CPU.
+//
+// When created through `ExecutorFactory` as "FROZEN_EXECUTOR" (e.g. by
+// setting `ConfigProto.experimental.executor_type`), graphs that are not
+// supported fall back to the default executor.
+Status NewFrozenExecutor(const LocalExecutorParams& params,
+                         std::unique_ptr<const Graph> graph,
+                         Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_FROZEN_EXECUTOR_H_
@@ -0,0 +1,363 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+// Set true for greater intelligibility of debug mode log messages.
+#define READABLE_KEYS false
+
+namespace tensorflow {
+namespace {
+// Key to be used for BufRendezvous by HalvingDoublingReducer and its
+// subclasses.
+string HalvingDoublingBufKey(const string& exec_key, int subdiv, int step,
+                             int src_rank, int dst_rank) {
+  if (READABLE_KEYS) {
+    return strings::StrCat("halving_doubling(", exec_key, "):subdiv(", subdiv,
+                           "):step(", step, "):src(", src_rank, "):dst(",
+                           dst_rank, ")");
+  } else {
+    return strings::StrCat(exec_key, ":", subdiv, ":", step, ":", src_rank,
+                           ":", dst_rank);
+  }
+}
+}  // namespace
+
+HalvingDoublingReducer::HalvingDoublingReducer()
+    : col_ctx_(nullptr), col_params_(nullptr) {}
+
+Status HalvingDoublingReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HalvingDoublingReducer does not support ",
+                            col_params->instance.ToString());
+  }
+  // The final op is applied with a group size scalar in host memory.
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        col_params->instance.impl_details.collective_name,
+        " only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  std::vector<std::vector<int>>& perms =
+      col_params->instance.impl_details.subdiv_permutations;
+  perms.assign(1, std::vector<int>());
+  for (int di = 0; di < col_params->group.group_size; ++di) {
+    perms[0].push_back(di);
+  }
+  col_params->subdiv_rank.assign(1, col_params->default_rank);
+  VLOG(2) << collective_util::SubdivPermDebugString(*col_params);
+  return Status::OK();
+}
+
+Status HalvingDoublingReducer::InitializeCollectiveContext(
+    CollectiveContext* col_ctx) {
+  DCHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = &col_ctx->col_params;
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HalvingDoublingReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  Status s = PrepareOutput();
+  if (s.ok()) {
+    s = AllReduce(/*subdiv=*/0, /*finalize=*/true);
+  }
+  Finish(s, done);
+}
+
+Status HalvingDoublingReducer::PrepareOutput() {
+  // Start by copying input to output if they're not already the same, i.e. if
+  // we're not computing in-place on the input tensor.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    // We are running in a blockable thread and the callback can't block so
+    // just wait here on the copy.
+    Notification note;
+    Status status;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->input_device_context(0),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    TF_RETURN_IF_ERROR(status);
+  }
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, /*num_chunks=*/1,
+                                  col_ctx_->device->GetAllocator(attr)));
+  output_ = ca_->Value();
+  if (col_params_->final_op) {
+    group_size_tensor_ = ca_->Scalar(col_params_->group.group_size);
+  }
+  return Status::OK();
+}
+
+void HalvingDoublingReducer::Finish(const Status& s,
+                                    const StatusCallback& done) {
+  // Give up the Refs on the output before recovering it from the adapter.
+  output_ = Tensor();
+  if (s.ok()) {
+    ca_->ConsumeFinalValue(col_ctx_->output);
+  } else {
+    StartAbort(s);
+  }
+  done(s);
+}
+
+Status HalvingDoublingReducer::AllReduce(int subdiv, bool finalize) {
+  const int group_size = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations[subdiv].size());
+  const int rank = col_params_->subdiv_rank[subdiv];
+  DCHECK_GE(rank, 0);
+  // The devices that take part in the halving and doubling steps, whose
+  // number is the largest power of two not above the group size.
+  int num_participants = 1;
+  int num_halving_steps = 0;
+  while (num_participants * 2 <= group_size) {
+    num_participants *= 2;
+    ++num_halving_steps;
+  }
+  const int num_folded = group_size - num_participants;
+  const int unfold_step = 2 * num_halving_steps + 1;
+  VLOG(1) << "HalvingDoublingReducer::AllReduce device="
+          << col_ctx_->device_name << " subdiv=" << subdiv
+          << " rank=" << rank << " group_size=" << group_size;
+
+  // Fold the first 2 * num_folded devices in pairs: each even rank hands its
+  // value to the next odd rank, and waits for the result.
+  if (rank < 2 * num_folded) {
+    if (rank % 2 == 0) {
+      TF_RETURN_IF_ERROR(
+          Exchange(subdiv, /*step=*/0, rank + 1, &output_, nullptr));
+      return Exchange(subdiv, unfold_step, rank + 1, nullptr, &output_);
+    }
+    Tensor folded = TempTensor(output_.NumElements());
+    TF_RETURN_IF_ERROR(
+        Exchange(subdiv, /*step=*/0, rank - 1, nullptr, &folded));
+    TF_RETURN_IF_ERROR(Reduce(&output_, &folded));
+  }
+  const int virtual_rank =
+      (rank < 2 * num_folded) ? rank / 2 : rank - num_folded;
+  auto rank_of = [num_folded](int virtual_rank) {
+    return (virtual_rank < num_folded) ? 2 * virtual_rank + 1
+                                       : virtual_rank + num_folded;
+  };
+
+  // Reduce-scatter by recursive halving.  The output is divided in
+  // num_participants chunks, and [begin, end) are the chunks this device is
+  // responsible for.  Each step exchanges with the peer at twice the distance
+  // of the previous step, so that the largest ranges are exchanged between
+  // the nearest ranks.
+  struct Split {
+    int keep_begin;
+    int keep_end;
+    int give_begin;
+    int give_end;
+  };
+  std::vector<Split> splits;
+  int begin = 0;
+  int end = num_participants;
+  for (int i = 0; i < num_halving_steps; ++i) {
+    const int mid = begin + (end - begin) / 2;
+    const Split split = ((virtual_rank >> i) & 1) == 0
+                            ? Split{begin, mid, mid, end}
+                            : Split{mid, end, begin, mid};
+    Tensor give =
+        ChunkRange(num_participants, split.give_begin, split.give_end);
+    Tensor keep =
+        ChunkRange(num_participants, split.keep_begin, split.keep_end);
+    Tensor received = TempTensor(keep.NumElements());
+    TF_RETURN_IF_ERROR(Exchange(subdiv, /*step=*/1 + i,
+                                rank_of(virtual_rank ^ (1 << i)), &give,
+                                &received));
+    if (keep.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(Reduce(&keep, &received));
+    }
+    splits.push_back(split);
+    begin = split.keep_begin;
+    end = split.keep_end;
+  }
+
+  // The chunks this device is responsible for are now fully reduced.
+  if (finalize && col_params_->final_op) {
+    Tensor owned = ChunkRange(num_participants, begin, end);
+    if (owned.NumElements() > 0) {
+      TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+          col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+          col_params_->final_op.get(), &owned, &group_size_tensor_));
+    }
+  }
+
+  // All-gather by recursive doubling, retracing the halving steps.
+  for (int i = num_halving_steps - 1; i >= 0; --i) {
+    const Split& split = splits[i];
+    Tensor keep =
+        ChunkRange(num_participants, split.keep_begin, split.keep_end);
+    Tensor give =
+        ChunkRange(num_participants, split.give_begin, split.give_end);
+    TF_RETURN_IF_ERROR(Exchange(subdiv,
+                                /*step=*/1 + 2 * num_halving_steps - 1 - i,
+                                rank_of(virtual_rank ^ (1 << i)), &keep,
+                                &give));
+  }
+
+  // Hand the result back to the devices dropped by the fold.
+  if (rank < 2 * num_folded) {
+    TF_RETURN_IF_ERROR(
+        Exchange(subdiv, unfold_step, rank - 1, &output_, nullptr));
+  }
+  return Status::OK();
+}
+
+Status HalvingDoublingReducer::Exchange(int subdiv, int step, int peer_rank,
+                                        const Tensor* send_tensor,
+                                        Tensor* recv_tensor) {
+  const int rank = col_params_->subdiv_rank[subdiv];
+  const int peer_idx =
+      col_params_->instance.impl_details.subdiv_permutations[subdiv]
+                                                            [peer_rank];
+  Notification send_note;
+  Notification recv_note;
+  Status send_status;
+  Status recv_status;
+  if (send_tensor != nullptr && send_tensor->NumElements() > 0) {
+    string send_buf_key = HalvingDoublingBufKey(col_ctx_->exec_key, subdiv,
+                                                step, rank, peer_rank);
+    VLOG(3) << "DispatchSend " << send_buf_key << " from_device "
+            << col_ctx_->device_name << " to_device "
+            << col_params_->instance.device_names[peer_idx];
+    col_ctx_->col_exec->PostToPeer(
+        col_params_->instance.device_names[peer_idx],
+        col_params_->instance.task_names[peer_idx], send_buf_key,
+        col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), send_tensor,
+        col_ctx_->device_locality,
+        [this, &send_note, &send_status](const Status& s) {
+          if (!s.ok()) {
+            StartAbort(s);
+          }
+          send_status = s;
+          send_note.Notify();
+        });
+  } else {
+    send_note.Notify();
+  }
+  if (recv_tensor != nullptr && recv_tensor->NumElements() > 0) {
+    string recv_buf_key = HalvingDoublingBufKey(col_ctx_->exec_key, subdiv,
+                                                step, peer_rank, rank);
+    VLOG(3) << "DispatchRecv " << recv_buf_key << " from_device "
+            << col_params_->instance.device_names[peer_idx] << " to_device "
+            << col_ctx_->device_name;
+    col_ctx_->col_exec->RecvFromPeer(
+        col_params_->instance.device_names[peer_idx],
+        col_params_->instance.task_names[peer_idx],
+        col_params_->task.is_local[peer_idx], recv_buf_key, col_ctx_->device,
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->output_alloc_attr(0), recv_tensor,
+        col_ctx_->device_locality, 0 /*dev_to_dev_stream_index*/,
+        [this, &recv_note, &recv_status](const Status& s) {
+          if (!s.ok()) {
+            StartAbort(s);
+          }
+          recv_status = s;
+          recv_note.Notify();
+        });
+  } else {
+    recv_note.Notify();
+  }
+  send_note.WaitForNotification();
+  recv_note.WaitForNotification();
+  TF_RETURN_IF_ERROR(send_status);
+  return recv_status;
+}
+
+Status HalvingDoublingReducer::Reduce(Tensor* output, Tensor* input) {
+  return collective_util::ComputeBinOp(col_ctx_->op_ctx, col_ctx_->op_params,
+                                       col_ctx_->device,
+                                       col_params_->merge_op.get(), output,
+                                       input);
+}
+
+Tensor HalvingDoublingReducer::TempTensor(int64 num_elements) const {
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  return Tensor(col_ctx_->device->GetAllocator(attr), output_.dtype(),
+                TensorShape({num_elements}));
+}
+
+Tensor HalvingDoublingReducer::ChunkRange(int num_chunks, int begin,
+                                          int end) const {
+  const int64 total_elts = output_.NumElements();
+  // Chunks start on alignment boundaries, as required of the buffers backing
+  // the aliasing tensors.
+  const int64 chunk_elts = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(output_.dtype()), total_elts, num_chunks);
+  const int64 start = std::min(total_elts, begin * chunk_elts);
+  const int64 limit = std::min(total_elts, end * chunk_elts);
+  // As in CollectiveAdapter::ChunkAlias, take empty ranges from the front of
+  // the tensor to avoid an illegal offset.
+  return (start < limit) ? output_.Slice(start, limit) : output_.Slice(0, 0);
+}
+
+void HalvingDoublingReducer::StartAbort(const Status& s) {
+  // In abort mode we stop issuing additional exchanges, and the
+  // CollectiveExecutor cancels the outstanding ones on all devices.
+  bool abort_started = false;
+  {
+    mutex_lock l(status_mu_);
+    if (status_.ok()) {
+      LOG(ERROR) << "Aborting "
+                 << col_params_->instance.impl_details.collective_name
+                 << " with " << s;
+      abort_started = true;
+      status_.Update(s);
+    }
+  }
+  if (abort_started) {
+    col_ctx_->col_exec->StartAbort(s);
+  }
+}
+
+REGISTER_COLLECTIVE(HalvingDoublingReduce, HalvingDoublingReducer);
+
+}  // namespace tensorflow
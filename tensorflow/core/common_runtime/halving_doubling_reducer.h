@@ -0,0 +1,113 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// Recursive halving-doubling implementation of collective all-reduce.
+//
+// The devices first reduce-scatter the tensor by recursive halving: in step i
+// each device exchanges half of the tensor range it is responsible for with
+// the device whose rank differs in bit i, and reduces the half it keeps.
+// After log2(n) steps each device holds a fully reduced 1/n of the tensor,
+// which the devices then all-gather by recursive doubling.  This takes
+// 2 * log2(n) steps instead of the 2 * (n - 1) steps of the ring algorithm,
+// while sending the same number of bytes per device, which makes it the
+// better choice for small tensors and large groups where latency dominates.
+//
+// When the group size is not a power of two, the first 2 * r devices, where
+// r is the number of devices beyond the largest power of two, are first
+// folded in pairs, and the devices dropped by the fold receive the result at
+// the end.
+class HalvingDoublingReducer : public CollectiveImplementationInterface {
+ public:
+  HalvingDoublingReducer();
+  ~HalvingDoublingReducer() override = default;
+
+  // Establishes a single subdiv comprising all devices in default rank
+  // order, so that devices on the same task exchange the largest ranges.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(CollectiveContext* col_ctx) override;
+
+  // No-op for halving-doubling reducer.
+  Status InitializeCollectiveGroupRuntimeDetails(
+      CollGroupRuntimeDetails*) override {
+    return Status::OK();
+  }
+
+  // Begins async execution of the halving-doubling all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ protected:
+  // Copies the input to the output, if they differ, and prepares the output
+  // and the final op operand for `AllReduce`.
+  Status PrepareOutput();
+
+  // Moves the reduced value to the output and calls `done` with `s`.
+  void Finish(const Status& s, const StatusCallback& done);
+
+  // All-reduces the output among the devices of `subdiv` by recursive
+  // halving-doubling.  Applies the final op, if any, when `finalize` is true.
+  // Must only be called by devices that participate in `subdiv`.
+  Status AllReduce(int subdiv, bool finalize);
+
+  // Sends `send_tensor` to and receives `recv_tensor` from the device at
+  // `peer_rank` in `subdiv`, waiting for both.  Either may be null or empty,
+  // in which case it is skipped; the peer makes the symmetric call.  `step`
+  // distinguishes successive exchanges between the same pair of devices.
+  Status Exchange(int subdiv, int step, int peer_rank,
+                  const Tensor* send_tensor, Tensor* recv_tensor);
+
+  // Reduces `input` into `output` with the merge op.
+  Status Reduce(Tensor* output, Tensor* input);
+
+  // Returns a tensor with `num_elements` elements allocated on the device,
+  // to receive values that are reduced into the output.
+  Tensor TempTensor(int64 num_elements) const;
+
+  // Starts aborting the collective on all devices after an error.
+  void StartAbort(const Status& s);
+
+  CollectiveContext* col_ctx_;          // Not owned
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  // A flattened alias of the output.
+  Tensor output_;
+  Tensor group_size_tensor_;
+
+ private:
+  // Returns the elements of chunks [`begin`, `end`) of the output, when the
+  // output is divided in `num_chunks` aligned chunks.
+  Tensor ChunkRange(int num_chunks, int begin, int end) const;
+
+  mutex status_mu_;
+  Status status_ GUARDED_BY(status_mu_);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HALVING_DOUBLING_REDUCER_H_
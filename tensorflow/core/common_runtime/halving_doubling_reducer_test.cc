@@ -0,0 +1,403 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
+
+#include <atomic>
+#include "absl/memory/memory.h"
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/device_resolver_local.h"
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/test_collective_executor_mgr.h"
+#include "tensorflow/core/common_runtime/threadpool_device.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+// Wraps CollectiveRemoteAccessLocal with the ability to return an
+// error status to the N'th action.
+class FailTestRMA : public CollectiveRemoteAccessLocal {
+ public:
+  FailTestRMA(const DeviceMgr* dev_mgr, DeviceResolverInterface* dev_resolver,
+              int64 step_id, int fail_after)
+      : CollectiveRemoteAccessLocal(dev_mgr, dev_resolver, step_id),
+        fail_after_(fail_after) {}
+
+  bool MaybeFail(const StatusCallback& done) {
+    bool fail_now = false;
+    {
+      mutex_lock l(mu_);
+      if (fail_after_ > 0) {
+        fail_now = (--fail_after_ == 0);
+      }
+    }
+    if (fail_now) {
+      done(errors::Internal("Deliberate failure"));
+      return true;
+    }
+    return false;
+  }
+
+  void RecvFromPeer(const string& peer_device, const string& peer_task,
+                    bool peer_is_local, const string& key, Device* to_device,
+                    DeviceContext* to_device_ctx,
+                    const AllocatorAttributes& to_alloc_attr, Tensor* to_tensor,
+                    const DeviceLocality& client_locality,
+                    int dev_to_dev_stream_index,
+                    const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::RecvFromPeer(
+        peer_device, peer_task, peer_is_local, key, to_device, to_device_ctx,
+        to_alloc_attr, to_tensor, client_locality, dev_to_dev_stream_index,
+        done);
+  }
+
+  void PostToPeer(const string& peer_device, const string& peer_task,
+                  const string& key, Device* from_device,
+                  DeviceContext* from_device_ctx,
+                  const AllocatorAttributes& from_alloc_attr,
+                  const Tensor* from_tensor,
+                  const DeviceLocality& client_locality,
+                  const StatusCallback& done) override {
+    if (MaybeFail(done)) return;
+    CollectiveRemoteAccessLocal::PostToPeer(
+        peer_device, peer_task, key, from_device, from_device_ctx,
+        from_alloc_attr, from_tensor, client_locality, done);
+  }
+
+  mutex mu_;
+  int fail_after_ GUARDED_BY(mu_);
+};
+
+std::unique_ptr<OpKernel> GetKernel(const NodeDef& node, DeviceBase* device) {
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      DEVICE_CPU, device, device->GetAllocator(AllocatorAttributes()), node,
+      TF_GRAPH_DEF_VERSION, &status);
+  if (!status.ok()) {
+    LOG(FATAL) << status;
+  }
+  return k;
+}
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  NodeDefBuilder builder(strings::StrCat(op, "_node"), op);
+  TF_CHECK_OK(builder.Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  return GetKernel(node_def, device);
+}
+
+static int64 kStepId = 123;
+
+class HalvingDoublingReducerTest : public ::testing::Test {
+ protected:
+  ~HalvingDoublingReducerTest() override {
+    for (auto i : instances_) delete i;
+    if (col_exec_) col_exec_->Unref();
+  }
+
+  void Init(const string& collective_name, int num_workers, int num_devices,
+            DataType dtype, int fail_after) {
+    std::vector<std::unique_ptr<Device>> local_devices;
+    SessionOptions sess_opts;
+    sess_opts.env = Env::Default();
+    Bytes mem_limit(4 << 20);
+    DeviceLocality dev_locality;
+    for (int wi = 0; wi < num_workers; ++wi) {
+      for (int di = 0; di < num_devices; ++di) {
+        string dev_name =
+            strings::StrCat("/job:worker/replica:0/task:", wi, "/cpu:", di);
+        local_devices.push_back(absl::make_unique<ThreadPoolDevice>(
+            sess_opts, dev_name, mem_limit, dev_locality, cpu_allocator()));
+      }
+    }
+    dev_mgr_.reset(new DeviceMgr(std::move(local_devices)));
+    dev_resolver_.reset(new DeviceResolverLocal(dev_mgr_.get()));
+    rma_ = new FailTestRMA(dev_mgr_.get(), dev_resolver_.get(), kStepId,
+                           fail_after);
+    col_exec_ = new BaseCollectiveExecutor(&col_exec_mgr_, rma_, kStepId,
+                                           dev_mgr_.get(), &gpu_ring_order_);
+    col_params_.name = "test_collective";
+    col_params_.group.group_key = 5;
+    col_params_.group.device_type = DEVICE_CPU;
+    col_params_.group.group_size = num_workers * num_devices;
+    col_params_.group.num_tasks = num_workers;
+    col_params_.instance.instance_key = 17;
+    col_params_.instance.type = REDUCTION_COLLECTIVE;
+    col_params_.instance.impl_details.collective_name = collective_name;
+    col_params_.instance.data_type = dtype;
+    for (int wi = 0; wi < num_workers; ++wi) {
+      string task_name = strings::StrCat("/job:worker/replica:0/task:", wi);
+      for (int di = 0; di < num_devices; ++di) {
+        col_params_.instance.device_names.push_back(
+            strings::StrCat(task_name, "/cpu:", di));
+        col_params_.instance.task_names.push_back(task_name);
+        // This test runs in a single process so is_local is always true.
+        col_params_.task.is_local.push_back(true);
+      }
+    }
+    for (int rank = 0; rank < col_params_.group.group_size; ++rank) {
+      instances_.push_back(new DeviceInstance(rank, this));
+    }
+  }
+
+  template <typename T>
+  void RunTest(const string& collective_name, DataType dtype, int num_workers,
+               int num_devices, int tensor_len, int fail_after) {
+    Init(collective_name, num_workers, num_devices, dtype, fail_after);
+    const int group_size = num_workers * num_devices;
+    std::vector<T> expected(tensor_len, 0);
+    for (int di = 0; di < group_size; ++di) {
+      Tensor* t = &instances_[di]->tensor_;
+      *t = Tensor(dtype, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        // Multiples of the group size keep the mean exact for integer types.
+        T value = static_cast<T>((di * 10 + i) * group_size);
+        t->flat<T>()(i) = value;
+        expected[i] += value;
+      }
+    }
+    std::atomic<int> done(0);
+    for (DeviceInstance* instance : instances_) {
+      SchedClosure([instance, &done] {
+        instance->DoReduce();
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (int di = 0; di < group_size; ++di) {
+      if (fail_after > 0) {
+        // Confirm that every device terminated with the expected error.
+        EXPECT_NE(
+            instances_[di]->status_.error_message().find("Deliberate failure"),
+            string::npos);
+        continue;
+      }
+      TF_EXPECT_OK(instances_[di]->status_);
+      auto actual = instances_[di]->tensor_.flat<T>();
+      for (int i = 0; i < tensor_len; ++i) {
+        EXPECT_EQ(expected[i] / group_size, actual(i))
+            << "Mismatch at device " << di << " index " << i;
+      }
+    }
+  }
+
+  class DeviceInstance {
+   public:
+    DeviceInstance(int rank, HalvingDoublingReducerTest* parent)
+        : parent_(parent) {
+      const CollectiveParams& cp = parent_->col_params_;
+      TF_CHECK_OK(parent_->dev_mgr_->LookupDevice(
+          cp.instance.device_names[rank], &device_));
+      col_params_.name = cp.name;
+      col_params_.group = cp.group;
+      col_params_.instance = cp.instance;
+      col_params_.task.is_local = cp.task.is_local;
+      col_params_.default_rank = rank;
+      CollectiveImplementationInterface* impl;
+      TF_CHECK_OK(CollectiveRegistry::LookupParamResolverInstance(
+          cp.instance.impl_details.collective_name, &impl));
+      TF_CHECK_OK(impl->InitializeCollectiveParams(&col_params_));
+    }
+
+    void DoReduce() {
+      const DataType dtype = col_params_.instance.data_type;
+      col_params_.merge_op = GetBinOp("Add", dtype, device_);
+      col_params_.final_op = GetBinOp("Div", dtype, device_);
+
+      // Prepare an OpKernelContext.
+      OpKernelContext::Params op_params;
+      op_params.step_id = kStepId;
+      op_params.device = device_;
+      gtl::InlinedVector<TensorValue, 4> inputs;
+      inputs.push_back(TensorValue(&tensor_));
+      op_params.inputs = &inputs;
+      gtl::InlinedVector<AllocatorAttributes, 4> input_aa(
+          {AllocatorAttributes()});
+      op_params.input_alloc_attrs = &input_aa;
+      DeviceContext* dev_ctx = new DeviceContext;
+      gtl::InlinedVector<DeviceContext*, 4> input_dc({dev_ctx});
+      op_params.input_device_contexts = &input_dc;
+      op_params.op_device_context = dev_ctx;
+      int forward_from = 0;
+      op_params.forward_from_array = &forward_from;
+      AllocatorAttributes generic_alloc_attr;
+      op_params.output_attr_array = &generic_alloc_attr;
+      std::unique_ptr<OpKernel> op = GetBinOp("Add", dtype, device_);
+      op_params.op_kernel = op.get();
+      OpKernelContext ctx(&op_params, 1);
+
+      // We never actually execute the kernel, so we need to do the output
+      // allocation it would do, ourselves.
+      Tensor* output_tensor_ptr = nullptr;
+      TF_CHECK_OK(ctx.forward_input_or_allocate_output({0}, 0, tensor_.shape(),
+                                                       &output_tensor_ptr));
+
+      CollectiveImplementationInterface* impl;
+      TF_CHECK_OK(CollectiveRegistry::Lookup(
+          col_params_.instance.impl_details.collective_name, &impl));
+      std::unique_ptr<CollectiveImplementationInterface> reducer(impl);
+      string exec_key =
+          strings::StrCat(col_params_.instance.instance_key, ":0:0");
+      CollectiveContext col_ctx(parent_->col_exec_, parent_->dev_mgr_.get(),
+                                &ctx, &op_params, col_params_, exec_key,
+                                kStepId, &tensor_, &tensor_);
+      TF_CHECK_OK(reducer->InitializeCollectiveContext(&col_ctx));
+
+      // Run the all-reduce.
+      reducer->Run([this](Status s) { status_ = s; });
+      if (status_.ok()) {
+        CHECK(tensor_.CopyFrom(*ctx.mutable_output(0), tensor_.shape()));
+      }
+      dev_ctx->Unref();
+    }
+
+    HalvingDoublingReducerTest* parent_;
+    Device* device_;
+    CollectiveParams col_params_;
+    Tensor tensor_;
+    Status status_;
+  };
+
+  TestCollectiveExecutorMgr col_exec_mgr_;
+  CollectiveExecutor* col_exec_ = nullptr;
+  CollectiveRemoteAccessLocal* rma_;
+  std::unique_ptr<DeviceResolverLocal> dev_resolver_;
+  std::unique_ptr<DeviceMgr> dev_mgr_;
+  string gpu_ring_order_;
+  std::vector<DeviceInstance*> instances_;
+  CollectiveParams col_params_;
+};
+
+CollectiveParams SetUpCollectiveParams(const std::vector<int>& devs_per_task,
+                                       int default_rank) {
+  CollectiveParams cp;
+  cp.group.device_type = DEVICE_CPU;
+  cp.group.num_tasks = devs_per_task.size();
+  cp.instance.type = REDUCTION_COLLECTIVE;
+  for (int ti = 0; ti < devs_per_task.size(); ++ti) {
+    string task_name = strings::StrCat("/job:worker/replica:0/task:", ti);
+    for (int di = 0; di < devs_per_task[ti]; ++di) {
+      cp.instance.task_names.push_back(task_name);
+      cp.instance.device_names.push_back(
+          strings::StrCat(task_name, "/device:CPU:", di));
+    }
+  }
+  cp.group.group_size = cp.instance.device_names.size();
+  cp.default_rank = default_rank;
+  return cp;
+}
+
+TEST_F(HalvingDoublingReducerTest, InitializeParams) {
+  CollectiveParams cp = SetUpCollectiveParams({3, 2}, 3);
+  HalvingDoublingReducer reducer;
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  EXPECT_EQ(std::vector<std::vector<int>>({{0, 1, 2, 3, 4}}),
+            cp.instance.impl_details.subdiv_permutations);
+  EXPECT_EQ(std::vector<int>({3}), cp.subdiv_rank);
+}
+
+TEST_F(HalvingDoublingReducerTest, InitializeHierarchicalParams) {
+  HierarchicalReducer reducer;
+  const std::vector<std::vector<int>> expected_perms = {
+      {0, 3, 5}, {0, 1, 2}, {3, 4}, {5}};
+  CollectiveParams cp = SetUpCollectiveParams({3, 2, 1}, 3);
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  EXPECT_EQ(expected_perms, cp.instance.impl_details.subdiv_permutations);
+  EXPECT_EQ(std::vector<int>({1, -1, 0, -1}), cp.subdiv_rank);
+
+  cp = SetUpCollectiveParams({3, 2, 1}, 2);
+  TF_ASSERT_OK(reducer.InitializeCollectiveParams(&cp));
+  EXPECT_EQ(expected_perms, cp.instance.impl_details.subdiv_permutations);
+  EXPECT_EQ(std::vector<int>({-1, 2, -1, -1}), cp.subdiv_rank);
+}
+
+TEST_F(HalvingDoublingReducerTest, RejectsGpuGroups) {
+  CollectiveParams cp = SetUpCollectiveParams({4}, 0);
+  cp.group.device_type = DEVICE_GPU;
+  HalvingDoublingReducer reducer;
+  EXPECT_TRUE(
+      errors::IsUnimplemented(reducer.InitializeCollectiveParams(&cp)));
+}
+
+#define DEF_TEST(C, B, W, D, L, A)                                           \
+  TEST_F(HalvingDoublingReducerTest,                                         \
+         C##_DaTy##B##_Wkr##W##_Dev##D##_Len##L##_Abrt##A) {                 \
+    DataType dtype = DT_##B;                                                 \
+    switch (dtype) {                                                         \
+      case DT_FLOAT: {                                                       \
+        RunTest<float>(#C, dtype, W, D, L, A);                               \
+      } break;                                                               \
+      case DT_DOUBLE: {                                                      \
+        RunTest<double>(#C, dtype, W, D, L, A);                              \
+      } break;                                                               \
+      case DT_INT32: {                                                       \
+        RunTest<int32>(#C, dtype, W, D, L, A);                               \
+      } break;                                                               \
+      case DT_INT64: {                                                       \
+        RunTest<int64>(#C, dtype, W, D, L, A);                               \
+      } break;                                                               \
+      default:                                                               \
+        LOG(FATAL) << "Unimplemented";                                       \
+    }                                                                        \
+  }
+
+// Success tests
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 1, 16, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 2, 1, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 4, 1001, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 5, 3, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 7, 1001, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 2, 4, 4096, 0)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 3, 4, 9408, 0)
+DEF_TEST(HalvingDoublingReduce, DOUBLE, 1, 6, 1001, 0)
+DEF_TEST(HalvingDoublingReduce, INT32, 1, 6, 1001, 0)
+DEF_TEST(HalvingDoublingReduce, INT64, 2, 3, 1001, 0)
+DEF_TEST(HierarchicalReduce, FLOAT, 1, 4, 1001, 0)
+DEF_TEST(HierarchicalReduce, FLOAT, 2, 1, 16, 0)
+DEF_TEST(HierarchicalReduce, FLOAT, 2, 4, 1, 0)
+DEF_TEST(HierarchicalReduce, FLOAT, 3, 3, 1001, 0)
+DEF_TEST(HierarchicalReduce, FLOAT, 4, 5, 4096, 0)
+DEF_TEST(HierarchicalReduce, DOUBLE, 3, 2, 1001, 0)
+DEF_TEST(HierarchicalReduce, INT32, 2, 3, 1001, 0)
+DEF_TEST(HierarchicalReduce, INT64, 5, 2, 1001, 0)
+
+// Failure tests
+DEF_TEST(HalvingDoublingReduce, FLOAT, 2, 4, 9408, 1)
+DEF_TEST(HalvingDoublingReduce, FLOAT, 1, 6, 9408, 5)
+DEF_TEST(HierarchicalReduce, FLOAT, 2, 4, 9408, 1)
+DEF_TEST(HierarchicalReduce, FLOAT, 3, 3, 9408, 7)
+
+}  // namespace
+}  // namespace tensorflow
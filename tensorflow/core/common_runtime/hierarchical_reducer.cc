@@ -0,0 +1,143 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  if (col_params->instance.type != REDUCTION_COLLECTIVE) {
+    return errors::Internal("HierarchicalReducer does not support ",
+                            col_params->instance.ToString());
+  }
+  // The final op is applied with a group size scalar in host memory.
+  if (col_params->group.device_type != DEVICE_CPU) {
+    return errors::Unimplemented(
+        col_params->instance.impl_details.collective_name,
+        " only supports CPU devices, got ",
+        col_params->group.device_type.type_string());
+  }
+  // Precondition: device_names must be sorted so that all devices in the same
+  // task are adjacent.
+  std::vector<int> first_device_of_task;
+  for (int di = 0; di < col_params->group.group_size; ++di) {
+    if (di == 0 || col_params->instance.task_names[di] !=
+                       col_params->instance.task_names[di - 1]) {
+      first_device_of_task.push_back(di);
+    }
+  }
+  const int num_tasks = static_cast<int>(first_device_of_task.size());
+  first_device_of_task.push_back(col_params->group.group_size);
+
+  std::vector<std::vector<int>>& perms =
+      col_params->instance.impl_details.subdiv_permutations;
+  perms.assign(1 + num_tasks, std::vector<int>());
+  col_params->subdiv_rank.assign(1 + num_tasks, -1);
+  const int rank = col_params->default_rank;
+  for (int ti = 0; ti < num_tasks; ++ti) {
+    const int task_begin = first_device_of_task[ti];
+    const int task_end = first_device_of_task[ti + 1];
+    if (rank == task_begin) col_params->subdiv_rank[0] = ti;
+    perms[0].push_back(task_begin);
+    for (int di = task_begin; di < task_end; ++di) {
+      if (rank == di) col_params->subdiv_rank[1 + ti] = di - task_begin;
+      perms[1 + ti].push_back(di);
+    }
+  }
+  VLOG(2) << collective_util::SubdivPermDebugString(*col_params);
+  return Status::OK();
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  int task_subdiv = -1;
+  for (int sdi = 1; sdi < col_params_->subdiv_rank.size(); ++sdi) {
+    if (col_params_->subdiv_rank[sdi] >= 0) {
+      task_subdiv = sdi;
+      break;
+    }
+  }
+  DCHECK_GE(task_subdiv, 1);
+  Status s = PrepareOutput();
+  if (s.ok()) {
+    s = TreeReduce(task_subdiv);
+  }
+  if (s.ok() && col_params_->subdiv_rank[0] >= 0) {
+    s = AllReduce(/*subdiv=*/0, /*finalize=*/true);
+  }
+  if (s.ok()) {
+    s = TreeBroadcast(task_subdiv);
+  }
+  Finish(s, done);
+}
+
+Status HierarchicalReducer::TreeReduce(int subdiv) {
+  const int group_size = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations[subdiv].size());
+  const int rank = col_params_->subdiv_rank[subdiv];
+  // In the step at distance d, every rank that is an odd multiple of d sends
+  // its partial value to the rank d below it, and leaves the tree.
+  int step = 0;
+  for (int distance = 1; distance < group_size; distance *= 2, ++step) {
+    if (rank % (2 * distance) == distance) {
+      return Exchange(subdiv, step, rank - distance, &output_, nullptr);
+    }
+    if (rank + distance < group_size) {
+      Tensor received = TempTensor(output_.NumElements());
+      TF_RETURN_IF_ERROR(
+          Exchange(subdiv, step, rank + distance, nullptr, &received));
+      TF_RETURN_IF_ERROR(Reduce(&output_, &received));
+    }
+  }
+  return Status::OK();
+}
+
+Status HierarchicalReducer::TreeBroadcast(int subdiv) {
+  const int group_size = static_cast<int>(
+      col_params_->instance.impl_details.subdiv_permutations[subdiv].size());
+  const int rank = col_params_->subdiv_rank[subdiv];
+  int num_steps = 0;
+  int distance = 1;
+  while (distance < group_size) {
+    distance *= 2;
+    ++num_steps;
+  }
+  // Retraces the reduction tree from the root, with step numbers following
+  // those of `TreeReduce`.
+  for (int step = num_steps - 1; step >= 0; --step) {
+    distance = 1 << step;
+    if (rank % (2 * distance) == distance) {
+      TF_RETURN_IF_ERROR(Exchange(subdiv, num_steps + step, rank - distance,
+                                  nullptr, &output_));
+    } else if (rank % (2 * distance) == 0 && rank + distance < group_size) {
+      TF_RETURN_IF_ERROR(Exchange(subdiv, num_steps + step, rank + distance,
+                                  &output_, nullptr));
+    }
+  }
+  return Status::OK();
+}
+
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+
+}  // namespace tensorflow
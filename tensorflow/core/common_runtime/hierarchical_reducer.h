@@ -0,0 +1,53 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include "tensorflow/core/common_runtime/halving_doubling_reducer.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce for groups spanning
+// several tasks with several devices each.  The devices of each task first
+// reduce to the first device of the task along a binary tree, the first
+// devices of all tasks then all-reduce by recursive halving-doubling, and
+// each of them finally broadcasts the result to the other devices of its task
+// along the same tree.  Only one device per task sends over the network, and
+// the inter-task all-reduce takes 2 * log2(#tasks) steps.
+class HierarchicalReducer : public HalvingDoublingReducer {
+ public:
+  HierarchicalReducer() = default;
+  ~HierarchicalReducer() override = default;
+
+  // Establishes the subdiv permutations.  Subdiv 0 comprises the first device
+  // of each task, and subdiv 1 + ti comprises the devices of task ti.  A
+  // device's subdiv rank is -1 in the subdivs it does not participate in.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Begins async execution of the hierarchical all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+ private:
+  // Reduces the outputs of the devices of `subdiv` to its rank 0 device.
+  Status TreeReduce(int subdiv);
+
+  // Broadcasts the output of the rank 0 device of `subdiv` to its other
+  // devices.
+  Status TreeBroadcast(int subdiv);
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
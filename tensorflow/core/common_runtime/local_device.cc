@@ -106,12 +106,15 @@ struct LocalDevice::EigenThreadPoolInfo {
     }
     ThreadOptions thread_opts;
     thread_opts.numa_node = numa_node;
+    thread::SchedulingPolicy policy;
+    policy.spin_before_park =
+        !options.config.experimental().disable_thread_spinning();
+    policy.pin_threads_to_cores =
+        options.config.experimental().pin_threads_to_cores();
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
     eigen_worker_threads_.workers = new thread::ThreadPool(
         options.env, thread_opts, strings::StrCat("numa_", numa_node, "_Eigen"),
-        intra_op_parallelism_threads,
-        !options.config.experimental().disable_thread_spinning(),
-        /*allocator=*/nullptr);
+        intra_op_parallelism_threads, policy, /*allocator=*/nullptr);
     Eigen::ThreadPoolInterface* threadpool =
         eigen_worker_threads_.workers->AsEigenThreadPool();
     if (threadpool == nullptr) {
@@ -48,6 +48,20 @@ auto* graph_run_output_tensor_bytes = monitoring::Sampler<0>::New(
     // Power of 2 with bucket count 14 (256G)
     {monitoring::Buckets::Exponential(1, 4, 14)});
 
+auto* run_handler_wait_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/run_handler/wait_usecs",
+     "The time a Session::Run() waited for a free RunHandler in "
+     "microseconds."},
+    // Power of 2 with bucket count 30 (> 8 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
+auto* run_handler_queueing_delay_usecs = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/run_handler/queueing_delay_usecs",
+     "The mean time the inter-op closures of a Session::Run() waited for a "
+     "thread in microseconds."},
+    // Power of 2 with bucket count 30 (> 8 minutes)
+    {monitoring::Buckets::Exponential(1, 2, 30)});
+
 auto* tf_data_autotune_counter = monitoring::Counter<1>::New(
     "/tensorflow/data/autotune", "tf.data autotuning", "name");
 
@@ -112,6 +126,12 @@ void UpdateGraphExecTime(const uint64 running_time_usecs) {
   }
 }
 
+void RecordRunHandlerQueueingDelay(const uint64 wait_usecs,
+                                   const uint64 queueing_delay_usecs) {
+  run_handler_wait_usecs->GetCell()->Add(wait_usecs);
+  run_handler_queueing_delay_usecs->GetCell()->Add(queueing_delay_usecs);
+}
+
 void UpdateGraphBuildTime(const uint64 running_time_usecs) {
   if (running_time_usecs > 0) {
     build_graph_calls->GetCell()->IncrementBy(1);
@@ -49,6 +49,12 @@ void RecordGraphOutputTensors(const size_t size);
 
 void UpdateGraphExecTime(const uint64 running_time_usecs);
 
+// Records, for a Session::Run() scheduled through a RunHandler, the time it
+// waited for a free handler and the mean time its inter-op closures waited
+// for a thread.
+void RecordRunHandlerQueueingDelay(const uint64 wait_usecs,
+                                   const uint64 queueing_delay_usecs);
+
 // Updates the metrics stored about time spent building graphs.
 //
 // By "GraphBuild", we refer to building a client graph, which is a sub-graph of
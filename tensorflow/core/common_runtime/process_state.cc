@@ -91,12 +91,20 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      bool use_thread_cache = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_ALLOCATOR_THREAD_CACHE", false,
+                                  &use_thread_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       DCHECK(sub_allocator);
       allocator =
           new BFCAllocator(sub_allocator, cpu_mem_limit, true /*allow_growth*/,
-                           "bfc_cpu_allocator_for_gpu" /*name*/);
+                           "bfc_cpu_allocator_for_gpu" /*name*/,
+                           use_thread_cache);
       VLOG(2) << "Using BFCAllocator with memory limit of "
-              << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
+              << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator"
+              << (use_thread_cache ? " and a thread cache" : "");
     } else if (sub_allocator) {
       DCHECK(sub_allocator);
       allocator =
@@ -74,7 +74,7 @@ static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
   }
   return new thread::ThreadPool(
       Env::Default(), ThreadOptions(), "Compute", inter_op_parallelism_threads,
-      !options.config.experimental().disable_thread_spinning(),
+      InterOpSchedulingPolicyFromSessionOptions(options),
       /*allocator=*/nullptr);
 }
 
@@ -122,13 +122,23 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
   return DefaultNumInterOpThreads();
 }
 
+thread::SchedulingPolicy InterOpSchedulingPolicyFromSessionOptions(
+    const SessionOptions& options) {
+  const auto& experimental = options.config.experimental();
+  thread::SchedulingPolicy policy;
+  policy.spin_before_park = !experimental.disable_thread_spinning();
+  policy.wake_batch_size = std::max(experimental.inter_op_wake_batch_size(), 1);
+  policy.pin_threads_to_cores = experimental.pin_threads_to_cores();
+  return policy;
+}
+
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options) {
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
   return new thread::ThreadPool(
       options.env, ThreadOptions(), "Compute", num_threads,
-      !options.config.experimental().disable_thread_spinning(),
+      InterOpSchedulingPolicyFromSessionOptions(options),
       /*allocator=*/nullptr);
 }
 
@@ -44,6 +44,11 @@ int32 NumIntraOpThreadsFromEnvironment();
 // on the number of schedulable CPUs, and any MKL and OpenMP configurations.
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 
+// Returns the scheduling policy of the inter-op thread pools created for
+// `options`.
+thread::SchedulingPolicy InterOpSchedulingPolicyFromSessionOptions(
+    const SessionOptions& options);
+
 // Creates a thread pool with number of inter op threads.
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "absl/memory/memory.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 namespace tensorflow {
 
@@ -40,6 +43,31 @@ std::unique_ptr<Device> RenamedDevice::NewRenamedDevice(
       underlying, attributes, owns_underlying, isolate_session_state));
 }
 
+/* static */
+std::unique_ptr<Device> RenamedDevice::NewRenamedDevice(
+    const string& new_base, Device* underlying, bool owns_underlying,
+    bool isolate_session_state,
+    Eigen::ThreadPoolInterface* intra_op_threadpool,
+    int intra_op_parallelism) {
+  CHECK(intra_op_threadpool != nullptr);
+  CHECK_GT(intra_op_parallelism, 0);
+  std::unique_ptr<Device> device = NewRenamedDevice(
+      new_base, underlying, owns_underlying, isolate_session_state);
+  RenamedDevice* renamed = static_cast<RenamedDevice*>(device.get());
+  renamed->intra_op_threadpool_.reset(
+      new thread::ThreadPool(intra_op_threadpool, intra_op_parallelism));
+  renamed->intra_op_worker_threads_.num_threads = intra_op_parallelism;
+  renamed->intra_op_worker_threads_.workers =
+      renamed->intra_op_threadpool_.get();
+  // set_eigen_cpu_device() copies the device for every number of threads up
+  // to its own.
+  Eigen::ThreadPoolDevice eigen_device(
+      intra_op_threadpool, intra_op_parallelism,
+      underlying->eigen_cpu_device()->allocator());
+  renamed->set_eigen_cpu_device(&eigen_device);
+  return device;
+}
+
 RenamedDevice::RenamedDevice(Device* underlying,
                              const DeviceAttributes& attributes,
                              bool owns_underlying, bool isolate_session_state)
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_RENAMED_DEVICE_H_
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
@@ -25,7 +26,8 @@ namespace tensorflow {
 //
 // This class is used to wrap local devices when using clusterspec propagation
 // where the name of a particular device may change in the context of a given
-// session.
+// session.  It is also used to run the kernels of one step on a CPU device
+// with a thread pool of their own for intra-op parallelism.
 class RenamedDevice : public Device {
  public:
   static std::unique_ptr<Device> NewRenamedDevice(const string& new_base,
@@ -33,6 +35,15 @@ class RenamedDevice : public Device {
                                                   bool owns_underlying,
                                                   bool isolate_session_state);
 
+  // As above, except that the kernels run on the returned device schedule
+  // their intra-op work on "intra_op_threadpool", which must outlive it,
+  // using at most "intra_op_parallelism" of its threads at once.
+  static std::unique_ptr<Device> NewRenamedDevice(
+      const string& new_base, Device* underlying, bool owns_underlying,
+      bool isolate_session_state,
+      Eigen::ThreadPoolInterface* intra_op_threadpool,
+      int intra_op_parallelism);
+
   ~RenamedDevice() override;
 
   // Below are virtual methods defined on DeviceBase
@@ -48,6 +59,7 @@ class RenamedDevice : public Device {
   }
 
   const CpuWorkerThreads* tensorflow_cpu_worker_threads() const override {
+    if (intra_op_threadpool_ != nullptr) return &intra_op_worker_threads_;
     return underlying_->tensorflow_cpu_worker_threads();
   }
 
@@ -69,6 +81,7 @@ class RenamedDevice : public Device {
   }
 
   const Eigen::ThreadPoolDevice* eigen_cpu_device() override {
+    if (has_eigen_cpu_device()) return Device::eigen_cpu_device();
     return underlying_->eigen_cpu_device();
   }
 
@@ -143,6 +156,10 @@ class RenamedDevice : public Device {
   Device* const underlying_;
   const bool owns_underlying_;
   const bool isolate_session_state_;
+
+  // Null unless the device has a thread pool of its own.
+  std::unique_ptr<thread::ThreadPool> intra_op_threadpool_;
+  CpuWorkerThreads intra_op_worker_threads_;
 };
 
 }  // namespace tensorflow
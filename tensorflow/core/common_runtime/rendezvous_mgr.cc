@@ -127,44 +127,75 @@ void IntraProcessRendezvous::SameWorkerRecvDone(
       out, 0 /*dev_to_dev_stream_index*/, std::move(done), sync_dst_compute);
 }
 
+Status IntraProcessRendezvous::SendToSlot(const SlotId& slot,
+                                          const ParsedKey& parsed,
+                                          const Rendezvous::Args& args,
+                                          const Tensor& val,
+                                          const bool is_dead) {
+  VLOG(1) << "IntraProcessRendezvous SendToSlot " << this << " " << slot.index
+          << " " << parsed.FullKey();
+  {
+    mutex_lock l(mu_);
+    if (!status_.ok()) return status_;
+  }
+
+  // Buffers "val" and "device_context" in local_.
+  return local_->SendToSlot(slot, parsed, args, val, is_dead);
+}
+
 void IntraProcessRendezvous::RecvAsync(const ParsedKey& parsed,
                                        const Rendezvous::Args& recv_args,
                                        DoneCallback done) {
   VLOG(1) << "IntraProcessRendezvous Recv " << this << " " << parsed.FullKey();
 
   // Recv the tensor from local_.
-  local_->RecvAsync(
-      parsed, recv_args,
-      std::bind(
-          [this, parsed](DoneCallback done,
-                         // Begin unbound arguments.
-                         const Status& status,
-                         const Rendezvous::Args& send_args,
-                         const Rendezvous::Args& recv_args, const Tensor& in,
-                         bool is_dead) {
-            // If "in" is an uninitialized tensor, do copy-construction to
-            // preserve the uninitialized state, along with data type and shape
-            // info, which is useful for debugger purposes.
-            Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
-
-            auto final_callback = std::bind(
-                [send_args, recv_args, out, is_dead](DoneCallback done,
-                                                     // Begin unbound arguments.
-                                                     const Status& s) {
-                  done(s, send_args, recv_args, *out, is_dead);
-                  delete out;
-                },
-                std::move(done), std::placeholders::_1);
-
-            if (status.ok() && in.IsInitialized()) {
-              SameWorkerRecvDone(parsed, send_args, recv_args, in, out,
-                                 std::move(final_callback));
-            } else {
-              final_callback(status);
-            }
-          },
-          std::move(done), std::placeholders::_1, std::placeholders::_2,
-          std::placeholders::_3, std::placeholders::_4, std::placeholders::_5));
+  local_->RecvAsync(parsed, recv_args,
+                    MakeRecvCallback(parsed, std::move(done)));
+}
+
+void IntraProcessRendezvous::RecvFromSlotAsync(
+    const SlotId& slot, const ParsedKey& parsed,
+    const Rendezvous::Args& recv_args, DoneCallback done) {
+  VLOG(1) << "IntraProcessRendezvous RecvFromSlot " << this << " "
+          << slot.index << " " << parsed.FullKey();
+
+  // Recv the tensor from local_.
+  local_->RecvFromSlotAsync(slot, parsed, recv_args,
+                            MakeRecvCallback(parsed, std::move(done)));
+}
+
+Rendezvous::DoneCallback IntraProcessRendezvous::MakeRecvCallback(
+    const Rendezvous::ParsedKey& parsed, DoneCallback done) {
+  return std::bind(
+      [this, parsed](DoneCallback done,
+                     // Begin unbound arguments.
+                     const Status& status,
+                     const Rendezvous::Args& send_args,
+                     const Rendezvous::Args& recv_args, const Tensor& in,
+                     bool is_dead) {
+        // If "in" is an uninitialized tensor, do copy-construction to
+        // preserve the uninitialized state, along with data type and shape
+        // info, which is useful for debugger purposes.
+        Tensor* out = in.IsInitialized() ? new Tensor : new Tensor(in);
+
+        auto final_callback = std::bind(
+            [send_args, recv_args, out, is_dead](DoneCallback done,
+                                                 // Begin unbound arguments.
+                                                 const Status& s) {
+              done(s, send_args, recv_args, *out, is_dead);
+              delete out;
+            },
+            std::move(done), std::placeholders::_1);
+
+        if (status.ok() && in.IsInitialized()) {
+          SameWorkerRecvDone(parsed, send_args, recv_args, in, out,
+                             std::move(final_callback));
+        } else {
+          final_callback(status);
+        }
+      },
+      std::move(done), std::placeholders::_1, std::placeholders::_2,
+      std::placeholders::_3, std::placeholders::_4, std::placeholders::_5);
 }
 
 void IntraProcessRendezvous::StartAbort(const Status& s) {
@@ -53,6 +53,14 @@ class IntraProcessRendezvous : public Rendezvous {
   void RecvAsync(const ParsedKey& key, const Rendezvous::Args& args,
                  DoneCallback done) override;
 
+  // Like Send() and RecvAsync(), matching the pair by slot in local_.
+  Status SendToSlot(const SlotId& slot, const ParsedKey& key,
+                    const Rendezvous::Args& args, const Tensor& val,
+                    const bool is_dead) override;
+  void RecvFromSlotAsync(const SlotId& slot, const ParsedKey& key,
+                         const Rendezvous::Args& args,
+                         DoneCallback done) override;
+
   void StartAbort(const Status& status) override;
 
  private:
@@ -82,6 +90,11 @@ class IntraProcessRendezvous : public Rendezvous {
                           const Rendezvous::Args& recv_args, const Tensor& in,
                           Tensor* out, StatusCallback done);
 
+  // Wraps "done" to copy the tensor received from local_ under "parsed" to
+  // the receiving device.
+  DoneCallback MakeRecvCallback(const Rendezvous::ParsedKey& parsed,
+                                DoneCallback done);
+
   TF_DISALLOW_COPY_AND_ASSIGN(IntraProcessRendezvous);
 };
 
@@ -377,6 +377,11 @@ string RingAlg::RingField::DebugString() const {
   return rv;
 }
 
+bool RingAlg::IsCompressed(const RingField& rf) const {
+  return col_params_->compressor != nullptr &&
+         (!rf.second_pass || col_params_->compressor->compresses_gather());
+}
+
 void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
   DCHECK(rf->do_send);
   string send_buf_key = RingAlgBufKey(name_, col_ctx_->exec_key,
@@ -387,11 +392,31 @@ void RingAlg::DispatchSend(RingField* rf, const StatusCallback& done) {
   int send_to_rank = (rf->rank + 1) % group_size_;
   int send_to_dev_idx = col_params_->instance.impl_details
                             .subdiv_permutations[rf->subdiv_idx][send_to_rank];
+  const Tensor* send_tensor = &rf->chunk;
+  if (IsCompressed(*rf)) {
+    CollectiveCompressor* compressor = col_params_->compressor.get();
+    if (rf->second_pass) {
+      // Values received in this pass are encoded exactly, but the reduced
+      // values that originate here must also be replaced by their decoding,
+      // so that every device ends up with the same values.
+      compressor->Encode(rf->chunk, 0, 0, /*error_feedback=*/false,
+                         &rf->wire_chunk);
+      if (!rf->do_recv) compressor->Decode(rf->wire_chunk, &rf->chunk);
+    } else {
+      const int64 offset =
+          (static_cast<const char*>(DMAHelper::base(&rf->chunk)) -
+           static_cast<const char*>(DMAHelper::base(&ca_->Value()))) /
+          DataTypeSize(rf->chunk.dtype());
+      compressor->Encode(rf->chunk, offset, ca_->Value().NumElements(),
+                         /*error_feedback=*/true, &rf->wire_chunk);
+    }
+    send_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->PostToPeer(
       col_params_->instance.device_names[send_to_dev_idx],
       col_params_->instance.task_names[send_to_dev_idx], send_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
-      col_ctx_->op_ctx->output_alloc_attr(0), &rf->chunk,
+      col_ctx_->op_ctx->output_alloc_attr(0), send_tensor,
       col_ctx_->device_locality, done);
 }
 
@@ -406,13 +431,21 @@ void RingAlg::DispatchRecv(RingField* rf, const StatusCallback& done) {
   Tensor* dst_tensor = (!rf->second_pass && (col_params_->merge_op != nullptr))
                            ? &rf->tmp_chunk
                            : &rf->chunk;
+  StatusCallback recv_done = done;
+  if (IsCompressed(*rf)) {
+    recv_done = [this, rf, dst_tensor, done](const Status& s) {
+      if (s.ok()) col_params_->compressor->Decode(rf->wire_chunk, dst_tensor);
+      done(s);
+    };
+    dst_tensor = &rf->wire_chunk;
+  }
   col_ctx_->col_exec->RecvFromPeer(
       col_params_->instance.device_names[rf->recv_dev_idx],
       col_params_->instance.task_names[rf->recv_dev_idx],
       col_params_->task.is_local[rf->recv_dev_idx], recv_buf_key,
       col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
       col_ctx_->op_ctx->output_alloc_attr(0), dst_tensor,
-      col_ctx_->device_locality, rf->subdiv_idx, done);
+      col_ctx_->device_locality, rf->subdiv_idx, recv_done);
 }
 
 string RingAlg::FieldState() {
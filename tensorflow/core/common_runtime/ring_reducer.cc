@@ -164,6 +164,14 @@ void RingReducer::InitRingField(RingField* rf, int chunk_idx, int subdiv_idx,
   if (rf->do_recv) {
     rf->tmp_chunk = ca_->TempChunk(rf->sc_idx);
   }
+  if (col_params_->compressor) {
+    AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+    rf->wire_chunk = Tensor(
+        col_ctx_->device->GetAllocator(attr),
+        col_params_->compressor->encoded_dtype(),
+        TensorShape({col_params_->compressor->NumEncodedElements(
+            rf->chunk.NumElements())}));
+  }
 }
 
 // At the beginning of the algorithm initialize a RingField struct for
@@ -315,6 +315,9 @@ class RingReducerTest : public ::testing::Test {
       for (int i = 0; i < tensor_len; ++i) {
         expected[i] /= (num_workers * num_devices);
       }
+      // Lossy compression still leaves every device with the same values.
+      const bool lossy = (compression_ == "bf16" || compression_ == "fp16");
+      Tensor first_actual;
       for (int di = 0; di < static_cast<int>(instances_.size()); ++di) {
         TF_EXPECT_OK(instances_[di]->status_);
         Tensor* inst = &instances_[di]->tensor_;
@@ -337,11 +340,20 @@ class RingReducerTest : public ::testing::Test {
         }
 
         auto alias = actual.template unaligned_flat<T>();
+        if (di == 0) first_actual = actual;
         for (int i = 0; i < tensor_len; ++i) {
           switch (dtype) {
             case DT_FLOAT:
-              EXPECT_FLOAT_EQ(expected[i], alias(i))
-                  << "Mismatch at device " << di << " index " << i;
+              if (lossy) {
+                EXPECT_NEAR(expected[i], alias(i), 1e-2 * std::abs(expected[i]))
+                    << "Mismatch at device " << di << " index " << i;
+                EXPECT_EQ(first_actual.template unaligned_flat<T>()(i),
+                          alias(i))
+                    << "Mismatch at device " << di << " index " << i;
+              } else {
+                EXPECT_FLOAT_EQ(expected[i], alias(i))
+                    << "Mismatch at device " << di << " index " << i;
+              }
               break;
             case DT_DOUBLE:
               EXPECT_DOUBLE_EQ(expected[i], alias(i))
@@ -468,6 +480,9 @@ class RingReducerTest : public ::testing::Test {
           GetAdd(col_params_.instance.data_type, device_type_, device_);
       col_params_.final_op =
           GetDiv(col_params_.instance.data_type, device_type_, device_);
+      TF_CHECK_OK(CollectiveCompressor::Create(
+          parent_->compression_, parent_->topk_ratio_,
+          &col_params_.compressor));
 
       // Prepare an OpKernelContext.
       OpKernelContext::Params op_params;
@@ -541,6 +556,8 @@ class RingReducerTest : public ::testing::Test {
 
   bool stop_ = false;
   DeviceType device_type_;
+  string compression_ = "none";
+  float topk_ratio_ = 0.01;
   TestCollectiveExecutorMgr col_exec_mgr_;
   CollectiveExecutor* col_exec_;
   CollectiveRemoteAccessLocal* rma_;
@@ -703,6 +720,24 @@ DEF_TEST(INT64, CPU, 2, 8, 3, 4095, 0)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 1)
 DEF_TEST(FLOAT, CPU, 2, 8, 1, 9408, 7)
 DEF_TEST(FLOAT, CPU, 2, 8, 2, 9408, 11)
+
+// Compression tests
+TEST_F(RingReducerTest, CompressionBF16) {
+  compression_ = "bf16";
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, 2, 4, 1, 4096, 0);
+}
+
+TEST_F(RingReducerTest, CompressionFP16) {
+  compression_ = "fp16";
+  // Keeps the values within the range of half precision.
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, 1, 3, 2, 100, 0);
+}
+
+TEST_F(RingReducerTest, CompressionTopKAllValues) {
+  compression_ = "topk";
+  topk_ratio_ = 1.0;
+  RunTest<float>(DT_FLOAT, DEVICE_CPU, 2, 4, 1, 1001, 0);
+}
 #endif
 
 #ifdef GOOGLE_CUDA
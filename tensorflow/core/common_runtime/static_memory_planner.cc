@@ -0,0 +1,306 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/static_memory_planner.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/shape_refiner.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+
+void InferStaticOutputBytes(const Graph& graph,
+                            std::vector<std::vector<int64>>* output_bytes) {
+  output_bytes->clear();
+  output_bytes->resize(graph.num_node_ids());
+
+  ShapeRefiner refiner(graph.versions(), graph.op_registry());
+  refiner.set_require_shape_inference_fns(false);
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  for (const Node* n : order) {
+    std::vector<int64>* bytes = &(*output_bytes)[n->id()];
+    bytes->assign(n->num_outputs(), -1);
+    if (!refiner.AddNode(n).ok()) continue;
+    shape_inference::InferenceContext* c = refiner.GetContext(n);
+    for (int i = 0; i < n->num_outputs(); ++i) {
+      const DataType dt = n->output_type(i);
+      if (!DataTypeCanUseMemcpy(dt) || !c->FullyDefined(c->output(i))) {
+        continue;
+      }
+      (*bytes)[i] =
+          c->Value(c->NumElements(c->output(i))) * DataTypeSize(BaseType(dt));
+    }
+  }
+}
+
+namespace {
+
+// Answers whether one node is an ancestor of another with a backward search
+// that only visits nodes between the two in topological order.  A search that
+// would visit more than kMaxVisits nodes answers false, which only keeps the
+// planner from sharing memory.  Answers are cached, since the planner asks
+// about the same pairs many times.
+class AncestorQuery {
+ public:
+  // 'position' is the topological position of each node id.
+  AncestorQuery(const Graph& graph, const std::vector<int>& position)
+      : graph_(graph), position_(position), visited_(position.size(), 0) {}
+
+  bool IsAncestor(int ancestor, int node) {
+    if (position_[ancestor] >= position_[node]) return false;
+    const uint64 key = (static_cast<uint64>(ancestor) << 32) | node;
+    auto it = cache_.find(key);
+    if (it != cache_.end()) return it->second;
+    const bool result = Search(ancestor, node);
+    cache_.emplace(key, result);
+    return result;
+  }
+
+ private:
+  static const int kMaxVisits = 4096;
+
+  bool Search(int ancestor, int node) {
+    ++epoch_;
+    const int min_position = position_[ancestor];
+    stack_.clear();
+    stack_.push_back(node);
+    visited_[node] = epoch_;
+    int visits = 0;
+    while (!stack_.empty()) {
+      const Node* n = graph_.FindNodeId(stack_.back());
+      stack_.pop_back();
+      if (++visits > kMaxVisits) return false;
+      for (const Edge* e : n->in_edges()) {
+        const int src = e->src()->id();
+        if (src == ancestor) return true;
+        if (position_[src] <= min_position || visited_[src] == epoch_) {
+          continue;
+        }
+        visited_[src] = epoch_;
+        stack_.push_back(src);
+      }
+    }
+    return false;
+  }
+
+  const Graph& graph_;
+  const std::vector<int>& position_;
+  std::vector<uint32> visited_;
+  uint32 epoch_ = 0;
+  std::vector<int> stack_;
+  std::unordered_map<uint64, bool> cache_;
+};
+
+}  // namespace
+
+Status StaticMemoryPlan::Create(
+    const Graph& graph, const std::vector<std::vector<int64>>& output_bytes,
+    std::unique_ptr<StaticMemoryPlan>* plan) {
+  const int num_nodes = graph.num_node_ids();
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<int> position(num_nodes, -1);
+  for (int i = 0; i < order.size(); ++i) {
+    position[order[i]->id()] = i;
+  }
+
+  for (const Node* n : order) {
+    for (const Edge* e : n->in_edges()) {
+      if (position[e->src()->id()] >= position[n->id()]) {
+        return errors::InvalidArgument(
+            "The static memory planner does not support cyclic graphs");
+      }
+    }
+  }
+  AncestorQuery ancestors(graph, position);
+
+  std::unique_ptr<StaticMemoryPlan> p(new StaticMemoryPlan);
+  // For every buffer, the nodes after which it is no longer used.
+  std::vector<std::vector<int>> last_users;
+  p->output_base_.assign(num_nodes, -1);
+  for (const Node* n : order) {
+    const int id = n->id();
+    if (id >= output_bytes.size()) continue;
+    const std::vector<int64>& bytes = output_bytes[id];
+    if (std::none_of(bytes.begin(), bytes.end(),
+                     [](int64 b) { return b > 0; })) {
+      continue;
+    }
+    p->output_base_[id] = p->buffer_for_output_.size();
+    for (int i = 0; i < bytes.size(); ++i) {
+      if (bytes[i] <= 0) {
+        p->buffer_for_output_.push_back(-1);
+        continue;
+      }
+      p->buffer_for_output_.push_back(p->buffers_.size());
+      const int64 alignment = Allocator::kAllocatorAlignment;
+      p->buffers_.push_back(
+          {id, i, 0, (bytes[i] + alignment - 1) / alignment * alignment, {}});
+      std::vector<int> users;
+      for (const Edge* e : n->out_edges()) {
+        if (!e->IsControlEdge() && e->src_output() == i) {
+          users.push_back(e->dst()->id());
+        }
+      }
+      if (users.empty()) users.push_back(id);
+      last_users.push_back(std::move(users));
+    }
+  }
+
+  std::vector<Buffer>& buffers = p->buffers_;
+  // True iff buffer 'a' is dead before buffer 'b' is allocated.
+  auto dead_before = [&](int a, int b) {
+    for (int user : last_users[a]) {
+      if (!ancestors.IsAncestor(user, buffers[b].node_id)) return false;
+    }
+    return true;
+  };
+
+  std::vector<int> by_size(buffers.size());
+  for (int i = 0; i < by_size.size(); ++i) by_size[i] = i;
+  std::stable_sort(by_size.begin(), by_size.end(), [&buffers](int a, int b) {
+    return buffers[a].size > buffers[b].size;
+  });
+  std::vector<int> placed;
+  std::vector<std::pair<int64, int64>> taken;
+  for (int b : by_size) {
+    taken.clear();
+    for (int other : placed) {
+      if (!dead_before(b, other) && !dead_before(other, b)) {
+        taken.emplace_back(buffers[other].offset,
+                           buffers[other].offset + buffers[other].size);
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    int64 offset = 0;
+    for (const auto& range : taken) {
+      if (range.first >= offset + buffers[b].size) break;
+      offset = std::max(offset, range.second);
+    }
+    buffers[b].offset = offset;
+    p->slab_size_ = std::max(p->slab_size_, offset + buffers[b].size);
+    placed.push_back(b);
+  }
+
+  for (int a = 0; a < buffers.size(); ++a) {
+    for (int b = a + 1; b < buffers.size(); ++b) {
+      if (buffers[a].offset < buffers[b].offset + buffers[b].size &&
+          buffers[b].offset < buffers[a].offset + buffers[a].size) {
+        buffers[a].overlapping.push_back(b);
+        buffers[b].overlapping.push_back(a);
+      }
+    }
+  }
+
+  *plan = std::move(p);
+  return Status::OK();
+}
+
+class StaticMemorySlab::BufferAllocator : public Allocator {
+ public:
+  BufferAllocator(StaticMemorySlab* slab, int buffer)
+      : slab_(slab), buffer_(buffer) {}
+
+  string Name() override { return "static_memory_slab"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return slab_->AllocateBuffer(buffer_, alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    slab_->DeallocateBuffer(buffer_, ptr);
+  }
+
+ private:
+  StaticMemorySlab* const slab_;
+  const int buffer_;
+};
+
+StaticMemorySlab::StaticMemorySlab(const StaticMemoryPlan* plan,
+                                   Allocator* fallback)
+    : plan_(plan),
+      fallback_(fallback),
+      size_(plan->slab_size()),
+      base_(static_cast<char*>(port::AlignedMalloc(
+          std::max<int64>(size_, Allocator::kAllocatorAlignment),
+          Allocator::kAllocatorAlignment))) {
+  CHECK(base_ != nullptr) << "Failed to allocate a static memory slab of "
+                          << plan->slab_size() << " bytes";
+  const int num_buffers = plan_->buffers().size();
+  for (int i = 0; i < num_buffers; ++i) {
+    buffer_allocators_.emplace_back(new BufferAllocator(this, i));
+  }
+  output_allocators_.resize(plan_->num_outputs(), nullptr);
+  for (int i = 0; i < plan_->num_outputs(); ++i) {
+    const int buffer = plan_->buffer_for_output(i);
+    if (buffer >= 0) output_allocators_[i] = buffer_allocators_[buffer].get();
+  }
+  live_.resize(num_buffers, false);
+}
+
+StaticMemorySlab::~StaticMemorySlab() { port::AlignedFree(base_); }
+
+void* StaticMemorySlab::AllocateBuffer(int buffer, size_t alignment,
+                                       size_t num_bytes) {
+  const StaticMemoryPlan::Buffer& b = plan_->buffers()[buffer];
+  bool planned = num_bytes > 0 && num_bytes <= b.size &&
+                 alignment <= Allocator::kAllocatorAlignment;
+  {
+    mutex_lock l(mu_);
+    if (planned && live_[buffer]) planned = false;
+    for (int other : b.overlapping) {
+      if (!planned) break;
+      if (live_[other]) planned = false;
+    }
+    if (planned) {
+      live_[buffer] = true;
+      ++num_planned_allocs_;
+    } else {
+      ++num_fallback_allocs_;
+    }
+  }
+  if (!planned) {
+    VLOG(2) << "Static memory plan fallback for output " << b.output
+            << " of node " << b.node_id << " (" << num_bytes << " bytes)";
+    return fallback_->AllocateRaw(alignment, num_bytes);
+  }
+  Ref();
+  return base_ + b.offset;
+}
+
+void StaticMemorySlab::DeallocateBuffer(int buffer, void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  // Buffers may be released after the plan is gone, so only look at members
+  // of the slab.
+  if (p < base_ || p >= base_ + size_) {
+    fallback_->DeallocateRaw(ptr);
+    return;
+  }
+  {
+    mutex_lock l(mu_);
+    DCHECK(live_[buffer]);
+    live_[buffer] = false;
+  }
+  // May delete this.
+  Unref();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,138 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLANNER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLANNER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Returns in '*output_bytes', indexed by node id and output index, the size
+// in bytes of every node output whose shape is fully known from shape
+// inference, or -1.
+void InferStaticOutputBytes(const Graph& graph,
+                            std::vector<std::vector<int64>>* output_bytes);
+
+// A plan placing node outputs of a loop-free graph at offsets in a single
+// slab of memory, in the spirit of TF Lite's ArenaPlanner.
+//
+// Two outputs share memory only if the lifetime of one of them is ordered
+// before the other by the edges of the graph: every consumer of the first (or
+// its producer, if it has none) is an ancestor of the producer of the second.
+// Ancestry is checked with a bounded search, so in very large graphs some
+// outputs that could share memory do not.
+// Placement is greedy, largest output first, at the lowest offset that does
+// not overlap an output with a concurrent lifetime.
+class StaticMemoryPlan {
+ public:
+  struct Buffer {
+    int node_id;
+    int output;
+    int64 offset;
+    int64 size;
+    // The other buffers that share memory with this one.
+    std::vector<int> overlapping;
+  };
+
+  // Plans the outputs for which 'output_bytes[node id][output]' is positive.
+  // Returns an error if the graph has a cycle.
+  static Status Create(const Graph& graph,
+                       const std::vector<std::vector<int64>>& output_bytes,
+                       std::unique_ptr<StaticMemoryPlan>* plan);
+
+  int64 slab_size() const { return slab_size_; }
+  const std::vector<Buffer>& buffers() const { return buffers_; }
+
+  // Outputs are numbered contiguously for each node with planned outputs.
+  // Returns the number of the first output of 'node_id', or -1 if none of its
+  // outputs are planned.
+  int output_base(int node_id) const { return output_base_[node_id]; }
+  int num_outputs() const { return buffer_for_output_.size(); }
+  // Returns the buffer index for output number 'i', or -1.
+  int buffer_for_output(int i) const { return buffer_for_output_[i]; }
+
+ private:
+  StaticMemoryPlan() {}
+
+  int64 slab_size_ = 0;
+  std::vector<Buffer> buffers_;
+  std::vector<int> output_base_;
+  std::vector<int> buffer_for_output_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemoryPlan);
+};
+
+// The memory for one step run with a StaticMemoryPlan.
+//
+// Each planned output is allocated through an Allocator of its own, which
+// hands out the planned range of the slab unless a buffer sharing that range
+// is still live, or the request is larger than planned; in that case it
+// delegates to 'fallback'.  The check makes the slab safe even if a kernel
+// forwards or retains an output against the plan.  Every live buffer holds a
+// reference on the slab.
+class StaticMemorySlab : public core::RefCounted {
+ public:
+  StaticMemorySlab(const StaticMemoryPlan* plan, Allocator* fallback);
+  ~StaticMemorySlab() override;
+
+  // Indexed by planned output number; null for outputs that are not planned.
+  Allocator* const* output_allocators() const {
+    return output_allocators_.data();
+  }
+
+  int64 num_planned_allocs() {
+    mutex_lock l(mu_);
+    return num_planned_allocs_;
+  }
+  int64 num_fallback_allocs() {
+    mutex_lock l(mu_);
+    return num_fallback_allocs_;
+  }
+
+ private:
+  class BufferAllocator;
+
+  void* AllocateBuffer(int buffer, size_t alignment, size_t num_bytes);
+  void DeallocateBuffer(int buffer, void* ptr);
+
+  // Only valid while the owner of the plan runs steps with this slab.
+  const StaticMemoryPlan* const plan_;
+  Allocator* const fallback_;
+  const int64 size_;
+  char* const base_;
+  std::vector<std::unique_ptr<BufferAllocator>> buffer_allocators_;
+  std::vector<Allocator*> output_allocators_;
+
+  mutex mu_;
+  std::vector<bool> live_ GUARDED_BY(mu_);
+  int64 num_planned_allocs_ GUARDED_BY(mu_) = 0;
+  int64 num_fallback_allocs_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticMemorySlab);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLANNER_H_
@@ -0,0 +1,133 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/static_memory_planner.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class StaticMemoryPlannerTest : public ::testing::Test {
+ protected:
+  StaticMemoryPlannerTest() : graph_(OpRegistry::Global()) {
+    Tensor t(DT_FLOAT, TensorShape({256}));
+    t.flat<float>().setZero();
+    input_ = test::graph::Constant(&graph_, t);
+  }
+
+  // Plans every output of every node but the input.
+  std::unique_ptr<StaticMemoryPlan> Plan() {
+    FixupSourceAndSinkEdges(&graph_);
+    std::vector<std::vector<int64>> output_bytes;
+    InferStaticOutputBytes(graph_, &output_bytes);
+    output_bytes[input_->id()].assign(1, -1);
+    std::unique_ptr<StaticMemoryPlan> plan;
+    TF_CHECK_OK(StaticMemoryPlan::Create(graph_, output_bytes, &plan));
+    return plan;
+  }
+
+  const StaticMemoryPlan::Buffer& BufferFor(const StaticMemoryPlan& plan,
+                                            const Node* n) {
+    return plan.buffers()[plan.buffer_for_output(plan.output_base(n->id()))];
+  }
+
+  Graph graph_;
+  Node* input_;
+};
+
+TEST_F(StaticMemoryPlannerTest, InferStaticOutputBytes) {
+  Node* neg = test::graph::Unary(&graph_, "Neg", input_);
+  FixupSourceAndSinkEdges(&graph_);
+  std::vector<std::vector<int64>> output_bytes;
+  InferStaticOutputBytes(graph_, &output_bytes);
+  EXPECT_EQ(output_bytes[input_->id()], std::vector<int64>({1024}));
+  EXPECT_EQ(output_bytes[neg->id()], std::vector<int64>({1024}));
+}
+
+TEST_F(StaticMemoryPlannerTest, ChainReusesMemory) {
+  std::vector<Node*> chain;
+  Node* last = input_;
+  for (int i = 0; i < 4; ++i) {
+    last = test::graph::Unary(&graph_, "Neg", last);
+    chain.push_back(last);
+  }
+  std::unique_ptr<StaticMemoryPlan> plan = Plan();
+  ASSERT_EQ(plan->buffers().size(), 4);
+  // An output is live while its consumer runs, so two buffers are needed.
+  EXPECT_EQ(plan->slab_size(), 2 * 1024);
+  EXPECT_EQ(BufferFor(*plan, chain[0]).offset,
+            BufferFor(*plan, chain[2]).offset);
+  EXPECT_EQ(BufferFor(*plan, chain[1]).offset,
+            BufferFor(*plan, chain[3]).offset);
+  EXPECT_NE(BufferFor(*plan, chain[0]).offset,
+            BufferFor(*plan, chain[1]).offset);
+}
+
+TEST_F(StaticMemoryPlannerTest, ConcurrentBranchesDoNotShare) {
+  Node* x = test::graph::Unary(&graph_, "Neg", input_);
+  Node* y = test::graph::Unary(&graph_, "Neg", input_);
+  Node* z = test::graph::Add(&graph_, x, y);
+  std::unique_ptr<StaticMemoryPlan> plan = Plan();
+  ASSERT_EQ(plan->buffers().size(), 3);
+  EXPECT_EQ(plan->slab_size(), 3 * 1024);
+  EXPECT_NE(BufferFor(*plan, x).offset, BufferFor(*plan, y).offset);
+  EXPECT_NE(BufferFor(*plan, x).offset, BufferFor(*plan, z).offset);
+  EXPECT_NE(BufferFor(*plan, y).offset, BufferFor(*plan, z).offset);
+}
+
+TEST_F(StaticMemoryPlannerTest, SlabFallsBackWhileOverlappingBufferIsLive) {
+  Node* a = test::graph::Unary(&graph_, "Neg", input_);
+  Node* b = test::graph::Unary(&graph_, "Neg", a);
+  Node* c = test::graph::Unary(&graph_, "Neg", b);
+  std::unique_ptr<StaticMemoryPlan> plan = Plan();
+  ASSERT_EQ(BufferFor(*plan, a).offset, BufferFor(*plan, c).offset);
+
+  StaticMemorySlab* slab = new StaticMemorySlab(plan.get(), cpu_allocator());
+  Allocator* alloc_a = slab->output_allocators()[plan->output_base(a->id())];
+  Allocator* alloc_c = slab->output_allocators()[plan->output_base(c->id())];
+  {
+    Tensor ta(alloc_a, DT_FLOAT, TensorShape({256}));
+    // 'a' is kept alive, e.g. by a kernel that retained it, so 'c' must not
+    // reuse its memory.
+    Tensor tc(alloc_c, DT_FLOAT, TensorShape({256}));
+    EXPECT_NE(ta.tensor_data().data(), tc.tensor_data().data());
+    EXPECT_EQ(slab->num_planned_allocs(), 1);
+    EXPECT_EQ(slab->num_fallback_allocs(), 1);
+  }
+  {
+    Tensor ta(alloc_a, DT_FLOAT, TensorShape({256}));
+    const char* data_a = ta.tensor_data().data();
+    ta = Tensor();
+    Tensor tc(alloc_c, DT_FLOAT, TensorShape({256}));
+    EXPECT_EQ(data_a, tc.tensor_data().data());
+    // Larger than planned.
+    Tensor tb(slab->output_allocators()[plan->output_base(b->id())], DT_FLOAT,
+              TensorShape({512}));
+    EXPECT_EQ(slab->num_planned_allocs(), 3);
+    EXPECT_EQ(slab->num_fallback_allocs(), 2);
+    EXPECT_FALSE(slab->RefCountIsOne());
+  }
+  EXPECT_TRUE(slab->RefCountIsOne());
+  slab->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
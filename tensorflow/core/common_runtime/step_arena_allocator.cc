@@ -0,0 +1,138 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(size_t block_size)
+    : block_size_(block_size), arena_(block_size) {}
+
+StepArenaAllocator::~StepArenaAllocator() {
+  mutex_lock l(mu_);
+  CHECK_EQ(num_live_allocs_, 0)
+      << "StepArenaAllocator destroyed with live allocations";
+}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  if (num_bytes == 0) {
+    return nullptr;
+  }
+  alignment = std::max(alignment, size_t{core::Arena::kDefaultAlignment});
+  mutex_lock l(mu_);
+  void* ptr = arena_.AllocAligned(num_bytes, alignment);
+  ++num_live_allocs_;
+  bytes_allocated_ += num_bytes + alignment;
+  largest_alloc_size_ = std::max(largest_alloc_size_, num_bytes);
+  const char* begin = static_cast<const char*>(ptr);
+  if (!ranges_.empty() && begin >= ranges_.back().second &&
+      begin - ranges_.back().second < static_cast<ptrdiff_t>(alignment)) {
+    ranges_.back().second = begin + num_bytes;
+  } else {
+    ranges_.emplace_back(begin, begin + num_bytes);
+  }
+
+  ++stats_.num_allocs;
+  stats_.bytes_in_use = bytes_allocated_;
+  stats_.peak_bytes_in_use =
+      std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+  stats_.largest_alloc_size =
+      std::max<int64>(stats_.largest_alloc_size, num_bytes);
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  mutex_lock l(mu_);
+  --num_live_allocs_;
+  DCHECK_GE(num_live_allocs_, 0);
+}
+
+absl::optional<AllocatorStats> StepArenaAllocator::GetStats() {
+  mutex_lock l(mu_);
+  return stats_;
+}
+
+bool StepArenaAllocator::Reset() {
+  mutex_lock l(mu_);
+  if (num_live_allocs_ != 0) {
+    return false;
+  }
+  arena_.Reset();
+  ranges_.clear();
+  bytes_allocated_ = 0;
+  largest_alloc_size_ = 0;
+  stats_.bytes_in_use = 0;
+  return true;
+}
+
+bool StepArenaAllocator::Owns(const void* ptr) {
+  const char* p = static_cast<const char*>(ptr);
+  mutex_lock l(mu_);
+  for (const auto& range : ranges_) {
+    if (p >= range.first && p < range.second) return true;
+  }
+  return false;
+}
+
+size_t StepArenaAllocator::RequiredBlockSize() {
+  mutex_lock l(mu_);
+  // core::Arena serves allocations of more than a quarter of its block size
+  // from blocks of their own.
+  return std::max(bytes_allocated_, 4 * largest_alloc_size_);
+}
+
+StepArenaAllocatorPool::StepArenaAllocatorPool(size_t min_block_size,
+                                               size_t max_block_size)
+    : max_block_size_(max_block_size), block_size_(min_block_size) {}
+
+StepArenaAllocatorPool::~StepArenaAllocatorPool() {}
+
+StepArenaAllocator* StepArenaAllocatorPool::Get() {
+  mutex_lock l(mu_);
+  while (!free_.empty()) {
+    std::unique_ptr<StepArenaAllocator> allocator = std::move(free_.back());
+    free_.pop_back();
+    if (allocator->block_size() >= block_size_) {
+      return allocator.release();
+    }
+  }
+  return new StepArenaAllocator(block_size_);
+}
+
+void StepArenaAllocatorPool::Release(StepArenaAllocator* allocator) {
+  const size_t required_block_size = allocator->RequiredBlockSize();
+  if (!allocator->Reset()) {
+    LOG(ERROR) << "Tensors allocated from a step arena outlived their step; "
+               << "leaking " << required_block_size << " bytes.";
+    return;
+  }
+  mutex_lock l(mu_);
+  if (required_block_size > block_size_ && block_size_ < max_block_size_) {
+    block_size_ = std::min(required_block_size, max_block_size_);
+  }
+  if (allocator->block_size() < block_size_) {
+    delete allocator;
+  } else {
+    free_.emplace_back(allocator);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,107 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/arena.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An Allocator that carves memory out of a core::Arena and releases all of
+// it at once when Reset() is called at the end of a step.  DeallocateRaw() only
+// updates the count of live allocations.
+//
+// It is meant for tensors that the executor has proven not to outlive the
+// step, so that they cost a pointer bump instead of a malloc/free pair.
+class StepArenaAllocator : public Allocator {
+ public:
+  explicit StepArenaAllocator(size_t block_size);
+  ~StepArenaAllocator() override;
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  absl::optional<AllocatorStats> GetStats() override;
+
+  // Releases all memory allocated since the last call to Reset(), and returns
+  // true.  Returns false, and leaves the memory untouched, if some of it has
+  // not been deallocated.
+  bool Reset();
+
+  size_t block_size() const { return block_size_; }
+
+  // Returns the block size that would have let all allocations since the last
+  // call to Reset() be served from the first block of the arena.
+  size_t RequiredBlockSize();
+
+  // Returns true iff 'ptr' points into memory allocated since the last call
+  // to Reset().
+  bool Owns(const void* ptr);
+
+ private:
+  const size_t block_size_;
+
+  mutex mu_;
+  core::Arena arena_ GUARDED_BY(mu_);
+  int64 num_live_allocs_ GUARDED_BY(mu_) = 0;
+  // Bytes handed out since the last Reset(), including alignment padding.
+  size_t bytes_allocated_ GUARDED_BY(mu_) = 0;
+  size_t largest_alloc_size_ GUARDED_BY(mu_) = 0;
+  AllocatorStats stats_ GUARDED_BY(mu_);
+  // Address ranges allocated since the last Reset().  Allocations that follow
+  // each other in one arena block are merged into a single range.
+  std::vector<std::pair<const char*, const char*>> ranges_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+// A pool of StepArenaAllocators shared by the concurrent steps of one
+// executor.  The block size of the arenas grows to the largest requirement
+// seen so far, up to 'max_block_size', so that a steady-state step allocates
+// from a single block without calling into the system allocator.
+class StepArenaAllocatorPool {
+ public:
+  StepArenaAllocatorPool(size_t min_block_size, size_t max_block_size);
+  ~StepArenaAllocatorPool();
+
+  // Returns an allocator for the exclusive use of one step.
+  StepArenaAllocator* Get();
+
+  // Returns 'allocator', which must have been returned by Get(), to the pool.
+  // If any of its allocations are still live, the allocator and its memory
+  // are leaked rather than reused.
+  void Release(StepArenaAllocator* allocator);
+
+ private:
+  const size_t max_block_size_;
+
+  mutex mu_;
+  size_t block_size_ GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<StepArenaAllocator>> free_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocatorPool);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,134 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StepArenaAllocatorTest, AllocationsAreAlignedAndDisjoint) {
+  StepArenaAllocator a(1 << 16);
+  std::vector<std::pair<char*, size_t>> ptrs;
+  for (size_t s = 1; s < 4096; s += 61) {
+    char* p = static_cast<char*>(
+        a.AllocateRaw(Allocator::kAllocatorAlignment, s));
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(0,
+              reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment);
+    ptrs.emplace_back(p, s);
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < ptrs.size(); ++i) {
+    EXPECT_GE(ptrs[i].first - ptrs[i - 1].first, ptrs[i - 1].second);
+  }
+  for (const auto& p : ptrs) {
+    a.DeallocateRaw(p.first);
+  }
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_allocs, ptrs.size());
+  EXPECT_TRUE(a.Reset());
+}
+
+TEST(StepArenaAllocatorTest, ResetFailsWithLiveAllocations) {
+  StepArenaAllocator a(1 << 16);
+  void* p = a.AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  EXPECT_FALSE(a.Reset());
+  a.DeallocateRaw(p);
+  EXPECT_TRUE(a.Reset());
+}
+
+TEST(StepArenaAllocatorTest, Tensors) {
+  StepArenaAllocator a(1 << 16);
+  {
+    Tensor t1(&a, DT_FLOAT, TensorShape({16, 16}));
+    Tensor t2(&a, DT_INT32, TensorShape({1000}));
+    Tensor t3(&a, DT_FLOAT, TensorShape({0}));
+    t1.flat<float>().setZero();
+    t2.flat<int32>().setConstant(7);
+    EXPECT_FALSE(a.Reset());
+  }
+  EXPECT_TRUE(a.Reset());
+}
+
+TEST(StepArenaAllocatorTest, Owns) {
+  StepArenaAllocator a(1 << 12);
+  char outside[64];
+  std::vector<std::pair<char*, size_t>> ptrs;
+  // Large enough to spill into several arena blocks.
+  for (size_t s = 100; s < 10000; s += 997) {
+    char* p = static_cast<char*>(
+        a.AllocateRaw(Allocator::kAllocatorAlignment, s));
+    ptrs.emplace_back(p, s);
+  }
+  for (const auto& p : ptrs) {
+    EXPECT_TRUE(a.Owns(p.first));
+    EXPECT_TRUE(a.Owns(p.first + p.second - 1));
+  }
+  EXPECT_FALSE(a.Owns(outside));
+  for (const auto& p : ptrs) {
+    a.DeallocateRaw(p.first);
+  }
+  EXPECT_TRUE(a.Reset());
+  EXPECT_FALSE(a.Owns(ptrs[0].first));
+}
+
+TEST(StepArenaAllocatorPoolTest, BlockSizeGrows) {
+  StepArenaAllocatorPool pool(1 << 12, 1 << 20);
+  StepArenaAllocator* a = pool.Get();
+  EXPECT_EQ(a->block_size(), 1 << 12);
+  // Larger than a quarter of the block, so served from a block of its own.
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 14);
+  a->DeallocateRaw(p);
+  pool.Release(a);
+
+  a = pool.Get();
+  EXPECT_EQ(a->block_size(), 1 << 16);
+  pool.Release(a);
+
+  // The block size is capped.
+  a = pool.Get();
+  p = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  a->DeallocateRaw(p);
+  pool.Release(a);
+  a = pool.Get();
+  EXPECT_EQ(a->block_size(), 1 << 20);
+  pool.Release(a);
+}
+
+static void BM_StepArenaAllocation(int iters, int num_allocs) {
+  StepArenaAllocatorPool pool(1 << 20, 1 << 28);
+  std::vector<void*> ptrs(num_allocs);
+  while (--iters > 0) {
+    StepArenaAllocator* a = pool.Get();
+    for (int i = 0; i < num_allocs; ++i) {
+      ptrs[i] = a->AllocateRaw(Allocator::kAllocatorAlignment, 256 + i * 64);
+    }
+    for (void* p : ptrs) {
+      a->DeallocateRaw(p);
+    }
+    pool.Release(a);
+  }
+}
+BENCHMARK(BM_StepArenaAllocation)->Arg(16)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
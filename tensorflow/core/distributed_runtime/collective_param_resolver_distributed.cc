@@ -57,6 +57,8 @@ class CompleteInstanceCall : public CancellableCall {
     req_.set_type(instance.type);
     req_.set_data_type(instance.data_type);
     instance.shape.AsProto(req_.mutable_shape());
+    req_.set_compression(instance.compression);
+    req_.set_topk_ratio(instance.topk_ratio);
     req_.set_group_key(group.group_key);
     req_.set_group_size(group.group_size);
     req_.set_instance_key(instance.instance_key);
@@ -160,6 +162,11 @@ void CollectiveParamResolverDistributed::CompleteInstanceAsync(
   cp->instance.instance_key = request->instance_key();
   cp->instance.data_type = request->data_type();
   cp->instance.shape = TensorShape(request->shape());
+  // Requests from workers that predate compression leave it empty.
+  if (!request->compression().empty()) {
+    cp->instance.compression = request->compression();
+  }
+  cp->instance.topk_ratio = request->topk_ratio();
   for (int32 offset : request->subdiv_offset()) {
     cp->instance.impl_details.subdiv_offsets.push_back(offset);
   }
@@ -313,6 +313,11 @@ TEST_F(DeviceResDistTest, Workers2Devices2) {
   DefineCollectiveParams(num_workers, num_devices);
   IssueRequests(num_workers, num_devices);
   ValidateCollectiveParams(num_workers, num_devices);
+  // Small reductions over several devices per task reduce within each task
+  // first.
+  for (const CollectiveParams& cp : cp_) {
+    EXPECT_EQ("HierarchicalReduce", cp.instance.impl_details.collective_name);
+  }
 }
 
 #ifndef GOOGLE_CUDA
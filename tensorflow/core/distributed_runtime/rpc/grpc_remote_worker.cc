@@ -61,6 +61,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         cleanupall_(Method(GrpcWorkerMethod::kCleanupAll)),
         recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
         recvbuf_(Method(GrpcWorkerMethod::kRecvBuf)),
+        batchrecvtensor_(Method(GrpcWorkerMethod::kBatchRecvTensor)),
         logging_(Method(GrpcWorkerMethod::kLogging)),
         tracing_(Method(GrpcWorkerMethod::kTracing)),
         completegroup_(Method(GrpcWorkerMethod::kCompleteGroup)),
@@ -253,6 +254,49 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, recvtensor_, callback, call_opts);
   }
 
+  void BatchRecvTensorAsync(CallOptions* call_opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override {
+    VLOG(1) << "BatchRecvTensorAsync step " << request->step_id() << ": "
+            << request->requests_size() << " tensors";
+    int64 start_usec = Env::Default()->NowMicros();
+    bool logging_active = logger_->LoggingActive();
+
+    auto callback = [this, request, response, done, start_usec,
+                     logging_active](Status s) {
+      if (logging_active && logger_->LoggingActive() && s.ok()) {
+        int64 end_usec = Env::Default()->NowMicros();
+        for (int i = 0; i < response->responses_size(); ++i) {
+          const RecvTensorResponse& r = response->responses(i);
+          int64 send_start_usec = start_usec;
+          if (r.send_start_micros()) {
+            send_start_usec = std::max(
+                start_usec, static_cast<int64>(r.send_start_micros()));
+            send_start_usec = std::min(send_start_usec, end_usec - 1);
+          }
+          const string& key =
+              request->requests(response->request_index(i)).rendezvous_key();
+          std::vector<string> key_parts = str_util::Split(key, ';');
+          if (key_parts.size() != 5) {
+            LOG(WARNING) << "Bad key: " << key;
+          } else {
+            logger_->RecordDataTransfer(request->step_id(), send_start_usec,
+                                        end_usec,
+                                        key_parts[3],  // tensor name
+                                        key_parts[0],  // src_device
+                                        key_parts[2],  // dst_device
+                                        r.tensor().tensor_content().size(),
+                                        "", "BatchRecvTensor");
+          }
+        }
+      }
+      done(s);
+    };
+
+    IssueRequest(request, response, batchrecvtensor_, callback, call_opts);
+  }
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override {
     IssueRequest(request, response, logging_, done);
@@ -311,6 +355,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string cleanupall_;
   const ::grpc::string recvtensor_;
   const ::grpc::string recvbuf_;
+  const ::grpc::string batchrecvtensor_;
   const ::grpc::string logging_;
   const ::grpc::string tracing_;
   const ::grpc::string completegroup_;
@@ -490,6 +490,124 @@ TEST(GrpcSessionTest, LargeTensorSend) {
   TF_CHECK_OK(session->Close());
 }
 
+// Makes a cluster of two workers whose rendezvous managers coalesce the
+// receives issued within 10ms into BatchRecvTensor calls.
+void MakeBatchingTestCluster(std::unique_ptr<test::TestCluster>* cluster) {
+  // The test servers inherit this environment.
+  setenv("TF_RPC_RECV_TENSOR_BATCH_WINDOW_US", "10000", 1);
+  setenv("TF_RPC_RECV_TENSOR_MAX_BATCH_SIZE", "4", 1);
+  TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 0), 2, cluster));
+  unsetenv("TF_RPC_RECV_TENSOR_BATCH_WINDOW_US");
+  unsetenv("TF_RPC_RECV_TENSOR_MAX_BATCH_SIZE");
+}
+
+// Returns the number of RPCs named `method` in `ss`.
+int CountRPCs(const StepStats& ss, const string& method) {
+  int count = 0;
+  for (const auto& dev : ss.dev_stats()) {
+    for (const auto& node : dev.node_stats()) {
+      if (node.node_name() == method) ++count;
+    }
+  }
+  return count;
+}
+
+TEST(GrpcSessionTest, BatchedRecvTensor) {
+  std::unique_ptr<test::TestCluster> cluster;
+  MakeBatchingTestCluster(&cluster);
+
+  // sum = v0 + v1 + ... + v9, with every v on the second worker.
+  Graph graph(OpRegistry::Global());
+  std::vector<Node*> values;
+  for (int i = 0; i < 10; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2}));
+    test::FillValues<float>(&t, {static_cast<float>(i), -1.0f});
+    values.push_back(test::graph::Constant(&graph, t));
+  }
+  std::vector<Node*> adds;
+  Node* sum = values[0];
+  for (size_t i = 1; i < values.size(); ++i) {
+    sum = test::graph::Binary(&graph, "Add", sum, values[i]);
+    adds.push_back(sum);
+  }
+
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  for (Node* n : values) {
+    SetDevice(&def, n->name(), cluster->devices()[1].name());
+  }
+  for (Node* n : adds) {
+    SetDevice(&def, n->name(), cluster->devices()[0].name());
+  }
+
+  SessionOptions options = Options(cluster->targets()[0], 1000);
+  // Keep the constants from being folded into the consumers.
+  options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  std::unique_ptr<Session> session(NewRemote(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(def));
+  int num_batched_recvs = 0;
+  for (int iters = 0; iters < 3; ++iters) {
+    std::vector<Tensor> outputs;
+    RunOptions run_options;
+    run_options.set_trace_level(RunOptions::FULL_TRACE);
+    RunMetadata metadata;
+    TF_CHECK_OK(session->Run(run_options, {}, {sum->name()}, {}, &outputs,
+                             &metadata));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({45.0f, -10.0f}, TensorShape({2})), outputs[0]);
+    // The RPC log of the step records each tensor received by a
+    // BatchRecvTensor call.  Logging is enabled asynchronously, so only
+    // the total over all the steps is checked.
+    num_batched_recvs += CountRPCs(metadata.step_stats(), "BatchRecvTensor");
+    EXPECT_EQ(0, CountRPCs(metadata.step_stats(), "RecvTensor"));
+  }
+  EXPECT_GT(num_batched_recvs, 0);
+  TF_CHECK_OK(session->Close());
+}
+
+TEST(GrpcSessionTest, BatchedRecvTensorCrossWorkerDependency) {
+  std::unique_ptr<test::TestCluster> cluster;
+  MakeBatchingTestCluster(&cluster);
+
+  // The second worker receives `a` and `c` from the first one in the same
+  // batch, but `c` can only be computed once the second worker has
+  // received `a`.
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&a_tensor, {1.0f, -1.0f});
+  Node* a = test::graph::Constant(&graph, a_tensor);
+  Node* b = test::graph::Unary(&graph, "Neg", a);
+  Node* c = test::graph::Unary(&graph, "Neg", b);
+  Node* d = test::graph::Binary(&graph, "Add", a, c);
+
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+  SetDevice(&def, a->name(), cluster->devices()[0].name());
+  SetDevice(&def, b->name(), cluster->devices()[1].name());
+  SetDevice(&def, c->name(), cluster->devices()[0].name());
+  SetDevice(&def, d->name(), cluster->devices()[1].name());
+
+  SessionOptions options = Options(cluster->targets()[0], 1000);
+  options.config.mutable_graph_options()
+      ->mutable_rewrite_options()
+      ->set_disable_meta_optimizer(true);
+  std::unique_ptr<Session> session(NewRemote(options));
+  ASSERT_TRUE(session != nullptr);
+  TF_CHECK_OK(session->Create(def));
+  for (int iters = 0; iters < 3; ++iters) {
+    std::vector<Tensor> outputs;
+    TF_CHECK_OK(session->Run({}, {d->name()}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({2.0f, -2.0f}, TensorShape({2})), outputs[0]);
+  }
+  TF_CHECK_OK(session->Close());
+}
+
 TEST(GrpcSessionTest, MultiDevices_String) {
   std::unique_ptr<test::TestCluster> cluster;
   TF_CHECK_OK(test::TestCluster::MakeTestCluster(Devices(1, 1), 2, &cluster));
@@ -137,12 +137,22 @@ static void EncodeSkeleton(const Tensor& val, io::ProtoEncodeHelper* e) {
 
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result) {
+  EncodeCompressedTensorToByteBuffer(is_dead, val, "", require_ack, result);
+}
+
+void EncodeCompressedTensorToByteBuffer(bool is_dead, const Tensor& val,
+                                        const string& compression,
+                                        bool require_ack,
+                                        ::grpc::ByteBuffer* result) {
   const int kLargeTensorBytes = 1024;
   RecvTensorResponse response;
   if (is_dead) {
     response.set_is_dead(is_dead);
   }
   response.set_require_ack(require_ack);
+  if (!compression.empty()) {
+    response.set_compression(compression);
+  }
   response.set_send_start_micros(Env::Default()->NowMicros());
   if (!DataTypeCanUseMemcpy(val.dtype())) {
     // Straightforward but slow path for complicated kinds of tensor data
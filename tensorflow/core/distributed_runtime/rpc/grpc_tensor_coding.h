@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_TENSOR_CODING_H_
 
 #include "grpcpp/impl/codegen/byte_buffer.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 class Tensor;
@@ -49,6 +50,14 @@ void EncodeRecvTensorResponseToByteBuffer(const RecvTensorResponse& proto,
 void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
                               ::grpc::ByteBuffer* result);
 
+// Like EncodeTensorToByteBuffer, where "val" is the encoding of a float
+// tensor with the lossy encoding "compression" (see
+// "RecvTensorResponse::compression").
+void EncodeCompressedTensorToByteBuffer(bool is_dead, const Tensor& val,
+                                        const string& compression,
+                                        bool require_ack,
+                                        ::grpc::ByteBuffer* result);
+
 }  // namespace grpc
 }  // namespace tensorflow
 
@@ -144,6 +144,7 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(CompleteInstance, 10, true);
     SETUP_FOR_REQUEST(GetStepSequence, 10, true);
     SETUP_FOR_REQUEST(RecvBuf, 500, true);
+    SETUP_FOR_REQUEST(BatchRecvTensor, 100, true);
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
@@ -300,6 +301,25 @@ class GrpcWorkerServiceThread {
     ENQUEUE_REQUEST(RecvBuf, true);
   }
 
+  void BatchRecvTensorHandler(
+      WorkerCall<BatchRecvTensorRequest, BatchRecvTensorResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->BatchRecvTensorAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(1) << "Bad response from BatchRecvTensor:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    ENQUEUE_REQUEST(BatchRecvTensor, true);
+  }
+
   void CompleteGroupHandler(
       WorkerCall<CompleteGroupRequest, CompleteGroupResponse>* call) {
     Schedule([this, call]() {
@@ -428,7 +448,24 @@ GrpcWorker::GrpcWorker(WorkerEnv* worker_env, const ConfigProto& config)
       recv_buf_max_chunk_(
           config.experimental().recv_buf_max_chunk() > 0
               ? config.experimental().recv_buf_max_chunk()
-              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)) {}
+              : (config.experimental().recv_buf_max_chunk() < 0 ? 0 : 4096)) {
+  const string& compression = config.experimental().recv_tensor_compression();
+  if (!compression.empty()) {
+    Status s = CollectiveCompressor::Create(compression, 0,
+                                            &recv_tensor_compressor_);
+    if (s.ok() && recv_tensor_compressor_ != nullptr &&
+        !recv_tensor_compressor_->compresses_gather()) {
+      // The encoding must have the shape of the tensor.
+      s = errors::InvalidArgument(compression, " is not supported");
+    }
+    if (!s.ok()) {
+      LOG(ERROR) << "Ignoring recv_tensor_compression: " << s;
+      recv_tensor_compressor_.reset();
+    } else if (recv_tensor_compressor_ != nullptr) {
+      recv_tensor_compression_ = compression;
+    }
+  }
+}
 
 void GrpcWorker::EnableResponseCache() {
   VLOG(1) << "Enabling gRPC tensor response cache.";
@@ -446,12 +483,25 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   const int64 step_id = request->step_id();
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
+  CollectiveCompressor* compressor =
+      request->accept_compression() ? recv_tensor_compressor_.get() : nullptr;
+  const string& compression = recv_tensor_compression_;
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  auto do_response = [response, done, cache_enabled, compressor, compression](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      if (compressor != nullptr && !is_dead && tensor.dtype() == DT_FLOAT) {
+        // The tensor is in host memory, see RecvLocalTensorAsync().
+        Tensor encoded(compressor->encoded_dtype(), tensor.shape());
+        compressor->Encode(tensor, 0, tensor.NumElements(),
+                           /*error_feedback=*/false, &encoded);
+        grpc::EncodeCompressedTensorToByteBuffer(is_dead, encoded, compression,
+                                                 cache_enabled, response);
+      } else {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+      }
     }
     done(status);
   };
@@ -487,34 +537,43 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
     return;
   }
 
-  const string& key = request->rendezvous_key();
+  // Request the tensor associated with the rendezvous key.
+  // Note that we log the cancellation here but do not abort the current step.
+  // gRPC can generate cancellations in response to transient network failures,
+  // and aborting the step eliminates the opportunity for client side retries.
+  // Repeated client failures will eventually cause the step to be aborted by
+  // the client.
+  opts->SetCancelCallback(
+      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
+  RecvLocalTensorAsync(
+      step_id, request->rendezvous_key(),
+      [opts, rendezvous_done](const Tensor& val, bool is_dead,
+                              const Status& status) {
+        opts->ClearCancelCallback();
+        rendezvous_done(val, is_dead, status);
+      });
+}
+
+void GrpcWorker::RecvLocalTensorAsync(int64 step_id, const string& key,
+                                      RecvLocalTensorCallback done) {
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
-  s = Rendezvous::ParseKey(key, &parsed);
+  Status s = Rendezvous::ParseKey(key, &parsed);
   Device* src_dev = nullptr;
   if (s.ok()) {
     s = PrepareRecvTensor(parsed, &src_dev);
   }
   if (!s.ok()) {
-    fail(s);
+    done(Tensor(), false, s);
     return;
   }
 
-  // Request the tensor associated with the rendezvous key.
-  // Note that we log the cancellation here but do not abort the current step.
-  // gRPC can generate cancellations in response to transient network failures,
-  // and aborting the step eliminates the opportunity for client side retries.
-  // Repeated client failures will eventually cause the step to be aborted by
-  // the client.
-  opts->SetCancelCallback(
-      [step_id]() { LOG(WARNING) << "RecvTensor cancelled for " << step_id; });
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, rendezvous_done, src_dev, request](
-          const Status& status, const Rendezvous::Args& send_args,
-          const Rendezvous::Args& recv_args, const Tensor& val,
-          const bool is_dead) {
-        opts->ClearCancelCallback();
+      [done, src_dev, key](const Status& status,
+                           const Rendezvous::Args& send_args,
+                           const Rendezvous::Args& recv_args, const Tensor& val,
+                           const bool is_dead) {
         if (status.ok()) {
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
@@ -537,24 +596,182 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on an accelerator device. Uses the device_context to
               // fill the copy on host.
-              StatusCallback copy_ready = [rendezvous_done, copy,
+              StatusCallback copy_ready = [done, copy,
                                            is_dead](const Status& s) {
                 // The value is now ready to be returned on the wire.
-                rendezvous_done(*copy, is_dead, s);
+                done(*copy, is_dead, s);
                 delete copy;
               };
 
-              send_dev_context->CopyDeviceTensorToCPU(
-                  &val, request->rendezvous_key(), src_dev, copy, copy_ready);
+              send_dev_context->CopyDeviceTensorToCPU(&val, key, src_dev, copy,
+                                                      copy_ready);
               return;
             }
           }
         }
 
-        rendezvous_done(val, is_dead, status);
+        done(val, is_dead, status);
       });
 }
 
+// State of one BatchRecvTensor call.
+struct GrpcWorker::BatchRecvCall {
+  CallOptions* opts;
+  const BatchRecvTensorRequest* request;
+  BatchRecvTensorResponse* response;
+  StatusCallback done;
+  // Set once every requested tensor has been registered.
+  bool armed = false;
+};
+
+// BatchRecvTensorAsync encodes the tensors into an ordinary protocol buffer.
+// It is meant for many small tensors, where the per-RPC overhead of
+// RecvTensor dominates and the extra copy does not matter.
+//
+// The response is sent as soon as any of the requested tensors is
+// available, and contains the tensors available at that time.  The others
+// are kept in `pending_batch_recvs_` until the receiver asks for them again,
+// so that a tensor that depends on another one in the same batch (possibly
+// through the receiving worker) does not deadlock the batch.
+void GrpcWorker::BatchRecvTensorAsync(CallOptions* opts,
+                                      const BatchRecvTensorRequest* request,
+                                      BatchRecvTensorResponse* response,
+                                      StatusCallback done) {
+  const int64 step_id = request->step_id();
+  response->Clear();
+  for (const RecvTensorRequest& r : request->requests()) {
+    if (r.step_id() != step_id) {
+      done(errors::InvalidArgument("BatchRecvTensor for step ", step_id,
+                                   " contains a request for step ",
+                                   r.step_id()));
+      return;
+    }
+  }
+  if (request->requests_size() == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  BatchRecvCall* call = new BatchRecvCall;
+  call->opts = opts;
+  call->request = request;
+  call->response = response;
+  call->done = std::move(done);
+
+  // Register the call as the waiter of every requested tensor, and start
+  // receiving the tensors that were not requested before.
+  std::vector<int> to_start;
+  Status s;
+  {
+    mutex_lock l(batch_recv_mu_);
+    for (int i = 0; i < request->requests_size() && s.ok(); ++i) {
+      const RecvTensorRequest& r = request->requests(i);
+      if (pending_batch_recvs_.count(r.request_id()) == 0) {
+        s = recent_request_ids_.TrackUnique(r.request_id(),
+                                            "BatchRecvTensor (GrpcWorker)", r);
+        to_start.push_back(i);
+      }
+    }
+    if (s.ok()) {
+      for (const RecvTensorRequest& r : request->requests()) {
+        PendingBatchRecv& pending = pending_batch_recvs_[r.request_id()];
+        pending.step_id = step_id;
+        pending.waiter = call;
+      }
+    }
+  }
+  if (!s.ok()) {
+    call->done(s);
+    delete call;
+    return;
+  }
+
+  // As for RecvTensor, cancellation is logged but does not abort the step.
+  opts->SetCancelCallback([step_id]() {
+    LOG(WARNING) << "BatchRecvTensor cancelled for " << step_id;
+  });
+  for (int i : to_start) {
+    const int64 request_id = request->requests(i).request_id();
+    RecvLocalTensorAsync(
+        step_id, request->requests(i).rendezvous_key(),
+        [this, request_id](const Tensor& val, bool is_dead, const Status& s) {
+          BatchRecvReady(request_id, val, is_dead, s);
+        });
+  }
+
+  ReadyBatchRecvs ready;
+  {
+    mutex_lock l(batch_recv_mu_);
+    call->armed = true;
+    if (!TakeReadyLocked(call, &ready)) return;
+  }
+  RespondBatchRecv(call, &ready);
+}
+
+void GrpcWorker::BatchRecvReady(int64 request_id, const Tensor& val,
+                                bool is_dead, const Status& status) {
+  BatchRecvCall* call;
+  ReadyBatchRecvs ready;
+  {
+    mutex_lock l(batch_recv_mu_);
+    auto it = pending_batch_recvs_.find(request_id);
+    // The step has already been cleaned up.
+    if (it == pending_batch_recvs_.end()) return;
+    PendingBatchRecv& pending = it->second;
+    pending.ready = true;
+    pending.val = val;
+    pending.is_dead = is_dead;
+    pending.status = status;
+    call = pending.waiter;
+    if (call == nullptr || !call->armed) return;
+    TakeReadyLocked(call, &ready);
+  }
+  RespondBatchRecv(call, &ready);
+}
+
+bool GrpcWorker::TakeReadyLocked(BatchRecvCall* call, ReadyBatchRecvs* ready) {
+  const BatchRecvTensorRequest& request = *call->request;
+  bool any_ready = false;
+  for (const RecvTensorRequest& r : request.requests()) {
+    auto it = pending_batch_recvs_.find(r.request_id());
+    if (it != pending_batch_recvs_.end() && it->second.ready) {
+      any_ready = true;
+      break;
+    }
+  }
+  if (!any_ready) return false;
+  for (int i = 0; i < request.requests_size(); ++i) {
+    auto it = pending_batch_recvs_.find(request.requests(i).request_id());
+    if (it == pending_batch_recvs_.end()) continue;
+    if (it->second.ready) {
+      ready->emplace_back(i, std::move(it->second));
+      pending_batch_recvs_.erase(it);
+    } else if (it->second.waiter == call) {
+      it->second.waiter = nullptr;
+    }
+  }
+  return true;
+}
+
+void GrpcWorker::RespondBatchRecv(BatchRecvCall* call,
+                                  ReadyBatchRecvs* ready) {
+  Status s;
+  for (auto& index_and_recv : *ready) {
+    const PendingBatchRecv& recv = index_and_recv.second;
+    s.Update(recv.status);
+    if (!s.ok()) break;
+    call->response->add_request_index(index_and_recv.first);
+    RecvTensorResponse* out = call->response->add_responses();
+    recv.val.AsProtoTensorContent(out->mutable_tensor());
+    out->set_is_dead(recv.is_dead);
+    out->set_send_start_micros(env_->env->NowMicros());
+  }
+  if (!s.ok()) call->response->Clear();
+  call->opts->ClearCancelCallback();
+  call->done(s);
+  delete call;
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
@@ -709,12 +926,25 @@ void GrpcWorker::LoggingAsync(const LoggingRequest* request,
 void GrpcWorker::CleanupGraphAsync(const CleanupGraphRequest* request,
                                    CleanupGraphResponse* response,
                                    StatusCallback done) {
+  const int64 step_id = request->step_id();
   if (response_cache_) {
     // Cleanup any stale response cache entries for this step. This can occur if
     // a worker crashes before acking a request.
-    response_cache_->CleanEntriesForStep(request->step_id());
+    response_cache_->CleanEntriesForStep(step_id);
   }
+  // Aborts the rendezvous of the step, which fails any BatchRecvTensor call
+  // still waiting for one of its tensors.
   Worker::CleanupGraphAsync(request, response, done);
+  // Drop the tensors of the step that were never asked for again.
+  mutex_lock l(batch_recv_mu_);
+  for (auto it = pending_batch_recvs_.begin();
+       it != pending_batch_recvs_.end();) {
+    if (it->second.step_id == step_id) {
+      it = pending_batch_recvs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 WorkerEnv* GrpcWorker::env() { return env_; }
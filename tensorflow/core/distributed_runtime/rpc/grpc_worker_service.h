@@ -18,10 +18,14 @@ limitations under the License.
 
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "grpcpp/server_builder.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_response_cache.h"
+#include "tensorflow/core/framework/collective_compression.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 
 namespace grpc {
@@ -46,6 +50,11 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  void BatchRecvTensorAsync(CallOptions* opts,
+                            const BatchRecvTensorRequest* request,
+                            BatchRecvTensorResponse* response,
+                            StatusCallback done) override;
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
@@ -62,9 +71,58 @@ class GrpcWorker : public Worker {
 
   void RemoveCacheEntryForId(int64 request_id);
 
+ protected:
+  typedef std::function<void(const Tensor& tensor, bool is_dead,
+                             const Status& status)>
+      RecvLocalTensorCallback;
+
+  // Receives the tensor for rendezvous key `key` from the local rendezvous,
+  // first copying it to host memory if it was produced on an accelerator.
+  void RecvLocalTensorAsync(int64 step_id, const string& key,
+                            RecvLocalTensorCallback done);
+
  private:
+  struct BatchRecvCall;
+
+  // A tensor requested by BatchRecvTensor.  If it is not available when the
+  // response is sent, it stays here until the receiver asks for it again
+  // with the same request_id.
+  struct PendingBatchRecv {
+    int64 step_id = 0;
+    bool ready = false;
+    Tensor val;
+    bool is_dead = false;
+    Status status;
+    // The call waiting for this tensor, if any.
+    BatchRecvCall* waiter = nullptr;
+  };
+  typedef std::vector<std::pair<int, PendingBatchRecv>> ReadyBatchRecvs;
+
+  // Called when the tensor for the BatchRecvTensor request `request_id`
+  // becomes available.
+  void BatchRecvReady(int64 request_id, const Tensor& val, bool is_dead,
+                      const Status& status);
+  // If any tensor requested by `call` is available, moves the available
+  // tensors, with their index in the request, to `ready` and returns true.
+  // The others no longer wait for `call`.
+  bool TakeReadyLocked(BatchRecvCall* call, ReadyBatchRecvs* ready)
+      EXCLUSIVE_LOCKS_REQUIRED(batch_recv_mu_);
+  // Sends the response for `call` with the tensors in `ready`, and deletes
+  // `call`.
+  void RespondBatchRecv(BatchRecvCall* call, ReadyBatchRecvs* ready);
+
   std::unique_ptr<GrpcResponseCache> response_cache_;
   const int32 recv_buf_max_chunk_;
+  // Encodes the float tensors sent by RecvTensor to receivers that accept
+  // it, if not null, with the encoding named `recv_tensor_compression_`.
+  std::unique_ptr<CollectiveCompressor> recv_tensor_compressor_;
+  string recv_tensor_compression_;
+
+  mutex batch_recv_mu_;
+  // Tensors requested by BatchRecvTensor that have not yet been returned,
+  // keyed by request_id.
+  std::unordered_map<int64, PendingBatchRecv> pending_batch_recvs_
+      GUARDED_BY(batch_recv_mu_);
 };
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* worker_env,
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
@@ -32,15 +33,21 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+class RpcBatchRecvTensorCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                      int64 batch_window_micros, int64 max_batch_size)
+      : BaseRemoteRendezvous(env, step_id),
+        batch_window_micros_(batch_window_micros),
+        max_batch_size_(max_batch_size) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -50,6 +57,24 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Adds the receive to the pending batch for its source worker, which is
+  // started when it is full or when the batch window has elapsed.
+  void BatchedRecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                                  const Rendezvous::Args& recv_args,
+                                  DoneCallback done);
+  // Starts the pending batch for `src_worker` if it is still batch `id`.
+  void FlushBatch(const string& src_worker, int64 id);
+  void StartBatch(RpcBatchRecvTensorCall* call);
+
+  const int64 batch_window_micros_;
+  const int64 max_batch_size_;
+
+  mutex batch_mu_;
+  int64 next_batch_id_ GUARDED_BY(batch_mu_) = 0;
+  // Receives waiting to be sent, keyed by source worker.
+  std::unordered_map<string, RpcBatchRecvTensorCall*> pending_batches_
+      GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -69,6 +94,9 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    // TensorResponse decodes compressed tensors received into host memory.
+    req_.set_accept_compression(alloc_attrs.on_host() ||
+                                dst_device->device_type() == DEVICE_CPU);
   }
 
   void Reset() {
@@ -213,10 +241,186 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// Retrieves several tensors from one remote worker with BatchRecvTensor
+// calls.  Each response contains the tensors that were available when it
+// was sent, which are delivered immediately, and the others are requested
+// again until every tensor has been received.
+class RpcBatchRecvTensorCall : public BaseRecvTensorCall {
+ public:
+  RpcBatchRecvTensorCall(const string& src_worker, int64 step_id, int64 id)
+      : src_worker_(src_worker), id_(id), wi_(nullptr) {
+    req_.set_step_id(step_id);
+  }
+
+  ~RpcBatchRecvTensorCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RpcBatchRecvTensorCall destructor.";
+  }
+
+  void Add(StringPiece key, Device* dst_device,
+           const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+    RecvTensorRequest* req = req_.add_requests();
+    req->set_step_id(req_.step_id());
+    req->set_rendezvous_key(key.data(), key.size());
+    req->set_request_id(GetUniqueRequestId());
+    pending_.push_back(recvs_.size());
+    recvs_.push_back({dst_device, recv_args, std::move(done)});
+  }
+
+  int64 size() const { return recvs_.size(); }
+  int64 id() const { return id_; }
+  const string& src_worker() const { return src_worker_; }
+
+  void set_worker(WorkerInterface* wi) { wi_ = wi; }
+
+  void ReleaseWorker(WorkerCacheInterface* worker_cache) {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "RpcBatchRecvTensorCall::ReleaseWorker() called twice.";
+    worker_cache->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  // Calls `recv_done` once the last response has been received, or on
+  // error.  The tensors of that response are delivered by Deliver().
+  void Start(std::function<void()> recv_done) override {
+    recv_done_ = std::move(recv_done);
+    IssueRequest();
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  // Calls the done callback of every receive not delivered yet, with its
+  // tensor if `s` is OK and with `s` otherwise.
+  void Deliver(Status s) {
+    std::vector<RecvTensorResponse*> responses(pending_.size(), nullptr);
+    if (s.ok()) {
+      for (int i = 0; i < resp_.responses_size(); ++i) {
+        responses[resp_.request_index(i)] = resp_.mutable_responses(i);
+      }
+    }
+    for (size_t i = 0; i < pending_.size(); ++i) {
+      Recv& recv = recvs_[pending_[i]];
+      Status rs = s;
+      if (rs.ok() && responses[i] == nullptr) {
+        rs = errors::Internal("BatchRecvTensor did not return ",
+                              req_.requests(i).rendezvous_key());
+      }
+      if (!rs.ok()) {
+        recv.done(rs, Rendezvous::Args(), recv.recv_args, Tensor(), false);
+        continue;
+      }
+      DeliverOne(&recv, responses[i]);
+    }
+    pending_.clear();
+  }
+
+ private:
+  struct Recv {
+    Device* dst_device;
+    Rendezvous::Args recv_args;
+    Rendezvous::DoneCallback done;
+  };
+
+  void IssueRequest() {
+    resp_.Clear();
+    wi_->BatchRecvTensorAsync(&opts_, &req_, &resp_,
+                              [this](const Status& s) { OnResponse(s); });
+  }
+
+  void OnResponse(Status s) {
+    const int num_requests = req_.requests_size();
+    if (s.ok()) {
+      if (resp_.responses_size() == 0 ||
+          resp_.request_index_size() != resp_.responses_size()) {
+        s = errors::Internal("BatchRecvTensor returned ",
+                             resp_.responses_size(), " tensors and ",
+                             resp_.request_index_size(), " indices");
+      }
+      for (int index : resp_.request_index()) {
+        if (index < 0 || index >= num_requests) {
+          s = errors::Internal("BatchRecvTensor returned index ", index,
+                               " for ", num_requests, " requests");
+        }
+      }
+    }
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    if (!s.ok() || resp_.responses_size() == num_requests) {
+      recv_done_();
+      return;
+    }
+
+    // Deliver the available tensors and request the others again.
+    std::vector<bool> delivered(num_requests, false);
+    for (int i = 0; i < resp_.responses_size(); ++i) {
+      const int index = resp_.request_index(i);
+      delivered[index] = true;
+      DeliverOne(&recvs_[pending_[index]], resp_.mutable_responses(i));
+    }
+    BatchRecvTensorRequest remaining;
+    remaining.set_step_id(req_.step_id());
+    std::vector<int> still_pending;
+    for (int i = 0; i < num_requests; ++i) {
+      if (delivered[i]) continue;
+      remaining.add_requests()->Swap(req_.mutable_requests(i));
+      still_pending.push_back(pending_[i]);
+    }
+    req_.Swap(&remaining);
+    pending_.swap(still_pending);
+    if (!status().ok()) {
+      recv_done_();
+      return;
+    }
+    IssueRequest();
+  }
+
+  void DeliverOne(Recv* recv, RecvTensorResponse* response) {
+    TensorResponse tensor;
+    tensor.InitAlloc(recv->dst_device, recv->recv_args.alloc_attrs);
+    Status s = tensor.InitFrom(response);
+    recv->done(s, Rendezvous::Args(), recv->recv_args, tensor.tensor(),
+               tensor.metadata().is_dead());
+  }
+
+  const string src_worker_;
+  const int64 id_;
+  WorkerInterface* wi_;  // Not owned.
+  std::vector<Recv> recvs_;
+  // Indices in `recvs_` of the receives not delivered yet, which are the
+  // elements of `req_.requests()`, in the same order.
+  std::vector<int> pending_;
+  std::function<void()> recv_done_;
+  CallOptions opts_;
+  BatchRecvTensorRequest req_;
+  BatchRecvTensorResponse resp_;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcBatchRecvTensorCall);
+};
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  if (batch_window_micros_ > 0) {
+    BatchedRecvFromRemoteAsync(parsed, recv_args, std::move(done));
+    return;
+  }
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -285,14 +489,115 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::BatchedRecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
+  Status s;
+  string src_worker;
+  string src_rel_device;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    s = errors::Internal(parsed.src_device,
+                         " is invalid remote source device.");
+  }
+  Device* dst_device;
+  if (s.ok()) {
+    s = session()->device_mgr()->LookupDevice(parsed.dst_device, &dst_device);
+  }
+  if (!s.ok()) {
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+
+  RpcBatchRecvTensorCall* full_batch = nullptr;
+  int64 new_batch_id = -1;
+  {
+    mutex_lock l(batch_mu_);
+    RpcBatchRecvTensorCall*& batch = pending_batches_[src_worker];
+    if (batch == nullptr) {
+      batch = new RpcBatchRecvTensorCall(src_worker, step_id_,
+                                         next_batch_id_++);
+      new_batch_id = batch->id();
+    }
+    batch->Add(parsed.FullKey(), dst_device, recv_args, std::move(done));
+    if (batch->size() >= max_batch_size_) {
+      full_batch = batch;
+      pending_batches_.erase(src_worker);
+    }
+  }
+  if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  } else if (new_batch_id >= 0) {
+    Ref();
+    env_->env->SchedClosureAfter(batch_window_micros_,
+                                 [this, src_worker, new_batch_id]() {
+                                   FlushBatch(src_worker, new_batch_id);
+                                   Unref();
+                                 });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker, int64 id) {
+  RpcBatchRecvTensorCall* batch = nullptr;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(src_worker);
+    // The batch may already have been started because it filled up.
+    if (it == pending_batches_.end() || it->second->id() != id) return;
+    batch = it->second;
+    pending_batches_.erase(it);
+  }
+  StartBatch(batch);
+}
+
+void RpcRemoteRendezvous::StartBatch(RpcBatchRecvTensorCall* call) {
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(call->src_worker());
+  if (rwi == nullptr) {
+    call->Deliver(errors::Internal("No worker known as ", call->src_worker()));
+    delete call;
+    return;
+  }
+  call->set_worker(rwi);
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call);
+
+  // RendezvousMgr already aborted, shouldn't send RPC call any more
+  if (!call->status().ok()) {
+    call->ReleaseWorker(sess->worker_cache.get());
+    call->Deliver(call->status());
+    delete call;
+    return;
+  }
+
+  Ref();
+  call->Start([this, call]() {
+    DeregisterCall(call);
+    Status s = call->status();
+    // NOTE: `*session()` can potentially be deleted by the done callbacks,
+    // so we must release the worker before calling them.
+    call->ReleaseWorker(session()->worker_cache.get());
+    call->Deliver(s);
+    delete call;
+    Unref();
+  });
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : BaseRendezvousMgr(env) {
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_RPC_RECV_TENSOR_BATCH_WINDOW_US", 0,
+                                  &batch_window_micros_));
+  TF_CHECK_OK(ReadInt64FromEnvVar("TF_RPC_RECV_TENSOR_MAX_BATCH_SIZE", 256,
+                                  &max_batch_size_));
+}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id, batch_window_micros_,
+                                 max_batch_size_);
 }
 
 }  // end namespace tensorflow
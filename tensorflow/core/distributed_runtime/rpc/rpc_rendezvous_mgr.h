@@ -42,6 +42,17 @@ class DeviceMgr;
 //
 // Tensors sent and recved through rendezvous managed by this
 // RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+//
+// If the environment variable TF_RPC_RECV_TENSOR_BATCH_WINDOW_US is
+// positive, receives from the same remote worker that are issued within
+// that many microseconds of each other are sent as a single
+// BatchRecvTensor call, of at most TF_RPC_RECV_TENSOR_MAX_BATCH_SIZE
+// (default 256) tensors.  This trades a little latency for far fewer RPCs
+// when a step fetches many small tensors, e.g. variables from a parameter
+// server.  The remote worker replies as soon as any tensor in the batch is
+// available, and the others are requested again, so a batch never waits
+// for its slowest tensor.  All workers in the cluster must support
+// BatchRecvTensor.
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
@@ -50,6 +61,9 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env);
 
  private:
+  int64 batch_window_micros_;
+  int64 max_batch_size_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
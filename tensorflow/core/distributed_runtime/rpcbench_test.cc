@@ -104,11 +104,11 @@ struct Cluster {
   std::vector<string> workers;
   std::vector<DeviceAttributes> devices;  // One per process
 
-  Cluster() {
+  explicit Cluster(int num_workers) {
     (*options.config.mutable_device_count())["CPU"] = 1;
     options.config.set_intra_op_parallelism_threads(1);
     options.config.set_inter_op_parallelism_threads(1);
-    MakeGRPCCluster(options, kWorkers, &workers, &devices);
+    MakeGRPCCluster(options, num_workers, &workers, &devices);
     LOG(ERROR) << "C " << workers.size() << " " << devices.size() << " "
                << workers[0] << " " << workers[1];
     options.target = workers[0];
@@ -116,7 +116,14 @@ struct Cluster {
 };
 
 static const Cluster* GetCluster() {
-  static Cluster* result = new Cluster;
+  static Cluster* result = new Cluster(kWorkers);
+  return result;
+}
+
+// A separate two-worker cluster, so that transfer benchmarks do not pay for
+// starting the large one.
+static const Cluster* GetPairCluster() {
+  static Cluster* result = new Cluster(2);
   return result;
 }
 
@@ -248,4 +255,44 @@ BENCHMARK(BM_SingleDevice)
     ->ArgPair(4, 10000)
     ->ArgPair(1, 1000000);
 
+// Measures a single RecvTensor of "bytes" bytes from the second worker to the
+// first.  The transferred value is a variable, so nothing is recomputed on the
+// sender, and only one element of it is fetched back to the client.
+static void BM_RecvTensor(int iters, int bytes) {
+  testing::StopTiming();
+  const Cluster* cluster = GetPairCluster();
+  const int64 num_elements = bytes / sizeof(float);
+
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+  Scope s = Scope::NewRootScope();
+  Scope sender = s.WithDevice("/job:localhost/replica:0/task:1/cpu:0");
+  Scope receiver = s.WithDevice("/job:localhost/replica:0/task:0/cpu:0");
+  Output var = Variable(sender.WithOpName("var"), {num_elements}, DT_FLOAT);
+  Assign(sender.WithOpName("init"), var,
+         Fill(sender, {num_elements}, 1.0f));
+  Slice(receiver.WithOpName("y"), var, {0}, {1});
+
+  GraphDef def;
+  TF_CHECK_OK(s.ToGraphDef(&def));
+  std::unique_ptr<Session> session(NewSession(cluster->options));
+  TF_CHECK_OK(session->Create(def));
+  TF_CHECK_OK(session->Run({}, {}, {"init"}, nullptr));
+
+  std::vector<Tensor> outputs;
+  // Warm up the channel and the receive buffers.
+  TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * num_elements *
+                          sizeof(float));
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    outputs.clear();
+    TF_CHECK_OK(session->Run({}, {"y:0"}, {}, &outputs));
+  }
+  testing::StopTiming();
+  TF_CHECK_OK(session->Close());
+}
+BENCHMARK(BM_RecvTensor)->Range(1 << 10, 1 << 30);
+
 }  // namespace tensorflow
@@ -18,8 +18,10 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/framework/collective_compression.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
 
 namespace tensorflow {
 
@@ -30,6 +32,7 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  staging_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -48,6 +51,15 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
     on_host_ = true;
   }
   allocator_ = device_->GetAllocator(alloc_attrs_);
+  const DeviceBase::GpuDeviceInfo* info = device_->tensorflow_gpu_device_info();
+  if (!on_host_ && info != nullptr && info->default_context != nullptr) {
+    // Tensor contents are parsed into DMA-able host memory and then copied
+    // to the device with a single transfer.
+    AllocatorAttributes host_attrs;
+    host_attrs.set_on_host(true);
+    host_attrs.set_gpu_compatible(true);
+    staging_allocator_ = device_->GetAllocator(host_attrs);
+  }
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
@@ -56,7 +68,12 @@ Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
+    } else {
+      s = DecompressTensor();
     }
+  } else if (!meta_.compression().empty()) {
+    s = errors::Unimplemented(
+        "Cannot decode a tensor sent with compression into device memory");
   } else {
     s = device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
   }
@@ -80,7 +97,18 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 }
 
 Status TensorResponse::ParseFrom(Source* source) {
+  if (already_used_) {
+    ClearTensor();
+  }
+  already_used_ = true;
   if (!on_host_) {
+    if (staging_allocator_ != nullptr) {
+      if (ParseFast(source)) {
+        TF_RETURN_IF_ERROR(DecompressTensor());
+        return CopyStagedTensorToDevice();
+      }
+      meta_.Clear();
+    }
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
 
@@ -88,6 +116,10 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (!meta_.compression().empty()) {
+      return errors::Unimplemented("Cannot decode a tensor sent with ",
+                                   "compression into device memory");
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -98,16 +130,65 @@ Status TensorResponse::ParseFrom(Source* source) {
     meta_.clear_tensor();
     return s;
   }
-  if (already_used_) {
-    ClearTensor();
-  }
-  already_used_ = true;
-  if (ParseFast(source)) return Status::OK();
+  if (ParseFast(source)) return DecompressTensor();
   meta_.Clear();
-  if (ParseSlow(source)) return Status::OK();
+  if (ParseSlow(source)) return DecompressTensor();
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
 
+Status TensorResponse::CopyStagedTensorToDevice() {
+  Tensor staged = std::move(tensor_);
+  Tensor on_device(allocator_, staged.dtype(), staged.shape());
+  if (!on_device.IsInitialized()) {
+    return errors::ResourceExhausted("Failed to allocate ",
+                                     staged.TotalBytes(), " bytes on ",
+                                     device_->name(), " for received tensor");
+  }
+  if (staged.NumElements() > 0) {
+    DeviceContext* ctx = device_->tensorflow_gpu_device_info()->default_context;
+    Notification n;
+    Status status;
+    ctx->CopyCPUTensorToDevice(&staged, static_cast<Device*>(device_),
+                               &on_device, [&n, &status](const Status& s) {
+                                 status = s;
+                                 n.Notify();
+                               });
+    n.WaitForNotification();
+    TF_RETURN_IF_ERROR(status);
+  }
+  tensor_ = std::move(on_device);
+  return Status::OK();
+}
+
+Status TensorResponse::DecompressTensor() {
+  if (meta_.compression().empty()) return Status::OK();
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_RETURN_IF_ERROR(
+      CollectiveCompressor::Create(meta_.compression(), 0, &compressor));
+  // Only encodings of one value per element can be sent, as the shape of the
+  // encoding is the shape of the tensor.
+  const int64 num_elements = tensor_.NumElements();
+  if (compressor == nullptr ||
+      compressor->encoded_dtype() != tensor_.dtype() ||
+      compressor->NumEncodedElements(num_elements) != num_elements) {
+    return errors::InvalidArgument("Cannot decode a ",
+                                   DataTypeString(tensor_.dtype()),
+                                   " tensor sent with compression ",
+                                   meta_.compression());
+  }
+  // Tensors staged for a device are decoded in host memory too.
+  Tensor decoded(on_host_ ? allocator_ : staging_allocator_, DT_FLOAT,
+                 tensor_.shape());
+  if (!decoded.IsInitialized()) {
+    return errors::ResourceExhausted("Failed to allocate ",
+                                     num_elements * sizeof(float),
+                                     " bytes for received tensor");
+  }
+  compressor->Decode(tensor_, &decoded);
+  tensor_ = std::move(decoded);
+  return Status::OK();
+}
+
 // Define some helper routines for decoding protocol buffer wire format data
 namespace {
 // We only need some of the wiretype values for this code
@@ -142,10 +223,18 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
   return input->DecrementRecursionDepthAndPopLimit(p.first);
 }
 
+bool ReadString(protobuf::io::CodedInputStream* input, string* value) {
+  int length;
+  return ReadVarintSizeAsInt(input, &length) &&
+         input->ReadString(value, length);
+}
+
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
     protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+  // Contents destined for a non-host device are staged in host memory.
+  Allocator* allocator = on_host_ ? allocator_ : staging_allocator_;
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -156,7 +245,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -196,12 +285,15 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        // The destination is allocated before any content is read, so
+        // ReadRaw copies each chunk yielded by the underlying stream (for
+        // gRPC, each received slice) straight into the tensor.  Aliasing
+        // the chunks instead is not attempted: their boundaries and
+        // alignment depend on how the transport happened to read the
+        // message and are rarely what allocator_ would provide.
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
-        // TODO(jeff,sanjay): Figure out a way to avoid this copy if
-        // the underlying ZeroCopyInputStream data is properly aligned
-        // and compatible with what allocator_ wants.
         if (!input->ReadRaw(const_cast<char*>(buf.data()), num_bytes))
           return false;
         tensor_ = std::move(t);
@@ -267,6 +359,12 @@ bool TensorResponse::ParseFast(Source* source) {
         meta_.set_require_ack(v != 0);
         break;
       }
+      case RecvTensorResponse::kCompressionFieldNumber: {
+        if ((wt != WIRETYPE_LENGTH_DELIMITED) ||
+            !ReadString(&input, meta_.mutable_compression()))
+          return false;
+        break;
+      }
       default: {
         // Unknown tag, so don't handle we can't handle on the fast path
         return false;
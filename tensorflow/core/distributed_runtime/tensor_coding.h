@@ -96,11 +96,19 @@ class TensorResponse {
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
+  // Replaces the host tensor produced by ParseFast with a copy of it on
+  // device_.
+  Status CopyStagedTensorToDevice();
+  // Replaces the host tensor with its decoding if it was sent compressed.
+  Status DecompressTensor();
 
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Host allocator used to stage contents for non-host devices that can
+  // copy from host memory, or nullptr.
+  Allocator* staging_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -46,6 +48,62 @@ class DummyDevice : public DeviceBase {
   DeviceAttributes attr_;
 };
 
+// A device that is not on the host but can copy host tensors onto itself,
+// like a GPU.  Its "device memory" is ordinary host memory.
+class FakeDmaDevice : public Device {
+ public:
+  class Context : public DeviceContext {
+   public:
+    void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
+                               Tensor* device_tensor, StatusCallback done,
+                               bool sync_dst_compute) const override {
+      ++num_copies;
+      StringPiece src = cpu_tensor->tensor_data();
+      memcpy(const_cast<char*>(device_tensor->tensor_data().data()),
+             src.data(), src.size());
+      done(Status::OK());
+    }
+
+    mutable int num_copies = 0;
+  };
+
+  explicit FakeDmaDevice(Env* env)
+      : Device(env, MakeAttributes()), context_(new Context) {
+    info_.default_context = context_;
+    set_tensorflow_gpu_device_info(&info_);
+  }
+  ~FakeDmaDevice() override { context_->Unref(); }
+
+  Status Sync() override { return Status::OK(); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+  Status MakeTensorFromProto(const TensorProto& tensor_proto,
+                             const AllocatorAttributes alloc_attrs,
+                             Tensor* tensor) override {
+    ++num_protos_parsed;
+    return tensor->FromProto(tensor_proto) ? Status::OK()
+                                           : errors::InvalidArgument("proto");
+  }
+
+  int num_copies() const { return context_->num_copies; }
+
+  int num_protos_parsed = 0;
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attr;
+    attr.set_name("/job:a/replica:0/task:0/device:FAKE_DMA:0");
+    attr.set_device_type("FAKE_DMA");
+    return attr;
+  }
+
+  Context* context_;
+  GpuDeviceInfo info_;
+};
+
 class StringSource : public TensorResponse::Source {
  public:
   explicit StringSource(const string* s, int block_size)
@@ -156,6 +214,83 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(TensorResponseTest, StagedCopyToDevice) {
+  FakeDmaDevice device(Env::Default());
+
+  Tensor src(DT_FLOAT, TensorShape({3, 1000}));
+  src.flat<float>().setRandom();
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  TensorResponse response;
+  response.InitAlloc(&device, AllocatorAttributes());
+  StringSource source(&encoded, 1024);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(src, response.tensor());
+  // Contents went through a single host-to-device copy rather than the
+  // device's TensorProto parsing.
+  EXPECT_EQ(1, device.num_copies());
+  EXPECT_EQ(0, device.num_protos_parsed);
+
+  // Tensors the fast path cannot handle still go through the device.
+  Tensor strings(DT_STRING, TensorShape({2}));
+  test::FillValues<string>(&strings, {"a", "b"});
+  strings.AsProtoTensorContent(proto.mutable_tensor());
+  encoded.clear();
+  proto.AppendToString(&encoded);
+  StringSource string_source(&encoded, 1024);
+  TF_EXPECT_OK(response.ParseFrom(&string_source));
+  test::ExpectTensorEqual<string>(strings, response.tensor());
+  EXPECT_EQ(1, device.num_copies());
+  EXPECT_EQ(1, device.num_protos_parsed);
+}
+
+TEST_F(TensorResponseTest, Compressed) {
+  Tensor src(DT_FLOAT, TensorShape({3, 100}));
+  src.flat<float>().setRandom();
+  // The sender rounds the values to bfloat16.
+  Tensor encoded_src(DT_BFLOAT16, src.shape());
+  Tensor expected(DT_FLOAT, src.shape());
+  for (int64 i = 0; i < src.NumElements(); ++i) {
+    encoded_src.flat<bfloat16>()(i) = bfloat16(src.flat<float>()(i));
+    expected.flat<float>()(i) =
+        static_cast<float>(encoded_src.flat<bfloat16>()(i));
+  }
+  RecvTensorResponse proto;
+  proto.set_compression("bf16");
+  encoded_src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  StringSource source(&encoded, 1024);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ("bf16", response.metadata().compression());
+  test::ExpectTensorEqual<float>(expected, response.tensor());
+
+  // Tensors staged for a device are decoded before the copy.
+  FakeDmaDevice device(Env::Default());
+  response.InitAlloc(&device, AllocatorAttributes());
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  test::ExpectTensorEqual<float>(expected, response.tensor());
+  EXPECT_EQ(1, device.num_copies());
+
+  // The encoding must match the type of the tensor.
+  proto.set_compression("fp16");
+  encoded.clear();
+  proto.AppendToString(&encoded);
+  response.InitAlloc(&cpu_device, AllocatorAttributes());
+  StringSource mismatched_source(&encoded, 1024);
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(response.ParseFrom(&mismatched_source)));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -82,13 +82,20 @@ struct AllocatorStats {
   // if such a limit is known.
   absl::optional<int64> bytes_reservable_limit;
 
+  // Stats for allocators with a thread cache in front of them.  Hits are
+  // included in num_allocs.
+  int64 num_cache_hits;    // Allocations served from a thread cache.
+  int64 num_cache_misses;  // Cacheable allocations the cache could not serve.
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
         peak_bytes_in_use(0),
         largest_alloc_size(0),
         bytes_reserved(0),
-        peak_bytes_reserved(0) {}
+        peak_bytes_reserved(0),
+        num_cache_hits(0),
+        num_cache_misses(0) {}
 
   string DebugString() const;
 };
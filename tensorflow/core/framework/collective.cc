@@ -66,6 +66,8 @@ CollInstanceParams& CollInstanceParams::operator=(
     type = other.type;
     data_type = other.data_type;
     shape = other.shape;
+    compression = other.compression;
+    topk_ratio = other.topk_ratio;
     device_names.clear();
     device_names.assign(other.device_names.begin(), other.device_names.end());
     task_names.assign(other.task_names.begin(), other.task_names.end());
@@ -91,7 +93,8 @@ CollInstanceParams& CollInstanceParams::operator=(
 string CollInstanceParams::ToString() const {
   string v = strings::StrCat("CollInstanceParams { instance_key=", instance_key,
                              " type=", type, " data_type=", data_type,
-                             " shape=", shape.DebugString(), " devices {");
+                             " shape=", shape.DebugString(),
+                             " compression=", compression, " devices {");
   for (const auto& d : device_names) {
     strings::StrAppend(&v, d, ",");
   }
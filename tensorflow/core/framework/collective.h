@@ -18,6 +18,7 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/framework/collective_compression.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -91,6 +92,11 @@ struct CollInstanceParams {
   CollectiveType type = UNDEFINED_COLLECTIVE;
   DataType data_type = DT_FLOAT;
   TensorShape shape = {0};
+  // Lossy encoding of the values a reduction sends between devices, and the
+  // fraction of the values sent for "topk" (see CollectiveCompressor::Create).
+  // Every member of the instance must use the same encoding.
+  string compression = "none";
+  float topk_ratio = 0;
   // Fully qualified name of device for each member, in default rank order.
   std::vector<string> device_names;
   // Task name prefix of corresponding device name.
@@ -128,6 +134,8 @@ struct CollectiveParams {
   std::vector<int> subdiv_rank;
   std::unique_ptr<OpKernel> merge_op;  // reduction only
   std::unique_ptr<OpKernel> final_op;  // reduction only
+  // Encodes the values sent between devices, if not null.
+  std::unique_ptr<CollectiveCompressor> compressor;  // reduction only
   string ToString() const;
 };
 
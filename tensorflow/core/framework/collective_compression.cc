@@ -0,0 +1,194 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/collective_compression.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+class BFloat16Compressor : public CollectiveCompressor {
+ public:
+  DataType encoded_dtype() const override { return DT_BFLOAT16; }
+
+  int64 NumEncodedElements(int64 num_elements) const override {
+    return num_elements;
+  }
+
+  bool compresses_gather() const override { return true; }
+
+ protected:
+  void EncodeValues(const float* values, int64 n,
+                    Tensor* encoded) const override {
+    bfloat16* out = encoded->flat<bfloat16>().data();
+    for (int64 i = 0; i < n; ++i) {
+      // Unlike FloatToBFloat16, rounds to nearest even.
+      out[i] = bfloat16(values[i]);
+    }
+  }
+
+  void DecodeValues(const Tensor& encoded, int64 n,
+                    float* values) const override {
+    BFloat16ToFloat(encoded.flat<bfloat16>().data(), values, n);
+  }
+};
+
+class HalfCompressor : public CollectiveCompressor {
+ public:
+  DataType encoded_dtype() const override { return DT_HALF; }
+
+  int64 NumEncodedElements(int64 num_elements) const override {
+    return num_elements;
+  }
+
+  bool compresses_gather() const override { return true; }
+
+ protected:
+  void EncodeValues(const float* values, int64 n,
+                    Tensor* encoded) const override {
+    Eigen::half* out = encoded->flat<Eigen::half>().data();
+    for (int64 i = 0; i < n; ++i) {
+      out[i] = Eigen::half(values[i]);
+    }
+  }
+
+  void DecodeValues(const Tensor& encoded, int64 n,
+                    float* values) const override {
+    const Eigen::half* in = encoded.flat<Eigen::half>().data();
+    for (int64 i = 0; i < n; ++i) {
+      values[i] = static_cast<float>(in[i]);
+    }
+  }
+};
+
+// Encodes k values as k int32 indices followed by the k values' bits.
+class TopKCompressor : public CollectiveCompressor {
+ public:
+  explicit TopKCompressor(float ratio) : ratio_(ratio) {}
+
+  DataType encoded_dtype() const override { return DT_INT32; }
+
+  int64 NumEncodedElements(int64 num_elements) const override {
+    return 2 * NumSelected(num_elements);
+  }
+
+  // The sum of sparse values is not sparse, so the reduced values are
+  // gathered as is.
+  bool compresses_gather() const override { return false; }
+
+ protected:
+  void EncodeValues(const float* values, int64 n,
+                    Tensor* encoded) const override {
+    const int64 k = NumSelected(n);
+    std::vector<int32> indices(n);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::nth_element(indices.begin(), indices.begin() + k, indices.end(),
+                     [values](int32 a, int32 b) {
+                       return std::abs(values[a]) > std::abs(values[b]);
+                     });
+    int32* out = encoded->flat<int32>().data();
+    for (int64 i = 0; i < k; ++i) {
+      out[i] = indices[i];
+      memcpy(&out[k + i], &values[indices[i]], sizeof(float));
+    }
+  }
+
+  void DecodeValues(const Tensor& encoded, int64 n,
+                    float* values) const override {
+    const int64 k = NumSelected(n);
+    const int32* in = encoded.flat<int32>().data();
+    std::fill(values, values + n, 0.0f);
+    for (int64 i = 0; i < k; ++i) {
+      memcpy(&values[in[i]], &in[k + i], sizeof(float));
+    }
+  }
+
+ private:
+  int64 NumSelected(int64 n) const {
+    if (n == 0) return 0;
+    return std::min(n, std::max<int64>(1, std::ceil(ratio_ * n)));
+  }
+
+  const float ratio_;
+};
+
+}  // namespace
+
+/* static */
+Status CollectiveCompressor::Create(
+    const string& name, float topk_ratio,
+    std::unique_ptr<CollectiveCompressor>* compressor) {
+  if (name == "none") {
+    compressor->reset();
+  } else if (name == "bf16") {
+    compressor->reset(new BFloat16Compressor);
+  } else if (name == "fp16") {
+    compressor->reset(new HalfCompressor);
+  } else if (name == "topk") {
+    if (!(topk_ratio > 0 && topk_ratio <= 1)) {
+      return errors::InvalidArgument("topk_ratio must be in (0, 1] but got ",
+                                     topk_ratio);
+    }
+    compressor->reset(new TopKCompressor(topk_ratio));
+  } else {
+    return errors::InvalidArgument("Unknown collective compression ", name);
+  }
+  return Status::OK();
+}
+
+void CollectiveCompressor::Encode(const Tensor& values, int64 offset,
+                                  int64 total_elements, bool error_feedback,
+                                  Tensor* encoded) {
+  const int64 n = values.NumElements();
+  DCHECK_EQ(NumEncodedElements(n), encoded->NumElements());
+  const float* in = values.flat<float>().data();
+  if (!error_feedback) {
+    EncodeValues(in, n, encoded);
+    return;
+  }
+  DCHECK_LE(offset + n, total_elements);
+  std::vector<float> compensated(in, in + n);
+  std::vector<float> decoded(n);
+  mutex_lock l(mu_);
+  if (static_cast<int64>(residual_.size()) != total_elements) {
+    residual_.assign(total_elements, 0.0f);
+  }
+  float* residual = residual_.data() + offset;
+  for (int64 i = 0; i < n; ++i) {
+    compensated[i] += residual[i];
+  }
+  EncodeValues(compensated.data(), n, encoded);
+  DecodeValues(*encoded, n, decoded.data());
+  for (int64 i = 0; i < n; ++i) {
+    residual[i] = compensated[i] - decoded[i];
+  }
+}
+
+void CollectiveCompressor::Decode(const Tensor& encoded,
+                                  Tensor* values) const {
+  DCHECK_EQ(NumEncodedElements(values->NumElements()), encoded.NumElements());
+  DecodeValues(encoded, values->NumElements(), values->flat<float>().data());
+}
+
+}  // namespace tensorflow
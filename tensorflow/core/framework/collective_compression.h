@@ -0,0 +1,95 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_FRAMEWORK_COLLECTIVE_COMPRESSION_H_
+#define TENSORFLOW_CORE_FRAMEWORK_COLLECTIVE_COMPRESSION_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Lossy encoding of the float values a collective reduction sends between
+// devices, to reduce the bytes sent when the reduction is network bound.
+//
+// The values sent while reducing are encoded with error feedback: the part of
+// each value lost to the encoding is retained, and added to the value sent
+// from the same position in the next execution, so that no update is lost
+// over successive executions.  The fully reduced values are also gathered in
+// encoded form if `compresses_gather()`, in which case every device ends up
+// with the same decoded values.
+//
+// A compressor belongs to a single collective op on a single device, as its
+// residuals are specific to the values that device sends.
+class CollectiveCompressor {
+ public:
+  // Creates the compressor named `name`, which is one of:
+  //   "bf16": rounds values to bfloat16.
+  //   "fp16": rounds values to IEEE half precision.
+  //   "topk": sends the `topk_ratio` fraction of the values of largest
+  //     magnitude, with their indices, and treats the others as zero.
+  // Sets `*compressor` to null for "none".
+  static Status Create(const string& name, float topk_ratio,
+                       std::unique_ptr<CollectiveCompressor>* compressor);
+
+  virtual ~CollectiveCompressor() {}
+
+  // The type of the encoded values.
+  virtual DataType encoded_dtype() const = 0;
+
+  // Returns the number of elements of the encoding of `num_elements` values.
+  virtual int64 NumEncodedElements(int64 num_elements) const = 0;
+
+  // Whether the fully reduced values are gathered in encoded form.  This
+  // requires that decoded values be encoded exactly.
+  virtual bool compresses_gather() const = 0;
+
+  // Encodes the float tensor `values` into `encoded`, which must have
+  // `NumEncodedElements(values.NumElements())` elements of `encoded_dtype()`.
+  //
+  // If `error_feedback` is true, `values` is taken to start at element
+  // `offset` of a tensor with `total_elements` elements: the residual of the
+  // previous encoding at the same position is added to the values before
+  // encoding them, and the new residual is retained.
+  void Encode(const Tensor& values, int64 offset, int64 total_elements,
+              bool error_feedback, Tensor* encoded);
+
+  // Decodes `encoded` into the float tensor `values`.
+  void Decode(const Tensor& encoded, Tensor* values) const;
+
+ protected:
+  // Encodes the `n` values at `values` into `encoded`.
+  virtual void EncodeValues(const float* values, int64 n,
+                            Tensor* encoded) const = 0;
+
+  // Decodes `encoded` into the `n` values at `values`.
+  virtual void DecodeValues(const Tensor& encoded, int64 n,
+                            float* values) const = 0;
+
+ private:
+  mutex mu_;
+  // The encoding error of the values sent at each position of the tensor.
+  std::vector<float> residual_ GUARDED_BY(mu_);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_FRAMEWORK_COLLECTIVE_COMPRESSION_H_
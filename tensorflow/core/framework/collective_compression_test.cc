@@ -0,0 +1,119 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/framework/collective_compression.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Encodes `values` and returns their decoding.
+Tensor RoundTrip(CollectiveCompressor* compressor, const Tensor& values,
+                 int64 offset, int64 total_elements, bool error_feedback) {
+  Tensor encoded(compressor->encoded_dtype(),
+                 TensorShape({compressor->NumEncodedElements(
+                     values.NumElements())}));
+  compressor->Encode(values, offset, total_elements, error_feedback,
+                     &encoded);
+  Tensor decoded(DT_FLOAT, values.shape());
+  compressor->Decode(encoded, &decoded);
+  return decoded;
+}
+
+TEST(CollectiveCompressorTest, Create) {
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_EXPECT_OK(CollectiveCompressor::Create("none", 0.01, &compressor));
+  EXPECT_EQ(nullptr, compressor);
+  TF_EXPECT_OK(CollectiveCompressor::Create("bf16", 0.01, &compressor));
+  EXPECT_EQ(DT_BFLOAT16, compressor->encoded_dtype());
+  EXPECT_TRUE(compressor->compresses_gather());
+  TF_EXPECT_OK(CollectiveCompressor::Create("fp16", 0.01, &compressor));
+  EXPECT_EQ(DT_HALF, compressor->encoded_dtype());
+  TF_EXPECT_OK(CollectiveCompressor::Create("topk", 0.01, &compressor));
+  EXPECT_EQ(DT_INT32, compressor->encoded_dtype());
+  EXPECT_FALSE(compressor->compresses_gather());
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CollectiveCompressor::Create("topk", 0, &compressor)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CollectiveCompressor::Create("topk", 1.5, &compressor)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      CollectiveCompressor::Create("int8", 0.01, &compressor)));
+}
+
+TEST(CollectiveCompressorTest, BFloat16) {
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_ASSERT_OK(CollectiveCompressor::Create("bf16", 0.01, &compressor));
+  EXPECT_EQ(4, compressor->NumEncodedElements(4));
+  // 1 + 2^-8 is halfway between two bfloat16 values, and rounds to even.
+  Tensor values = test::AsTensor<float>({1.0f, -2.5f, 1.00390625f, 3.0f});
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.0f, -2.5f, 1.0f, 3.0f}),
+      RoundTrip(compressor.get(), values, 0, 0, false));
+  // Decoded values are encoded exactly.
+  Tensor decoded = RoundTrip(compressor.get(), values, 0, 0, false);
+  test::ExpectTensorEqual<float>(
+      decoded, RoundTrip(compressor.get(), decoded, 0, 0, false));
+}
+
+TEST(CollectiveCompressorTest, Half) {
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_ASSERT_OK(CollectiveCompressor::Create("fp16", 0.01, &compressor));
+  Tensor values = test::AsTensor<float>({1.0f, -2.5f, 1.0001f, 65504.0f});
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1.0f, -2.5f, 1.0f, 65504.0f}),
+      RoundTrip(compressor.get(), values, 0, 0, false));
+}
+
+TEST(CollectiveCompressorTest, TopK) {
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_ASSERT_OK(CollectiveCompressor::Create("topk", 0.25, &compressor));
+  // Sends 2 indices and 2 values.
+  EXPECT_EQ(4, compressor->NumEncodedElements(8));
+  EXPECT_EQ(2, compressor->NumEncodedElements(1));
+  EXPECT_EQ(0, compressor->NumEncodedElements(0));
+  Tensor values = test::AsTensor<float>(
+      {0.5f, -4.0f, 1.0f, 0.0f, 3.0f, -0.25f, 2.0f, 1.5f});
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, -4.0f, 0, 0, 3.0f, 0, 0, 0}),
+      RoundTrip(compressor.get(), values, 0, 0, false));
+}
+
+TEST(CollectiveCompressorTest, TopKErrorFeedback) {
+  std::unique_ptr<CollectiveCompressor> compressor;
+  TF_ASSERT_OK(CollectiveCompressor::Create("topk", 0.5, &compressor));
+  // The values are the second half of a tensor of 4 elements.
+  Tensor values = test::AsTensor<float>({2.0f, 1.5f});
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({2.0f, 0}),
+                                 RoundTrip(compressor.get(), values, 2, 4,
+                                           /*error_feedback=*/true));
+  // The value that was not sent is added to the next value sent from the
+  // same position, which is then the largest.
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({0, 3.0f}),
+                                 RoundTrip(compressor.get(), values, 2, 4,
+                                           /*error_feedback=*/true));
+  // Values at another position have no residual.
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({2.0f, 0}),
+                                 RoundTrip(compressor.get(), values, 0, 4,
+                                           /*error_feedback=*/true));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({4.0f, 0}),
+                                 RoundTrip(compressor.get(), values, 2, 4,
+                                           /*error_feedback=*/true));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -548,6 +548,12 @@ class IteratorBase {
     return 0;
   }
 
+  // Returns the performance modeling `Node` associated with this iterator, or
+  // `nullptr` if modeling is disabled. Asynchronous work started by the
+  // iterator can hold on to the node to record its statistics directly,
+  // without looking the node up in the model by name.
+  const std::shared_ptr<model::Node>& model_node() const { return node_; }
+
  private:
   friend class DatasetBase;          // for access to `AddCleanupFunction`
   friend class DatasetBaseIterator;  // for access to `node_`
@@ -560,10 +566,10 @@ class IteratorBase {
   }
 
   // Associates the given performance modeling `Node` with this iterator.
-  void SetNode(std::shared_ptr<model::Node> node) { node_ = node.get(); }
+  void SetNode(std::shared_ptr<model::Node> node) { node_ = std::move(node); }
 
   std::vector<std::function<void()>> cleanup_fns_;
-  model::Node* node_ = nullptr;  // Not owned.
+  std::shared_ptr<model::Node> node_;
 };
 
 // Represents runtime information needed to construct a dataset.
@@ -803,7 +809,7 @@ class DatasetBaseIterator : public IteratorBase {
   void RecordBufferEnqueue(IteratorContext* ctx,
                            const std::vector<Tensor>& element) {
     if (collect_resource_usage(ctx)) {
-      node_->add_buffered_bytes(GetAllocatedBytes(element));
+      node_->record_buffer_enqueue(GetAllocatedBytes(element));
     }
   }
 
@@ -841,7 +847,7 @@ class DatasetBaseIterator : public IteratorBase {
 
  private:
   inline bool collect_resource_usage(IteratorContext* ctx) {
-    auto model = ctx->model();
+    const auto& model = ctx->model();
     return model && model->collect_resource_usage() && node_;
   }
 
@@ -17,8 +17,6 @@ limitations under the License.
 
 #include <memory>
 
-#include "absl/time/clock.h"
-
 namespace tensorflow {
 namespace data {
 namespace model {
@@ -29,8 +27,14 @@ std::shared_ptr<Parameter> MakeParameter(const string& name,
   return std::make_shared<Parameter>(name, state, min, max);
 }
 
+thread_local int64 Node::work_start_;
+
 namespace {
 
+// The minimum decrease of the output time, relative to the output time, for
+// which the optimization increases a buffer size.
+constexpr double kMinBufferSizeImprovement = 0.001;
+
 // Given the average time between output events (`output_time`), the average
 // time between input events (`input_time`) and the buffer size, the method
 // computes the expected time an input event will have to wait.
@@ -135,10 +139,11 @@ class AsyncInterleaveMany : public Node {
   }
 
   // The output time is estimated using `ComputeWaitTime(output_time,
-  // input_time, parallelism)`, where `output_time` is the sum of the
+  // input_time, buffer_size)`, where `output_time` is the sum of the
   // self-processing time and the average output time of inputs comprising the
   // interleave "cycle", `input_time` is specified through `input_times` and
-  // `buffer_size` is derived from parallelism.
+  // `buffer_size` is the sum of parallelism and the number of prefetched
+  // inputs, whose first results are fetched ahead of time too.
   double OutputTimeLocked(std::vector<double>* input_times) const override
       SHARED_LOCKS_REQUIRED(mu_) {
     if (inputs_.size() <= 1) {
@@ -150,16 +155,24 @@ class AsyncInterleaveMany : public Node {
     input_times->push_back(new_input_time);
     auto cleanup =
         gtl::MakeCleanup([input_times]() { input_times->pop_back(); });
-    double parallelism = inputs_.size() - 1;  // default to cycle length
-    if (auto* parameter = gtl::FindOrNull(parameters_, "parallelism")) {
-      parallelism = std::min(static_cast<int>(parallelism),
-                             static_cast<int>((*parameter)->value));
-    }
+    const double parallelism = ParallelismLocked();
     double output_time = (OutputTimeForInputs(input_times) -
                           inputs_.front()->OutputTime(input_times)) /
                          static_cast<double>(num_inputs() - 1) / parallelism;
     return ComputeWaitTime(SelfProcessingTimeLocked() + output_time,
-                           old_input_time, parallelism);
+                           old_input_time,
+                           parallelism + ParameterValueLocked(kBufferSize, 0));
+  }
+
+  // Each of the elements produced concurrently and of the prefetched inputs
+  // holds at least one buffered element.
+  double MaximumBufferedBytesLocked() const override
+      SHARED_LOCKS_REQUIRED(mu_) {
+    if (inputs_.size() <= 1) {
+      return 0;
+    }
+    return AverageBufferedElementSizeLocked() *
+           (ParallelismLocked() + ParameterValueLocked(kBufferSize, 0));
   }
 
   // The processing time is the sum of the self processing time and the average
@@ -173,6 +186,17 @@ class AsyncInterleaveMany : public Node {
     return SelfProcessingTimeLocked() +
            processing_time / static_cast<double>(num_inputs() - 1);
   }
+
+ private:
+  // Returns the parallelism, which defaults to the cycle length.
+  double ParallelismLocked() const SHARED_LOCKS_REQUIRED(mu_) {
+    double parallelism = inputs_.size() - 1;
+    if (auto* parameter = gtl::FindOrNull(parameters_, kParallelism)) {
+      parallelism = std::min(static_cast<int>(parallelism),
+                             static_cast<int>((*parameter)->value));
+    }
+    return parallelism;
+  }
 };
 
 class KnownRatio : public Node {
@@ -239,19 +263,17 @@ class AsyncKnownRatio : public Node {
   }
 
   // The output time is estimated using `ComputeWaitTime(output_time,
-  // input_time, parallelism)`, where `output_time` is the sum of the self
+  // input_time, buffer_size)`, where `output_time` is the sum of the self
   // processing time and the product of `ratio_` and the sum of output times of
   // inputs, `input_time` is specified through `input_times` and `buffer_size`
-  // is derived from parallelism.
+  // is the "buffer_size" parameter, or parallelism if there is none.
   double OutputTimeLocked(std::vector<double>* input_times) const override
       SHARED_LOCKS_REQUIRED(mu_) {
-    double parallelism = 1.0;
-    if (auto* parameter = gtl::FindOrNull(parameters_, "parallelism")) {
-      parallelism = (*parameter)->value;
-    }
+    const double parallelism = ParameterValueLocked(kParallelism, 1.0);
+    const double buffer_size = BufferSizeLocked();
     if (ratio_ == 0.0) {
       double output_time = SelfProcessingTimeLocked() / parallelism;
-      return ComputeWaitTime(output_time, input_times->back(), parallelism);
+      return ComputeWaitTime(output_time, input_times->back(), buffer_size);
     }
     double old_input_time = input_times->back();
     double new_input_time = SelfProcessingTimeLocked() / ratio_ / parallelism;
@@ -260,7 +282,7 @@ class AsyncKnownRatio : public Node {
         gtl::MakeCleanup([input_times]() { input_times->pop_back(); });
     double output_time = SelfProcessingTimeLocked() / parallelism +
                          ratio_ * OutputTimeForInputs(input_times);
-    return ComputeWaitTime(output_time, old_input_time, parallelism);
+    return ComputeWaitTime(output_time, old_input_time, buffer_size);
   }
 
   // The processing time is the sum of the self processing time and the product
@@ -269,7 +291,18 @@ class AsyncKnownRatio : public Node {
     return SelfProcessingTimeLocked() + ratio_ * ProcessingTimeForInputs();
   }
 
+  double MaximumBufferedBytesLocked() const override
+      SHARED_LOCKS_REQUIRED(mu_) {
+    return AverageBufferedElementSizeLocked() * BufferSizeLocked();
+  }
+
  private:
+  // Returns the number of elements buffered at most.
+  double BufferSizeLocked() const SHARED_LOCKS_REQUIRED(mu_) {
+    return ParameterValueLocked(kBufferSize,
+                                ParameterValueLocked(kParallelism, 1.0));
+  }
+
   const double ratio_;
 };
 
@@ -417,21 +450,16 @@ std::shared_ptr<Node> Model::AddNode(Node::Factory factory, const string& name,
   return node;
 }
 
-void Model::AddProcessingTime(const string& name, int64 delta) {
-  tf_shared_lock l(mu_);
-  auto node = gtl::FindOrNull(lookup_table_, name);
-  if (node) {
-    (*node)->add_processing_time(delta);
-  }
-}
-
-// The optimization algorithm starts by setting all tunable parallelism
-// parameters to 1. It then repeatedly identifies the parameter whose increase
-// in parallelism decreases the output time the most. This process is repeated
-// until all parameters reach their maximum values or the projected output time
-// is less than or equal to the processing time needed to produce an element
-// divided by CPU budget.
-void Model::Optimize(int64 cpu_budget) {
+// The optimization algorithm starts by setting all tunable parameters to their
+// minimum values. It then repeatedly identifies the parameter whose increase
+// decreases the output time the most without making the buffers of the input
+// pipeline exceed the RAM budget. Buffer sizes are only increased if doing so
+// decreases the output time noticeably, as larger buffers cost memory. This
+// process is repeated until all parameters reach their maximum values, no
+// parameter can be increased within the RAM budget, or the projected output
+// time is less than or equal to the processing time needed to produce an
+// element divided by CPU budget.
+void Model::Optimize(int64 cpu_budget, int64 ram_budget) {
   std::shared_ptr<Node> snapshot;
   {
     tf_shared_lock lock(mu_);
@@ -441,7 +469,7 @@ void Model::Optimize(int64 cpu_budget) {
   const double processing_time = TotalProcessingTime(snapshot);
   auto parameters = CollectTunableParameters(snapshot);
   for (auto& pair : parameters) {
-    pair.second->value = 1;
+    pair.second->value = pair.second->min;
   }
   while (true) {
     const double output_time = OutputTime(snapshot);
@@ -457,20 +485,34 @@ void Model::Optimize(int64 cpu_budget) {
     }
     double best_delta = -1.0L;
     Parameter* best_parameter = nullptr;
+    // Whether some parameter could be increased but is not worth increasing.
+    bool constrained = false;
     for (auto& pair : parameters) {
       if (pair.second->value == pair.second->max) {
         continue;
       }
       pair.second->value++;
       double new_output_time = OutputTime(snapshot);
+      double buffered_bytes = TotalMaximumBufferedBytes(snapshot);
+      pair.second->value--;
       double delta = output_time - new_output_time;
+      if (buffered_bytes > ram_budget ||
+          (pair.second->name == kBufferSize &&
+           delta <= kMinBufferSizeImprovement * output_time)) {
+        constrained = true;
+        continue;
+      }
       if (delta > best_delta) {
         best_delta = delta;
         best_parameter = pair.second.get();
       }
-      pair.second->value--;
     }
     if (!best_parameter) {
+      if (constrained) {
+        VLOG(2) << "No parameter is worth increasing within the RAM budget of "
+                << ram_budget << " bytes";
+        break;
+      }
       LOG(WARNING) << "Failed to find a tunable parameter that would "
                       "decrease the output time. This means that the "
                       "autotuning optimization got stuck in a local maximum. "
@@ -479,7 +521,9 @@ void Model::Optimize(int64 cpu_budget) {
     }
     best_parameter->value++;
   }
-  VLOG(2) << "Number of tunable parameters: " << parameters.size();
+  VLOG(2) << "Number of tunable parameters: " << parameters.size()
+          << ", maximum buffered bytes: "
+          << TotalMaximumBufferedBytes(snapshot);
   for (auto& pair : parameters) {
     auto& parameter = pair.second;
     VLOG(2) << "Setting tunable parameter " << pair.first << " to "
@@ -490,47 +534,6 @@ void Model::Optimize(int64 cpu_budget) {
   }
 }
 
-void Model::RecordElement(const string& name) {
-  tf_shared_lock l(mu_);
-  auto node = gtl::FindOrNull(lookup_table_, name);
-  if (node) {
-    (*node)->record_element();
-  }
-}
-
-int64 Model::NumElements(const string& name) {
-  tf_shared_lock l(mu_);
-  auto node = gtl::FindOrNull(lookup_table_, name);
-  if (node) {
-    return (*node)->num_elements();
-  }
-  return 0;
-}
-
-void Model::RecordStart(const string& name, bool stop_output) {
-  tf_shared_lock l(mu_);
-  auto node = gtl::FindOrNull(lookup_table_, name);
-  if (collect_resource_usage_ && node) {
-    int64 now_nanos = absl::GetCurrentTimeNanos();
-    if (stop_output && (*node)->output()) {
-      (*node)->output()->record_stop(now_nanos);
-    }
-    (*node)->record_start(now_nanos);
-  }
-}
-
-void Model::RecordStop(const string& name, bool start_output) {
-  tf_shared_lock l(mu_);
-  auto node = gtl::FindOrNull(lookup_table_, name);
-  if (collect_resource_usage_ && node) {
-    int64 now_nanos = absl::GetCurrentTimeNanos();
-    (*node)->record_stop(now_nanos);
-    if (start_output && (*node)->output()) {
-      (*node)->output()->record_start(now_nanos);
-    }
-  }
-}
-
 void Model::RemoveNode(const string& name) {
   mutex_lock l(mu_);
   auto node = gtl::FindOrNull(lookup_table_, name);
@@ -566,6 +569,10 @@ double Model::TotalProcessingTime(std::shared_ptr<Node> node) {
   return node->TotalProcessingTime();
 }
 
+double Model::TotalMaximumBufferedBytes(std::shared_ptr<Node> node) {
+  return node->TotalMaximumBufferedBytes();
+}
+
 }  // namespace model
 }  // namespace data
 }  // namespace tensorflow
@@ -15,11 +15,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 #define TENSORFLOW_CORE_FRAMEWORK_MODEL_H_
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
-// TODO(b/114492873): Move this include into core/platform.
-#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -37,6 +36,13 @@ namespace model {
 // A constant that can be used to enable auto-tuning.
 constexpr int kAutoTune = -1;
 
+// Names of the tunable parameters the model understands. The "parallelism"
+// parameter determines the number of elements produced concurrently, while the
+// "buffer_size" parameter determines the number of elements buffered ahead of
+// the consumer.
+constexpr char kParallelism[] = "parallelism";
+constexpr char kBufferSize[] = "buffer_size";
+
 // Represents thread-safe state that can be shared between an input pipeline and
 // the performance model.
 struct SharedState {
@@ -121,9 +127,14 @@ class Node {
   virtual ~Node() {}
 
   // Increments the bytes buffered by the given delta.
-  void add_buffered_bytes(int64 delta) LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    buffered_bytes_ += delta;
+  void add_buffered_bytes(int64 delta) { buffered_bytes_ += delta; }
+
+  // Records that an element of the given size was added to this node's buffer.
+  // Removing it is recorded through `add_buffered_bytes(-bytes)`.
+  void record_buffer_enqueue(int64 bytes) {
+    buffered_bytes_ += bytes;
+    bytes_enqueued_ += bytes;
+    num_enqueued_++;
   }
 
   // Adds an input.
@@ -133,21 +144,19 @@ class Node {
   }
 
   // Increments the aggregate processing time by the given delta.
-  void add_processing_time(int64 delta) LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    processing_time_ += delta;
-  }
+  void add_processing_time(int64 delta) { processing_time_ += delta; }
 
   // Returns an indication whether autotuning is enabled for this node.
-  bool autotune() const LOCKS_EXCLUDED(mu_) {
-    tf_shared_lock l(mu_);
-    return autotune_;
-  }
+  bool autotune() const { return autotune_; }
 
   // Returns the number of bytes stored in this node's buffer.
-  int64 buffered_bytes() const LOCKS_EXCLUDED(mu_) {
+  int64 buffered_bytes() const { return buffered_bytes_; }
+
+  // Returns the average size of the elements added to this node's buffer, or
+  // 0 if none have been added yet.
+  double AverageBufferedElementSize() const LOCKS_EXCLUDED(mu_) {
     tf_shared_lock l(mu_);
-    return buffered_bytes_;
+    return AverageBufferedElementSizeLocked();
   }
 
   // Indicates whether the node has tunable parameters.
@@ -175,43 +184,27 @@ class Node {
   const string& name() const { return name_; }
 
   // Returns the number of elements produced by the node.
-  int64 num_elements() const LOCKS_EXCLUDED(mu_) {
-    tf_shared_lock l(mu_);
-    return num_elements_;
-  }
+  int64 num_elements() const { return num_elements_; }
 
   // Returns the node output.
   Node* output() const { return output_; }
 
   // Returns the aggregate processing time.
-  int64 processing_time() const LOCKS_EXCLUDED(mu_) {
-    tf_shared_lock l(mu_);
-    return processing_time_;
-  }
+  int64 processing_time() const { return processing_time_; }
 
   // Records that the node produced an element.
-  void record_element() LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    num_elements_++;
-  }
+  void record_element() { num_elements_++; }
 
   // Records that a node thread has started executing.
-  void record_start(int64 time_nanos) LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    work_start_[std::this_thread::get_id()] = time_nanos;
-  }
+  void record_start(int64 time_nanos) { work_start_ = time_nanos; }
 
   // Records that a node thread has stopped executing.
-  void record_stop(int64 time_nanos) LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    std::thread::id tid = std::this_thread::get_id();
-    auto iter = work_start_.find(tid);
-    if (iter != work_start_.end()) {
-      processing_time_ += time_nanos - iter->second;
-      work_start_.erase(iter);
+  void record_stop(int64 time_nanos) {
+    if (work_start_ != 0) {
+      processing_time_ += time_nanos - work_start_;
+      work_start_ = 0;
     } else {
-      LOG(WARNING)
-          << "Encountered a stop event that was not preceded by a start event.";
+      VLOG(1) << "Encountered a stop event without a matching start event.";
     }
   }
 
@@ -222,10 +215,7 @@ class Node {
   }
 
   // Sets the value that determines whether autotuning is enabled for this node.
-  void set_autotune(bool autotune) LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
-    autotune_ = autotune;
-  }
+  void set_autotune(bool autotune) { autotune_ = autotune; }
 
   // Collects tunable parameters in the subtree rooted in this node.
   void CollectTunableParameters(
@@ -250,10 +240,12 @@ class Node {
     tf_shared_lock l(mu_);
     string result;
     strings::StrAppend(&result, long_name(), ":\n");
-    strings::StrAppend(&result, "  autotune=", autotune_, "\n");
-    strings::StrAppend(&result, "  buffered_bytes=", buffered_bytes_, "\n");
-    strings::StrAppend(&result, "  processing_time=", processing_time_, "\n");
-    strings::StrAppend(&result, "  num_elements=", num_elements_, "\n");
+    strings::StrAppend(&result, "  autotune=", autotune_.load(), "\n");
+    strings::StrAppend(&result, "  buffered_bytes=", buffered_bytes_.load(),
+                       "\n");
+    strings::StrAppend(&result, "  processing_time=", processing_time_.load(),
+                       "\n");
+    strings::StrAppend(&result, "  num_elements=", num_elements_.load(), "\n");
     string inputs;
     for (auto& input : inputs_) {
       strings::StrAppend(&inputs, input->long_name(), ",");
@@ -283,10 +275,12 @@ class Node {
     std::shared_ptr<Node> result = Clone(output);
     {
       mutex_lock l2(result->mu_);
-      result->autotune_ = autotune_;
-      result->buffered_bytes_ = buffered_bytes_;
-      result->processing_time_ = processing_time_;
-      result->num_elements_ = num_elements_;
+      result->autotune_.store(autotune_);
+      result->buffered_bytes_.store(buffered_bytes_);
+      result->bytes_enqueued_.store(bytes_enqueued_);
+      result->num_enqueued_.store(num_enqueued_);
+      result->processing_time_.store(processing_time_);
+      result->num_elements_.store(num_elements_);
       result->parameters_ = parameters_;
     }
     for (auto& input : inputs_) {
@@ -307,6 +301,20 @@ class Node {
     return TotalProcessingTimeLocked();
   }
 
+  // Returns the number of bytes the subtree rooted in this node is expected to
+  // buffer at most, given the model values of its parameters.
+  double TotalMaximumBufferedBytes() const LOCKS_EXCLUDED(mu_) {
+    tf_shared_lock l(mu_);
+    double sum = MaximumBufferedBytesLocked();
+    for (auto& input : inputs_) {
+      // Inputs for which autotuning is disabled are excluded.
+      if (input->autotune()) {
+        sum += input->TotalMaximumBufferedBytes();
+      }
+    }
+    return sum;
+  }
+
  protected:
   // Returns the number of inputs.
   int64 num_inputs() const SHARED_LOCKS_REQUIRED(mu_) {
@@ -355,6 +363,31 @@ class Node {
     return sum;
   }
 
+  // Returns the average size of the elements added to this node's buffer.
+  double AverageBufferedElementSizeLocked() const SHARED_LOCKS_REQUIRED(mu_) {
+    if (num_enqueued_ == 0) {
+      return 0;
+    }
+    return static_cast<double>(bytes_enqueued_) /
+           static_cast<double>(num_enqueued_);
+  }
+
+  // Returns the model value of the given parameter, or `default_value` if the
+  // node does not have it.
+  double ParameterValueLocked(const string& name, double default_value) const
+      SHARED_LOCKS_REQUIRED(mu_) {
+    if (auto* parameter = gtl::FindOrNull(parameters_, name)) {
+      return (*parameter)->value;
+    }
+    return default_value;
+  }
+
+  // Returns the number of bytes this node (excluding its inputs) is expected to
+  // buffer at most. Nodes without a buffer return 0.
+  virtual double MaximumBufferedBytesLocked() const SHARED_LOCKS_REQUIRED(mu_) {
+    return 0;
+  }
+
   // Returns the per-element processing time spent in this node.
   double SelfProcessingTimeLocked() const SHARED_LOCKS_REQUIRED(mu_) {
     if (num_elements_ == 0) {
@@ -368,6 +401,21 @@ class Node {
   virtual double TotalProcessingTimeLocked() const
       SHARED_LOCKS_REQUIRED(mu_) = 0;
 
+  // Stores the time passed to the last call to `Node::record_start()` on the
+  // current thread.
+  //
+  // NOTE: This thread-local variable is shared between all instances of `Node`
+  // on which the same thread calls `record_start()` or `record_stop()`. It
+  // relies on the invariant that at most one `Node` can be "active" on a
+  // particular thread at any time. Therefore if `n->record_start()` is called
+  // on thread `t`, then `n->record_stop()` must be called before another call
+  // to `Node::record_start()` (for any node).
+  static thread_local int64 work_start_;  // Will be initialized to 0.
+
+  // The statistics below are updated on every element produced by the input
+  // pipeline, so they are kept in lock-free counters rather than guarded by
+  // `mu_`. The mutex only protects the structure of the model (inputs and
+  // parameters).
   mutable mutex mu_;
   const int64 id_;
   const string name_;
@@ -375,11 +423,14 @@ class Node {
   // Indicates whether the subtree rooted in this node should be included in
   // autotuning. In particular, if this is `false`, then the subtree is excluded
   // from computation of output time and processing time.
-  bool autotune_ GUARDED_BY(mu_) = true;
-  int64 buffered_bytes_ GUARDED_BY(mu_) = 0;
-  int64 processing_time_ GUARDED_BY(mu_) = 0;
-  int64 num_elements_ GUARDED_BY(mu_) = 0;
-  std::map<std::thread::id, int64> work_start_ GUARDED_BY(mu_);
+  std::atomic<bool> autotune_{true};
+  std::atomic<int64> buffered_bytes_{0};
+  // The number and total size of the elements ever added to the buffer, used
+  // to estimate the size of an element.
+  std::atomic<int64> bytes_enqueued_{0};
+  std::atomic<int64> num_enqueued_{0};
+  std::atomic<int64> processing_time_{0};
+  std::atomic<int64> num_elements_{0};
   std::map<string, std::shared_ptr<Parameter>> parameters_ GUARDED_BY(mu_);
 
   // Inputs of this node. These can represent an iterator created from the input
@@ -457,25 +508,10 @@ class Model {
   std::shared_ptr<Node> AddNode(Node::Factory factory, const string& name,
                                 const string& output_name) LOCKS_EXCLUDED(mu_);
 
-  // Increments the processing time for the given node..
-  void AddProcessingTime(const string& name, int64 delta) LOCKS_EXCLUDED(mu_);
-
-  // Runs optimization.
-  void Optimize(int64 cpu_budget) LOCKS_EXCLUDED(mu_);
-
-  // Records that a node has produced an element.
-  void RecordElement(const string& name) LOCKS_EXCLUDED(mu_);
-
-  // Returns the number of elements that the input pipeline has produced.
-  int64 NumElements(const string& name) LOCKS_EXCLUDED(mu_);
-
-  // Records that the given node has started work. If `stop_output` is set, it
-  // also records that the output of the given node has stopped work.
-  void RecordStart(const string& name, bool stop_output) LOCKS_EXCLUDED(mu_);
-
-  // Records that the given node has stopped work. If `stop_output` is set, it
-  // also records that the output of the given node has started work.
-  void RecordStop(const string& name, bool start_output) LOCKS_EXCLUDED(mu_);
+  // Runs optimization, jointly tuning parallelism and buffer sizes so that
+  // the input pipeline uses at most `cpu_budget` cores and the buffers of its
+  // tunable nodes hold at most `ram_budget` bytes.
+  void Optimize(int64 cpu_budget, int64 ram_budget) LOCKS_EXCLUDED(mu_);
 
   // Removes the given node.
   void RemoveNode(const string& name) LOCKS_EXCLUDED(mu_);
@@ -492,9 +528,13 @@ class Model {
   // Collects the processing time for the given node.
   double TotalProcessingTime(std::shared_ptr<Node> node);
 
-  // Used for coordination between different input pipeline threads. Exclusive
-  // access is required only when adding or removing nodes. Concurrent access to
-  // existing nodes is protected by a node mutex.
+  // Collects the maximum number of bytes buffered by the given node.
+  double TotalMaximumBufferedBytes(std::shared_ptr<Node> node);
+
+  // Used for coordination between different input pipeline threads. It is
+  // only acquired when adding or removing nodes and when taking a snapshot for
+  // optimization; statistics are recorded directly on the `Node` handles held
+  // by the iterators, without going through the model.
   mutex mu_;
   int64 id_counter_ GUARDED_BY(mu_) = 1;
   std::shared_ptr<Node> output_ GUARDED_BY(mu_);
@@ -375,6 +375,11 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->buffered_bytes(), 0);
   node->add_buffered_bytes(42);
   EXPECT_EQ(node->buffered_bytes(), 42);
+  EXPECT_EQ(node->AverageBufferedElementSize(), 0);
+  node->record_buffer_enqueue(100);
+  node->record_buffer_enqueue(200);
+  EXPECT_EQ(node->buffered_bytes(), 342);
+  EXPECT_EQ(node->AverageBufferedElementSize(), 150);
 
   EXPECT_EQ(node->processing_time(), 0);
   node->record_start(1);
@@ -399,6 +404,85 @@ TEST(SetterGetterTest, Node) {
   EXPECT_EQ(node->num_elements(), 1);
 }
 
+TEST(SetterGetterTest, ConcurrentUpdates) {
+  std::shared_ptr<TestNode> node =
+      std::make_shared<TestNode>(model::Node::Args{-1, "TestNode", nullptr});
+  std::shared_ptr<TestNode> input =
+      std::make_shared<TestNode>(model::Node::Args{-1, "TestInput", node});
+  const int kNumThreads = 4;
+  const int kNumElements = 1000;
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumThreads; ++i) {
+      threads.emplace_back(Env::Default()->StartThread(
+          {}, "test", [&node, &input]() {
+            for (int j = 1; j <= kNumElements; ++j) {
+              // Each thread hands over from `node` to `input`, which only works
+              // if the start times are tracked per thread.
+              node->record_start(10 * j);
+              node->record_stop(10 * j + 1);
+              input->record_start(10 * j + 1);
+              input->record_stop(10 * j + 3);
+              node->record_element();
+              node->record_buffer_enqueue(8);
+            }
+          }));
+    }
+  }
+  EXPECT_EQ(node->num_elements(), kNumThreads * kNumElements);
+  EXPECT_EQ(node->processing_time(), kNumThreads * kNumElements);
+  EXPECT_EQ(input->processing_time(), 2 * kNumThreads * kNumElements);
+  EXPECT_EQ(node->buffered_bytes(), 8 * kNumThreads * kNumElements);
+  EXPECT_EQ(node->AverageBufferedElementSize(), 8);
+}
+
+// Builds a model of a consumer that reads from a prefetch node with a tunable
+// buffer size, which buffers elements of 1000 bytes.
+class OptimizeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    buffer_size_ = std::make_shared<SharedState>(
+        kAutoTune, std::make_shared<mutex>(),
+        std::make_shared<condition_variable>());
+    model_ = std::make_shared<Model>([](std::shared_ptr<Node>) {});
+    std::shared_ptr<Node> consumer = model_->AddNode(
+        [](Node::Args args) { return MakeKnownRatioNode(std::move(args), 1); },
+        "consumer", "");
+    std::shared_ptr<SharedState> buffer_size = buffer_size_;
+    prefetch_ = model_->AddNode(
+        [buffer_size](Node::Args args) {
+          return MakeAsyncKnownRatioNode(
+              std::move(args), 1,
+              {MakeParameter(kBufferSize, buffer_size, 1, 64)});
+        },
+        "consumer::prefetch", "consumer");
+    model_->AddNode(
+        [](Node::Args args) { return MakeSourceNode(std::move(args)); },
+        "consumer::prefetch::source", "consumer::prefetch");
+    consumer->add_processing_time(100);
+    consumer->record_element();
+    prefetch_->add_processing_time(100);
+    prefetch_->record_element();
+    prefetch_->record_buffer_enqueue(1000);
+  }
+
+  std::shared_ptr<SharedState> buffer_size_;
+  std::shared_ptr<Model> model_;
+  std::shared_ptr<Node> prefetch_;
+};
+
+TEST_F(OptimizeTest, BufferSizeWithinRamBudget) {
+  model_->Optimize(/*cpu_budget=*/1000, /*ram_budget=*/5000);
+  EXPECT_EQ(buffer_size_->value, 5);
+  EXPECT_EQ(prefetch_->TotalMaximumBufferedBytes(), 5000);
+}
+
+TEST_F(OptimizeTest, BufferSizeStopsImproving) {
+  model_->Optimize(/*cpu_budget=*/1000, /*ram_budget=*/1 << 30);
+  EXPECT_GT(buffer_size_->value, 5);
+  EXPECT_LT(buffer_size_->value, 64);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
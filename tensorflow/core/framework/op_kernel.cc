@@ -698,10 +698,23 @@ Status OpKernelContext::allocate_output(StringPiece name,
   return allocate_output(start, shape, tensor, attr);
 }
 
+Allocator* OpKernelContext::get_step_allocator(AllocatorAttributes attr,
+                                               int output_index) {
+  if (attr.value != 0 || attr.scope_id != 0 || track_allocations()) {
+    return nullptr;
+  }
+  if (output_index >= 0 && params_->output_allocator_array != nullptr &&
+      params_->output_allocator_array[output_index] != nullptr) {
+    return params_->output_allocator_array[output_index];
+  }
+  return params_->step_allocator;
+}
+
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
-    AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+    AllocatorAttributes attr, const AllocationAttributes& allocation_attr,
+    Allocator* allocator) {
+  Allocator* a = allocator != nullptr ? allocator : get_allocator(attr);
   Tensor new_tensor(a, type, shape,
                     AllocationAttributes(allocation_attr.no_retry_on_failure,
                                          /* allocation_will_be_logged= */ true,
@@ -731,7 +744,9 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   auto output_tensor = MakeUnique<Tensor>();
-  Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
+  Status s = allocate_tensor(type, shape, output_tensor.get(), attr,
+                             AllocationAttributes(),
+                             get_step_allocator(attr, index));
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor.release());
     *output = outputs_[index].tensor;
@@ -744,7 +759,8 @@ Status OpKernelContext::allocate_temp(
     AllocatorAttributes allocator_attr,
     const AllocationAttributes& allocation_attr) {
   Status s =
-      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr);
+      allocate_tensor(type, shape, out_temp, allocator_attr, allocation_attr,
+                      get_step_allocator(allocator_attr, -1));
   if (track_allocations() && s.ok() && out_temp->TotalBytes() > 0) {
     Allocator* a = get_allocator(allocator_attr);
     if (a->TracksAllocationSizes()) {
@@ -646,6 +646,19 @@ class OpKernelContext {
     // stored in this container..
     ScopedStepContainer* step_container = nullptr;
 
+    // If not null, allocate_output() and allocate_temp() calls that do not
+    // request special allocator attributes use this allocator, whose memory
+    // is released at the end of the step.  The executor sets it only for
+    // kernels that cannot keep tensors past the step, and copies tensors
+    // allocated from it out of it before they reach any other kernel.
+    Allocator* step_allocator = nullptr;
+
+    // If not null, indexed by output number: a non-null entry is the
+    // allocator to use for allocate_output() calls on that output that do not
+    // request special allocator attributes, e.g. the allocator of a buffer
+    // planned ahead of time.  Takes precedence over 'step_allocator'.
+    Allocator* const* output_allocator_array = nullptr;
+
     // Mechanism used by this op kernel invocation to communicate with
     // computations running on other devices.
     Rendezvous* rendezvous = nullptr;
@@ -1272,9 +1285,16 @@ class OpKernelContext {
                            AllocationAttributes());
   }
 
+  // If 'allocator' is null, uses get_allocator(allocator_attr).
   Status allocate_tensor(DataType type, const TensorShape& shape,
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
-                         const AllocationAttributes& allocation_attr);
+                         const AllocationAttributes& allocation_attr,
+                         Allocator* allocator = nullptr);
+
+  // Returns the allocator set up by the executor for an output (if
+  // 'output_index' is not negative) or temporary allocated with 'attr', or
+  // null if get_allocator() should be used.
+  Allocator* get_step_allocator(AllocatorAttributes attr, int output_index);
 
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
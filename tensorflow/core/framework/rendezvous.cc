@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <utility>
@@ -146,9 +147,24 @@ Status Rendezvous::Recv(const ParsedKey& key, const Args& args, Tensor* val,
   return Recv(key, args, val, is_dead, no_timeout);
 }
 
+Status Rendezvous::SendToSlot(const SlotId& slot, const ParsedKey& key,
+                              const Args& args, const Tensor& val,
+                              const bool is_dead) {
+  return Send(key, args, val, is_dead);
+}
+
+void Rendezvous::RecvFromSlotAsync(const SlotId& slot, const ParsedKey& key,
+                                   const Args& args, DoneCallback done) {
+  RecvAsync(key, args, std::move(done));
+}
+
 class LocalRendezvousImpl : public Rendezvous {
  public:
-  explicit LocalRendezvousImpl() {}
+  explicit LocalRendezvousImpl() {
+    for (auto& chunk : slot_chunks_) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+  }
 
   Status Send(const ParsedKey& key, const Args& send_args, const Tensor& val,
               const bool is_dead) override {
@@ -247,6 +263,103 @@ class LocalRendezvousImpl : public Rendezvous {
     delete item;
   }
 
+  Status SendToSlot(const SlotId& slot_id, const ParsedKey& key,
+                    const Args& send_args, const Tensor& val,
+                    const bool is_dead) override {
+    Slot* slot = GetSlot(slot_id);
+    if (slot == nullptr) {
+      return Send(key, send_args, val, is_dead);
+    }
+    VLOG(2) << "SendToSlot " << this << " " << slot_id.index << " "
+            << key.FullKey();
+    if (aborted_.load()) return status();
+
+    Item* item = nullptr;
+    Item* current = slot->load();
+    while (true) {
+      if (current == nullptr) {
+        // No waiter yet: leave the message in the slot.
+        if (item == nullptr) {
+          item = new Item;
+          item->value = val;
+          item->is_dead = is_dead;
+          item->send_args = send_args;
+          if (item->send_args.device_context) {
+            item->send_args.device_context->Ref();
+          }
+        }
+        if (slot->compare_exchange_weak(current, item)) return Status::OK();
+      } else if (current == AbortedItem()) {
+        delete item;
+        return status();
+      } else if (current == ConsumedItem() || current->IsSendValue()) {
+        delete item;
+        return errors::Internal("Duplicate send to rendezvous slot ",
+                                slot_id.index, " for ", key.FullKey());
+      } else if (slot->compare_exchange_weak(current, ConsumedItem())) {
+        // There is a waiter for this message; it is now ours to notify.
+        delete item;
+        current->waiter(Status::OK(), send_args, current->recv_args, val,
+                        is_dead);
+        delete current;
+        return Status::OK();
+      }
+    }
+  }
+
+  void RecvFromSlotAsync(const SlotId& slot_id, const ParsedKey& key,
+                         const Args& recv_args, DoneCallback done) override {
+    Slot* slot = GetSlot(slot_id);
+    if (slot == nullptr) {
+      RecvAsync(key, recv_args, std::move(done));
+      return;
+    }
+    VLOG(2) << "RecvFromSlot " << this << " " << slot_id.index << " "
+            << key.FullKey();
+    if (aborted_.load()) {
+      done(status(), Args(), recv_args, Tensor(), false);
+      return;
+    }
+
+    Item* current = slot->load();
+    while (true) {
+      if (current == nullptr) {
+        // No message yet: leave a waiter in the slot.
+        Item* item = new Item;
+        item->waiter = std::move(done);
+        item->recv_args = recv_args;
+        if (item->recv_args.device_context) {
+          item->recv_args.device_context->Ref();
+        }
+        if (slot->compare_exchange_strong(current, item)) {
+          // A concurrent StartAbort() may have swept the slots before this
+          // one was allocated, so check again and take the waiter back.
+          if (aborted_.load() && slot->compare_exchange_strong(
+                                     item, AbortedItem())) {
+            item->waiter(status(), Args(), item->recv_args, Tensor(), false);
+            delete item;
+          }
+          return;
+        }
+        done = std::move(item->waiter);
+        delete item;
+      } else if (current == AbortedItem()) {
+        done(status(), Args(), recv_args, Tensor(), false);
+        return;
+      } else if (current == ConsumedItem() || !current->IsSendValue()) {
+        done(errors::Internal("Duplicate recv from rendezvous slot ",
+                              slot_id.index, " for ", key.FullKey()),
+             Args(), recv_args, Tensor(), false);
+        return;
+      } else if (slot->compare_exchange_weak(current, ConsumedItem())) {
+        done(Status::OK(), current->send_args, recv_args, current->value,
+             current->is_dead);
+        delete current;
+        return;
+      }
+    }
+  }
+
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
     Table table;
@@ -255,6 +368,8 @@ class LocalRendezvousImpl : public Rendezvous {
       status_.Update(status);
       table_.swap(table);
     }
+    aborted_.store(true);
+    SweepSlots(status);
     for (auto& p : table) {
       for (Item* item : p.second) {
         if (!item->IsSendValue()) {
@@ -288,6 +403,86 @@ class LocalRendezvousImpl : public Rendezvous {
     bool IsSendValue() const { return this->waiter == nullptr; }
   };
 
+  // A slot holds nullptr, a sent message, a waiter, or one of the sentinels
+  // below.  Each transition out of a message or a waiter is a
+  // compare-and-swap, so exactly one thread takes ownership of the item.
+  typedef std::atomic<Item*> Slot;
+
+  // Marks a slot whose message has been delivered.
+  static Item* ConsumedItem() {
+    static Item* item = new Item;
+    return item;
+  }
+  // Marks a slot swept by StartAbort().
+  static Item* AbortedItem() {
+    static Item* item = new Item;
+    return item;
+  }
+
+  // Slots are allocated in chunks on first use, so that a rendezvous without
+  // slotted pairs does not pay for them.
+  static constexpr int64 kSlotsPerChunk = 1024;
+  static constexpr int64 kMaxSlotChunks = 256;
+
+  // Returns the slot for "slot_id", or nullptr if the pair must be matched
+  // by key instead.  The answer only depends on "slot_id", so both sides of
+  // a pair agree on it.
+  Slot* GetSlot(const SlotId& slot_id) {
+    if (slot_id.index < 0 || slot_id.scope == 0 ||
+        slot_id.index >= kSlotsPerChunk * kMaxSlotChunks) {
+      return nullptr;
+    }
+    // Only the first scope seen is matched by slot.
+    uint64 scope = slot_scope_.load();
+    if (scope == 0 && slot_scope_.compare_exchange_strong(scope,
+                                                          slot_id.scope)) {
+      scope = slot_id.scope;
+    }
+    if (scope != slot_id.scope) return nullptr;
+
+    std::atomic<Slot*>* chunk_ptr = &slot_chunks_[slot_id.index /
+                                                  kSlotsPerChunk];
+    Slot* chunk = chunk_ptr->load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+      Slot* new_chunk = new Slot[kSlotsPerChunk];
+      for (int64 i = 0; i < kSlotsPerChunk; ++i) {
+        new_chunk[i].store(nullptr, std::memory_order_relaxed);
+      }
+      if (chunk_ptr->compare_exchange_strong(chunk, new_chunk,
+                                             std::memory_order_acq_rel)) {
+        chunk = new_chunk;
+      } else {
+        delete[] new_chunk;
+      }
+    }
+    return &chunk[slot_id.index % kSlotsPerChunk];
+  }
+
+  // Marks every allocated slot as aborted, and fails the waiters left in
+  // them with "status".
+  void SweepSlots(const Status& status) {
+    for (auto& chunk_ptr : slot_chunks_) {
+      Slot* chunk = chunk_ptr.load(std::memory_order_acquire);
+      if (chunk == nullptr) continue;
+      for (int64 i = 0; i < kSlotsPerChunk; ++i) {
+        Item* item = chunk[i].exchange(AbortedItem());
+        if (item == nullptr || item == AbortedItem() ||
+            item == ConsumedItem()) {
+          continue;
+        }
+        if (!item->IsSendValue()) {
+          item->waiter(status, Args(), item->recv_args, Tensor(), false);
+        }
+        delete item;
+      }
+    }
+  }
+
+  Status status() {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
   // We key the hash table by KeyHash of the Rendezvous::CreateKey string
   static uint64 KeyHash(const StringPiece& k) {
     return Hash64(k.data(), k.size());
@@ -307,9 +502,18 @@ class LocalRendezvousImpl : public Rendezvous {
   Table table_ GUARDED_BY(mu_);
   Status status_ GUARDED_BY(mu_);
 
+  std::atomic<bool> aborted_{false};
+  std::atomic<uint64> slot_scope_{0};
+  std::atomic<Slot*> slot_chunks_[kMaxSlotChunks];
+
   ~LocalRendezvousImpl() override {
     if (!table_.empty()) {
       StartAbort(errors::Cancelled("LocalRendezvousImpl deleted"));
+    } else {
+      SweepSlots(errors::Cancelled("LocalRendezvousImpl deleted"));
+    }
+    for (auto& chunk : slot_chunks_) {
+      delete[] chunk.load();
     }
   }
 
@@ -114,6 +114,26 @@ class Rendezvous : public core::RefCounted {
   Status Recv(const ParsedKey& key, const Args& args, Tensor* val,
               bool* is_dead);
 
+  // Identifies a Send/Recv pair by an integer assigned when the graph was
+  // partitioned (see PartitionOptions::assign_rendezvous_slots).  Indices
+  // are dense from 0 within a scope, and every partitioning of a graph gets
+  // a scope of its own.
+  struct SlotId {
+    uint64 scope = 0;
+    int64 index = -1;
+  };
+
+  // Like Send() and RecvAsync(), for a pair of the top-level frame that has
+  // been assigned "slot".  An implementation may match such pairs by slot
+  // instead of by "key", in which case the pair must not use Send() or
+  // RecvAsync() for the same tensor.  The default implementations forward
+  // to Send() and RecvAsync().
+  virtual Status SendToSlot(const SlotId& slot, const ParsedKey& key,
+                            const Args& args, const Tensor& val,
+                            const bool is_dead);
+  virtual void RecvFromSlotAsync(const SlotId& slot, const ParsedKey& key,
+                                 const Args& args, DoneCallback done);
+
   // Aborts all pending and future Send/Recv with the given "status".
   //
   // StartAbort() does not wait for ongoing calls to finish.
@@ -127,6 +147,11 @@ class Rendezvous : public core::RefCounted {
 // Returns a Rendezvous instance that is limited to use only by
 // producers and consumers in the local process.  The caller assumes
 // ownership of one Ref() on the returned object.
+//
+// Pairs sent with SendToSlot() and received with RecvFromSlotAsync() are
+// matched through a lock-free array indexed by slot, without hashing the
+// key, for the first scope seen by the rendezvous.  Slots of other scopes
+// fall back to the key.
 Rendezvous* NewLocalRendezvous();
 
 }  // end namespace tensorflow
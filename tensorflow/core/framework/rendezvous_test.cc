@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -272,6 +274,137 @@ TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
       errors::IsAborted(rendez_->Recv(KeyFoo(), args, &val, &val_dead)));
 }
 
+Rendezvous::SlotId Slot(uint64 scope, int64 index) {
+  Rendezvous::SlotId slot;
+  slot.scope = scope;
+  slot.index = index;
+  return slot;
+}
+
+// Receives from "slot" of "rendez" and waits for the result.
+Status RecvFromSlot(Rendezvous* rendez, const Rendezvous::SlotId& slot,
+                    const Rendezvous::ParsedKey& key, Tensor* val) {
+  Status status;
+  Notification n;
+  rendez->RecvFromSlotAsync(
+      slot, key, Rendezvous::Args(),
+      [&status, &n, val](const Status& s, const Rendezvous::Args& send_args,
+                         const Rendezvous::Args& recv_args, const Tensor& v,
+                         const bool dead) {
+        status = s;
+        *val = v;
+        n.Notify();
+      });
+  n.WaitForNotification();
+  return status;
+}
+
+TEST_F(LocalRendezvousTest, SlotSendRecv) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->SendToSlot(Slot(1, 0), KeyFoo(), args, V("hello"),
+                                   false));
+  TF_ASSERT_OK(rendez_->SendToSlot(Slot(1, 5000), KeyBar(), args, V("world"),
+                                   false));
+  Tensor val(DT_STRING);
+  TF_ASSERT_OK(RecvFromSlot(rendez_, Slot(1, 5000), KeyBar(), &val));
+  EXPECT_EQ("world", V(val));
+  TF_ASSERT_OK(RecvFromSlot(rendez_, Slot(1, 0), KeyFoo(), &val));
+  EXPECT_EQ("hello", V(val));
+
+  // Each slot carries a single message.
+  EXPECT_TRUE(errors::IsInternal(
+      rendez_->SendToSlot(Slot(1, 0), KeyFoo(), args, V("again"), false)));
+  EXPECT_TRUE(
+      errors::IsInternal(RecvFromSlot(rendez_, Slot(1, 0), KeyFoo(), &val)));
+}
+
+TEST_F(LocalRendezvousTest, SlotRecvSend) {
+  SchedClosure([this]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    Rendezvous::Args args;
+    TF_ASSERT_OK(rendez_->SendToSlot(Slot(1, 3), KeyFoo(), args, V("hello"),
+                                     false));
+  });
+  Tensor val(DT_STRING);
+  TF_ASSERT_OK(RecvFromSlot(rendez_, Slot(1, 3), KeyFoo(), &val));
+  EXPECT_EQ("hello", V(val));
+}
+
+TEST_F(LocalRendezvousTest, SlotOfOtherScopeUsesKey) {
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->SendToSlot(Slot(1, 0), KeyFoo(), args, V("hello"),
+                                   false));
+  // Only the first scope is matched by slot, so the pairs of a second scope
+  // are matched by key, whatever their slot.
+  TF_ASSERT_OK(rendez_->SendToSlot(Slot(2, 0), KeyBar(), args, V("world"),
+                                   false));
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(KeyBar(), args, &val, &is_dead));
+  EXPECT_EQ("world", V(val));
+  TF_ASSERT_OK(RecvFromSlot(rendez_, Slot(1, 0), KeyFoo(), &val));
+  EXPECT_EQ("hello", V(val));
+}
+
+TEST_F(LocalRendezvousTest, RandomSlotSendRecv) {
+  static const int N = 100;
+  random::PhiloxRandom philox(testing::RandomSeed(), 17);
+  random::SimplePhilox rnd(&philox);
+  BlockingState state;
+  state.counter = N;
+  for (int i = 0; i < N; ++i) {
+    int micros = 100 + rnd.Uniform(1000);
+    SchedClosure([this, i, micros]() {
+      Env::Default()->SleepForMicroseconds(micros);
+      Rendezvous::Args args;
+      TF_ASSERT_OK(rendez_->SendToSlot(Slot(1, i), KeyFoo(), args,
+                                       V(strings::StrCat(i)), false));
+    });
+    auto recv_done = [&state, i](const Status& status,
+                                 const Rendezvous::Args& sender_args,
+                                 const Rendezvous::Args& recver_args,
+                                 const Tensor& val, const bool val_dead) {
+      EXPECT_EQ(strings::StrCat(i), V(val));
+      bool done = false;
+      {
+        mutex_lock l(state.lock);
+        state.counter--;
+        if (state.counter == 0) {
+          done = true;
+        }
+      }
+      if (done) {
+        state.done.Notify();
+      }
+    };
+    micros = 100 + rnd.Uniform(1000);
+    SchedClosure([this, i, micros, recv_done]() {
+      Env::Default()->SleepForMicroseconds(micros);
+      rendez_->RecvFromSlotAsync(Slot(1, i), KeyFoo(), Rendezvous::Args(),
+                                 recv_done);
+    });
+  }
+
+  state.done.WaitForNotification();
+}
+
+TEST_F(LocalRendezvousTest, SlotRecvAbort) {
+  rendez_->Ref();
+  SchedClosure([this]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    rendez_->StartAbort(errors::Aborted(""));  // abort
+    rendez_->Unref();
+  });
+  Tensor val(DT_STRING);
+  EXPECT_TRUE(
+      errors::IsAborted(RecvFromSlot(rendez_, Slot(1, 0), KeyFoo(), &val)));
+  EXPECT_TRUE(errors::IsAborted(
+      rendez_->SendToSlot(Slot(1, 1), KeyFoo(), Rendezvous::Args(), val,
+                          false)));
+  EXPECT_TRUE(
+      errors::IsAborted(RecvFromSlot(rendez_, Slot(1, 2), KeyFoo(), &val)));
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
@@ -329,6 +462,43 @@ void BM_SendRecv(int iters) {
 }
 BENCHMARK(BM_SendRecv);
 
+// Sends and receives the tensors of a step with many Send/Recv pairs, by
+// key or by slot.
+void BM_SendRecvStep(int iters, int use_slots) {
+  static const int kNumPairs = 1000;
+  std::vector<Rendezvous::ParsedKey> keys;
+  for (int i = 0; i < kNumPairs; ++i) {
+    keys.push_back(MakeKey(strings::StrCat("edge_", i)));
+  }
+  Tensor orig = V("val");
+  Tensor val(DT_STRING, TensorShape({}));
+  bool is_dead = false;
+  Rendezvous::Args args;
+  auto recv_done = [&val](const Status& s, const Rendezvous::Args& send_args,
+                          const Rendezvous::Args& recv_args, const Tensor& v,
+                          const bool dead) {
+    TF_CHECK_OK(s);
+    val = v;
+  };
+  testing::ItemsProcessed(static_cast<int64>(iters) * kNumPairs);
+  while (iters--) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    for (int i = 0; i < kNumPairs; ++i) {
+      if (use_slots) {
+        TF_CHECK_OK(
+            rendez->SendToSlot(Slot(1, i), keys[i], args, orig, is_dead));
+        rendez->RecvFromSlotAsync(Slot(1, i), keys[i], args, recv_done);
+      } else {
+        TF_CHECK_OK(rendez->Send(keys[i], args, orig, is_dead));
+        rendez->RecvAsync(keys[i], args, recv_done);
+      }
+    }
+    rendez->Unref();
+  }
+  CHECK_EQ(V(val), V(orig));
+}
+BENCHMARK(BM_SendRecvStep)->Arg(0)->Arg(1);
+
 void BM_PingPong(int iters) {
   CHECK_GT(iters, 0);
   thread::ThreadPool* pool = new thread::ThreadPool(Env::Default(), "test", 1);
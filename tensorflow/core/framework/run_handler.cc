@@ -17,6 +17,10 @@ limitations under the License.
 
 #include "tensorflow/core/framework/run_handler.h"
 
+#include <algorithm>
+#include <functional>
+#include <map>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/run_handler_util.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -29,7 +33,7 @@ namespace tensorflow {
 class RunHandler::Impl {
  public:
   explicit Impl(RunHandlerPool::Impl* pool_impl) : pool_impl_(pool_impl) {
-    Reset();
+    Reset(0, 0);
   }
 
   ~Impl() {}
@@ -48,13 +52,54 @@ class RunHandler::Impl {
   // requested via RunHandlerPool::Get().
   uint64 start_time_us() const { return start_time_us_; }
 
+  int64 priority() const { return priority_; }
+  int64 wait_usecs() const { return wait_usecs_; }
+
+  int64 mean_queueing_delay_usecs() const {
+    const int64 num_closures =
+        num_scheduled_closures_.load(std::memory_order_relaxed);
+    if (num_closures == 0) return 0;
+    return queueing_delay_usecs_.load(std::memory_order_relaxed) /
+           num_closures;
+  }
+
   void ScheduleInterOpClosure(std::function<void()> fn);
 
-  void Reset();
+  Eigen::ThreadPoolInterface* AsIntraThreadPoolInterface(
+      thread::ThreadPool* intra_op_pool);
+
+  // Sets [*start, *limit) to the share of the threads of an intra-op pool of
+  // "num_threads" threads that this request may use.
+  void IntraOpRange(int num_threads, int* start, int* limit) const;
+
+  void Reset(int64 priority, int64 wait_usecs);
 
   RunHandlerPool::Impl* pool_impl() { return pool_impl_; }
 
  private:
+  // Schedules closures on the threads of an intra-op pool in the range given
+  // by IntraOpRange().
+  class IntraOpThreadPool : public Eigen::ThreadPoolInterface {
+   public:
+    IntraOpThreadPool(const Impl* handler, thread::ThreadPool* pool)
+        : handler_(handler), pool_(pool) {}
+
+    void Schedule(std::function<void()> fn) override {
+      int start = 0, limit = 0;
+      handler_->IntraOpRange(pool_->NumThreads(), &start, &limit);
+      pool_->ScheduleWithHint(std::move(fn), start, limit);
+    }
+
+    int NumThreads() const override { return pool_->NumThreads(); }
+    int CurrentThreadId() const override { return pool_->CurrentThreadId(); }
+
+    thread::ThreadPool* pool() const { return pool_; }
+
+   private:
+    const Impl* const handler_;       // Not owned.
+    thread::ThreadPool* const pool_;  // Not owned.
+  };
+
   // Encoding/decoding logic for storing [start, limit) into a single
   // uint_fast32_t int. We assume that pool_num_threads < (1 << 16).
   const int kMaxPartitionBits = 16;
@@ -66,7 +111,7 @@ class RunHandler::Impl {
   }
 
   void DecodePartition(std::uint_fast32_t val, std::uint_fast32_t* start,
-                       std::uint_fast32_t* limit) {
+                       std::uint_fast32_t* limit) const {
     *limit = val & (kMaxThreads - 1);
     val >>= kMaxPartitionBits;
     *start = val;
@@ -75,6 +120,15 @@ class RunHandler::Impl {
   std::atomic_uint_fast32_t inter_op_scheduling_range_;
   RunHandlerPool::Impl* pool_impl_;  // NOT OWNED.
   uint64 start_time_us_;
+  int64 priority_;
+  int64 wait_usecs_;
+  std::atomic<int64> queueing_delay_usecs_;
+  std::atomic<int64> num_scheduled_closures_;
+
+  mutex mu_;
+  // Kept across requests, so that callers may cache state per pool.
+  std::vector<std::unique_ptr<IntraOpThreadPool>> intra_op_pools_
+      GUARDED_BY(mu_);
 };
 
 // Contains shared state across all run handlers present in the pool. Also
@@ -120,18 +174,32 @@ class RunHandlerPool::Impl {
     return inter_op_thread_pool_.get();
   }
 
-  std::unique_ptr<RunHandler> Get() LOCKS_EXCLUDED(mu_) {
+  std::unique_ptr<RunHandler> Get(int64 priority) LOCKS_EXCLUDED(mu_) {
+    const uint64 wait_start_us = tensorflow::Env::Default()->NowMicros();
     mutex_lock l(mu_);
-    while (free_handlers_.empty()) {
-      one_handler_free_.wait(l);
+    if (free_handlers_.empty() || HasWaiterAtOrAboveLocked(priority)) {
+      condition_variable handler_free;
+      auto waiter = waiters_.emplace(priority, &handler_free);
+      do {
+        handler_free.wait(l);
+      } while (free_handlers_.empty() || waiters_.begin() != waiter);
+      waiters_.erase(waiter);
+      if (free_handlers_.size() > 1) NotifyFirstWaiterLocked();
     }
-    // Remove the last entry from free_handlers_ and add to the end of
-    // sorted_active_handlers_.
+    const int64 wait_usecs =
+        tensorflow::Env::Default()->NowMicros() - wait_start_us;
+    // Remove the last entry from free_handlers_ and add it to
+    // sorted_active_handlers_, after the handlers with the same or a higher
+    // priority.  Among those with the same priority, handlers stay sorted by
+    // start time since they are obtained in increasing order of time.
     auto* handler_impl = free_handlers_.back();
-    handler_impl->Reset();
-    // Sortedness isn't violated if we simply add at the end of the list, since
-    // handlers are expected to be obtained in increasing order of time.
-    sorted_active_handlers_.push_back(handler_impl);
+    handler_impl->Reset(priority, wait_usecs);
+    auto iter = std::upper_bound(
+        sorted_active_handlers_.begin(), sorted_active_handlers_.end(),
+        priority, [](int64 p, const RunHandler::Impl* handler) {
+          return p > handler->priority();
+        });
+    sorted_active_handlers_.insert(iter, handler_impl);
     DCHECK_LE(sorted_active_handlers_.size(), max_handlers_);
     free_handlers_.pop_back();
 
@@ -163,13 +231,25 @@ class RunHandlerPool::Impl {
       DCHECK_LE(free_handlers_.size(), max_handlers_);
 
       RecomputePoolStatsLocked();
+      // The waiter is woken under the lock, since it owns its condition
+      // variable and may return as soon as the lock is released.
+      NotifyFirstWaiterLocked();
     }
-    one_handler_free_.notify_one();
   }
 
  private:
   void RecomputePoolStatsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  bool HasWaiterAtOrAboveLocked(int64 priority) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !waiters_.empty() && waiters_.begin()->first >= priority;
+  }
+
+  // Wakes up the caller of Get() that is next in line for a free handler.
+  void NotifyFirstWaiterLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (!waiters_.empty()) waiters_.begin()->second->notify_one();
+  }
+
   // Maximum number of handlers pre-created during pool construction time. The
   // number has been chosen expecting each handler might at least want 1
   // inter-op thread for execution (during compute intensive workloads like
@@ -188,16 +268,19 @@ class RunHandlerPool::Impl {
   const std::unique_ptr<thread::ThreadPool> inter_op_thread_pool_;
 
   // Thread compatible part used only by lock under RunHandlerPool.
-  // Handlers are sorted by start time.
+  // Handlers are sorted by decreasing priority, then by start time.
   std::vector<RunHandler::Impl*> sorted_active_handlers_ GUARDED_BY(mu_);
   std::vector<RunHandler::Impl*> free_handlers_ GUARDED_BY(mu_);
   std::vector<std::unique_ptr<RunHandler::Impl>> handlers_ GUARDED_BY(mu_);
+  // The callers blocked in Get(), by decreasing priority and then in the
+  // order they arrived, each with the condition variable it waits on.
+  std::multimap<int64, condition_variable*, std::greater<int64>> waiters_
+      GUARDED_BY(mu_);
   // Histogram of elapsed runtime of every handler (in ms).
   histogram::Histogram time_hist_ GUARDED_BY(mu_);
   std::vector<std::uint_fast32_t> inter_op_start_ GUARDED_BY(mu_);
   std::vector<std::uint_fast32_t> inter_op_limit_ GUARDED_BY(mu_);
   int64 iterations_ GUARDED_BY(mu_);
-  condition_variable one_handler_free_;
   mutex mu_;
 };
 
@@ -245,14 +328,50 @@ void RunHandler::Impl::ScheduleInterOpClosure(std::function<void()> fn) {
   std::uint_fast32_t start = 0, limit = 0;
   DecodePartition(inter_op_scheduling_range(), &start, &limit);
   DCHECK_LT(start, limit);
-  pool_impl_->inter_op_thread_pool()->ScheduleWithHint(std::move(fn), start,
-                                                       limit);
+  const uint64 scheduled_us = tensorflow::Env::Default()->NowMicros();
+  pool_impl_->inter_op_thread_pool()->ScheduleWithHint(
+      std::bind(
+          [this, scheduled_us](const std::function<void()>& fn) {
+            queueing_delay_usecs_.fetch_add(
+                tensorflow::Env::Default()->NowMicros() - scheduled_us,
+                std::memory_order_relaxed);
+            num_scheduled_closures_.fetch_add(1, std::memory_order_relaxed);
+            fn();
+          },
+          std::move(fn)),
+      start, limit);
+}
+
+Eigen::ThreadPoolInterface* RunHandler::Impl::AsIntraThreadPoolInterface(
+    thread::ThreadPool* intra_op_pool) {
+  mutex_lock l(mu_);
+  for (const auto& pool : intra_op_pools_) {
+    if (pool->pool() == intra_op_pool) return pool.get();
+  }
+  intra_op_pools_.emplace_back(new IntraOpThreadPool(this, intra_op_pool));
+  return intra_op_pools_.back().get();
+}
+
+void RunHandler::Impl::IntraOpRange(int num_threads, int* start,
+                                    int* limit) const {
+  std::uint_fast32_t inter_op_start = 0, inter_op_limit = 0;
+  DecodePartition(inter_op_scheduling_range(), &inter_op_start,
+                  &inter_op_limit);
+  const int64 num_inter_op_threads =
+      pool_impl_->inter_op_thread_pool()->NumThreads();
+  *start = inter_op_start * num_threads / num_inter_op_threads;
+  *limit = std::max<int64>(*start + 1,
+                           inter_op_limit * num_threads / num_inter_op_threads);
 }
 
-void RunHandler::Impl::Reset() {
+void RunHandler::Impl::Reset(int64 priority, int64 wait_usecs) {
   set_inter_op_scheduling_range(
       0, pool_impl_->inter_op_thread_pool()->NumThreads());
   start_time_us_ = tensorflow::Env::Default()->NowMicros();
+  priority_ = priority;
+  wait_usecs_ = wait_usecs;
+  queueing_delay_usecs_.store(0, std::memory_order_relaxed);
+  num_scheduled_closures_.store(0, std::memory_order_relaxed);
 }
 
 RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
@@ -260,7 +379,9 @@ RunHandlerPool::RunHandlerPool(int num_inter_op_threads)
 
 RunHandlerPool::~RunHandlerPool() {}
 
-std::unique_ptr<RunHandler> RunHandlerPool::Get() { return impl_->Get(); }
+std::unique_ptr<RunHandler> RunHandlerPool::Get(int64 priority) {
+  return impl_->Get(priority);
+}
 
 RunHandler::RunHandler(Impl* impl) : impl_(impl) {}
 
@@ -268,5 +389,22 @@ void RunHandler::ScheduleInterOpClosure(std::function<void()> fn) {
   impl_->ScheduleInterOpClosure(std::move(fn));
 }
 
+Eigen::ThreadPoolInterface* RunHandler::AsIntraThreadPoolInterface(
+    thread::ThreadPool* intra_op_pool) {
+  return impl_->AsIntraThreadPoolInterface(intra_op_pool);
+}
+
+int RunHandler::IntraOpParallelism(int num_threads) const {
+  int start = 0, limit = 0;
+  impl_->IntraOpRange(num_threads, &start, &limit);
+  return limit - start;
+}
+
+int64 RunHandler::wait_usecs() const { return impl_->wait_usecs(); }
+
+int64 RunHandler::mean_queueing_delay_usecs() const {
+  return impl_->mean_queueing_delay_usecs();
+}
+
 RunHandler::~RunHandler() { impl_->pool_impl()->ReleaseHandler(impl_); }
 }  // namespace tensorflow
@@ -37,11 +37,17 @@ class RunHandler;
 // * Create a single RunHandlerPool (say run_handler_pool_).
 //
 // * When a Session::Run() is invoked, obtain a handler by:
-// auto handler = run_handler_pool_->Get();
+// auto handler = run_handler_pool_->Get(priority);
 //
 // * Use handler for scheduling all inter-op work by:
 // handler->ScheduleInterOpClosure(closure);
 //
+// * Optionally, run the intra-op work of the request on its share of an
+// intra-op pool through handler->AsIntraThreadPoolInterface(pool).
+//
+// Active handlers are ranked by decreasing priority, then by the time they
+// were obtained, and higher ranked handlers get access to more threads.
+//
 // This class is thread safe.
 class RunHandlerPool {
  public:
@@ -55,8 +61,10 @@ class RunHandlerPool {
   // and is being used by a client.  It becomes 'inactive' once more when the
   // unique_ptr is destroyed.
   //
-  // Will block unless there is an inactive handler.
-  std::unique_ptr<RunHandler> Get();
+  // Will block unless there is an inactive handler.  Blocked callers with
+  // higher "priority" are served first, and callers with the same priority
+  // in the order they arrived.
+  std::unique_ptr<RunHandler> Get(int64 priority = 0);
 
  private:
   class Impl;
@@ -79,6 +87,29 @@ class RunHandler {
  public:
   void ScheduleInterOpClosure(std::function<void()> fn);
 
+  // Returns a thread pool that schedules closures on this request's share of
+  // the threads of "intra_op_pool": the same fraction of its threads as of
+  // the inter-op threads.  The handler owns the returned pool and returns the
+  // same one for "intra_op_pool" to every request it serves, so callers may
+  // cache state keyed by it.
+  //
+  // The returned pool reports the threads of "intra_op_pool", so that
+  // thread ids stay unique; IntraOpParallelism() is the number of them that
+  // the request should use at once.
+  Eigen::ThreadPoolInterface* AsIntraThreadPoolInterface(
+      thread::ThreadPool* intra_op_pool);
+
+  // Returns the number of threads of an intra-op pool of "num_threads"
+  // threads that this request may use at once.
+  int IntraOpParallelism(int num_threads) const;
+
+  // The time spent in RunHandlerPool::Get() waiting for this handler.
+  int64 wait_usecs() const;
+
+  // The mean time from ScheduleInterOpClosure() to the start of the closures
+  // scheduled so far.
+  int64 mean_queueing_delay_usecs() const;
+
   ~RunHandler();
 
  private:
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <atomic>
 #include <deque>
 #include <queue>
 #include <unordered_map>
@@ -995,6 +996,12 @@ Status Partition(const PartitionOptions& opts, Graph* g,
   status = BuildMemoryDeviceInfo(*g, &g_info);
   if (!status.ok()) return status;
 
+  // Scopes start from 1 so that 0 means "no slot".
+  static std::atomic<int64> next_slot_scope(1);
+  const int64 slot_scope =
+      opts.assign_rendezvous_slots ? next_slot_scope.fetch_add(1) : 0;
+  int64 num_slots = 0;
+
   string dstp;
   std::vector<const Edge*> inputs;
   DupRecvTable dup_recv(3);
@@ -1149,6 +1156,14 @@ Status Partition(const PartitionOptions& opts, Graph* g,
           AddRecv(opts, g_info, dst_graph, edge, &real_recv, &status);
       if (!status.ok()) return status;
 
+      if (opts.assign_rendezvous_slots) {
+        for (NodeDef* ndef : {send, real_recv}) {
+          AddNodeAttr("_rendezvous_slot_scope", slot_scope, ndef);
+          AddNodeAttr("_rendezvous_slot", num_slots, ndef);
+        }
+        ++num_slots;
+      }
+
       // Fix up the control flow edge.
       // NOTE(yuanbyu): 'real_recv' must be the real recv node.
       if (src_graph == dst_graph) {
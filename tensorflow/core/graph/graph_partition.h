@@ -76,6 +76,12 @@ struct PartitionOptions {
   // in the graph as a node attribute.
   bool need_to_record_start_times = false;
   std::vector<Microseconds> start_times;
+
+  // If true, every Send/Recv pair added by Partition is given the same
+  // "_rendezvous_slot" index, dense from 0, and a "_rendezvous_slot_scope"
+  // unique to this call, so that a rendezvous can match the pair without
+  // hashing its key.  See Rendezvous::SendToSlot.
+  bool assign_rendezvous_slots = false;
 };
 
 // Partition "input" graph into a set of graphs, one per location.
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <utility>
 
@@ -74,7 +76,8 @@ string DeviceName(const Node* node) {
 }
 
 void Partition(const GraphDef& graph_def,
-               std::unordered_map<string, GraphDef>* partitions) {
+               std::unordered_map<string, GraphDef>* partitions,
+               bool assign_rendezvous_slots = false) {
   Graph g(OpRegistry::Global());
   GraphConstructorOptions opts;
   TF_CHECK_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
@@ -94,6 +97,7 @@ void Partition(const GraphDef& graph_def,
   popts.get_incarnation = [](const string& name) {
     return (name[0] - 'A') + 100;
   };
+  popts.assign_rendezvous_slots = assign_rendezvous_slots;
   Status s = Partition(popts, &g, partitions);
   CHECK(s.ok()) << s;
 
@@ -522,6 +526,51 @@ TEST_F(GraphPartitionTest, SetIncarnation) {
   }
 }
 
+TEST_F(GraphPartitionTest, RendezvousSlots) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto b1 = FloatInput(in_.WithOpName("B1"));
+  Combine(in_.WithOpName("B2"), a1, b1);
+  Combine(in_.WithOpName("A2"), a1, b1);
+  const GraphDef& graph_def = ToGraphDef();
+
+  // Returns the scope of the slots, and the slot of every tensor name.
+  auto get_slots = [](const std::unordered_map<string, GraphDef>& partitions,
+                      std::map<string, int64>* slots) {
+    int64 scope = -1;
+    for (const auto& kv : partitions) {
+      for (const NodeDef& ndef : kv.second.node()) {
+        if (ndef.op() != "_Send" && ndef.op() != "_Recv") continue;
+        string tensor_name;
+        int64 slot;
+        int64 slot_scope;
+        TF_CHECK_OK(GetNodeAttr(ndef, "tensor_name", &tensor_name));
+        TF_CHECK_OK(GetNodeAttr(ndef, "_rendezvous_slot", &slot));
+        TF_CHECK_OK(GetNodeAttr(ndef, "_rendezvous_slot_scope", &slot_scope));
+        // Both nodes of a pair have the same slot.
+        auto it = slots->emplace(tensor_name, slot).first;
+        EXPECT_EQ(it->second, slot);
+        if (scope == -1) scope = slot_scope;
+        EXPECT_EQ(scope, slot_scope);
+      }
+    }
+    return scope;
+  };
+
+  Partition(graph_def, &partitions_, /*assign_rendezvous_slots=*/true);
+  std::map<string, int64> slots;
+  const int64 scope = get_slots(partitions_, &slots);
+  EXPECT_GT(scope, 0);
+  ASSERT_EQ(2, slots.size());
+  std::set<int64> indices;
+  for (const auto& kv : slots) indices.insert(kv.second);
+  EXPECT_EQ(std::set<int64>({0, 1}), indices);
+
+  std::unordered_map<string, GraphDef> partitions;
+  Partition(graph_def, &partitions, /*assign_rendezvous_slots=*/true);
+  slots.clear();
+  EXPECT_NE(scope, get_slots(partitions, &slots));
+}
+
 TEST(TopologicalSortNodesWithTimePriorityTest, NoDependencies) {
   // Create placeholders, shuffle them so the order in the graph is not strictly
   // increasing.
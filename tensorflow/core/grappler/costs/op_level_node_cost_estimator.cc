@@ -0,0 +1,96 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <memory>
+
+#include "tensorflow/core/common_runtime/critical_path.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Estimates node costs for the executors that order ready nodes by their
+// critical path, with the OpLevelCostEstimator.
+class OpLevelNodeCostEstimator : public NodeCostEstimatorInterface {
+ public:
+  explicit OpLevelNodeCostEstimator(const string& device_name)
+      : device_name_(device_name) {
+    DeviceNameUtils::ParsedName parsed;
+    device_ = DeviceNameUtils::ParseFullName(device_name, &parsed)
+                  ? GetDeviceInfo(parsed)
+                  : GetLocalCPUInfo();
+  }
+
+  int64 EstimateNsec(const Node& n,
+                     shape_inference::InferenceContext* c) override {
+    OpContext op_context;
+    op_context.name = n.name();
+    op_context.device_name = device_name_;
+    FillOpInfo(n, c, &op_context.op_info);
+    *op_context.op_info.mutable_device() = device_;
+    const Costs costs = estimator_.PredictCosts(op_context);
+    if (costs.execution_time == Costs::Duration::infinity()) return -1;
+    return costs.execution_time.count();
+  }
+
+ private:
+  // Fills in the op, attributes and statically known input and output
+  // properties of "n".
+  static void FillOpInfo(const Node& n, shape_inference::InferenceContext* c,
+                         OpInfo* op_info) {
+    op_info->set_op(n.type_string());
+    for (const auto& attr : n.attrs()) {
+      (*op_info->mutable_attr())[attr.first] = attr.second;
+    }
+    for (int i = 0; i < c->num_inputs() && i < n.num_inputs(); ++i) {
+      OpInfo::TensorProperties* input = op_info->add_inputs();
+      input->set_dtype(BaseType(n.input_type(i)));
+      c->ShapeHandleToProto(c->input(i), input->mutable_shape());
+    }
+    for (int i = 0; i < c->num_outputs() && i < n.num_outputs(); ++i) {
+      OpInfo::TensorProperties* output = op_info->add_outputs();
+      output->set_dtype(BaseType(n.output_type(i)));
+      c->ShapeHandleToProto(c->output(i), output->mutable_shape());
+    }
+  }
+
+  const string device_name_;
+  DeviceProperties device_;
+  OpLevelCostEstimator estimator_;
+};
+
+class OpLevelNodeCostEstimatorRegistration {
+ public:
+  static std::unique_ptr<NodeCostEstimatorInterface> CreateEstimator(
+      const string& device_name) {
+    return std::unique_ptr<NodeCostEstimatorInterface>(
+        new OpLevelNodeCostEstimator(device_name));
+  }
+
+  OpLevelNodeCostEstimatorRegistration() {
+    NodeCostEstimatorRegistry::RegisterFactory(CreateEstimator);
+  }
+};
+
+static OpLevelNodeCostEstimatorRegistration
+    register_op_level_node_cost_estimator;
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
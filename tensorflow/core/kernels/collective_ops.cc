@@ -158,6 +158,25 @@ class CollectiveReduceOpKernel : public CollectiveOpKernel {
                     final_op_name));
     OP_REQUIRES_OK(c, c->GetAttr("T", &col_params_.instance.data_type));
     OP_REQUIRES_OK(c, c->GetAttr("wait_for", &dependencies_));
+    CollInstanceParams& instance = col_params_.instance;
+    OP_REQUIRES_OK(c, c->GetAttr("compression", &instance.compression));
+    float topk_ratio;
+    OP_REQUIRES_OK(c, c->GetAttr("topk_ratio", &topk_ratio));
+    // The ratio only matters to "topk", so ignore it otherwise when the
+    // param resolver checks that all members agree.
+    instance.topk_ratio = instance.compression == "topk" ? topk_ratio : 0;
+    OP_REQUIRES_OK(c, CollectiveCompressor::Create(instance.compression,
+                                                   instance.topk_ratio,
+                                                   &col_params_.compressor));
+    if (col_params_.compressor) {
+      OP_REQUIRES(c, col_params_.instance.data_type == DT_FLOAT,
+                  errors::InvalidArgument(
+                      "compression requires float32 values but got ",
+                      DataTypeString(col_params_.instance.data_type)));
+      OP_REQUIRES(c, c->device_type() == DEVICE_CPU,
+                  errors::Unimplemented(
+                      "compression is only supported on CPU devices"));
+    }
 
     const NodeDef& real_node = c->def();
     col_params_.name = strings::StrCat(real_node.name(), ": Reduce(",
@@ -16,8 +16,16 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -27,10 +35,107 @@ namespace {
 // See documentation in ../../ops/dataset_ops.cc for a high-level description of
 // the following op.
 
+// The size of the read buffer used for reading spilled elements.
+const size_t kSpillReaderBufferSize = 256 * 1024;  // 256 KB
+
+// Encodes `element` into the compact binary format used for the elements that
+// a hybrid cache spills to disk. For each tensor, the format stores the rank
+// and the dimensions of its shape as varints, followed by:
+// - the raw tensor buffer, for types that can be copied with memcpy,
+// - the length and `port::EncodeStringList()` encoding, for strings, and
+// - the length and serialized `TensorProto`, for all other types.
+// The types themselves are not stored, as they are known from the dataset.
+void EncodeSpilledElement(const std::vector<Tensor>& element, string* out) {
+  out->clear();
+  for (const Tensor& t : element) {
+    core::PutVarint64(out, t.dims());
+    for (int64 dim : t.shape().dim_sizes()) {
+      core::PutVarint64(out, dim);
+    }
+    if (DataTypeCanUseMemcpy(t.dtype())) {
+      StringPiece buffer = t.tensor_data();
+      out->append(buffer.data(), buffer.size());
+    } else {
+      string encoded;
+      if (t.dtype() == DT_STRING) {
+        auto strings = t.flat<string>();
+        port::EncodeStringList(strings.data(), strings.size(), &encoded);
+      } else {
+        TensorProto proto;
+        t.AsProtoTensorContent(&proto);
+        proto.AppendToString(&encoded);
+      }
+      core::PutVarint64(out, encoded.size());
+      out->append(encoded);
+    }
+  }
+}
+
+// Decodes an element encoded by `EncodeSpilledElement()`.
+Status DecodeSpilledElement(StringPiece input, const DataTypeVector& dtypes,
+                            std::vector<Tensor>* out) {
+  out->clear();
+  out->reserve(dtypes.size());
+  for (DataType dtype : dtypes) {
+    uint64 rank;
+    if (!core::GetVarint64(&input, &rank)) {
+      return errors::DataLoss("Corrupted cache spill file.");
+    }
+    gtl::InlinedVector<int64, 4> dims(rank);
+    for (uint64 i = 0; i < rank; ++i) {
+      uint64 dim;
+      if (!core::GetVarint64(&input, &dim)) {
+        return errors::DataLoss("Corrupted cache spill file.");
+      }
+      dims[i] = static_cast<int64>(dim);
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        TensorShapeUtils::MakeShape(dims.data(), dims.size(), &shape));
+    if (DataTypeCanUseMemcpy(dtype)) {
+      out->emplace_back(dtype, shape);
+      StringPiece buffer = out->back().tensor_data();
+      if (input.size() < buffer.size()) {
+        return errors::DataLoss("Corrupted cache spill file.");
+      }
+      std::copy(input.data(), input.data() + buffer.size(),
+                const_cast<char*>(buffer.data()));
+      input.remove_prefix(buffer.size());
+      continue;
+    }
+    uint64 size;
+    if (!core::GetVarint64(&input, &size) || input.size() < size) {
+      return errors::DataLoss("Corrupted cache spill file.");
+    }
+    StringPiece encoded(input.data(), size);
+    input.remove_prefix(size);
+    if (dtype == DT_STRING) {
+      out->emplace_back(DT_STRING, shape);
+      auto strings = out->back().flat<string>();
+      if (!port::DecodeStringList(string(encoded), strings.data(),
+                                  strings.size())) {
+        return errors::DataLoss("Corrupted cache spill file.");
+      }
+    } else {
+      TensorProto proto;
+      out->emplace_back();
+      if (!proto.ParseFromArray(encoded.data(), encoded.size()) ||
+          !out->back().FromProto(proto)) {
+        return errors::DataLoss("Corrupted cache spill file.");
+      }
+    }
+  }
+  return Status::OK();
+}
+
 class CacheDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit CacheDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("memory_budget", &memory_budget_));
+    OP_REQUIRES(ctx, memory_budget_ >= 0,
+                errors::InvalidArgument("memory_budget must be non-negative."));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -39,7 +144,10 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx,
                    ParseScalarArgument<string>(ctx, "filename", &filename));
 
-    if (filename.empty()) {
+    if (memory_budget_ > 0) {
+      *output = new HybridDataset(ctx, input, filename, memory_budget_,
+                                  ctx->env());
+    } else if (filename.empty()) {
       *output = new MemoryDataset(ctx, input);
     } else {
       *output = new FileDataset(ctx, input, filename, ctx->env());
@@ -958,6 +1066,561 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
     const DatasetBase* const input_;
   };  // MemoryDataset
+
+  // Caches the elements of its input in memory up to `memory_budget` bytes
+  // and spills the remaining elements to a local file, so that datasets that
+  // are slightly larger than the available memory do not have to be cached on
+  // disk in their entirety. The spill file is named after `filename` if it is
+  // set, or is a temporary file otherwise, and is deleted with the cache.
+  // Unlike the file cache, it is not reused by other programs.
+  class HybridDataset : public DatasetBase {
+   public:
+    explicit HybridDataset(OpKernelContext* ctx, const DatasetBase* input,
+                           string filename, int64 memory_budget, Env* env)
+        : DatasetBase(DatasetContext(ctx)),
+          input_(input),
+          filename_(std::move(filename)),
+          memory_budget_(memory_budget),
+          env_(env) {
+      input->Ref();
+    }
+
+    ~HybridDataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<HybridIterator>(HybridIterator::Params{
+          this, strings::StrCat(prefix, "::HybridCache")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() const override {
+      return "CacheDatasetOp::HybridDataset";
+    }
+
+    int64 Cardinality() const override { return input_->Cardinality(); }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* input_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_node));
+      Node* filename_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename_node));
+      AttrValue memory_budget;
+      b->BuildAttrValue<int64>(memory_budget_, &memory_budget);
+      TF_RETURN_IF_ERROR(
+          b->AddDataset(this, {input_node, filename_node},
+                        {std::make_pair("memory_budget", memory_budget)},
+                        output));
+      return Status::OK();
+    }
+
+   private:
+    // A thread-safe data structure for caching dataset elements partly in
+    // memory and partly on disk.
+    //
+    // As with `MemoryCache`, a single `HybridWriterIterator` populates the
+    // cache. Elements are kept in memory until the next element would exceed
+    // the memory budget; that element and all later ones are appended to the
+    // spill file. Once the cache is completed, any number of
+    // `HybridReaderIterator`s can read it concurrently, each through its own
+    // handle to the spill file.
+    class HybridCache : public ResourceBase {
+     public:
+      HybridCache(Env* env, int64 memory_budget, string spill_filename)
+          : env_(env),
+            memory_budget_(memory_budget),
+            spill_filename_(std::move(spill_filename)) {}
+
+      ~HybridCache() override { Reset(); }
+
+      string DebugString() const override {
+        return "CacheDataset::HybridCache";
+      }
+
+      // Adds the element to the cache.
+      Status Append(const std::vector<Tensor>& element) {
+        mutex_lock l(mu_);
+        if (num_spilled_ == 0) {
+          int64 bytes = 0;
+          for (const Tensor& t : element) {
+            bytes += t.TotalBytes();
+          }
+          if (memory_bytes_ + bytes <= memory_budget_) {
+            memory_bytes_ += bytes;
+            memory_.push_back(element);
+            return Status::OK();
+          }
+        }
+        EncodeSpilledElement(element, &encoded_);
+        return AppendSpilledLocked(encoded_);
+      }
+
+      // Adds an element encoded by `EncodeSpilledElement()` to the spill
+      // file, e.g. when the cache is restored from a checkpoint.
+      Status AppendSpilled(StringPiece record) {
+        mutex_lock l(mu_);
+        return AppendSpilledLocked(record);
+      }
+
+      // Calls `fn` with each element spilled to disk so far, encoded by
+      // `EncodeSpilledElement()`, in order.
+      Status ForEachSpilled(const std::function<Status(const string&)>& fn) {
+        mutex_lock l(mu_);
+        if (num_spilled_ == 0) {
+          return Status::OK();
+        }
+        if (spill_writer_) {
+          TF_RETURN_IF_ERROR(spill_writer_->Flush());
+        }
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(spill_filename_, &file));
+        io::RecordReaderOptions options;
+        options.buffer_size = kSpillReaderBufferSize;
+        io::SequentialRecordReader reader(file.get(), options);
+        string record;
+        for (size_t i = 0; i < num_spilled_; ++i) {
+          TF_RETURN_IF_ERROR(reader.ReadRecord(&record));
+          TF_RETURN_IF_ERROR(fn(record));
+        }
+        return Status::OK();
+      }
+
+      // Marks the cache as completed, making the spilled elements readable.
+      Status Complete() {
+        mutex_lock l(mu_);
+        if (spill_writer_) {
+          TF_RETURN_IF_ERROR(spill_writer_->Close());
+          TF_RETURN_IF_ERROR(spill_file_->Close());
+          spill_writer_.reset();
+          spill_file_.reset();
+        }
+        completed_ = true;
+        return Status::OK();
+      }
+
+      // Returns whether the cache is claimed.
+      bool IsClaimed() {
+        tf_shared_lock l(mu_);
+        return claimed_;
+      }
+
+      // Returns whether the cache is completed.
+      bool IsCompleted() {
+        tf_shared_lock l(mu_);
+        return completed_;
+      }
+
+      // Attempts to claim the cache, returning whether the cache was claimed.
+      bool MaybeClaim() {
+        mutex_lock l(mu_);
+        if (!claimed_) {
+          claimed_ = true;
+          return true;
+        }
+        return false;
+      }
+
+      // Resets the cache, deleting the spill file.
+      void Reset() {
+        mutex_lock l(mu_);
+        claimed_ = false;
+        completed_ = false;
+        memory_.clear();
+        memory_bytes_ = 0;
+        spill_writer_.reset();
+        spill_file_.reset();
+        if (num_spilled_ > 0) {
+          env_->DeleteFile(spill_filename_).IgnoreError();
+        }
+        num_spilled_ = 0;
+      }
+
+      // Returns the element at the given index, which must be smaller than
+      // `num_memory_elements()`.
+      const std::vector<Tensor>& at(int64 index) {
+        tf_shared_lock l(mu_);
+        DCHECK(index < memory_.size());
+        return memory_[index];
+      }
+
+      // Returns the number of elements held in memory.
+      size_t num_memory_elements() {
+        tf_shared_lock l(mu_);
+        return memory_.size();
+      }
+
+      // Returns the number of elements spilled to disk.
+      size_t num_spilled_elements() {
+        tf_shared_lock l(mu_);
+        return num_spilled_;
+      }
+
+      const string& spill_filename() const { return spill_filename_; }
+
+     private:
+      Status AppendSpilledLocked(StringPiece record)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!spill_writer_) {
+          TF_RETURN_IF_ERROR(
+              env_->NewWritableFile(spill_filename_, &spill_file_));
+          spill_writer_ =
+              absl::make_unique<io::RecordWriter>(spill_file_.get());
+        }
+        TF_RETURN_IF_ERROR(spill_writer_->WriteRecord(record));
+        num_spilled_++;
+        return Status::OK();
+      }
+
+      Env* const env_;
+      const int64 memory_budget_;
+      const string spill_filename_;
+      mutex mu_;
+      // Determines whether a writer has claimed the cache.
+      bool claimed_ GUARDED_BY(mu_) = false;
+      // Determines whether all elements of the dataset have been cached.
+      bool completed_ GUARDED_BY(mu_) = false;
+      std::vector<std::vector<Tensor>> memory_ GUARDED_BY(mu_);
+      int64 memory_bytes_ GUARDED_BY(mu_) = 0;
+      size_t num_spilled_ GUARDED_BY(mu_) = 0;
+      std::unique_ptr<WritableFile> spill_file_ GUARDED_BY(mu_);
+      std::unique_ptr<io::RecordWriter> spill_writer_ GUARDED_BY(mu_);
+      // Scratch space for encoding spilled elements.
+      string encoded_ GUARDED_BY(mu_);
+    };
+
+    class HybridIterator : public DatasetIterator<HybridDataset> {
+     public:
+      explicit HybridIterator(const Params& params)
+          : DatasetIterator<HybridDataset>(params) {}
+
+      ~HybridIterator() override {
+        if (cache_) cache_->Unref();
+      }
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        // Use the resource manager in the iterator context to get / create
+        // a cache.
+        ResourceMgr* mgr = ctx->resource_mgr();
+        const string name = strings::StrCat(
+            prefix(), "::", dataset()->node_name(), "::HybridCache");
+        const HybridDataset* dataset = this->dataset();
+        TF_RETURN_IF_ERROR(mgr->LookupOrCreate<HybridCache>(
+            "tf_data", name, &cache_, [dataset](HybridCache** cache) {
+              string spill_filename;
+              if (dataset->filename_.empty()) {
+                if (!dataset->env_->LocalTempFilename(&spill_filename)) {
+                  return errors::Internal(
+                      "Failed to create a temporary file for the cache.");
+                }
+              } else {
+                spill_filename = strings::StrCat(
+                    dataset->filename_, "_",
+                    strings::Hex(random::New64(), strings::kZeroPad16),
+                    ".spill");
+              }
+              *cache = new HybridCache(dataset->env_, dataset->memory_budget_,
+                                       std::move(spill_filename));
+              return Status::OK();
+            }));
+        mode_ = cache_->MaybeClaim() ? Mode::write : Mode::read;
+        InitializeIterator();
+        if (mode_ == Mode::read && !cache_->IsCompleted()) {
+          return errors::Internal(
+              "Cache should only be read after it has been completed.");
+        }
+        return iterator_->Initialize(ctx);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        return iterator_->GetNext(ctx, out_tensors, end_of_sequence);
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      // As for the memory cache, the contents of the cache are saved with the
+      // iterator, since the spill file does not outlive the cache. Spilled
+      // elements are saved in their encoded form.
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("mode"), mode_));
+        if (cache_->IsClaimed()) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("cache_claimed"), ""));
+          size_t cache_size = cache_->num_memory_elements();
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("cache_size"), cache_size));
+          for (size_t i = 0; i < cache_size; i++) {
+            auto& element = cache_->at(i);
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                full_name(strings::StrCat("cache[", i, "].size")),
+                element.size()));
+            for (size_t j = 0; j < element.size(); ++j) {
+              TF_RETURN_IF_ERROR(writer->WriteTensor(
+                  full_name(strings::StrCat("cache[", i, "][", j, "]")),
+                  element[j]));
+            }
+          }
+          size_t num_spilled = 0;
+          TF_RETURN_IF_ERROR(cache_->ForEachSpilled(
+              [this, writer, &num_spilled](const string& record) {
+                return writer->WriteScalar(
+                    full_name(strings::StrCat("spilled[", num_spilled++, "]")),
+                    record);
+              }));
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("num_spilled"), num_spilled));
+          if (cache_->IsCompleted()) {
+            TF_RETURN_IF_ERROR(
+                writer->WriteScalar(full_name("cache_completed"), ""));
+          }
+        }
+        return SaveInput(writer, iterator_);
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        iterator_.reset();
+        cache_->Reset();
+        {
+          int64 temp;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("mode"), &temp));
+          mode_ = static_cast<Mode>(temp);
+        }
+        if (reader->Contains(full_name("cache_claimed"))) {
+          CHECK(cache_->MaybeClaim());
+          size_t cache_size;
+          {
+            int64 temp;
+            TF_RETURN_IF_ERROR(
+                reader->ReadScalar(full_name("cache_size"), &temp));
+            cache_size = static_cast<size_t>(temp);
+          }
+          for (size_t i = 0; i < cache_size; ++i) {
+            std::vector<Tensor> element;
+            size_t element_size;
+            {
+              int64 temp;
+              TF_RETURN_IF_ERROR(reader->ReadScalar(
+                  full_name(strings::StrCat("cache[", i, "].size")), &temp));
+              element_size = static_cast<size_t>(temp);
+            }
+            element.reserve(element_size);
+            for (size_t j = 0; j < element_size; ++j) {
+              element.emplace_back();
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  full_name(strings::StrCat("cache[", i, "][", j, "]")),
+                  &element.back()));
+            }
+            TF_RETURN_IF_ERROR(cache_->Append(element));
+          }
+          int64 num_spilled;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("num_spilled"), &num_spilled));
+          string record;
+          for (int64 i = 0; i < num_spilled; ++i) {
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                full_name(strings::StrCat("spilled[", i, "]")), &record));
+            TF_RETURN_IF_ERROR(cache_->AppendSpilled(record));
+          }
+          if (reader->Contains(full_name("cache_completed"))) {
+            TF_RETURN_IF_ERROR(cache_->Complete());
+          }
+        }
+        InitializeIterator();
+        TF_RETURN_IF_ERROR(iterator_->Initialize(ctx));
+        return RestoreInput(ctx, reader, iterator_);
+      }
+
+     private:
+      class HybridWriterIterator : public DatasetIterator<HybridDataset> {
+       public:
+        explicit HybridWriterIterator(const Params& params, HybridCache* cache)
+            : DatasetIterator<HybridDataset>(params), cache_(cache) {
+          CHECK(cache_);
+        }
+
+        ~HybridWriterIterator() override {
+          if (!cache_->IsCompleted()) {
+            // See `MemoryWriterIterator` for why a partially written cache is
+            // discarded.
+            cache_->Reset();
+          }
+        }
+
+        Status Initialize(IteratorContext* ctx) override {
+          return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
+        }
+
+        Status GetNextInternal(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) override {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+          if (*end_of_sequence) {
+            return cache_->Complete();
+          }
+          return cache_->Append(*out_tensors);
+        }
+
+       protected:
+        std::shared_ptr<model::Node> CreateNode(
+            IteratorContext* ctx, model::Node::Args args) const override {
+          return model::MakeKnownRatioNode(std::move(args),
+                                           /*ratio=*/1);
+        }
+
+        Status SaveInternal(IteratorStateWriter* writer) override {
+          mutex_lock l(mu_);
+          return SaveInput(writer, input_impl_);
+        }
+
+        Status RestoreInternal(IteratorContext* ctx,
+                               IteratorStateReader* reader) override {
+          mutex_lock l(mu_);
+          return RestoreInput(ctx, reader, input_impl_);
+        }
+
+       private:
+        mutex mu_;
+        std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+        HybridCache* const cache_;  // not owned.
+      };  // HybridWriterIterator
+
+      class HybridReaderIterator : public DatasetIterator<HybridDataset> {
+       public:
+        explicit HybridReaderIterator(const Params& params, HybridCache* cache)
+            : DatasetIterator<HybridDataset>(params),
+              cache_(cache),
+              num_memory_elements_(cache->num_memory_elements()),
+              num_spilled_elements_(cache->num_spilled_elements()) {}
+
+        Status Initialize(IteratorContext* ctx) override {
+          mutex_lock l(mu_);
+          if (num_spilled_elements_ > 0) {
+            TF_RETURN_IF_ERROR(dataset()->env_->NewRandomAccessFile(
+                cache_->spill_filename(), &spill_file_));
+            io::RecordReaderOptions options;
+            options.buffer_size = kSpillReaderBufferSize;
+            spill_reader_ = absl::make_unique<io::SequentialRecordReader>(
+                spill_file_.get(), options);
+          }
+          return Status::OK();
+        }
+
+        Status GetNextInternal(IteratorContext* ctx,
+                               std::vector<Tensor>* out_tensors,
+                               bool* end_of_sequence) override {
+          mutex_lock l(mu_);
+          if (index_ < num_memory_elements_) {
+            const std::vector<Tensor>& cache_tensors = cache_->at(index_);
+            out_tensors->insert(out_tensors->begin(), cache_tensors.begin(),
+                                cache_tensors.end());
+          } else if (index_ < num_memory_elements_ + num_spilled_elements_) {
+            TF_RETURN_IF_ERROR(spill_reader_->ReadRecord(&record_));
+            TF_RETURN_IF_ERROR(DecodeSpilledElement(
+                record_, dataset()->output_dtypes(), out_tensors));
+          } else {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          index_++;
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+
+       protected:
+        std::shared_ptr<model::Node> CreateNode(
+            IteratorContext* ctx, model::Node::Args args) const override {
+          return model::MakeKnownRatioNode(std::move(args),
+                                           /*ratio=*/1);
+        }
+
+        Status SaveInternal(IteratorStateWriter* writer) override {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("index"), index_));
+          return Status::OK();
+        }
+
+        Status RestoreInternal(IteratorContext* ctx,
+                               IteratorStateReader* reader) override {
+          mutex_lock l(mu_);
+          {
+            int64 temp;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("index"), &temp));
+            index_ = static_cast<size_t>(temp);
+          }
+          // Skip the spilled elements that were already read.
+          const size_t num_read_spilled = std::min(
+              index_, num_memory_elements_ + num_spilled_elements_);
+          for (size_t i = num_memory_elements_; i < num_read_spilled; ++i) {
+            TF_RETURN_IF_ERROR(spill_reader_->ReadRecord(&record_));
+          }
+          return Status::OK();
+        }
+
+       private:
+        mutex mu_;
+        HybridCache* const cache_;  // not owned.
+        const size_t num_memory_elements_;
+        const size_t num_spilled_elements_;
+        size_t index_ GUARDED_BY(mu_) = 0;
+        std::unique_ptr<RandomAccessFile> spill_file_ GUARDED_BY(mu_);
+        std::unique_ptr<io::SequentialRecordReader> spill_reader_
+            GUARDED_BY(mu_);
+        string record_ GUARDED_BY(mu_);
+      };  // HybridReaderIterator
+
+      void InitializeIterator() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        switch (mode_) {
+          case Mode::read:
+            iterator_ = absl::make_unique<HybridReaderIterator>(
+                HybridReaderIterator::Params{
+                    dataset(), strings::StrCat(prefix(), "Impl")},
+                cache_);
+            break;
+          case Mode::write:
+            iterator_ = absl::make_unique<HybridWriterIterator>(
+                HybridWriterIterator::Params{
+                    dataset(), strings::StrCat(prefix(), "Impl")},
+                cache_);
+        }
+      }
+
+      mutex mu_;
+      HybridCache* cache_ GUARDED_BY(mu_) = nullptr;  // not owned.
+      enum Mode { read, write };
+      Mode mode_ GUARDED_BY(mu_);
+      std::unique_ptr<IteratorBase> iterator_ GUARDED_BY(mu_);
+    };  // HybridIterator
+
+    const DatasetBase* const input_;
+    const string filename_;
+    const int64 memory_budget_;
+    Env* const env_;
+  };  // HybridDataset
+
+  int64 memory_budget_;
 };    // CacheDatasetOp
 
 REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
@@ -631,7 +631,8 @@ Status InstantiatedCapturedFunction::RunInstantiated(
 
 void InstantiatedCapturedFunction::RunAsync(
     IteratorContext* ctx, std::vector<Tensor>&& args, std::vector<Tensor>* rets,
-    FunctionLibraryRuntime::DoneCallback done, const string& prefix) const {
+    FunctionLibraryRuntime::DoneCallback done, const string& prefix,
+    const std::shared_ptr<model::Node>& node) const {
   auto& info = captured_func_->short_circuit_info();
   if (!info.indices.empty()) {
     // Run the `done` callback on a threadpool thread, because it will
@@ -671,7 +672,7 @@ void InstantiatedCapturedFunction::RunAsync(
   CancellationManager* c_mgr = new CancellationManager();
   f_opts.cancellation_manager = c_mgr;
   std::shared_ptr<SimpleStepStatsCollector> stats_collector;
-  if (ctx->model() || ctx->stats_aggregator()) {
+  if (node || ctx->stats_aggregator()) {
     stats_collector = absl::make_unique<SimpleStepStatsCollector>();
   }
   f_opts.stats_collector = stats_collector.get();
@@ -680,6 +681,7 @@ void InstantiatedCapturedFunction::RunAsync(
       [this, rets, step_container, c_mgr, frame](
           const FunctionLibraryRuntime::DoneCallback& done,
           const std::shared_ptr<model::Model>& model,
+          const std::shared_ptr<model::Node>& node,
           const std::shared_ptr<StatsAggregator>& stats_aggregator,
           const string& prefix,
           const std::shared_ptr<SimpleStepStatsCollector>& stats_collector,
@@ -703,18 +705,24 @@ void InstantiatedCapturedFunction::RunAsync(
           stats_aggregator->AddToHistogram(
               stats_utils::ExecutionTimeHistogramName(prefix_with_func_name),
               {static_cast<float>(stats_collector->processing_time())},
-              model->NumElements(prefix));
+              node ? node->num_elements() : 0);
         }
-        if (model) {
-          model->AddProcessingTime(prefix, stats_collector->processing_time());
-          model->RecordStart(prefix, false /* stop_output */);
+        // The node is held by the callback, so it is safe to record its
+        // statistics even if `done` destroys the iterator that owns it.
+        const bool collect_resource_usage =
+            node && model && model->collect_resource_usage();
+        if (node) {
+          node->add_processing_time(stats_collector->processing_time());
+        }
+        if (collect_resource_usage) {
+          node->record_start(absl::GetCurrentTimeNanos());
         }
         done(s);
-        if (model) {
-          model->RecordStop(prefix, false /* start_output */);
+        if (collect_resource_usage) {
+          node->record_stop(absl::GetCurrentTimeNanos());
         }
       },
-      std::move(done), ctx->model(), ctx->stats_aggregator(), prefix,
+      std::move(done), ctx->model(), node, ctx->stats_aggregator(), prefix,
       std::move(stats_collector), std::placeholders::_1);
 
   lib_->Run(f_opts, f_handle_, frame, std::move(callback));
@@ -82,11 +82,13 @@ class InstantiatedCapturedFunction {
   // Asynchronously runs the captured function on the given `args`, stores
   // the results in `*rets`, and calls the given `done` callback when the
   // function returns. This method takes ownership of the tensors in `args`,
-  // in order to be able to deallocate them as early as possible.
+  // in order to be able to deallocate them as early as possible. If `node` is
+  // set, the time spent in the function is recorded on it.
   void RunAsync(IteratorContext* ctx, std::vector<Tensor>&& args,
                 std::vector<Tensor>* rets,
                 FunctionLibraryRuntime::DoneCallback done,
-                const string& prefix) const;
+                const string& prefix,
+                const std::shared_ptr<model::Node>& node) const;
 
  private:
   InstantiatedCapturedFunction(
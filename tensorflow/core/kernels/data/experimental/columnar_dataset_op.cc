@@ -0,0 +1,771 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <unordered_map>
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/data/experimental/columnar.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// See documentation in ../../ops/experimental_dataset_ops.cc for a high-level
+// description of the following op.
+
+constexpr char kColumnarMagic[] = "TFCF";
+constexpr size_t kColumnarMagicSize = 4;
+// The size of the fixed trailer that ends a columnar file: the size of the
+// footer as a fixed64, followed by the magic string.
+constexpr size_t kColumnarTrailerSize = sizeof(uint64) + kColumnarMagicSize;
+
+// A comparison between the values of a column and a constant.
+struct ColumnFilter {
+  enum class Op {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessEqual,
+    kGreater,
+    kGreaterEqual
+  };
+
+  string column;
+  Op op;
+  double value;
+
+  // Returns whether `x` satisfies the filter.
+  bool Matches(double x) const {
+    switch (op) {
+      case Op::kEqual:
+        return x == value;
+      case Op::kNotEqual:
+        return x != value;
+      case Op::kLess:
+        return x < value;
+      case Op::kLessEqual:
+        return x <= value;
+      case Op::kGreater:
+        return x > value;
+      case Op::kGreaterEqual:
+        return x >= value;
+    }
+    return false;
+  }
+
+  // Returns whether any value in `[min_value, max_value]` may satisfy the
+  // filter.
+  bool MayMatch(double min_value, double max_value) const {
+    switch (op) {
+      case Op::kEqual:
+        return min_value <= value && value <= max_value;
+      case Op::kNotEqual:
+        return !(min_value == value && max_value == value);
+      case Op::kLess:
+        return min_value < value;
+      case Op::kLessEqual:
+        return min_value <= value;
+      case Op::kGreater:
+        return max_value > value;
+      case Op::kGreaterEqual:
+        return max_value >= value;
+    }
+    return true;
+  }
+};
+
+Status ParseFilterOp(const string& op, ColumnFilter::Op* out) {
+  if (op == "==") {
+    *out = ColumnFilter::Op::kEqual;
+  } else if (op == "!=") {
+    *out = ColumnFilter::Op::kNotEqual;
+  } else if (op == "<") {
+    *out = ColumnFilter::Op::kLess;
+  } else if (op == "<=") {
+    *out = ColumnFilter::Op::kLessEqual;
+  } else if (op == ">") {
+    *out = ColumnFilter::Op::kGreater;
+  } else if (op == ">=") {
+    *out = ColumnFilter::Op::kGreaterEqual;
+  } else {
+    return errors::InvalidArgument("Unsupported filter operation: ", op);
+  }
+  return Status::OK();
+}
+
+string FilterOpToString(ColumnFilter::Op op) {
+  switch (op) {
+    case ColumnFilter::Op::kEqual:
+      return "==";
+    case ColumnFilter::Op::kNotEqual:
+      return "!=";
+    case ColumnFilter::Op::kLess:
+      return "<";
+    case ColumnFilter::Op::kLessEqual:
+      return "<=";
+    case ColumnFilter::Op::kGreater:
+      return ">";
+    case ColumnFilter::Op::kGreaterEqual:
+      return ">=";
+  }
+  return "";
+}
+
+// Stores the `index`-th value of the numeric tensor `t` in `value`.
+Status NumericValue(const Tensor& t, int64 index, double* value) {
+  switch (t.dtype()) {
+    case DT_HALF:
+      *value = static_cast<float>(t.flat<Eigen::half>()(index));
+      return Status::OK();
+    case DT_BFLOAT16:
+      *value = static_cast<float>(t.flat<bfloat16>()(index));
+      return Status::OK();
+    case DT_FLOAT:
+      *value = t.flat<float>()(index);
+      return Status::OK();
+    case DT_DOUBLE:
+      *value = t.flat<double>()(index);
+      return Status::OK();
+    case DT_INT8:
+      *value = t.flat<int8>()(index);
+      return Status::OK();
+    case DT_UINT8:
+      *value = t.flat<uint8>()(index);
+      return Status::OK();
+    case DT_INT16:
+      *value = t.flat<int16>()(index);
+      return Status::OK();
+    case DT_UINT16:
+      *value = t.flat<uint16>()(index);
+      return Status::OK();
+    case DT_INT32:
+      *value = t.flat<int32>()(index);
+      return Status::OK();
+    case DT_UINT32:
+      *value = t.flat<uint32>()(index);
+      return Status::OK();
+    case DT_INT64:
+      *value = t.flat<int64>()(index);
+      return Status::OK();
+    case DT_UINT64:
+      *value = t.flat<uint64>()(index);
+      return Status::OK();
+    default:
+      return errors::InvalidArgument("Cannot filter on a column of type ",
+                                     DataTypeString(t.dtype()));
+  }
+}
+
+class ColumnarDatasetOp : public DatasetOpKernel {
+ public:
+  explicit ColumnarDatasetOp(OpKernelConstruction* ctx) : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    const Tensor* columns_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("columns", &columns_tensor));
+    OP_REQUIRES(ctx, columns_tensor->dims() == 1,
+                errors::InvalidArgument("`columns` must be a vector."));
+    OP_REQUIRES(
+        ctx, columns_tensor->NumElements() == output_types_.size(),
+        errors::InvalidArgument("`columns` must have one entry per output, "
+                                "but has ",
+                                columns_tensor->NumElements(), " entries for ",
+                                output_types_.size(), " outputs."));
+    std::vector<string> columns;
+    columns.reserve(columns_tensor->NumElements());
+    for (int i = 0; i < columns_tensor->NumElements(); ++i) {
+      columns.push_back(columns_tensor->flat<string>()(i));
+    }
+
+    int64 batch_size;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(ctx, batch_size > 0,
+                errors::InvalidArgument("`batch_size` must be positive."));
+
+    const Tensor* filter_columns_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filter_columns", &filter_columns_tensor));
+    const Tensor* filter_ops_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filter_ops", &filter_ops_tensor));
+    const Tensor* filter_values_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filter_values", &filter_values_tensor));
+    OP_REQUIRES(ctx,
+                filter_columns_tensor->dims() == 1 &&
+                    filter_ops_tensor->dims() == 1 &&
+                    filter_values_tensor->dims() == 1,
+                errors::InvalidArgument(
+                    "`filter_columns`, `filter_ops` and `filter_values` must "
+                    "be vectors."));
+    const int64 num_filters = filter_columns_tensor->NumElements();
+    OP_REQUIRES(ctx,
+                filter_ops_tensor->NumElements() == num_filters &&
+                    filter_values_tensor->NumElements() == num_filters,
+                errors::InvalidArgument(
+                    "`filter_columns`, `filter_ops` and `filter_values` must "
+                    "have the same size."));
+    std::vector<ColumnFilter> filters(num_filters);
+    for (int64 i = 0; i < num_filters; ++i) {
+      filters[i].column = filter_columns_tensor->flat<string>()(i);
+      OP_REQUIRES_OK(ctx, ParseFilterOp(filter_ops_tensor->flat<string>()(i),
+                                        &filters[i].op));
+      filters[i].value = filter_values_tensor->flat<double>()(i);
+    }
+
+    *output = new Dataset(ctx, std::move(filenames), std::move(columns),
+                          batch_size, std::move(filters), output_types_,
+                          output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+            std::vector<string> columns, int64 batch_size,
+            std::vector<ColumnFilter> filters,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : DatasetBase(DatasetContext(ctx)),
+          filenames_(std::move(filenames)),
+          columns_(std::move(columns)),
+          batch_size_(batch_size),
+          filters_(std::move(filters)),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal(
+        const string& prefix) const override {
+      return absl::make_unique<Iterator>(
+          Iterator::Params{this, strings::StrCat(prefix, "::Columnar")});
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() const override {
+      return "ColumnarDatasetOp::Dataset";
+    }
+
+   protected:
+    Status AsGraphDefInternal(SerializationContext* ctx,
+                              DatasetGraphDefBuilder* b,
+                              Node** output) const override {
+      Node* filenames = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+      Node* columns = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(columns_, &columns));
+      Node* batch_size = nullptr;
+      TF_RETURN_IF_ERROR(b->AddScalar(batch_size_, &batch_size));
+      std::vector<string> filter_columns;
+      std::vector<string> filter_ops;
+      std::vector<double> filter_values;
+      for (const ColumnFilter& filter : filters_) {
+        filter_columns.push_back(filter.column);
+        filter_ops.push_back(FilterOpToString(filter.op));
+        filter_values.push_back(filter.value);
+      }
+      Node* filter_columns_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filter_columns, &filter_columns_node));
+      Node* filter_ops_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filter_ops, &filter_ops_node));
+      Node* filter_values_node = nullptr;
+      TF_RETURN_IF_ERROR(b->AddVector(filter_values, &filter_values_node));
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this,
+          {filenames, columns, batch_size, filter_columns_node,
+           filter_ops_node, filter_values_node},
+          output));
+      return Status::OK();
+    }
+
+   private:
+    // Reads the row groups of each file in turn. Only the chunks of the
+    // requested and filtered columns are read, and row groups whose column
+    // statistics show that no row can satisfy the filters are skipped
+    // without reading any chunk.
+    //
+    // Without filters, the values of numeric columns are read from the file
+    // directly into the buffers of the output batch. Otherwise, the chunks of
+    // the row group are loaded, the filters are evaluated over the filtered
+    // columns to select rows, and the selected values are gathered into the
+    // output batch.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Params& params)
+          : DatasetIterator<Dataset>(params) {}
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        const int64 batch_size = dataset()->batch_size_;
+        std::vector<Tensor> batch;
+        batch.reserve(dataset()->output_types_.size());
+        for (DataType dtype : dataset()->output_types_) {
+          batch.emplace_back(ctx->allocator({}), dtype,
+                             TensorShape({batch_size}));
+        }
+        int64 num_rows = 0;
+        while (num_rows < batch_size) {
+          if (next_row_ == num_selected_rows_) {
+            bool end_of_input = false;
+            TF_RETURN_IF_ERROR(AdvanceRowGroup(ctx->env(), &end_of_input));
+            if (end_of_input) {
+              break;
+            }
+            continue;
+          }
+          const int64 n =
+              std::min(batch_size - num_rows, num_selected_rows_ - next_row_);
+          for (size_t i = 0; i < batch.size(); ++i) {
+            TF_RETURN_IF_ERROR(CopyRows(i, n, num_rows, &batch[i]));
+          }
+          next_row_ += n;
+          num_rows += n;
+        }
+        if (num_rows == 0) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        for (Tensor& t : batch) {
+          out_tensors->push_back(num_rows < batch_size ? t.Slice(0, num_rows)
+                                                       : std::move(t));
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeSourceNode(std::move(args));
+      }
+
+      Status SaveInternal(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("current_file_index"),
+                                               current_file_index_));
+        if (file_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              full_name("current_row_group"), current_row_group_));
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar(full_name("next_row"), next_row_));
+        }
+        return Status::OK();
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        ResetFileLocked();
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("current_file_index"),
+                                              &current_file_index));
+        current_file_index_ = current_file_index;
+        if (reader->Contains(full_name("current_row_group"))) {
+          int64 current_row_group;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("current_row_group"),
+                                                &current_row_group));
+          int64 next_row;
+          TF_RETURN_IF_ERROR(
+              reader->ReadScalar(full_name("next_row"), &next_row));
+          TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env()));
+          if (current_row_group >= 0) {
+            TF_RETURN_IF_ERROR(LoadRowGroupLocked(current_row_group));
+            if (next_row > num_selected_rows_) {
+              return errors::DataLoss("Invalid row index ", next_row,
+                                      " for a row group of ",
+                                      num_selected_rows_, " selected rows.");
+            }
+            next_row_ = next_row;
+          }
+        }
+        return Status::OK();
+      }
+
+     private:
+      // Moves on to the next row group that may contain selected rows,
+      // opening the next file if needed.
+      Status AdvanceRowGroup(Env* env, bool* end_of_input)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (true) {
+          if (file_) {
+            for (int64 i = current_row_group_ + 1;
+                 i < footer_.row_group_size(); ++i) {
+              if (!CanSkipRowGroup(footer_.row_group(i))) {
+                return LoadRowGroupLocked(i);
+              }
+            }
+            ResetFileLocked();
+            ++current_file_index_;
+          }
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            *end_of_input = true;
+            return Status::OK();
+          }
+          TF_RETURN_IF_ERROR(OpenFileLocked(env));
+        }
+      }
+
+      // Returns whether the statistics of `row_group` show that none of its
+      // rows can satisfy the filters.
+      bool CanSkipRowGroup(const experimental::RowGroup& row_group)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        for (size_t i = 0; i < dataset()->filters_.size(); ++i) {
+          const experimental::ColumnChunk& chunk =
+              row_group.chunk(filter_column_indices_[i]);
+          if (chunk.has_statistics() &&
+              !dataset()->filters_[i].MayMatch(chunk.min_value(),
+                                               chunk.max_value())) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      // Opens the current file and reads its footer.
+      Status OpenFileLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const string& filename = dataset()->filenames_[current_file_index_];
+        uint64 file_size;
+        TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+        if (file_size < kColumnarTrailerSize) {
+          return errors::DataLoss("File ", filename,
+                                  " is too small to be a columnar file.");
+        }
+        std::unique_ptr<RandomAccessFile> file;
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+
+        char trailer_scratch[kColumnarTrailerSize];
+        StringPiece trailer;
+        TF_RETURN_IF_ERROR(file->Read(file_size - kColumnarTrailerSize,
+                                      kColumnarTrailerSize, &trailer,
+                                      trailer_scratch));
+        if (trailer.size() != kColumnarTrailerSize ||
+            memcmp(trailer.data() + sizeof(uint64), kColumnarMagic,
+                   kColumnarMagicSize) != 0) {
+          return errors::DataLoss("File ", filename,
+                                  " is not a columnar file.");
+        }
+        const uint64 footer_size = core::DecodeFixed64(trailer.data());
+        if (footer_size > file_size - kColumnarTrailerSize) {
+          return errors::DataLoss("Invalid footer size in ", filename);
+        }
+        string footer_scratch(footer_size, '\0');
+        StringPiece footer;
+        TF_RETURN_IF_ERROR(
+            file->Read(file_size - kColumnarTrailerSize - footer_size,
+                       footer_size, &footer, &footer_scratch[0]));
+        if (footer.size() != footer_size ||
+            !footer_.ParseFromArray(footer.data(), footer.size())) {
+          return errors::DataLoss("Failed to parse the footer of ", filename);
+        }
+
+        // Resolve the requested and filtered columns.
+        std::unordered_map<string, int> column_index;
+        for (int i = 0; i < footer_.column_size(); ++i) {
+          column_index[footer_.column(i).name()] = i;
+        }
+        for (const auto& row_group : footer_.row_group()) {
+          if (row_group.chunk_size() != footer_.column_size() ||
+              row_group.num_rows() < 0) {
+            return errors::DataLoss("Invalid row group in ", filename);
+          }
+          // Every row takes at least a value, or an offset for strings, in
+          // each chunk.
+          for (int i = 0; i < footer_.column_size(); ++i) {
+            const experimental::ColumnChunk& chunk = row_group.chunk(i);
+            const DataType dtype = footer_.column(i).dtype();
+            int64 row_bytes = 0;
+            if (DataTypeCanUseMemcpy(dtype)) {
+              row_bytes = DataTypeSize(dtype);
+            } else if (dtype == DT_STRING) {
+              row_bytes = sizeof(uint64);
+            }
+            if (chunk.offset() < 0 || chunk.size_bytes() < 0 ||
+                (row_bytes > 0 &&
+                 row_group.num_rows() > chunk.size_bytes() / row_bytes)) {
+              return errors::DataLoss("Invalid chunk for column ",
+                                      footer_.column(i).name(), " in ",
+                                      filename);
+            }
+          }
+        }
+        output_column_indices_.clear();
+        for (size_t i = 0; i < dataset()->columns_.size(); ++i) {
+          const string& name = dataset()->columns_[i];
+          auto it = column_index.find(name);
+          if (it == column_index.end()) {
+            return errors::InvalidArgument("Column ", name, " not found in ",
+                                           filename);
+          }
+          const DataType dtype = footer_.column(it->second).dtype();
+          if (dtype != dataset()->output_types_[i]) {
+            return errors::InvalidArgument(
+                "Column ", name, " in ", filename, " has type ",
+                DataTypeString(dtype), " but ",
+                DataTypeString(dataset()->output_types_[i]),
+                " was requested.");
+          }
+          output_column_indices_.push_back(it->second);
+        }
+        filter_column_indices_.clear();
+        for (const ColumnFilter& filter : dataset()->filters_) {
+          auto it = column_index.find(filter.column);
+          if (it == column_index.end()) {
+            return errors::InvalidArgument("Filter column ", filter.column,
+                                           " not found in ", filename);
+          }
+          if (!DataTypeIsFloating(footer_.column(it->second).dtype()) &&
+              !DataTypeIsInteger(footer_.column(it->second).dtype())) {
+            return errors::InvalidArgument("Filter column ", filter.column,
+                                           " must be numeric.");
+          }
+          filter_column_indices_.push_back(it->second);
+        }
+        file_ = std::move(file);
+        current_row_group_ = -1;
+        return Status::OK();
+      }
+
+      void ResetFileLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        file_.reset();
+        footer_.Clear();
+        current_row_group_ = -1;
+        loaded_columns_.clear();
+        selected_rows_.clear();
+        num_selected_rows_ = 0;
+        next_row_ = 0;
+      }
+
+      // Makes `index` the current row group. Loads the chunks that are not
+      // read directly into the output batches, and selects the rows that
+      // satisfy the filters.
+      Status LoadRowGroupLocked(int64 index) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const experimental::RowGroup& row_group = footer_.row_group(index);
+        current_row_group_ = index;
+        loaded_columns_.clear();
+        selected_rows_.clear();
+        next_row_ = 0;
+        num_selected_rows_ = row_group.num_rows();
+        if (dataset()->filters_.empty()) {
+          for (int column : output_column_indices_) {
+            if (!DataTypeCanUseMemcpy(footer_.column(column).dtype())) {
+              TF_RETURN_IF_ERROR(LoadColumnLocked(row_group, column));
+            }
+          }
+          return Status::OK();
+        }
+        for (int column : output_column_indices_) {
+          TF_RETURN_IF_ERROR(LoadColumnLocked(row_group, column));
+        }
+        for (int column : filter_column_indices_) {
+          TF_RETURN_IF_ERROR(LoadColumnLocked(row_group, column));
+        }
+        for (int64 row = 0; row < row_group.num_rows(); ++row) {
+          bool selected = true;
+          for (size_t i = 0; i < dataset()->filters_.size() && selected; ++i) {
+            double value;
+            TF_RETURN_IF_ERROR(NumericValue(
+                loaded_columns_[filter_column_indices_[i]], row, &value));
+            selected = dataset()->filters_[i].Matches(value);
+          }
+          if (selected) {
+            selected_rows_.push_back(row);
+          }
+        }
+        num_selected_rows_ = selected_rows_.size();
+        return Status::OK();
+      }
+
+      // Reads the chunk of `column` in `row_group` into `loaded_columns_`.
+      Status LoadColumnLocked(const experimental::RowGroup& row_group,
+                              int column) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (loaded_columns_.count(column) > 0) {
+          return Status::OK();
+        }
+        const experimental::ColumnChunk& chunk = row_group.chunk(column);
+        const DataType dtype = footer_.column(column).dtype();
+        const int64 num_rows = row_group.num_rows();
+        Tensor t(dtype, TensorShape({num_rows}));
+        if (DataTypeCanUseMemcpy(dtype)) {
+          TF_RETURN_IF_ERROR(ReadValuesLocked(chunk, dtype, 0, num_rows,
+                                              const_cast<char*>(
+                                                  t.tensor_data().data())));
+        } else if (dtype == DT_STRING) {
+          string scratch(chunk.size_bytes(), '\0');
+          StringPiece data;
+          TF_RETURN_IF_ERROR(file_->Read(chunk.offset(), chunk.size_bytes(),
+                                         &data, &scratch[0]));
+          const uint64 offsets_size = num_rows * sizeof(uint64);
+          if (data.size() != chunk.size_bytes() ||
+              data.size() < offsets_size) {
+            return errors::DataLoss("Truncated chunk for column ",
+                                    footer_.column(column).name());
+          }
+          StringPiece values(data.data() + offsets_size,
+                             data.size() - offsets_size);
+          auto strings = t.flat<string>();
+          uint64 start = 0;
+          for (int64 i = 0; i < num_rows; ++i) {
+            const uint64 end =
+                core::DecodeFixed64(data.data() + i * sizeof(uint64));
+            if (end < start || end > values.size()) {
+              return errors::DataLoss("Corrupted chunk for column ",
+                                      footer_.column(column).name());
+            }
+            strings(i).assign(values.data() + start, end - start);
+            start = end;
+          }
+        } else {
+          return errors::Unimplemented("Unsupported column type: ",
+                                       DataTypeString(dtype));
+        }
+        loaded_columns_.emplace(column, std::move(t));
+        return Status::OK();
+      }
+
+      // Reads `num_rows` values of a numeric chunk, starting at row `start`,
+      // into `dst`.
+      Status ReadValuesLocked(const experimental::ColumnChunk& chunk,
+                              DataType dtype, int64 start, int64 num_rows,
+                              char* dst) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64 value_size = DataTypeSize(dtype);
+        const int64 size = num_rows * value_size;
+        if ((start + num_rows) * value_size > chunk.size_bytes()) {
+          return errors::DataLoss("Truncated chunk of type ",
+                                  DataTypeString(dtype));
+        }
+        StringPiece data;
+        TF_RETURN_IF_ERROR(
+            file_->Read(chunk.offset() + start * value_size, size, &data, dst));
+        if (data.size() != size) {
+          return errors::DataLoss("Truncated chunk of type ",
+                                  DataTypeString(dtype));
+        }
+        if (data.data() != dst) {
+          memcpy(dst, data.data(), size);
+        }
+        return Status::OK();
+      }
+
+      // Copies `n` selected rows, starting at `next_row_`, of the `i`-th
+      // requested column into `batch` at row `offset`.
+      Status CopyRows(size_t i, int64 n, int64 offset, Tensor* batch)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int column = output_column_indices_[i];
+        const DataType dtype = batch->dtype();
+        auto it = loaded_columns_.find(column);
+        if (it == loaded_columns_.end()) {
+          // The rows are contiguous; read them straight into the batch.
+          const int64 value_size = DataTypeSize(dtype);
+          char* dst = const_cast<char*>(batch->tensor_data().data()) +
+                      offset * value_size;
+          return ReadValuesLocked(
+              footer_.row_group(current_row_group_).chunk(column), dtype,
+              next_row_, n, dst);
+        }
+        const Tensor& values = it->second;
+        switch (dtype) {
+#define HANDLE_TYPE(T)                       \
+  case DataTypeToEnum<T>::value:             \
+    GatherRows<T>(values, n, offset, batch); \
+    break;
+          HANDLE_TYPE(float);
+          HANDLE_TYPE(double);
+          HANDLE_TYPE(int32);
+          HANDLE_TYPE(int64);
+          HANDLE_TYPE(string);
+#undef HANDLE_TYPE
+          default:
+            return errors::Unimplemented("Unsupported column type: ",
+                                         DataTypeString(dtype));
+        }
+        return Status::OK();
+      }
+
+      template <typename T>
+      void GatherRows(const Tensor& values, int64 n, int64 offset,
+                      Tensor* batch) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        auto src = values.flat<T>();
+        auto dst = batch->flat<T>();
+        if (selected_rows_.empty()) {
+          for (int64 j = 0; j < n; ++j) {
+            dst(offset + j) = src(next_row_ + j);
+          }
+        } else {
+          for (int64 j = 0; j < n; ++j) {
+            dst(offset + j) = src(selected_rows_[next_row_ + j]);
+          }
+        }
+      }
+
+      mutex mu_;
+      size_t current_file_index_ GUARDED_BY(mu_) = 0;
+      std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
+      experimental::ColumnarFooter footer_ GUARDED_BY(mu_);
+      // The indices in `footer_` of the requested and filtered columns.
+      std::vector<int> output_column_indices_ GUARDED_BY(mu_);
+      std::vector<int> filter_column_indices_ GUARDED_BY(mu_);
+      int64 current_row_group_ GUARDED_BY(mu_) = -1;
+      // The chunks of the current row group that have been loaded in memory,
+      // keyed by column index.
+      std::unordered_map<int, Tensor> loaded_columns_ GUARDED_BY(mu_);
+      // The rows of the current row group that satisfy the filters, if there
+      // are filters.
+      std::vector<int64> selected_rows_ GUARDED_BY(mu_);
+      int64 num_selected_rows_ GUARDED_BY(mu_) = 0;
+      // The index of the next selected row to produce.
+      int64 next_row_ GUARDED_BY(mu_) = 0;
+    };
+
+    const std::vector<string> filenames_;
+    const std::vector<string> columns_;
+    const int64 batch_size_;
+    const std::vector<ColumnFilter> filters_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ColumnarDataset").Device(DEVICE_CPU),
+                        ColumnarDatasetOp);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -192,10 +192,11 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
             cond_var_(std::make_shared<condition_variable>()),
             num_parallel_calls_(std::make_shared<model::SharedState>(
                 params.dataset->num_parallel_calls_, mu_, cond_var_)),
-            max_batch_results_(std::min(kMaxBatchResults,
-                                        (params.dataset->num_parallel_calls_ +
-                                         params.dataset->batch_size_ - 1) /
-                                            params.dataset->batch_size_)) {}
+            max_batch_results_(std::make_shared<model::SharedState>(
+                params.dataset->num_parallel_calls_ == model::kAutoTune
+                    ? model::kAutoTune
+                    : MaxBatchResults(params.dataset),
+                mu_, cond_var_)) {}
 
       ~Iterator() override {
         mutex_lock l(*mu_);
@@ -222,6 +223,16 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         if (num_parallel_calls_->value == model::kAutoTune) {
           num_parallel_calls_->value = ctx->runner_threadpool_size();
         }
+        if (max_batch_results_->value == model::kAutoTune) {
+          if (ctx->model() != nullptr) {
+            // The performance model tunes the number of batches together with
+            // the parallelism, under its RAM budget.
+            legacy_autotune_ = false;
+            max_batch_results_->value = 1;
+          } else {
+            max_batch_results_->value = MaxBatchResults(dataset());
+          }
+        }
         TF_RETURN_IF_ERROR(
             dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
         return dataset()->captured_func_->Instantiate(
@@ -253,10 +264,16 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
      protected:
       std::shared_ptr<model::Node> CreateNode(
           IteratorContext* ctx, model::Node::Args args) const override {
+        std::vector<std::shared_ptr<model::Parameter>> parameters = {
+            model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
+                                 /*max=*/ctx->runner_threadpool_size())};
+        if (max_batch_results_->tunable) {
+          parameters.push_back(model::MakeParameter(
+              model::kBufferSize, max_batch_results_, /*min=*/1,
+              /*max=*/kMaxBatchResults));
+        }
         return model::MakeAsyncKnownRatioNode(
-            std::move(args), dataset()->batch_size_,
-            {model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
-                                  /*max=*/ctx->runner_threadpool_size())});
+            std::move(args), dataset()->batch_size_, std::move(parameters));
       }
 
       Status SaveInternal(IteratorStateWriter* writer) override {
@@ -427,7 +444,7 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         // `return_values`, and invoking `done` when finished.
         instantiated_captured_func_->RunAsync(
             ctx.get(), std::move(input_element), return_values.get(),
-            std::move(done), prefix());
+            std::move(done), prefix(), model_node());
       }
 
       Status CopyPartialBatch(Tensor* output, const Tensor& value,
@@ -451,6 +468,14 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // Returns the default maximum number of batch results to store.
+      static int64 MaxBatchResults(const Dataset* dataset) {
+        const int64 batch_size = dataset->batch_size_;
+        return std::min(
+            kMaxBatchResults,
+            (dataset->num_parallel_calls_ + batch_size - 1) / batch_size);
+      }
+
       void EnsureRunnerThreadStarted(IteratorContext* ctx)
           EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
         if (!runner_thread_) {
@@ -484,6 +509,7 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
           }
         }
         result->output_allocated = true;
+        RecordBufferEnqueue(ctx.get(), result->output);
         return Status::OK();
       }
 
@@ -492,6 +518,9 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
                            std::vector<Tensor>* out_tensors,
                            bool* end_of_sequence) {
         mutex_lock l(result->mu);
+        if (result->output_allocated) {
+          RecordBufferDequeue(ctx, result->output);
+        }
         if (result->num_elements == 0) {
           if (result->status.ok() || errors::IsOutOfRange(result->status)) {
             *end_of_sequence = true;
@@ -547,21 +576,22 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
         auto busy = [this]() EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
           int64 num_parallel_calls = num_parallel_calls_->value;
           return num_calls_ >= num_parallel_calls ||
-                 (batch_results_.size() > max_batch_results_ ||
-                  (batch_results_.size() == max_batch_results_ &&
+                 (batch_results_.size() > max_batch_results_->value ||
+                  (batch_results_.size() == max_batch_results_->value &&
                    call_counter_ % dataset()->batch_size_ == 0));
         };
         while (true) {
           {
             mutex_lock l(*mu_);
             while (!cancelled_ && busy()) {
-              if (waiting_ > 0 && num_calls_ < num_parallel_calls_->value &&
-                  max_batch_results_ < kMaxBatchResults) {
+              if (legacy_autotune_ && waiting_ > 0 &&
+                  num_calls_ < num_parallel_calls_->value &&
+                  max_batch_results_->value < kMaxBatchResults) {
                 // If there is a caller waiting for a batch and the number of
                 // outstanding calls is not maxed out, it means we are out of
                 // `batch_results_` slots. Instead of waiting for a slot to open
                 // up, we create a new one to utilize CPU efficiently.
-                max_batch_results_++;
+                max_batch_results_->value++;
                 continue;
               }
               RecordStop(ctx.get());
@@ -743,8 +773,13 @@ class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
       bool cancelled_ GUARDED_BY(*mu_) = false;
       // Identifies the number of callers currently waiting for a batch result.
       int64 waiting_ GUARDED_BY(*mu_) = 0;
-      // Identifies the maximum number of batch results to store.
-      int64 max_batch_results_ GUARDED_BY(*mu_);
+      // Identifies the maximum number of batch results to store, which the
+      // performance model tunes if the parallelism is autotuned and the input
+      // pipeline is modeled.
+      const std::shared_ptr<model::SharedState> max_batch_results_;
+      // If true, the maximum number of batch results grows whenever a caller
+      // waits for a batch, rather than being tuned by the performance model.
+      bool legacy_autotune_ GUARDED_BY(*mu_) = true;
       std::unique_ptr<InstantiatedCapturedFunction> instantiated_captured_func_;
     };
 
@@ -263,18 +263,29 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
           : dataset_(dataset) {}
 
       void MapFunc(IteratorContext* ctx, const string& prefix,
+                   const std::shared_ptr<model::Node>& node,
                    std::vector<Tensor> input, std::vector<Tensor>* output,
                    StatusCallback callback) override {
-        (*ctx->runner())([this, ctx, prefix, input, output, callback]() {
+        (*ctx->runner())([this, ctx, node, input, output, callback]() {
           thread::ThreadPool* device_threadpool =
               ctx->flr()->device()->tensorflow_cpu_worker_threads()->workers;
+          // Parse the serialized examples in place when they are in a single
+          // tensor, which is the common case, instead of copying them.
           std::vector<string> slice_vec;
-          for (const Tensor& t : input) {
-            auto serialized_t = t.flat<string>();
-            gtl::ArraySlice<string> slice(serialized_t.data(),
-                                          serialized_t.size());
-            for (auto it = slice.begin(); it != slice.end(); it++)
-              slice_vec.push_back(*it);
+          gtl::ArraySlice<string> serialized;
+          if (input.size() == 1) {
+            auto serialized_t = input[0].flat<string>();
+            serialized = gtl::ArraySlice<string>(serialized_t.data(),
+                                                 serialized_t.size());
+          } else {
+            for (const Tensor& t : input) {
+              auto serialized_t = t.flat<string>();
+              gtl::ArraySlice<string> slice(serialized_t.data(),
+                                            serialized_t.size());
+              for (auto it = slice.begin(); it != slice.end(); it++)
+                slice_vec.push_back(*it);
+            }
+            serialized = slice_vec;
           }
           example::FastParseExampleConfig config = dataset_->config_;
           // local copy of config_ for modification.
@@ -283,8 +294,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
             config.collect_feature_stats = true;
           }
           example::Result example_result;
-          Status s = FastParseExample(config, slice_vec, {}, device_threadpool,
-                                      &example_result);
+          Status s = FastParseExample(config, serialized, {},
+                                      device_threadpool, &example_result);
           if (s.ok()) {
             (*output).resize(dataset_->key_to_output_index_.size());
             for (int d = 0; d < dataset_->dense_keys_.size(); ++d) {
@@ -347,7 +358,7 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                 stats_aggregator->IncrementCounter(
                     stats_utils::kFeatureValuesCount, "trainer",
                     feature_stats.feature_values_count);
-                int64 steps = ctx->model()->NumElements(prefix);
+                int64 steps = node ? node->num_elements() : 0;
                 stats_aggregator->AddToHistogram(
                     stats_utils::FeatureHistogramName(dataset_->node_name()),
                     {static_cast<double>(feature_stats.features_count)}, steps);
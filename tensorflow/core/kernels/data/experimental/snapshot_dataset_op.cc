@@ -12,12 +12,16 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
+#include <deque>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"  // NOLINT
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/compression.h"
+#include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -27,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/protobuf/data/experimental/snapshot.pb.h"
 #include "tensorflow/core/util/batch_util.h"
 
@@ -38,19 +43,42 @@ enum SnapshotMode { READER = 0, WRITER = 1, PASSTHROUGH = 2 };
 
 const uint64 kReaderBufferSize = 8 * 1024 * 1024;  // 8 MB
 
-const char* kCompressionType = io::compression::kGzip;
+// The compression used by version 0 snapshots.
+const char* kLegacyCompressionType = io::compression::kGzip;
+
+// Compresses the contents of each tensor with snappy, instead of compressing
+// whole records.
+const char kSnappy[] = "SNAPPY";
+
+// The version of the snapshot file format written by this kernel. See
+// `SnapshotMetadataRecord` for a description of the versions.
+const int64 kFileFormatVersion = 1;
 
 const uint64 kOneDayInMicroseconds = 24L * 60L * 60L * 1e6L;
 
+// The number of elements per file of version 0 snapshots.
 const uint64 kNumElementsPerShard = 10000;
 
 const char kSnapshotFilename[] = "snapshot.metadata";
+const char kSnapshotFileSuffix[] = ".snapshot";
 
 string GetCurrentSnapshotDataFilename(uint64 next_index,
                                       const string& run_dir) {
   uint64_t shard_id = next_index / kNumElementsPerShard;
   return absl::StrCat(run_dir, "/", strings::Printf("%08lu", shard_id),
-                      ".snapshot");
+                      kSnapshotFileSuffix);
+}
+
+// Returns the name of the `shard_index`-th file written by the writer thread
+// with the given index. Every writer thread produces its own sequence of
+// files, so that writers never contend on a file.
+string GetShardFilename(const string& run_dir, int64 thread_index,
+                        int64 shard_index) {
+  return absl::StrCat(
+      run_dir, "/",
+      strings::Printf("%08lld_%08lld", static_cast<long long>(thread_index),
+                      static_cast<long long>(shard_index)),
+      kSnapshotFileSuffix);
 }
 
 Status WriteMetadataFile(const string& fingerprint_dir,
@@ -110,6 +138,129 @@ SnapshotMode DetermineOpState(
   }
 }
 
+// Returns the compression applied by the record writers and readers of a
+// snapshot with the given compression.
+string RecordCompressionType(const string& compression) {
+  if (compression == kSnappy) {
+    return io::compression::kNone;
+  }
+  return compression;
+}
+
+// Encodes `element` into the two records that represent it in a version 1
+// snapshot. Tensors that can be copied with memcpy are appended to
+// `data_record` directly from their buffers, without going through a
+// `TensorProto`.
+Status EncodeElement(const std::vector<Tensor>& element,
+                     const string& compression, string* metadata_record,
+                     string* data_record) {
+  experimental::SnapshotTensorMetadata metadata;
+  data_record->clear();
+  for (const Tensor& t : element) {
+    experimental::TensorMetadata* tensor_metadata =
+        metadata.add_tensor_metadata();
+    t.shape().AsProto(tensor_metadata->mutable_tensor_shape());
+    StringPiece bytes;
+    string proto_bytes;
+    if (DataTypeCanUseMemcpy(t.dtype())) {
+      bytes = t.tensor_data();
+    } else {
+      TensorProto proto;
+      t.AsProtoTensorContent(&proto);
+      proto.AppendToString(&proto_bytes);
+      bytes = proto_bytes;
+    }
+    if (compression == kSnappy) {
+      string compressed;
+      if (!port::Snappy_Compress(bytes.data(), bytes.size(), &compressed)) {
+        return errors::Internal("Failed to compress tensor using snappy.");
+      }
+      tensor_metadata->set_tensor_size_bytes(compressed.size());
+      data_record->append(compressed);
+    } else {
+      tensor_metadata->set_tensor_size_bytes(bytes.size());
+      data_record->append(bytes.data(), bytes.size());
+    }
+  }
+  metadata_record->clear();
+  metadata.AppendToString(metadata_record);
+  return Status::OK();
+}
+
+// Decodes an element of a version 1 snapshot from its two records. The
+// contents of tensors that can be copied with memcpy are copied (or
+// decompressed) straight into the buffers of the resulting tensors.
+Status DecodeElement(const experimental::SnapshotTensorMetadata& metadata,
+                     StringPiece data_record, const string& compression,
+                     const DataTypeVector& dtypes, std::vector<Tensor>* out) {
+  if (metadata.tensor_metadata_size() != static_cast<int>(dtypes.size())) {
+    return errors::DataLoss("Expected ", dtypes.size(),
+                            " tensors in snapshot element but found ",
+                            metadata.tensor_metadata_size(), ".");
+  }
+  out->clear();
+  out->reserve(dtypes.size());
+  const bool snappy = compression == kSnappy;
+  for (int i = 0; i < metadata.tensor_metadata_size(); ++i) {
+    const experimental::TensorMetadata& tensor_metadata =
+        metadata.tensor_metadata(i);
+    const uint64 size = tensor_metadata.tensor_size_bytes();
+    if (size > data_record.size()) {
+      return errors::DataLoss("Snapshot element is truncated.");
+    }
+    StringPiece bytes(data_record.data(), size);
+    data_record.remove_prefix(size);
+
+    if (DataTypeCanUseMemcpy(dtypes[i])) {
+      TF_RETURN_IF_ERROR(
+          TensorShape::IsValidShape(tensor_metadata.tensor_shape()));
+      out->emplace_back(dtypes[i], TensorShape(tensor_metadata.tensor_shape()));
+      StringPiece buffer = out->back().tensor_data();
+      char* dst = const_cast<char*>(buffer.data());
+      if (snappy) {
+        size_t uncompressed_size;
+        if (!port::Snappy_GetUncompressedLength(bytes.data(), bytes.size(),
+                                                &uncompressed_size) ||
+            uncompressed_size != buffer.size() ||
+            !port::Snappy_Uncompress(bytes.data(), bytes.size(), dst)) {
+          return errors::DataLoss("Failed to decompress snapshot tensor.");
+        }
+      } else {
+        if (bytes.size() != buffer.size()) {
+          return errors::DataLoss("Expected ", buffer.size(),
+                                  " bytes for snapshot tensor but found ",
+                                  bytes.size(), ".");
+        }
+        std::copy(bytes.begin(), bytes.end(), dst);
+      }
+    } else {
+      string uncompressed;
+      if (snappy) {
+        size_t uncompressed_size;
+        if (!port::Snappy_GetUncompressedLength(bytes.data(), bytes.size(),
+                                                &uncompressed_size)) {
+          return errors::DataLoss("Failed to decompress snapshot tensor.");
+        }
+        uncompressed.resize(uncompressed_size);
+        if (!port::Snappy_Uncompress(bytes.data(), bytes.size(),
+                                     &uncompressed[0])) {
+          return errors::DataLoss("Failed to decompress snapshot tensor.");
+        }
+        bytes = uncompressed;
+      }
+      TensorProto proto;
+      if (!proto.ParseFromArray(bytes.data(), bytes.size())) {
+        return errors::DataLoss("Unable to parse TensorProto from snapshot.");
+      }
+      out->emplace_back();
+      if (!out->back().FromProto(proto)) {
+        return errors::DataLoss("Unable to parse Tensor from proto.");
+      }
+    }
+  }
+  return Status::OK();
+}
+
 class SnapshotDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit SnapshotDatasetOp(OpKernelConstruction* ctx)
@@ -117,6 +268,34 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         graph_def_version_(ctx->graph_def_version()) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("compression", &compression_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("shard_size_bytes", &shard_size_bytes_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("num_reader_threads", &num_reader_threads_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("reader_buffer_size", &reader_buffer_size_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("num_writer_threads", &num_writer_threads_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("writer_buffer_size", &writer_buffer_size_));
+
+    OP_REQUIRES(ctx,
+                compression_ == io::compression::kNone ||
+                    compression_ == io::compression::kGzip ||
+                    compression_ == kSnappy,
+                errors::InvalidArgument("compression must be either '', "
+                                        "'GZIP' or 'SNAPPY'."));
+    OP_REQUIRES(
+        ctx, shard_size_bytes_ > 0,
+        errors::InvalidArgument("shard_size_bytes must be greater than 0."));
+    OP_REQUIRES(
+        ctx, num_reader_threads_ > 0 && num_writer_threads_ > 0,
+        errors::InvalidArgument(
+            "num_reader_threads and num_writer_threads must be positive."));
+    OP_REQUIRES(
+        ctx, reader_buffer_size_ > 0 && writer_buffer_size_ > 0,
+        errors::InvalidArgument(
+            "reader_buffer_size and writer_buffer_size must be positive."));
   }
 
  protected:
@@ -138,18 +317,30 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
     string graph_fingerprint = strings::StrCat(
         strings::Hex(Fingerprint64(graph_def_serialized), strings::kZeroPad16));
 
-    *output = new Dataset(ctx, input, path, graph_fingerprint);
+    *output = new Dataset(ctx, input, path, graph_fingerprint, compression_,
+                          shard_size_bytes_, num_reader_threads_,
+                          reader_buffer_size_, num_writer_threads_,
+                          writer_buffer_size_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input, const string& path,
-            const string& graph_fingerprint)
+            const string& graph_fingerprint, const string& compression,
+            int64 shard_size_bytes, int64 num_reader_threads,
+            int64 reader_buffer_size, int64 num_writer_threads,
+            int64 writer_buffer_size)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           dir_(path),
-          graph_fingerprint_(graph_fingerprint) {
+          graph_fingerprint_(graph_fingerprint),
+          compression_(compression),
+          shard_size_bytes_(shard_size_bytes),
+          num_reader_threads_(num_reader_threads),
+          reader_buffer_size_(reader_buffer_size),
+          num_writer_threads_(num_writer_threads),
+          writer_buffer_size_(writer_buffer_size) {
       input_->Ref();
     }
 
@@ -181,7 +372,27 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
       Node* path = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(dir_, &path));
-      TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph_node, path}, output));
+      AttrValue compression_attr;
+      b->BuildAttrValue(compression_, &compression_attr);
+      AttrValue shard_size_bytes_attr;
+      b->BuildAttrValue<int64>(shard_size_bytes_, &shard_size_bytes_attr);
+      AttrValue num_reader_threads_attr;
+      b->BuildAttrValue<int64>(num_reader_threads_, &num_reader_threads_attr);
+      AttrValue reader_buffer_size_attr;
+      b->BuildAttrValue<int64>(reader_buffer_size_, &reader_buffer_size_attr);
+      AttrValue num_writer_threads_attr;
+      b->BuildAttrValue<int64>(num_writer_threads_, &num_writer_threads_attr);
+      AttrValue writer_buffer_size_attr;
+      b->BuildAttrValue<int64>(writer_buffer_size_, &writer_buffer_size_attr);
+      TF_RETURN_IF_ERROR(b->AddDataset(
+          this, {input_graph_node, path},
+          {std::make_pair("compression", compression_attr),
+           std::make_pair("shard_size_bytes", shard_size_bytes_attr),
+           std::make_pair("num_reader_threads", num_reader_threads_attr),
+           std::make_pair("reader_buffer_size", reader_buffer_size_attr),
+           std::make_pair("num_writer_threads", num_writer_threads_attr),
+           std::make_pair("writer_buffer_size", writer_buffer_size_attr)},
+          output));
       return Status::OK();
     }
 
@@ -241,6 +452,11 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       }
 
      private:
+      // Reads the files of a snapshot. Version 1 snapshots are read by
+      // `num_reader_threads` background threads, each of which reads a
+      // disjoint subset of the files and decodes their elements into a shared
+      // buffer. With more than one thread, the order in which elements are
+      // produced is not deterministic.
       class SnapshotReaderIterator : public DatasetIterator<Dataset> {
        public:
         explicit SnapshotReaderIterator(
@@ -250,11 +466,36 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
               fingerprint_dir_(fingerprint_dir),
               metadata_(metadata) {}
 
+        ~SnapshotReaderIterator() override {
+          {
+            mutex_lock l(mu_);
+            cancelled_ = true;
+            cond_var_.notify_all();
+          }
+          // Wait for the reader threads to exit.
+          reader_threads_.clear();
+        }
+
         Status Initialize(IteratorContext* ctx) override {
           mutex_lock l(mu_);
 
           run_id_ = metadata_.run_id();
           run_dir_ = absl::StrCat(fingerprint_dir_, "/", run_id_);
+          if (metadata_.version() == 0) {
+            return Status::OK();
+          }
+
+          for (int dtype : metadata_.dtype()) {
+            dtypes_.push_back(static_cast<DataType>(dtype));
+          }
+          if (dtypes_ != dataset()->output_dtypes()) {
+            return errors::DataLoss("Snapshot in ", run_dir_,
+                                    " does not match the dataset types.");
+          }
+          TF_RETURN_IF_ERROR(Env::Default()->GetMatchingPaths(
+              io::JoinPath(run_dir_, strings::StrCat("*", kSnapshotFileSuffix)),
+              &filenames_));
+          std::sort(filenames_.begin(), filenames_.end());
           return Status::OK();
         }
 
@@ -262,7 +503,115 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                                std::vector<Tensor>* out_tensors,
                                bool* end_of_sequence) override {
           mutex_lock l(mu_);
+          if (metadata_.version() == 0) {
+            return GetNextLegacyLocked(out_tensors, end_of_sequence);
+          }
 
+          EnsureReaderThreadsStarted(ctx);
+          while (status_.ok() && buffer_.empty() && num_active_readers_ > 0) {
+            cond_var_.wait(l);
+          }
+          TF_RETURN_IF_ERROR(status_);
+          if (buffer_.empty()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          *out_tensors = std::move(buffer_.front());
+          buffer_.pop_front();
+          cond_var_.notify_all();
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+
+       private:
+        void EnsureReaderThreadsStarted(IteratorContext* ctx)
+            EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          if (!reader_threads_.empty() || filenames_.empty()) {
+            return;
+          }
+          num_active_readers_ = dataset()->num_reader_threads_;
+          for (int64 i = 0; i < dataset()->num_reader_threads_; ++i) {
+            reader_threads_.push_back(ctx->StartThread(
+                strings::StrCat("tf_data_snapshot_reader_", i),
+                std::bind(&SnapshotReaderIterator::ReaderThread, this, i)));
+          }
+        }
+
+        void ReaderThread(int64 thread_index) {
+          Status s;
+          for (size_t i = thread_index; s.ok() && i < filenames_.size();
+               i += dataset()->num_reader_threads_) {
+            s = ReadFile(filenames_[i]);
+          }
+          mutex_lock l(mu_);
+          // If the iterator was cancelled or another reader failed, `s` only
+          // reports that this reader stopped early.
+          if (!cancelled_) {
+            status_.Update(s);
+          }
+          num_active_readers_--;
+          cond_var_.notify_all();
+        }
+
+        // Reads the elements of the given file into `buffer_`.
+        Status ReadFile(const string& filename) {
+          std::unique_ptr<RandomAccessFile> file;
+          TF_RETURN_IF_ERROR(
+              Env::Default()->NewRandomAccessFile(filename, &file));
+          auto reader_options =
+              io::RecordReaderOptions::CreateRecordReaderOptions(
+                  RecordCompressionType(metadata_.compression()));
+          reader_options.buffer_size = kReaderBufferSize;
+          io::SequentialRecordReader reader(file.get(), reader_options);
+
+          string metadata_record;
+          string data_record;
+          while (true) {
+            Status s = reader.ReadRecord(&metadata_record);
+            if (errors::IsOutOfRange(s)) {
+              return Status::OK();
+            }
+            TF_RETURN_IF_ERROR(s);
+            s = reader.ReadRecord(&data_record);
+            if (errors::IsOutOfRange(s)) {
+              return errors::DataLoss("Snapshot file ", filename,
+                                      " is truncated.");
+            }
+            TF_RETURN_IF_ERROR(s);
+
+            experimental::SnapshotTensorMetadata metadata;
+            if (!metadata.ParseFromString(metadata_record)) {
+              return errors::DataLoss("Unable to parse snapshot metadata.");
+            }
+            std::vector<Tensor> element;
+            TF_RETURN_IF_ERROR(DecodeElement(metadata, data_record,
+                                             metadata_.compression(), dtypes_,
+                                             &element));
+
+            mutex_lock l(mu_);
+            while (!cancelled_ && status_.ok() &&
+                   buffer_.size() >= MaxBufferedElements()) {
+              cond_var_.wait(l);
+            }
+            if (cancelled_ || !status_.ok()) {
+              return errors::Cancelled("Snapshot reader was cancelled.");
+            }
+            buffer_.push_back(std::move(element));
+            cond_var_.notify_all();
+          }
+        }
+
+        size_t MaxBufferedElements() const {
+          return dataset()->reader_buffer_size_ *
+                 dataset()->num_reader_threads_;
+        }
+
+        // Reads the next element of a version 0 snapshot, whose files are
+        // named sequentially and whose elements are GZIP compressed
+        // `SnapshotRecord`s.
+        Status GetNextLegacyLocked(std::vector<Tensor>* out_tensors,
+                                   bool* end_of_sequence)
+            EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           string snapshot_data_filename =
               GetCurrentSnapshotDataFilename(next_index_, run_dir_);
 
@@ -284,7 +633,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                 snapshot_data_filename, &current_read_file_));
             auto reader_options =
                 io::RecordReaderOptions::CreateRecordReaderOptions(
-                    kCompressionType);
+                    kLegacyCompressionType);
             reader_options.buffer_size = kReaderBufferSize;
 
             current_reader_ = absl::make_unique<io::SequentialRecordReader>(
@@ -318,13 +667,20 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           return Status::OK();
         }
 
-       private:
         const string fingerprint_dir_;
         const experimental::SnapshotMetadataRecord metadata_;
         string run_id_ GUARDED_BY(mu_);
         string run_dir_ GUARDED_BY(mu_);
 
-        std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+        // The files and component types of a version 1 snapshot. Both are set
+        // by `Initialize()` and read-only afterwards.
+        std::vector<string> filenames_;
+        DataTypeVector dtypes_;
+
+        std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+        Status status_ GUARDED_BY(mu_);
+        int64 num_active_readers_ GUARDED_BY(mu_) = 0;
+        bool cancelled_ GUARDED_BY(mu_) = false;
 
         string current_read_filename_ GUARDED_BY(mu_);
         std::unique_ptr<RandomAccessFile> current_read_file_ GUARDED_BY(mu_);
@@ -334,8 +690,15 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         int64 next_index_ GUARDED_BY(mu_) = 0;
 
         mutex mu_;
+        condition_variable cond_var_;
+        std::vector<std::unique_ptr<Thread>> reader_threads_;
       };
 
+      // Produces the elements of the input dataset and hands them to
+      // `num_writer_threads` background threads, each of which writes its
+      // own sequence of shard files of at most `shard_size_bytes` bytes. This
+      // keeps the encoding, compression and writing of elements off the
+      // critical path of the input pipeline.
       class SnapshotWriterIterator : public DatasetIterator<Dataset> {
        public:
         explicit SnapshotWriterIterator(const Params& params,
@@ -343,8 +706,18 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             : DatasetIterator<Dataset>(params),
               fingerprint_dir_(fingerprint_dir) {}
 
+        ~SnapshotWriterIterator() override {
+          {
+            mutex_lock l(mu_);
+            cancelled_ = true;
+            cond_var_.notify_all();
+          }
+          // Wait for the writer threads to exit.
+          writer_threads_.clear();
+        }
+
         Status Initialize(IteratorContext* ctx) override {
-          mutex_lock l(mu_);
+          mutex_lock l(input_mu_);
 
           run_id_ = strings::StrCat(
               strings::Hex(random::New64(), strings::kZeroPad4));
@@ -356,6 +729,11 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           metadata.set_creation_timestamp(Env::Default()->NowMicros());
           metadata.set_graph_fingerprint(dataset()->graph_fingerprint_);
           metadata.set_run_id(run_id_);
+          metadata.set_version(kFileFormatVersion);
+          metadata.set_compression(dataset()->compression_);
+          for (DataType dtype : dataset()->output_dtypes()) {
+            metadata.add_dtype(dtype);
+          }
           metadata.set_finalized(false);
 
           TF_RETURN_IF_ERROR(WriteMetadataFile(fingerprint_dir_, metadata));
@@ -366,24 +744,36 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
         Status GetNextInternal(IteratorContext* ctx,
                                std::vector<Tensor>* out_tensors,
                                bool* end_of_sequence) override {
-          mutex_lock l(mu_);
+          // Calls to `GetNext()` are serialized by `input_mu_`, while `mu_`
+          // is only held to access the state shared with the writer threads,
+          // so that writing does not block on producing the next element.
+          mutex_lock input_l(input_mu_);
+          {
+            mutex_lock l(mu_);
+            TF_RETURN_IF_ERROR(status_);
+            if (input_done_) {
+              *end_of_sequence = true;
+              return Status::OK();
+            }
+            EnsureWriterThreadsStarted(ctx);
+          }
 
           TF_RETURN_IF_ERROR(
               input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
 
+          mutex_lock l(mu_);
           if (*end_of_sequence) {
+            input_done_ = true;
+            cond_var_.notify_all();
+            while (num_active_writers_ > 0) {
+              cond_var_.wait(l);
+            }
+            TF_RETURN_IF_ERROR(status_);
+
             experimental::SnapshotMetadataRecord metadata;
             TF_RETURN_IF_ERROR(ReadMetadataFile(fingerprint_dir_, &metadata));
 
             if (metadata.run_id() == run_id_) {
-              if (current_writer_) TF_RETURN_IF_ERROR(current_writer_->Close());
-              if (current_write_file_)
-                TF_RETURN_IF_ERROR(current_write_file_->Close());
-              current_writer_.reset();
-              current_write_file_.reset();
-
-              current_write_filename_ = "";
-
               metadata.set_finalized(true);
               TF_RETURN_IF_ERROR(WriteMetadataFile(fingerprint_dir_, metadata));
             } else {
@@ -393,56 +783,116 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             return Status::OK();
           }
 
-          string snapshot_data_filename =
-              GetCurrentSnapshotDataFilename(next_index_, run_dir_);
+          // The buffered element shares the tensor buffers of the produced
+          // element, so handing it to the writers does not copy any data.
+          while (status_.ok() && buffer_.size() >= MaxBufferedElements()) {
+            cond_var_.wait(l);
+          }
+          TF_RETURN_IF_ERROR(status_);
+          buffer_.push_back(*out_tensors);
+          cond_var_.notify_all();
+          return Status::OK();
+        }
 
-          if (current_write_filename_ != snapshot_data_filename) {
-            if (current_writer_) TF_RETURN_IF_ERROR(current_writer_->Close());
-            if (current_write_file_)
-              TF_RETURN_IF_ERROR(current_write_file_->Close());
+       private:
+        void EnsureWriterThreadsStarted(IteratorContext* ctx)
+            EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          if (!writer_threads_.empty()) {
+            return;
+          }
+          num_active_writers_ = dataset()->num_writer_threads_;
+          for (int64 i = 0; i < dataset()->num_writer_threads_; ++i) {
+            writer_threads_.push_back(ctx->StartThread(
+                strings::StrCat("tf_data_snapshot_writer_", i),
+                std::bind(&SnapshotWriterIterator::WriterThread, this, i)));
+          }
+        }
 
-            current_writer_.reset();
-            current_write_file_.reset();
+        void WriterThread(int64 thread_index) {
+          Status s = WriteShards(thread_index);
+          mutex_lock l(mu_);
+          status_.Update(s);
+          num_active_writers_--;
+          cond_var_.notify_all();
+        }
 
-            auto writer_options =
-                io::RecordWriterOptions::CreateRecordWriterOptions(
-                    kCompressionType);
+        // Writes the elements taken from `buffer_` to the shard files of the
+        // given writer thread until the input is exhausted.
+        Status WriteShards(int64 thread_index) {
+          std::unique_ptr<WritableFile> file;
+          std::unique_ptr<io::RecordWriter> writer;
+          int64 shard_index = 0;
+          int64 shard_bytes = 0;
+          string metadata_record;
+          string data_record;
+          while (true) {
+            std::vector<Tensor> element;
+            {
+              mutex_lock l(mu_);
+              while (!cancelled_ && status_.ok() && !input_done_ &&
+                     buffer_.empty()) {
+                cond_var_.wait(l);
+              }
+              if (cancelled_ || !status_.ok() || buffer_.empty()) {
+                break;
+              }
+              element = std::move(buffer_.front());
+              buffer_.pop_front();
+              cond_var_.notify_all();
+            }
 
-            TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(
-                snapshot_data_filename, &current_write_file_));
-            current_writer_ = absl::make_unique<io::RecordWriter>(
-                current_write_file_.get(), writer_options);
-            current_write_filename_ = snapshot_data_filename;
+            TF_RETURN_IF_ERROR(EncodeElement(element, dataset()->compression_,
+                                             &metadata_record, &data_record));
+            if (writer && shard_bytes >= dataset()->shard_size_bytes_) {
+              TF_RETURN_IF_ERROR(writer->Close());
+              TF_RETURN_IF_ERROR(file->Close());
+              writer.reset();
+              file.reset();
+              shard_index++;
+            }
+            if (!writer) {
+              TF_RETURN_IF_ERROR(Env::Default()->NewWritableFile(
+                  GetShardFilename(run_dir_, thread_index, shard_index),
+                  &file));
+              writer = absl::make_unique<io::RecordWriter>(
+                  file.get(),
+                  io::RecordWriterOptions::CreateRecordWriterOptions(
+                      RecordCompressionType(dataset()->compression_)));
+              shard_bytes = 0;
+            }
+            TF_RETURN_IF_ERROR(writer->WriteRecord(metadata_record));
+            TF_RETURN_IF_ERROR(writer->WriteRecord(data_record));
+            shard_bytes += metadata_record.size() + data_record.size();
           }
-
-          experimental::SnapshotRecord record;
-
-          for (auto out_tensor : *out_tensors) {
-            TensorProto* t = record.add_tensor();
-            out_tensor.AsProtoTensorContent(t);
+          if (writer) {
+            TF_RETURN_IF_ERROR(writer->Close());
+            TF_RETURN_IF_ERROR(file->Close());
           }
-
-          TF_RETURN_IF_ERROR(
-              current_writer_->WriteRecord(record.SerializeAsString()));
-
-          next_index_++;
           return Status::OK();
         }
 
-       private:
-        std::unique_ptr<IteratorBase> input_impl_;
+        size_t MaxBufferedElements() const {
+          return dataset()->writer_buffer_size_ *
+                 dataset()->num_writer_threads_;
+        }
 
-        const string fingerprint_dir_;
-        string run_id_ GUARDED_BY(mu_);
-        string run_dir_ GUARDED_BY(mu_);
+        mutex input_mu_;
+        std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(input_mu_);
 
-        string current_write_filename_ GUARDED_BY(mu_);
-        std::unique_ptr<WritableFile> current_write_file_ GUARDED_BY(mu_);
-        std::unique_ptr<io::RecordWriter> current_writer_ GUARDED_BY(mu_);
+        const string fingerprint_dir_;
+        // Set by `Initialize()` and read-only afterwards.
+        string run_id_;
+        string run_dir_;
 
-        uint64 next_index_ GUARDED_BY(mu_) = 0;
+        std::deque<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+        Status status_ GUARDED_BY(mu_);
+        int64 num_active_writers_ GUARDED_BY(mu_) = 0;
+        bool input_done_ GUARDED_BY(mu_) = false;
+        bool cancelled_ GUARDED_BY(mu_) = false;
 
         mutex mu_;
+        condition_variable cond_var_;
+        std::vector<std::unique_ptr<Thread>> writer_threads_;
       };
 
       class SnapshotPassthroughIterator : public DatasetIterator<Dataset> {
@@ -473,11 +923,23 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
     const DatasetBase* const input_;
     const string dir_;
     const string graph_fingerprint_;
+    const string compression_;
+    const int64 shard_size_bytes_;
+    const int64 num_reader_threads_;
+    const int64 reader_buffer_size_;
+    const int64 num_writer_threads_;
+    const int64 writer_buffer_size_;
   };
 
   const int graph_def_version_;
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
+  string compression_;
+  int64 shard_size_bytes_;
+  int64 num_reader_threads_;
+  int64 reader_buffer_size_;
+  int64 num_writer_threads_;
+  int64 writer_buffer_size_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
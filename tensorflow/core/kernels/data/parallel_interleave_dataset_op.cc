@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -39,6 +40,9 @@ namespace data {
 namespace {
 
 constexpr char kDatasetName[] = "ParallelInterleaveV2";
+// The number of inputs prefetched per interleave cycle element, unless the
+// performance model tunes it.
+constexpr int64 kPrefetchedInputsPerCycleElement = 2;
 
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following op.
@@ -50,8 +54,15 @@ constexpr char kDatasetName[] = "ParallelInterleaveV2";
 // in which elements are produced).
 //
 // Furthermore, this class favors modularity over extended functionality. In
-// particular, it refrains from implementing configurable buffering of output
-// elements and prefetching of input iterators.
+// particular, it refrains from implementing configurable per-element buffering
+// of output elements and prefetching of input iterators.
+//
+// Each cycle element buffers the results of its next block. If
+// `reorder_window_size` is positive, cycle elements may additionally buffer
+// up to that many results (in total) beyond their next block, so that the
+// workers keep producing while the output waits for a slow cycle element. The
+// results are still produced in the deterministic interleave order unless
+// `sloppy` is set.
 class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit ParallelInterleaveDatasetOp(OpKernelConstruction* ctx)
@@ -61,6 +72,10 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("sloppy", &sloppy_));
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr("reorder_window_size", &reorder_window_size_));
+    OP_REQUIRES(ctx, reorder_window_size_ >= 0,
+                errors::InvalidArgument("`reorder_window_size` must be >= 0"));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -100,7 +115,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
 
     *output = new Dataset(ctx, input, std::move(captured_func), cycle_length,
                           block_length, num_parallel_calls, sloppy_,
-                          output_types_, output_shapes_);
+                          reorder_window_size_, output_types_, output_shapes_);
   }
 
  private:
@@ -109,7 +124,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     Dataset(OpKernelContext* ctx, const DatasetBase* input,
             std::unique_ptr<CapturedFunction> captured_func, int64 cycle_length,
             int64 block_length, int64 num_parallel_calls, bool sloppy,
-            const DataTypeVector& output_types,
+            int64 reorder_window_size, const DataTypeVector& output_types,
             const std::vector<PartialTensorShape>& output_shapes)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
@@ -118,6 +133,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           block_length_(block_length),
           num_parallel_calls_(num_parallel_calls),
           sloppy_(sloppy),
+          reorder_window_size_(reorder_window_size),
           output_types_(output_types),
           output_shapes_(output_shapes) {
       input_->Ref();
@@ -168,6 +184,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
       AttrValue sloppy_attr;
       b->BuildAttrValue(sloppy_, &sloppy_attr);
+      AttrValue reorder_window_size_attr;
+      b->BuildAttrValue(reorder_window_size_, &reorder_window_size_attr);
 
       TF_RETURN_IF_ERROR(
           b->AddDataset(this,
@@ -178,7 +196,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                         {{1, other_arguments}},
                         {{"f", f},
                          {"Targuments", other_arguments_types_attr},
-                         {"sloppy", sloppy_attr}},
+                         {"sloppy", sloppy_attr},
+                         {"reorder_window_size", reorder_window_size_attr}},
                         output));
       return Status::OK();
     }
@@ -192,6 +211,12 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             cond_var_(std::make_shared<condition_variable>()),
             num_parallel_calls_(std::make_shared<model::SharedState>(
                 params.dataset->num_parallel_calls_, mu_, cond_var_)),
+            num_prefetched_inputs_(std::make_shared<model::SharedState>(
+                params.dataset->num_parallel_calls_ == model::kAutoTune
+                    ? model::kAutoTune
+                    : kPrefetchedInputsPerCycleElement *
+                          params.dataset->cycle_length_,
+                mu_, cond_var_)),
             sloppy_(sloppy),
             current_elements_(params.dataset->cycle_length_),
             thread_pool_(absl::make_unique<thread::ThreadPool>(
@@ -226,6 +251,15 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         if (num_parallel_calls_->value == model::kAutoTune) {
           num_parallel_calls_->value = dataset()->cycle_length_;
         }
+        if (num_prefetched_inputs_->value == model::kAutoTune) {
+          // If the input pipeline is modeled, the performance model tunes the
+          // number of prefetched inputs together with the parallelism, under
+          // its RAM budget.
+          num_prefetched_inputs_->value =
+              ctx->model() != nullptr
+                  ? 0
+                  : kPrefetchedInputsPerCycleElement * dataset()->cycle_length_;
+        }
         TF_RETURN_IF_ERROR(
             dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_));
         return dataset()->captured_func_->Instantiate(
@@ -236,6 +270,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         std::shared_ptr<Result> result;
+        int64 num_reordered_results;
         {
           mutex_lock l(*mu_);
           EnsureThreadsStarted(ctx);
@@ -244,6 +279,19 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             cond_var_->wait(l);
             RecordStart(ctx);
           }
+          num_reordered_results = num_reordered_results_;
+        }
+        const auto& stats_aggregator = ctx->stats_aggregator();
+        if (stats_aggregator && dataset()->reorder_window_size_ > 0) {
+          stats_aggregator->AddToHistogram(
+              stats_utils::ReorderBufferUtilizationHistogramName(
+                  dataset()->node_name()),
+              {static_cast<float>(num_reordered_results) /
+               static_cast<float>(dataset()->reorder_window_size_)},
+              num_elements());
+          stats_aggregator->AddScalar(
+              stats_utils::ReorderBufferSizeScalarName(dataset()->node_name()),
+              static_cast<float>(num_reordered_results), num_elements());
         }
         if (!result) {
           *end_of_sequence = true;
@@ -260,10 +308,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
      protected:
       std::shared_ptr<model::Node> CreateNode(
           IteratorContext* ctx, model::Node::Args args) const override {
-        return model::MakeAsyncInterleaveManyNode(
-            std::move(args),
-            {model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
-                                  /*max=*/dataset()->cycle_length_)});
+        std::vector<std::shared_ptr<model::Parameter>> parameters = {
+            model::MakeParameter("parallelism", num_parallel_calls_, /*min=*/1,
+                                 /*max=*/dataset()->cycle_length_)};
+        if (num_prefetched_inputs_->tunable) {
+          parameters.push_back(model::MakeParameter(
+              model::kBufferSize, num_prefetched_inputs_, /*min=*/0,
+              /*max=*/kPrefetchedInputsPerCycleElement *
+                  dataset()->cycle_length_));
+        }
+        return model::MakeAsyncInterleaveManyNode(std::move(args),
+                                                  std::move(parameters));
       }
 
       Status SaveInternal(IteratorStateWriter* writer) override {
@@ -295,6 +350,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       Status RestoreInternal(IteratorContext* ctx,
                              IteratorStateReader* reader) override {
         mutex_lock l(*mu_);
+        num_reordered_results_ = 0;
         TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
         TF_RETURN_IF_ERROR(
             reader->ReadScalar(full_name("block_index"), &block_index_));
@@ -336,8 +392,36 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         std::deque<std::shared_ptr<Result>> results GUARDED_BY(mu);
         // Indicates whether the element is used by a worker thread.
         bool in_use = false;
+        // The number of results in `results` or being fetched into it.
+        // Guarded by the iterator's `mu_`.
+        int64 num_reserved = 0;
       };
 
+      // Returns the number of results that a worker may fetch from `element`,
+      // which is not in use: the rest of its next block, or, once the block
+      // is buffered, up to another block from the reorder window.
+      int64 NumResultsToFetch(const Element& element)
+          EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        const int64 block_length = dataset()->block_length_;
+        if (element.num_reserved < block_length) {
+          return block_length - element.num_reserved;
+        }
+        return std::min(block_length, dataset()->reorder_window_size_ -
+                                          num_reordered_results_);
+      }
+
+      // Adds `delta` to the results reserved by `element`, accounting for
+      // the results beyond its next block in the reorder window.
+      void UpdateReservedLocked(Element* element, int64 delta)
+          EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+        const int64 block_length = dataset()->block_length_;
+        num_reordered_results_ -=
+            std::max<int64>(element->num_reserved - block_length, 0);
+        element->num_reserved += delta;
+        num_reordered_results_ +=
+            std::max<int64>(element->num_reserved - block_length, 0);
+      }
+
       // Advances the position in the interleave cycle to the next cycle
       // element.
       void AdvanceToNextInCycle() EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
@@ -383,6 +467,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                 // We found a result.
                 std::swap(*result, element->results.front());
                 element->results.pop_front();
+                UpdateReservedLocked(element.get(), -1);
                 AdvancePosition();
                 cond_var_->notify_all();
                 return true;
@@ -433,7 +518,6 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         auto busy = [this]() EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
           const bool has_more_elements =
               !future_elements_.empty() || !end_of_input_;
-          const int block_length = dataset()->block_length_;
           bool all_elements_busy = true;
           for (auto& element : current_elements_) {
             if (!element) {
@@ -441,13 +525,10 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
                 all_elements_busy = false;
                 break;
               }
-            } else {
-              mutex_lock l(element->mu);
-              if (!element->in_use && element->iterator &&
-                  element->results.size() < block_length) {
-                all_elements_busy = false;
-                break;
-              }
+            } else if (!element->in_use && element->iterator &&
+                       NumResultsToFetch(*element) > 0) {
+              all_elements_busy = false;
+              break;
             }
           }
           return all_elements_busy ||
@@ -488,13 +569,9 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             }
             std::shared_ptr<Element> element = current_elements_[idx];
             if (!element->in_use && element->iterator) {
-              int64 num_results;
-              {
-                mutex_lock l(element->mu);
-                num_results =
-                    dataset()->block_length_ - element->results.size();
-              }
+              const int64 num_results = NumResultsToFetch(*element);
               if (num_results > 0) {
+                UpdateReservedLocked(element.get(), num_results);
                 current_num_calls_++;
                 element->in_use = true;
                 thread_pool_->Schedule(std::bind(
@@ -552,7 +629,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         RecordStart(ctx.get());
         auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
         bool end_of_input = false;
-        for (int64 i = 0; i < num_results; ++i) {
+        int64 num_fetched = 0;
+        for (; num_fetched < num_results; ++num_fetched) {
           auto result = std::make_shared<Result>();
           result->status = element->iterator->GetNext(
               ctx.get(), &result->return_values, &end_of_input);
@@ -568,6 +646,8 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         }
 
         mutex_lock l(*mu_);
+        // Release the results reserved but not fetched.
+        UpdateReservedLocked(element.get(), num_fetched - num_results);
         // Release the ownership of the cycle element iterator.
         element->in_use = false;
         if (end_of_input) {
@@ -588,8 +668,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
         RecordStart(ctx.get());
         auto cleanup = gtl::MakeCleanup([this, ctx] { RecordStop(ctx.get()); });
         auto busy = [this]() EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
-          // TODO(jsimsa): Autotune the number of iterators to prefetch.
-          return future_elements_.size() >= 2 * dataset()->cycle_length_;
+          return future_elements_.size() >= num_prefetched_inputs_->value;
         };
         while (true) {
           mutex_lock l(*mu_);
@@ -617,6 +696,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
               continue;
             }
             DisableAutotune(ctx.get(), element->iterator.get());
+            UpdateReservedLocked(element.get(), dataset()->block_length_);
             ++future_num_calls_;
             element->in_use = true;
             thread_pool_->Schedule(std::bind(
@@ -641,6 +721,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
           auto result = std::make_shared<Result>();
           result->is_ready = true;
           result->status = status;
+          UpdateReservedLocked(element.get(), 1);
           mutex_lock l(element->mu);
           element->results.push_back(std::move(result));
           return element;
@@ -653,6 +734,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             auto result = std::make_shared<Result>();
             result->is_ready = true;
             result->status = status;
+            UpdateReservedLocked(element.get(), 1);
             mutex_lock l(element->mu);
             element->results.push_back(std::move(result));
             return element;
@@ -794,6 +876,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
             full_name(strings::StrCat(key_prefix, "[", idx, "].results.size")),
             &results_size));
         element->results.resize(results_size);
+        UpdateReservedLocked(element.get(), results_size);
         for (size_t i = 0; i < results_size; i++) {
           auto result = std::make_shared<Result>();
           TF_RETURN_IF_ERROR(ReadStatusLocked(
@@ -886,9 +969,17 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
       // Identifies the maximum number of parallel calls.
       const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+      // Identifies the number of input elements whose iterators are created
+      // and whose first results are fetched ahead of the interleave cycle.
+      const std::shared_ptr<model::SharedState> num_prefetched_inputs_;
+
       // Determines whether outputs can be produced in non-deterministic order.
       const bool sloppy_;
 
+      // The number of results that cycle elements have buffered, or are
+      // fetching, beyond their next block. Bounded by the reorder window.
+      int64 num_reordered_results_ GUARDED_BY(*mu_) = 0;
+
       // Iterator for input elements.
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(*mu_);
 
@@ -929,6 +1020,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
     const int64 block_length_;
     const int64 num_parallel_calls_;
     const bool sloppy_;
+    const int64 reorder_window_size_;
     const DataTypeVector output_types_;
     const std::vector<PartialTensorShape> output_shapes_;
   };
@@ -937,6 +1029,7 @@ class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
   bool sloppy_;
+  int64 reorder_window_size_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("ParallelInterleaveDatasetV2").Device(DEVICE_CPU),
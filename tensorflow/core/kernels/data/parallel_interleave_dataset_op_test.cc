@@ -38,7 +38,7 @@ class ParallelInterleaveDatasetOpTest : public DatasetOpsTestBase {
       const FunctionDefHelper::AttrValueWrapper &func,
       const DataTypeVector &output_types,
       const std::vector<PartialTensorShape> &output_shapes, bool sloppy,
-      std::unique_ptr<OpKernel> *op_kernel) {
+      int64 reorder_window_size, std::unique_ptr<OpKernel> *op_kernel) {
     NodeDef node_def = test::function::NDef(
         kNodeName, kOpName,
         {"input_dataset", "cycle_length", "block_length", "num_parallel_calls"},
@@ -46,7 +46,8 @@ class ParallelInterleaveDatasetOpTest : public DatasetOpsTestBase {
          {"Targuments", {}},
          {"output_types", output_types},
          {"output_shapes", output_shapes},
-         {"sloppy", sloppy}});
+         {"sloppy", sloppy},
+         {"reorder_window_size", reorder_window_size}});
     TF_RETURN_IF_ERROR(CreateOpKernel(node_def, op_kernel));
     return Status::OK();
   }
@@ -75,6 +76,7 @@ struct TestCase {
   std::vector<PartialTensorShape> expected_output_shapes;
   int64 expected_cardinality;
   std::vector<int> breakpoints;
+  int64 reorder_window_size = 0;
 };
 
 template <typename T>
@@ -442,6 +444,51 @@ TestCase InvalidNumParallelCallsTestCase() {
           /*breakpoints*/ {}};
 }
 
+// test case 14: cycle_length = 3, block_length = 2, num_parallel_calls = 2,
+// sloppy = false, reorder_window_size = 4
+TestCase ReorderWindowTestCase1() {
+  TestCase test_case = TestCase7();
+  test_case.reorder_window_size = 4;
+  return test_case;
+}
+
+// test case 15: cycle_length = 2, block_length = 1, num_parallel_calls = 2,
+// sloppy = false, reorder_window_size = 1
+TestCase ReorderWindowTestCase2() {
+  TestCase test_case = {
+      /*input_tensors*/
+      {DatasetOpsTestBase::CreateTensor<int64>(TensorShape{2, 4, 1},
+                                               {0, 1, 2, 3, 4, 5, 6, 7})},
+      /*func*/
+      MakeTensorSliceDatasetFunc(
+          DataTypeVector({DT_INT64}),
+          std::vector<PartialTensorShape>({PartialTensorShape({1})})),
+      /*func_lib*/ {test::function::MakeTensorSliceDataset()},
+      /*cycle_length*/
+      DatasetOpsTestBase::CreateTensor<int64>(TensorShape({}), {2}),
+      /*block_length*/
+      DatasetOpsTestBase::CreateTensor<int64>(TensorShape({}), {1}),
+      /*num_parallel_calls*/
+      DatasetOpsTestBase::CreateTensor<int64>(TensorShape({}), {2}),
+      /*sloppy*/ false,
+      /*expected_outputs*/
+      ConvertToTensorVec<int64>({0, 4, 1, 5, 2, 6, 3, 7}),
+      /*expected_output_dtypes*/ {DT_INT64},
+      /*expected_output_shapes*/ {PartialTensorShape({1})},
+      /*expected_cardinality*/ tensorflow::data::kUnknownCardinality,
+      /*breakpoints*/ {0, 3, 9}};
+  test_case.reorder_window_size = 1;
+  return test_case;
+}
+
+// test case 16: cycle_length = 3, block_length = 3, num_parallel_calls = 3,
+// sloppy = true, reorder_window_size = 8
+TestCase ReorderWindowTestCase3() {
+  TestCase test_case = TestCase8();
+  test_case.reorder_window_size = 8;
+  return test_case;
+}
+
 class ParameterizedParallelInterleaveDatasetOpTest
     : public ParallelInterleaveDatasetOpTest,
       public ::testing::WithParamInterface<TestCase> {};
@@ -456,7 +503,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, GetNext) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -510,7 +557,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
     TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
         test_case.func, test_case.expected_output_dtypes,
         test_case.expected_output_shapes, test_case.sloppy,
-        &parallel_interleave_dataset_kernel));
+        test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
     Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
     std::vector<Tensor> inputs_for_tensor_slice_dataset =
@@ -536,6 +583,20 @@ TEST_F(ParallelInterleaveDatasetOpTest, InvalidArguments) {
   }
 }
 
+TEST_F(ParallelInterleaveDatasetOpTest, InvalidReorderWindowSize) {
+  int thread_num = 2, cpu_num = 2;
+  TF_ASSERT_OK(InitThreadPool(thread_num));
+  TestCase test_case = TestCase1();
+  TF_ASSERT_OK(InitFunctionLibraryRuntime(test_case.func_lib, cpu_num));
+  std::unique_ptr<OpKernel> parallel_interleave_dataset_kernel;
+  EXPECT_EQ(CreateParallelInterleaveDatasetKernel(
+                test_case.func, test_case.expected_output_dtypes,
+                test_case.expected_output_shapes, test_case.sloppy,
+                /*reorder_window_size*/ -1, &parallel_interleave_dataset_kernel)
+                .code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
 TEST_F(ParallelInterleaveDatasetOpTest, DatasetNodeName) {
   int thread_num = 2, cpu_num = 2;
   const TestCase &test_case = TestCase1();
@@ -546,7 +607,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, DatasetNodeName) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -581,7 +642,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, DatasetTypeString) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -616,7 +677,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetOutputDtypes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -652,7 +713,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetOutputShapes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -689,7 +750,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, Cardinality) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -725,7 +786,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, DatasetSave) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -766,7 +827,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, IteratorOutputDtypes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -809,7 +870,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, IteratorOutputShapes) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -852,7 +913,7 @@ TEST_F(ParallelInterleaveDatasetOpTest, IteratorOutputPrefix) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -894,7 +955,7 @@ TEST_P(ParameterizedParallelInterleaveDatasetOpTest, Roundtrip) {
   TF_ASSERT_OK(CreateParallelInterleaveDatasetKernel(
       test_case.func, test_case.expected_output_dtypes,
       test_case.expected_output_shapes, test_case.sloppy,
-      &parallel_interleave_dataset_kernel));
+      test_case.reorder_window_size, &parallel_interleave_dataset_kernel));
 
   Tensor tensor_slice_dataset_tensor(DT_VARIANT, TensorShape({}));
   std::vector<Tensor> inputs_for_tensor_slice_dataset = test_case.input_tensors;
@@ -957,7 +1018,9 @@ INSTANTIATE_TEST_SUITE_P(
     ParameterizedParallelInterleaveDatasetOpTest,
     ::testing::ValuesIn(std::vector<TestCase>(
         {TestCase1(), TestCase2(), TestCase3(), TestCase4(), TestCase5(),
-         TestCase6(), TestCase7(), TestCase8(), TestCase9(), TestCase10()})));
+         TestCase6(), TestCase7(), TestCase8(), TestCase9(), TestCase10(),
+         ReorderWindowTestCase1(), ReorderWindowTestCase2(),
+         ReorderWindowTestCase3()})));
 
 }  // namespace
 }  // namespace data
@@ -188,21 +188,24 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
       }
 
       void MapFunc(IteratorContext* ctx, const string& prefix,
+                   const std::shared_ptr<model::Node>& node,
                    std::vector<Tensor> input_element,
                    std::vector<Tensor>* result, StatusCallback done) override {
         auto map_func = [this](IteratorContext* ctx, const string& prefix,
+                               const std::shared_ptr<model::Node>& node,
                                std::vector<Tensor> input_element,
                                std::vector<Tensor>* result,
                                StatusCallback done) {
-          instantiated_captured_func_->RunAsync(
-              ctx, std::move(input_element), result, std::move(done), prefix);
+          instantiated_captured_func_->RunAsync(ctx, std::move(input_element),
+                                                result, std::move(done), prefix,
+                                                node);
         };
         if (!dataset_->captured_func_->use_inter_op_parallelism()) {
-          (*ctx->runner())(std::bind(map_func, ctx, prefix,
+          (*ctx->runner())(std::bind(map_func, ctx, prefix, node,
                                      std::move(input_element), result,
                                      std::move(done)));
         } else {
-          map_func(ctx, prefix, std::move(input_element), result,
+          map_func(ctx, prefix, node, std::move(input_element), result,
                    std::move(done));
         }
       }
@@ -34,10 +34,14 @@ class ParallelMapFunctor {
   // asynchronously. The arguments are:
   // 1. An `IteratorContext*` for the context in which the function should
   // execute.
-  // 2. A `std::vector<Tensor>` containing the input element.
-  // 3. A `std::vector<Tensor>*` to which the function will write the result.
-  // 4. A `StatusCallback` that should be invoked when the function is complete.
+  // 2. The prefix of the calling iterator.
+  // 3. The performance modeling `Node` of the calling iterator, or `nullptr`
+  // if modeling is disabled.
+  // 4. A `std::vector<Tensor>` containing the input element.
+  // 5. A `std::vector<Tensor>*` to which the function will write the result.
+  // 6. A `StatusCallback` that should be invoked when the function is complete.
   virtual void MapFunc(IteratorContext* ctx, const string& prefix,
+                       const std::shared_ptr<model::Node>& node,
                        std::vector<Tensor> input, std::vector<Tensor>* output,
                        StatusCallback callback) = 0;
 };
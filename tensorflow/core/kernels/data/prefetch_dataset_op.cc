@@ -35,6 +35,8 @@ namespace data {
 // Determines the fraction of slack time by which to delay prefetching of data.
 constexpr double kSleepFactor = 0.2;
 constexpr char kDatasetName[] = "Prefetch";
+// The largest buffer size the performance model may pick.
+constexpr int64 kMaxAutotunedBufferSize = 1024;
 
 class PrefetchDatasetOp::Dataset : public DatasetBase {
  public:
@@ -88,6 +90,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
    public:
     explicit Iterator(const Params& params)
         : DatasetIterator<Dataset>(params),
+          mu_(std::make_shared<mutex>()),
+          cond_var_(std::make_shared<condition_variable>()),
+          buffer_size_(std::make_shared<model::SharedState>(
+              params.dataset->buffer_size_, mu_, cond_var_)),
           auto_tuner_(params.dataset->buffer_size_) {
       slack_us_ = 0;
     }
@@ -102,22 +108,32 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // through the IteratorContext to upstream,
       // potentially-blocking iterators, when we add these.
       {
-        mutex_lock l(mu_);
+        mutex_lock l(*mu_);
         cancelled_ = true;
-        cond_var_.notify_all();
+        cond_var_->notify_all();
       }
     }
 
     string BuildTraceMeName() override {
       int64 buffer_limit;
       {
-        tf_shared_lock l(mu_);
-        buffer_limit = auto_tuner_.buffer_limit();
+        tf_shared_lock l(*mu_);
+        buffer_limit = BufferLimit();
       }
       return strings::StrCat(prefix(), "#buffer_limit=", buffer_limit, "#");
     }
 
     Status Initialize(IteratorContext* ctx) override {
+      {
+        mutex_lock l(*mu_);
+        if (buffer_size_->tunable && ctx->model() != nullptr) {
+          // The performance model tunes the buffer size together with the
+          // parallelism of the rest of the input pipeline, under its RAM
+          // budget. Start small and let the model grow the buffer.
+          legacy_autotune_ = false;
+          buffer_size_->value = 1;
+        }
+      }
       return dataset()->input_->MakeIterator(ctx, prefix(), &input_impl_);
     }
 
@@ -126,15 +142,17 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
                            bool* end_of_sequence) override {
       const auto& stats_aggregator = ctx->stats_aggregator();
       {
-        mutex_lock l(mu_);
+        mutex_lock l(*mu_);
         TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
         // Wait until the next element in the buffer has been
         // produced, or we are shutting down.
         while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_ &&
-               auto_tuner_.buffer_limit() != 0) {
-          auto_tuner_.RecordEmpty();
+               BufferLimit() != 0) {
+          if (legacy_autotune_) {
+            auto_tuner_.RecordEmpty();
+          }
           RecordStop(ctx);
-          cond_var_.wait(l);
+          cond_var_->wait(l);
           RecordStart(ctx);
         }
 
@@ -152,18 +170,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           return Status::OK();
         }
 
-        DCHECK_EQ(auto_tuner_.buffer_limit(), 0);
+        DCHECK_EQ(BufferLimit(), 0);
       }
 
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       if (stats_aggregator) {
         stats_aggregator->AddScalar(
             stats_utils::BufferSizeScalarName(dataset()->node_name()),
             static_cast<float>(buffer_.size()), num_elements());
         stats_aggregator->AddScalar(
             stats_utils::BufferCapacityScalarName(dataset()->node_name()),
-            static_cast<float>(auto_tuner_.buffer_limit()), num_elements());
+            static_cast<float>(BufferLimit()), num_elements());
       }
       return input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
     }
@@ -171,16 +189,21 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
    protected:
     std::shared_ptr<model::Node> CreateNode(
         IteratorContext* ctx, model::Node::Args args) const override {
+      std::vector<std::shared_ptr<model::Parameter>> parameters;
+      if (buffer_size_->tunable) {
+        parameters.push_back(model::MakeParameter(
+            model::kBufferSize, buffer_size_, /*min=*/1,
+            /*max=*/kMaxAutotunedBufferSize));
+      }
       return model::MakeAsyncKnownRatioNode(std::move(args),
-                                            /*ratio=*/1,
-                                            /*parameters=*/{});
+                                            /*ratio=*/1, std::move(parameters));
     }
 
     Status SaveInternal(IteratorStateWriter* writer) override {
       // Acquire both locks to ensure that the prefetch thread and
       // all GetNext threads are blocked.
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       TF_RETURN_IF_ERROR(SaveInput(writer, input_impl_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name("buffer_size"), buffer_.size()));
@@ -204,7 +227,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
       mutex_lock parent_l(parent_mu_);
-      mutex_lock l(mu_);
+      mutex_lock l(*mu_);
       buffer_.clear();
       TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
       size_t buffer_size;
@@ -249,20 +272,20 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     };
 
     Status Consume(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
-                   bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                   bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       const auto& stats_aggregator = ctx->stats_aggregator();
       if (stats_aggregator) {
         stats_aggregator->AddToHistogram(
             stats_utils::BufferUtilizationHistogramName(dataset()->node_name()),
             {static_cast<float>(buffer_.size()) /
-             static_cast<float>(auto_tuner_.buffer_limit())},
+             static_cast<float>(BufferLimit())},
             num_elements());
         stats_aggregator->AddScalar(
             stats_utils::BufferSizeScalarName(dataset()->node_name()),
             static_cast<float>(buffer_.size()), num_elements());
         stats_aggregator->AddScalar(
             stats_utils::BufferCapacityScalarName(dataset()->node_name()),
-            static_cast<float>(auto_tuner_.buffer_limit()), num_elements());
+            static_cast<float>(BufferLimit()), num_elements());
       }
       // A new element is available. Forward the status from computing it, and
       // (if we successfully got an element) the output values.
@@ -285,7 +308,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         *out_tensors = std::move(buffer_.front().value);
         RecordBufferDequeue(ctx, *out_tensors);
       }
-      auto_tuner_.RecordConsumption(buffer_.size());
+      if (legacy_autotune_) {
+        auto_tuner_.RecordConsumption(buffer_.size());
+      }
       buffer_.pop_front();
       *end_of_sequence = false;
 
@@ -294,12 +319,20 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       //
       // TODO(mrry): Consider using different condition variables for
       // GetNext and Prefetch.
-      cond_var_.notify_all();
+      cond_var_->notify_all();
       return s;
     }
 
+    // Returns the number of elements the prefetch thread may buffer.
+    int64 BufferLimit() const SHARED_LOCKS_REQUIRED(*mu_) {
+      if (legacy_autotune_) {
+        return auto_tuner_.buffer_limit();
+      }
+      return buffer_size_->value;
+    }
+
     Status EnsurePrefetchThreadStarted(IteratorContext* ctx)
-        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       if (!prefetch_thread_) {
         std::shared_ptr<IteratorContext> new_ctx =
             std::make_shared<IteratorContext>(*ctx);
@@ -321,10 +354,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       while (true) {
         // 1. Wait for a slot in the buffer.
         {
-          mutex_lock l(mu_);
-          while (!cancelled_ && buffer_.size() >= auto_tuner_.buffer_limit()) {
+          mutex_lock l(*mu_);
+          while (!cancelled_ && buffer_.size() >= BufferLimit()) {
             RecordStop(ctx.get());
-            cond_var_.wait(l);
+            cond_var_->wait(l);
             RecordStart(ctx.get());
           }
 
@@ -353,26 +386,26 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         buffer_element.status = input_impl_->GetNext(
             ctx.get(), &buffer_element.value, &end_of_sequence);
         if (buffer_element.status.ok() && end_of_sequence) {
-          mutex_lock l(mu_);
+          mutex_lock l(*mu_);
           prefetch_thread_finished_ = true;
-          cond_var_.notify_all();
+          cond_var_->notify_all();
           return;
         }
 
         // 3. Signal that the element has been produced.
         {
-          mutex_lock l(mu_);
+          mutex_lock l(*mu_);
           RecordBufferEnqueue(ctx.get(), buffer_element.value);
           buffer_element.created_us = ctx->env()->NowMicros();
           buffer_.push_back(std::move(buffer_element));
-          cond_var_.notify_all();
+          cond_var_->notify_all();
         }
         ++num_produced;
       }
     }
 
     Status WriteStatus(IteratorStateWriter* writer, size_t index,
-                       const Status& status) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                       const Status& status) EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       TF_RETURN_IF_ERROR(writer->WriteScalar(
           CodeKey(index), static_cast<int64>(status.code())));
       if (!status.ok()) {
@@ -383,7 +416,7 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     }
 
     Status ReadStatus(IteratorStateReader* reader, size_t index, Status* status)
-        EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
       int64 code_int;
       TF_RETURN_IF_ERROR(reader->ReadScalar(CodeKey(index), &code_int));
       error::Code code = static_cast<error::Code>(code_int);
@@ -409,18 +442,24 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
 
     // This mutex is used to ensure exclusivity between multiple threads
     // reading/writing this iterator's local state.
-    mutex mu_;
+    const std::shared_ptr<mutex> mu_;
     // This mutex is used to ensure exclusivity between multiple threads
     // accessing the parent iterator. We keep this separate from `mu_` to
     // allow prefetching to run in parallel with GetNext calls.
-    mutex parent_mu_ ACQUIRED_BEFORE(mu_);
+    mutex parent_mu_ ACQUIRED_BEFORE(*mu_);
     std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(parent_mu_);
-    condition_variable cond_var_;
-    PrefetchAutotuner auto_tuner_ GUARDED_BY(mu_);
-    std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
-    std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
-    bool cancelled_ GUARDED_BY(mu_) = false;
-    bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+    const std::shared_ptr<condition_variable> cond_var_;
+    // Identifies the buffer size, which the performance model tunes if it is
+    // `model::kAutoTune` and the input pipeline is modeled.
+    const std::shared_ptr<model::SharedState> buffer_size_;
+    PrefetchAutotuner auto_tuner_ GUARDED_BY(*mu_);
+    // If true, the buffer size is tuned by `auto_tuner_` rather than the
+    // performance model.
+    bool legacy_autotune_ GUARDED_BY(*mu_) = true;
+    std::deque<BufferElement> buffer_ GUARDED_BY(*mu_);
+    std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(*mu_);
+    bool cancelled_ GUARDED_BY(*mu_) = false;
+    bool prefetch_thread_finished_ GUARDED_BY(*mu_) = false;
 
     std::atomic<int64> slack_us_;
   };
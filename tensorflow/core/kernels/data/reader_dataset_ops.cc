@@ -17,8 +17,8 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
-#include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -30,6 +30,11 @@ namespace {
 // See documentation in ../../ops/dataset_ops.cc for a high-level
 // description of the following ops.
 
+// The number of blocks into which the FixedLengthRecord and TFRecord datasets
+// split their read buffer, so that the next blocks of a file are read
+// asynchronously while the current one is consumed.
+constexpr int kReadaheadBlocks = 4;
+
 constexpr char kTextLineDatasetName[] = "TextLine";
 
 class TextLineDatasetOp : public DatasetOpKernel {
@@ -466,8 +471,9 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
           }
           TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
               dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_ = absl::make_unique<io::InputBuffer>(
-              file_.get(), dataset()->buffer_size_);
+          input_buffer_ = absl::make_unique<io::ReadaheadInputStream>(
+              file_.get(), dataset()->buffer_size_ / kReadaheadBlocks,
+              kReadaheadBlocks);
           TF_RETURN_IF_ERROR(
               input_buffer_->SkipNBytes(dataset()->header_bytes_));
         } while (true);
@@ -509,9 +515,10 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
           file_pos_limit_ = file_size - dataset()->footer_bytes_;
           TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
               dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_ = absl::make_unique<io::InputBuffer>(
-              file_.get(), dataset()->buffer_size_);
-          TF_RETURN_IF_ERROR(input_buffer_->Seek(current_pos));
+          input_buffer_ = absl::make_unique<io::ReadaheadInputStream>(
+              file_.get(), dataset()->buffer_size_ / kReadaheadBlocks,
+              kReadaheadBlocks);
+          TF_RETURN_IF_ERROR(input_buffer_->SkipNBytes(current_pos));
         }
 
         return Status::OK();
@@ -522,7 +529,7 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
       std::unique_ptr<RandomAccessFile> file_
           GUARDED_BY(mu_);  // must outlive input_buffer_
-      std::unique_ptr<io::InputBuffer> input_buffer_ GUARDED_BY(mu_);
+      std::unique_ptr<io::ReadaheadInputStream> input_buffer_ GUARDED_BY(mu_);
       int64 file_pos_limit_ GUARDED_BY(mu_) = -1;
     };
 
@@ -592,6 +599,7 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
             // We have reached the end of the current file, so maybe
             // move on to next file.
             buffered_input_stream_.reset();
+            file_stream_.reset();
             file_.reset();
             ++current_file_index_;
           }
@@ -631,8 +639,9 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
                 dataset()->compression_type_ == "ZLIB"
                     ? io::ZlibCompressionOptions::DEFAULT()
                     : io::ZlibCompressionOptions::GZIP();
-            file_stream_ =
-                absl::make_unique<io::RandomAccessInputStream>(file_.get());
+            file_stream_ = absl::make_unique<io::ReadaheadInputStream>(
+                file_.get(), dataset()->buffer_size_ / kReadaheadBlocks,
+                kReadaheadBlocks);
             buffered_input_stream_ = absl::make_unique<io::ZlibInputStream>(
                 file_stream_.get(), dataset()->buffer_size_,
                 dataset()->buffer_size_, zlib_options);
@@ -684,6 +693,7 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
 
         // Seek to current_pos.
         buffered_input_stream_.reset();
+        file_stream_.reset();
         file_.reset();
         if (current_pos >= 0) {  // There was an active buffered_input_stream_.
           TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
@@ -692,8 +702,9 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
               dataset()->compression_type_ == "ZLIB"
                   ? io::ZlibCompressionOptions::DEFAULT()
                   : io::ZlibCompressionOptions::GZIP();
-          file_stream_ =
-              absl::make_unique<io::RandomAccessInputStream>(file_.get());
+          file_stream_ = absl::make_unique<io::ReadaheadInputStream>(
+              file_.get(), dataset()->buffer_size_ / kReadaheadBlocks,
+              kReadaheadBlocks);
           buffered_input_stream_ = absl::make_unique<io::ZlibInputStream>(
               file_stream_.get(), dataset()->buffer_size_,
               dataset()->buffer_size_, zlib_options);
@@ -712,7 +723,7 @@ class FixedLengthRecordDatasetOp : public DatasetOpKernel {
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
       std::unique_ptr<RandomAccessFile> file_
           GUARDED_BY(mu_);  // must outlive buffered_input_stream_
-      std::unique_ptr<io::RandomAccessInputStream>
+      std::unique_ptr<io::ReadaheadInputStream>
           file_stream_;  // must outlive buffered_input_stream_
       std::unique_ptr<io::InputStreamInterface> buffered_input_stream_
           GUARDED_BY(mu_);
@@ -739,7 +750,11 @@ constexpr char kTFRecordDatasetName[] = "TFRecord";
 
 class TFRecordDatasetOp : public DatasetOpKernel {
  public:
-  using DatasetOpKernel::DatasetOpKernel;
+  explicit TFRecordDatasetOp(OpKernelConstruction* ctx)
+      : DatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_mmap", &use_mmap_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("verify_checksums", &verify_checksums_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
     const Tensor* filenames_tensor;
@@ -766,23 +781,27 @@ class TFRecordDatasetOp : public DatasetOpKernel {
                 errors::InvalidArgument(
                     "`buffer_size` must be >= 0 (0 == no buffering)"));
 
-    *output =
-        new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+    *output = new Dataset(ctx, std::move(filenames), compression_type,
+                          buffer_size, use_mmap_, verify_checksums_);
   }
 
  private:
   class Dataset : public DatasetBase {
    public:
     explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                     const string& compression_type, int64 buffer_size)
+                     const string& compression_type, int64 buffer_size,
+                     bool use_mmap, bool verify_checksums)
         : DatasetBase(DatasetContext(ctx)),
           filenames_(std::move(filenames)),
           compression_type_(compression_type),
           options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {
+              compression_type)),
+          use_mmap_(use_mmap) {
       if (buffer_size > 0) {
         options_.buffer_size = buffer_size;
+        options_.readahead_blocks = kReadaheadBlocks;
       }
+      options_.verify_checksums = verify_checksums;
     }
 
     std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -814,8 +833,15 @@ class TFRecordDatasetOp : public DatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
       Node* buffer_size = nullptr;
       TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+      AttrValue use_mmap;
+      b->BuildAttrValue(use_mmap_, &use_mmap);
+      AttrValue verify_checksums;
+      b->BuildAttrValue(options_.verify_checksums, &verify_checksums);
       TF_RETURN_IF_ERROR(b->AddDataset(
-          this, {filenames, compression_type, buffer_size}, output));
+          this, {filenames, compression_type, buffer_size},
+          {std::make_pair("use_mmap", use_mmap),
+           std::make_pair("verify_checksums", verify_checksums)},
+          output));
       return Status::OK();
     }
 
@@ -831,11 +857,11 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         mutex_lock l(mu_);
         do {
           // We are currently processing a file, so try to read the next record.
-          if (reader_) {
+          if (reader_ || mmap_reader_) {
             out_tensors->emplace_back(ctx->allocator({}), DT_STRING,
                                       TensorShape({}));
             Status s =
-                reader_->ReadRecord(&out_tensors->back().scalar<string>()());
+                ReadRecordLocked(&out_tensors->back().scalar<string>()());
             if (s.ok()) {
               metrics::RecordTFDataBytesRead(
                   kTFRecordDatasetName,
@@ -883,6 +909,9 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         if (reader_) {
           TF_RETURN_IF_ERROR(
               writer->WriteScalar(full_name("offset"), reader_->TellOffset()));
+        } else if (mmap_reader_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(full_name("offset"),
+                                                 mmap_reader_->TellOffset()));
         }
         return Status::OK();
       }
@@ -899,12 +928,28 @@ class TFRecordDatasetOp : public DatasetOpKernel {
           int64 offset;
           TF_RETURN_IF_ERROR(reader->ReadScalar(full_name("offset"), &offset));
           TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-          TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+          if (mmap_reader_) {
+            TF_RETURN_IF_ERROR(mmap_reader_->SeekOffset(offset));
+          } else {
+            TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
+          }
         }
         return Status::OK();
       }
 
      private:
+      // Reads the next record of the current file into `*record`.
+      Status ReadRecordLocked(string* record) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (mmap_reader_) {
+          // The record is copied once, straight out of the mapped file.
+          StringPiece view;
+          TF_RETURN_IF_ERROR(mmap_reader_->ReadRecord(&view));
+          record->assign(view.data(), view.size());
+          return Status::OK();
+        }
+        return reader_->ReadRecord(record);
+      }
+
       // Sets up reader streams to read from the file at `current_file_index_`.
       Status SetupStreamsLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (current_file_index_ >= dataset()->filenames_.size()) {
@@ -916,6 +961,15 @@ class TFRecordDatasetOp : public DatasetOpKernel {
         // Actually move on to next file.
         const string& next_filename =
             dataset()->filenames_[current_file_index_];
+        if (dataset()->use_mmap_ && dataset()->options_.compression_type ==
+                                        io::RecordReaderOptions::NONE) {
+          Status s = io::MemoryMappedRecordReader::New(
+              env, next_filename, dataset()->options_.verify_checksums,
+              &mmap_reader_);
+          // Read the file through a buffer if its file system does not
+          // support memory mapping.
+          if (!errors::IsUnimplemented(s)) return s;
+        }
         TF_RETURN_IF_ERROR(env->NewRandomAccessFile(next_filename, &file_));
         reader_ = absl::make_unique<io::SequentialRecordReader>(
             file_.get(), dataset()->options_);
@@ -924,6 +978,7 @@ class TFRecordDatasetOp : public DatasetOpKernel {
 
       // Resets all reader streams.
       void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        mmap_reader_.reset();
         reader_.reset();
         file_.reset();
       }
@@ -935,12 +990,19 @@ class TFRecordDatasetOp : public DatasetOpKernel {
       // we must destroy `reader_` before `file_`.
       std::unique_ptr<RandomAccessFile> file_ GUARDED_BY(mu_);
       std::unique_ptr<io::SequentialRecordReader> reader_ GUARDED_BY(mu_);
+      // Reads the current file when it is memory mapped, instead of `reader_`.
+      std::unique_ptr<io::MemoryMappedRecordReader> mmap_reader_
+          GUARDED_BY(mu_);
     };
 
     const std::vector<string> filenames_;
     const string compression_type_;
     io::RecordReaderOptions options_;
+    const bool use_mmap_;
   };
+
+  bool use_mmap_;
+  bool verify_checksums_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TFRecordDataset").Device(DEVICE_CPU),
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <atomic>
 #include <deque>
 #include <vector>
 
@@ -20,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -45,11 +47,12 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
   class ShuffleDatasetBase : public DatasetBase {
    public:
     ShuffleDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                       int64 buffer_size, int64 count)
+                       int64 buffer_size, int64 count, int64 num_producers)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           buffer_size_(buffer_size),
-          count_(count) {
+          count_(count),
+          num_producers_(num_producers) {
       input_->Ref();
     }
 
@@ -74,6 +77,20 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
     }
 
    protected:
+    // Implements both a synchronous and an asynchronous shuffle.
+    //
+    // In synchronous mode (`num_producers == 0`), each call to `GetNext()`
+    // pulls elements from the input into the buffer until it is full, and
+    // then produces one of them. The produced sequence only depends on the
+    // seeds, and the iterator can be checkpointed.
+    //
+    // In asynchronous mode, the buffer is split into `num_producers` shards,
+    // each refilled by its own background thread, and `GetNext()` only waits
+    // for the input when the buffer is empty (or, for the first element, until
+    // the buffer has been filled once). This hides the latency of the input
+    // from the consumer, but the produced sequence depends on the relative
+    // progress of the producers. Saving a checkpoint pauses the producers
+    // until the input iterator and the shards have been saved.
     template <class T>
     class Iterator : public DatasetIterator<T> {
      public:
@@ -87,15 +104,33 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
             num_elements_(0),
             parent_generator_(seed, seed2),
             generator_(&parent_generator_) {
-        buffer_ = absl::make_unique<std::vector<Tensor>[]>(
-            params.dataset->buffer_size_);
+        if (params.dataset->num_producers_ == 0) {
+          buffer_ = absl::make_unique<std::vector<Tensor>[]>(
+              params.dataset->buffer_size_);
+        }
         slices_.push_back(absl::make_unique<Slice>(0, 0));
       }
 
+      ~Iterator() override {
+        // Signal the producer threads to terminate. We will then join them
+        // when we delete `producer_threads_`.
+        mutex_lock l(mu_);
+        cancelled_ = true;
+        for (auto& shard : shards_) {
+          mutex_lock shard_l(shard->mu);
+          shard->cond_var.notify_all();
+        }
+        mutex_lock async_l(async_mu_);
+        async_cond_var_.notify_all();
+      }
+
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
+        if (this->dataset()->num_producers_ > 0) {
+          return GetNextAsync(ctx, out_tensors, end_of_sequence);
+        }
         int64 start_micros = ctx->env()->NowMicros();
         int64 num_log_entries = 0;
         bool first_call = false;
@@ -193,6 +228,10 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
      protected:
       std::shared_ptr<model::Node> CreateNode(
           IteratorContext* ctx, model::Node::Args args) const override {
+        if (this->dataset()->num_producers_ > 0) {
+          return model::MakeAsyncKnownRatioNode(std::move(args),
+                                                /*ratio=*/1, {});
+        }
         return model::MakeKnownRatioNode(std::move(args),
                                          /*ratio=*/1);
       }
@@ -213,6 +252,9 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
         TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name("seed"), seed_));
         TF_RETURN_IF_ERROR(
             writer->WriteScalar(this->full_name("seed2"), seed2_));
+        if (this->dataset()->num_producers_ > 0) {
+          return SaveAsync(writer);
+        }
 
         // Save input iterator if it hasn't been exhausted else write
         // "end_of_input_sequence".
@@ -263,6 +305,9 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
         TF_RETURN_IF_ERROR(
             reader->ReadScalar(this->full_name("seed2"), &seed2_));
         ResetRngs();
+        if (this->dataset()->num_producers_ > 0) {
+          return RestoreAsync(ctx, reader);
+        }
 
         // Restore the input iterator if it wasn't already exhausted.
         if (!reader->Contains(this->full_name("end_of_input_sequence"))) {
@@ -330,6 +375,345 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
         int64 end;
       };
 
+      // A part of the buffer that is refilled by a single producer thread in
+      // asynchronous mode. The elements of the shard are stored in
+      // `slots[0, size)`; an element is removed by moving the last element of
+      // the shard into its slot, so that neither the consumer nor the
+      // producer ever shifts the elements or reallocates the storage.
+      struct Shard {
+        explicit Shard(int64 capacity)
+            : capacity(capacity),
+              slots(absl::make_unique<std::vector<Tensor>[]>(capacity)) {}
+
+        const int64 capacity;
+        mutex mu;
+        // Signalled when the consumer frees a slot of the shard.
+        condition_variable cond_var;
+        std::unique_ptr<std::vector<Tensor>[]> slots GUARDED_BY(mu);
+        int64 size GUARDED_BY(mu) = 0;
+      };
+
+      // Creates the shards of the buffer, empty.
+      void CreateShards() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64 buffer_size = this->dataset()->buffer_size_;
+        const int64 num_shards =
+            std::min(this->dataset()->num_producers_, buffer_size);
+        for (int64 i = 0; i < num_shards; ++i) {
+          shards_.push_back(
+              absl::make_unique<Shard>(buffer_size * (i + 1) / num_shards -
+                                       buffer_size * i / num_shards));
+        }
+        mutex_lock l(async_mu_);
+        num_ready_.assign(num_shards, 0);
+      }
+
+      Status EnsureProducersStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!producer_threads_.empty()) {
+          return Status::OK();
+        }
+        // Unless they were restored from a checkpoint, create the input
+        // iterator and the shards.
+        if (shards_.empty()) {
+          TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+              ctx, this->prefix(), &input_impl_));
+          CreateShards();
+        }
+        {
+          mutex_lock l(async_mu_);
+          num_active_producers_ = shards_.size();
+        }
+        std::shared_ptr<IteratorContext> new_ctx =
+            std::make_shared<IteratorContext>(*ctx);
+        // The input iterator is not replaced while the producers are running,
+        // and its `GetNext()` is thread-safe, so the producers share it
+        // without holding `mu_`.
+        IteratorBase* input = input_impl_.get();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+          Shard* shard = shards_[i].get();
+          producer_threads_.push_back(ctx->StartThread(
+              "tf_data_shuffle_producer", [this, new_ctx, input, shard, i]() {
+                ProducerThread(new_ctx, input, shard, i);
+              }));
+        }
+        return Status::OK();
+      }
+
+      // Joins the producer threads and drops the shards and the input
+      // iterator, e.g. before the state is restored from a checkpoint.
+      void StopProducers() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        cancelled_ = true;
+        for (auto& shard : shards_) {
+          mutex_lock l(shard->mu);
+          shard->cond_var.notify_all();
+        }
+        {
+          mutex_lock l(async_mu_);
+          async_cond_var_.notify_all();
+        }
+        producer_threads_.clear();
+        cancelled_ = false;
+        shards_.clear();
+        input_impl_.reset();
+        mutex_lock l(async_mu_);
+        num_ready_.clear();
+        num_buffered_ = 0;
+        num_active_producers_ = 0;
+        num_busy_producers_ = 0;
+        paused_ = false;
+        buffer_filled_ = false;
+        producer_errors_.clear();
+      }
+
+      // Refills `shard`, the `shard_index`-th shard, with elements of `input`
+      // until the input is exhausted or the iterator is destroyed.
+      //
+      // It shares ownership of the iterator context passed to it.
+      void ProducerThread(const std::shared_ptr<IteratorContext>& ctx,
+                          IteratorBase* input, Shard* shard,
+                          size_t shard_index) {
+        this->RecordStart(ctx.get());
+        auto cleanup = gtl::MakeCleanup([this, ctx] {
+          this->RecordStop(ctx.get());
+          mutex_lock l(async_mu_);
+          num_active_producers_--;
+          async_cond_var_.notify_all();
+        });
+        while (true) {
+          // 1. Wait for a free slot in the shard.
+          {
+            mutex_lock l(shard->mu);
+            while (!cancelled_ && shard->size == shard->capacity) {
+              this->RecordStop(ctx.get());
+              shard->cond_var.wait(l);
+              this->RecordStart(ctx.get());
+            }
+          }
+          if (cancelled_) {
+            return;
+          }
+
+          // 2. Wait until no checkpoint is being saved and the consumer has
+          // taken the last input error.
+          {
+            mutex_lock l(async_mu_);
+            while (!cancelled_ && (paused_ || !producer_errors_.empty())) {
+              this->RecordStop(ctx.get());
+              async_cond_var_.wait(l);
+              this->RecordStart(ctx.get());
+            }
+            if (cancelled_) {
+              return;
+            }
+            num_busy_producers_++;
+          }
+
+          // 3. Read the next element and store it.
+          std::vector<Tensor> element;
+          bool end_of_input_sequence = false;
+          Status s =
+              input->GetNext(ctx.get(), &element, &end_of_input_sequence);
+          const bool stored = s.ok() && !end_of_input_sequence;
+          if (stored) {
+            this->RecordBufferEnqueue(ctx.get(), element);
+            mutex_lock l(shard->mu);
+            shard->slots[shard->size++] = std::move(element);
+          }
+
+          // 4. Hand the element or the error over to the consumer.
+          {
+            mutex_lock l(async_mu_);
+            num_busy_producers_--;
+            if (!s.ok()) {
+              producer_errors_.push_back(s);
+            } else if (stored) {
+              num_ready_[shard_index]++;
+              num_buffered_++;
+            }
+            async_cond_var_.notify_all();
+          }
+          if (s.ok() && end_of_input_sequence) {
+            return;
+          }
+        }
+      }
+
+      Status GetNextAsync(IteratorContext* ctx,
+                          std::vector<Tensor>* out_tensors,
+                          bool* end_of_sequence) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        TF_RETURN_IF_ERROR(EnsureProducersStarted(ctx));
+        Shard* shard;
+        int64 offset;
+        {
+          mutex_lock l(async_mu_);
+          // Until the first element is produced, wait for the buffer to fill
+          // up so that the first elements are as well shuffled as the rest.
+          while (producer_errors_.empty() && num_active_producers_ > 0 &&
+                 (num_buffered_ == 0 ||
+                  (!buffer_filled_ &&
+                   num_buffered_ < this->dataset()->buffer_size_))) {
+            this->RecordStop(ctx);
+            async_cond_var_.wait(l);
+            this->RecordStart(ctx);
+          }
+          if (!producer_errors_.empty()) {
+            Status s = producer_errors_.front();
+            producer_errors_.pop_front();
+            async_cond_var_.notify_all();
+            return s;
+          }
+          buffer_filled_ = true;
+          if (num_buffered_ == 0) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+          // Choose an element uniformly at random among the buffered elements,
+          // and find its shard from the number of elements each shard holds,
+          // so that only that shard is locked.
+          offset = Random() % num_buffered_;
+          size_t i = 0;
+          while (offset >= num_ready_[i]) {
+            offset -= num_ready_[i];
+            ++i;
+          }
+          num_ready_[i]--;
+          num_buffered_--;
+          shard = shards_[i].get();
+        }
+        // Only the consumer removes elements, so the shard holds at least
+        // `offset + 1` elements.
+        mutex_lock l(shard->mu);
+        *out_tensors = std::move(shard->slots[offset]);
+        shard->size--;
+        if (offset != shard->size) {
+          shard->slots[offset] = std::move(shard->slots[shard->size]);
+        }
+        shard->cond_var.notify_one();
+        this->RecordBufferDequeue(ctx, *out_tensors);
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+      Status SaveAsync(IteratorStateWriter* writer)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        // Pause the producers, so that every element they read is either in
+        // a shard or still to be read from the input iterator.
+        {
+          mutex_lock l(async_mu_);
+          paused_ = true;
+          while (num_busy_producers_ > 0) {
+            async_cond_var_.wait(l);
+          }
+        }
+        auto resume = gtl::MakeCleanup([this] {
+          mutex_lock l(async_mu_);
+          paused_ = false;
+          async_cond_var_.notify_all();
+        });
+        if (shards_.empty()) {
+          return writer->WriteScalar(this->full_name("producers_not_started"),
+                                     "");
+        }
+        TF_RETURN_IF_ERROR(this->SaveInput(writer, input_impl_));
+        {
+          mutex_lock l(async_mu_);
+          if (buffer_filled_) {
+            TF_RETURN_IF_ERROR(
+                writer->WriteScalar(this->full_name("buffer_filled"), ""));
+          }
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              this->full_name("num_producer_errors"), producer_errors_.size()));
+          for (size_t i = 0; i < producer_errors_.size(); ++i) {
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                this->full_name(strings::StrCat("producer_error_", i, "_code")),
+                static_cast<int64>(producer_errors_[i].code())));
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                this->full_name(
+                    strings::StrCat("producer_error_", i, "_message")),
+                producer_errors_[i].error_message()));
+          }
+        }
+        for (size_t i = 0; i < shards_.size(); ++i) {
+          Shard* shard = shards_[i].get();
+          mutex_lock l(shard->mu);
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              this->full_name(strings::StrCat("shard_", i, "_size")),
+              shard->size));
+          for (int64 j = 0; j < shard->size; ++j) {
+            const std::vector<Tensor>& element = shard->slots[j];
+            TF_RETURN_IF_ERROR(writer->WriteScalar(
+                this->full_name(strings::StrCat("shard_", i, "_", j, "_size")),
+                element.size()));
+            for (size_t k = 0; k < element.size(); ++k) {
+              TF_RETURN_IF_ERROR(writer->WriteTensor(
+                  this->full_name(strings::StrCat("shard_", i, "_", j, "_", k)),
+                  element[k]));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
+      // Restores the state saved by `SaveAsync()`. The producers are started
+      // again by the next call to `GetNext()`.
+      Status RestoreAsync(IteratorContext* ctx, IteratorStateReader* reader)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        StopProducers();
+        if (reader->Contains(this->full_name("producers_not_started"))) {
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(this->dataset()->input_->MakeIterator(
+            ctx, this->prefix(), &input_impl_));
+        TF_RETURN_IF_ERROR(this->RestoreInput(ctx, reader, input_impl_));
+        CreateShards();
+        mutex_lock l(async_mu_);
+        buffer_filled_ = reader->Contains(this->full_name("buffer_filled"));
+        int64 num_producer_errors;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            this->full_name("num_producer_errors"), &num_producer_errors));
+        for (int64 i = 0; i < num_producer_errors; ++i) {
+          int64 code;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              this->full_name(strings::StrCat("producer_error_", i, "_code")),
+              &code));
+          string message;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              this->full_name(
+                  strings::StrCat("producer_error_", i, "_message")),
+              &message));
+          producer_errors_.emplace_back(static_cast<error::Code>(code),
+                                        message);
+        }
+        for (size_t i = 0; i < shards_.size(); ++i) {
+          Shard* shard = shards_[i].get();
+          mutex_lock shard_l(shard->mu);
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              this->full_name(strings::StrCat("shard_", i, "_size")),
+              &shard->size));
+          if (shard->size > shard->capacity) {
+            return errors::DataLoss("Shuffle buffer shard ", i, " holds ",
+                                    shard->size, " elements, more than its ",
+                                    "capacity of ", shard->capacity);
+          }
+          for (int64 j = 0; j < shard->size; ++j) {
+            int64 element_size;
+            TF_RETURN_IF_ERROR(reader->ReadScalar(
+                this->full_name(strings::StrCat("shard_", i, "_", j, "_size")),
+                &element_size));
+            std::vector<Tensor>& element = shard->slots[j];
+            element.resize(element_size);
+            for (int64 k = 0; k < element_size; ++k) {
+              TF_RETURN_IF_ERROR(reader->ReadTensor(
+                  this->full_name(strings::StrCat("shard_", i, "_", j, "_", k)),
+                  &element[k]));
+            }
+          }
+          num_ready_[i] = shard->size;
+          num_buffered_ += shard->size;
+        }
+        return Status::OK();
+      }
+
       random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
           EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         num_random_samples_++;
@@ -346,11 +730,36 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
       random::SingleSampleAdapter<random::PhiloxRandom> generator_
           GUARDED_BY(mu_);
       int64 num_random_samples_ GUARDED_BY(mu_) = 0;
+
+      // State of the asynchronous mode.
+      std::vector<std::unique_ptr<Shard>> shards_ GUARDED_BY(mu_);
+      std::atomic<bool> cancelled_{false};
+      mutex async_mu_;
+      condition_variable async_cond_var_;
+      // The number of elements in each shard that the consumer may take, and
+      // their sum.
+      std::vector<int64> num_ready_ GUARDED_BY(async_mu_);
+      int64 num_buffered_ GUARDED_BY(async_mu_) = 0;
+      int64 num_active_producers_ GUARDED_BY(async_mu_) = 0;
+      // The number of producers that are reading or storing an element.
+      int64 num_busy_producers_ GUARDED_BY(async_mu_) = 0;
+      // Whether the producers must not start reading another element, while
+      // a checkpoint is saved.
+      bool paused_ GUARDED_BY(async_mu_) = false;
+      bool buffer_filled_ GUARDED_BY(async_mu_) = false;
+      // Input errors that have not been returned to the consumer yet.
+      std::deque<Status> producer_errors_ GUARDED_BY(async_mu_);
+      // Must be declared last so that the producers are joined before the
+      // state they access is destroyed.
+      std::vector<std::unique_ptr<Thread>> producer_threads_ GUARDED_BY(mu_);
     };
 
     const DatasetBase* const input_;
     const int64 buffer_size_;
     const int64 count_;
+    // If positive, the number of threads that refill the buffer
+    // asynchronously.
+    const int64 num_producers_;
   };
 };
 
@@ -360,6 +769,10 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
       : ShuffleDatasetOpBase(ctx) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("reshuffle_each_iteration",
                                      &reshuffle_each_iteration_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_producers", &num_producers_));
+    OP_REQUIRES(
+        ctx, num_producers_ >= 0,
+        errors::InvalidArgument("num_producers must be non-negative."));
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -386,11 +799,11 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
 
     int64 count = 1;
     if (reshuffle_each_iteration_) {
-      *output =
-          new ReshufflingDataset(ctx, input, buffer_size, seed, seed2, count);
+      *output = new ReshufflingDataset(ctx, input, buffer_size, seed, seed2,
+                                       count, num_producers_);
     } else {
-      *output =
-          new FixedSeedDataset(ctx, input, buffer_size, seed, seed2, count);
+      *output = new FixedSeedDataset(ctx, input, buffer_size, seed, seed2,
+                                     count, num_producers_);
     }
   }
 
@@ -400,8 +813,9 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   class ReshufflingDataset : public ShuffleDatasetBase {
    public:
     ReshufflingDataset(OpKernelContext* ctx, const DatasetBase* input,
-                       int64 buffer_size, int64 seed, int64 seed2, int64 count)
-        : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                       int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                       int64 num_producers)
+        : ShuffleDatasetBase(ctx, input, buffer_size, count, num_producers),
           seed_(seed),
           seed2_(seed2) {}
 
@@ -513,12 +927,6 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
       }
 
      protected:
-      std::shared_ptr<model::Node> CreateNode(
-          IteratorContext* ctx, model::Node::Args args) const override {
-        return model::MakeKnownRatioNode(std::move(args),
-                                         /*ratio=*/1);
-      }
-
       Status SaveInternal(IteratorStateWriter* writer) override {
         // Save RNG state of Dataset.
         TF_RETURN_IF_ERROR(
@@ -557,15 +965,17 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
       Node* seed = nullptr;
       Node* seed2 = nullptr;
       AttrValue reshuffle_each_iteration;
+      AttrValue num_producers;
 
       TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
       TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
       TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
       b->BuildAttrValue(true, &reshuffle_each_iteration);
+      b->BuildAttrValue(num_producers_, &num_producers);
       TF_RETURN_IF_ERROR(b->AddDataset(
           this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-          {std::make_pair("reshuffle_each_iteration",
-                          reshuffle_each_iteration)},  // Attrs
+          {std::make_pair("reshuffle_each_iteration", reshuffle_each_iteration),
+           std::make_pair("num_producers", num_producers)},  // Attrs
           output));
       return Status::OK();
     }
@@ -580,8 +990,9 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   class FixedSeedDataset : public ShuffleDatasetBase {
    public:
     FixedSeedDataset(OpKernelContext* ctx, const DatasetBase* input,
-                     int64 buffer_size, int64 seed, int64 seed2, int64 count)
-        : ShuffleDatasetBase(ctx, input, buffer_size, count),
+                     int64 buffer_size, int64 seed, int64 seed2, int64 count,
+                     int64 num_producers)
+        : ShuffleDatasetBase(ctx, input, buffer_size, count, num_producers),
           seed_(seed),
           seed2_(seed2) {}
 
@@ -609,15 +1020,17 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
       Node* seed = nullptr;
       Node* seed2 = nullptr;
       AttrValue reshuffle_each_iteration;
+      AttrValue num_producers;
 
       TF_RETURN_IF_ERROR(b->AddScalar(buffer_size_, &buffer_size));
       TF_RETURN_IF_ERROR(b->AddScalar(seed_, &seed));
       TF_RETURN_IF_ERROR(b->AddScalar(seed2_, &seed2));
       b->BuildAttrValue(false, &reshuffle_each_iteration);
+      b->BuildAttrValue(num_producers_, &num_producers);
       TF_RETURN_IF_ERROR(b->AddDataset(
           this, {input_graph_node, buffer_size, seed, seed2},  // Inputs
-          {std::make_pair("reshuffle_each_iteration",
-                          reshuffle_each_iteration)},  // Attrs
+          {std::make_pair("reshuffle_each_iteration", reshuffle_each_iteration),
+           std::make_pair("num_producers", num_producers)},  // Attrs
           output));
       return Status::OK();
     }
@@ -628,6 +1041,7 @@ class ShuffleDatasetOp : public ShuffleDatasetOpBase {
   };
 
   bool reshuffle_each_iteration_;
+  int64 num_producers_;
 };
 
 class ShuffleAndRepeatDatasetOp : public ShuffleDatasetOpBase {
@@ -672,7 +1086,8 @@ class ShuffleAndRepeatDatasetOp : public ShuffleDatasetOpBase {
    public:
     Dataset(OpKernelContext* ctx, const DatasetBase* input, int64 buffer_size,
             int64 seed, int64 seed2, int64 count)
-        : ShuffleDatasetBase(ctx, input, buffer_size, count),
+        : ShuffleDatasetBase(ctx, input, buffer_size, count,
+                             /*num_producers=*/0),
           seed_(seed),
           seed2_(seed2) {}
 
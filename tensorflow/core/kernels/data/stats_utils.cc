@@ -27,6 +27,9 @@ ABSL_CONST_INIT const char kThreadUtilization[] = "thread_utilization";
 ABSL_CONST_INIT const char kBufferSize[] = "buffer_size";
 ABSL_CONST_INIT const char kBufferCapacity[] = "buffer_capacity";
 ABSL_CONST_INIT const char kBufferUtilization[] = "buffer_utilization";
+ABSL_CONST_INIT const char kReorderBufferSize[] = "reorder_buffer_size";
+ABSL_CONST_INIT const char kReorderBufferUtilization[] =
+    "reorder_buffer_utilization";
 ABSL_CONST_INIT const char kFilteredElements[] = "filtered_elements";
 ABSL_CONST_INIT const char kDroppedElements[] = "dropped_elements";
 ABSL_CONST_INIT const char kFeaturesCount[] = "features_count";
@@ -53,6 +56,14 @@ string BufferUtilizationHistogramName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kBufferUtilization);
 }
 
+string ReorderBufferSizeScalarName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kReorderBufferSize);
+}
+
+string ReorderBufferUtilizationHistogramName(const string& prefix) {
+  return strings::StrCat(prefix, kDelimiter, kReorderBufferUtilization);
+}
+
 string FilterdElementsScalarName(const string& prefix) {
   return strings::StrCat(prefix, kDelimiter, kFilteredElements);
 }
@@ -49,6 +49,14 @@ string BufferCapacityScalarName(const string& prefix);
 // buffer size.) histogram metrics.
 string BufferUtilizationHistogramName(const string& prefix);
 
+// Name for reorder buffer size (number of results buffered out of order)
+// scalar metrics.
+string ReorderBufferSizeScalarName(const string& prefix);
+
+// Name for reorder buffer utilization (ratio of reorder buffer size and
+// reorder window size) histogram metrics.
+string ReorderBufferUtilizationHistogramName(const string& prefix);
+
 // Name for filtered elements scalar metrics.
 string FilterdElementsScalarName(const string& prefix);
 
@@ -39,6 +39,17 @@ static void GetRendezvousKey(const string& key_prefix,
                      frame_iter.iter_id);
 }
 
+static void GetRendezvousSlot(OpKernelConstruction* ctx,
+                              Rendezvous::SlotId* slot) {
+  int64 scope;
+  int64 index;
+  if (ctx->GetAttr("_rendezvous_slot_scope", &scope).ok() &&
+      ctx->GetAttr("_rendezvous_slot", &index).ok()) {
+    slot->scope = static_cast<uint64>(scope);
+    slot->index = index;
+  }
+}
+
 static FrameAndIter GetFrameAndIter(OpKernelContext* ctx,
                                     bool hostmem_sendrecv) {
   if (hostmem_sendrecv && ctx->call_frame() != nullptr) {
@@ -72,6 +83,7 @@ SendOp::SendOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
   if (!ctx->GetAttr("_hostmem_sendrecv", &hostmem_sendrecv_).ok()) {
     hostmem_sendrecv_ = false;
   }
+  GetRendezvousSlot(ctx, &slot_);
 }
 
 void SendOp::Compute(OpKernelContext* ctx) {
@@ -88,7 +100,14 @@ void SendOp::Compute(OpKernelContext* ctx) {
   args.alloc_attrs = ctx->input_alloc_attr(0);
 
   FrameAndIter frame_iter = GetFrameAndIter(ctx, hostmem_sendrecv_);
-  if (frame_iter == FrameAndIter(0, 0)) {
+  if (frame_iter == FrameAndIter(0, 0) && slot_.index >= 0) {
+    // Send/Recv pairs run at most once per step outside of loops, so the
+    // slot identifies the tensor.
+    VLOG(2) << "Send " << parsed_key_.buf_ << " to slot " << slot_.index;
+    ctx->SetStatus(ctx->rendezvous()->SendToSlot(
+        slot_, parsed_key_, args, ctx->input(0), ctx->is_input_dead()));
+    return;
+  } else if (frame_iter == FrameAndIter(0, 0)) {
     // Use the cached rendezvous key.
     VLOG(2) << "Send " << parsed_key_.buf_;
     ctx->SetStatus(ctx->rendezvous()->Send(parsed_key_, args, ctx->input(0),
@@ -139,6 +158,7 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
   if (!ctx->GetAttr("_hostmem_sendrecv", &hostmem_sendrecv_).ok()) {
     hostmem_sendrecv_ = false;
   }
+  GetRendezvousSlot(ctx, &slot_);
 }
 
 namespace {
@@ -177,7 +197,11 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   args.alloc_attrs = ctx->output_alloc_attr(0);
 
   FrameAndIter frame_iter = GetFrameAndIter(ctx, hostmem_sendrecv_);
-  if (frame_iter == FrameAndIter(0, 0)) {
+  if (frame_iter == FrameAndIter(0, 0) && slot_.index >= 0) {
+    VLOG(2) << "Recv " << parsed_key_.buf_ << " from slot " << slot_.index;
+    ctx->rendezvous()->RecvFromSlotAsync(
+        slot_, parsed_key_, args, make_recv_callback(ctx, std::move(done)));
+  } else if (frame_iter == FrameAndIter(0, 0)) {
     VLOG(2) << "Recv " << parsed_key_.buf_;
     ctx->rendezvous()->RecvAsync(parsed_key_, args,
                                  make_recv_callback(ctx, std::move(done)));
@@ -30,6 +30,8 @@ class SendOp : public OpKernel {
   string key_prefix_;
   Rendezvous::ParsedKey parsed_key_;
   bool hostmem_sendrecv_;
+  // Set for pairs assigned a slot by graph partitioning.
+  Rendezvous::SlotId slot_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(SendOp);
 };
@@ -43,6 +45,8 @@ class RecvOp : public AsyncOpKernel {
   string key_prefix_;
   Rendezvous::ParsedKey parsed_key_;
   bool hostmem_sendrecv_;
+  // Set for pairs assigned a slot by graph partitioning.
+  Rendezvous::SlotId slot_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
 };
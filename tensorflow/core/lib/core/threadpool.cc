@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 
+#include <algorithm>
+#include <atomic>
+
 #define EIGEN_USE_THREADS
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -30,6 +34,15 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+namespace {
+
+// The index, among the CPUs the process may run on, of the CPU the next
+// pinned thread is pinned to.  Shared by all pools, so that the threads of
+// different pools are pinned to different CPUs while there are enough.
+std::atomic<int> next_pinned_cpu_index(0);
+
+}  // namespace
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
@@ -44,12 +57,20 @@ struct EigenEnvironment {
   Env* const env_;
   const ThreadOptions thread_options_;
   const string name_;
+  const bool pin_threads_to_cores_;
 
   EigenEnvironment(Env* env, const ThreadOptions& thread_options,
-                   const string& name)
-      : env_(env), thread_options_(thread_options), name_(name) {}
+                   const string& name, bool pin_threads_to_cores)
+      : env_(env),
+        thread_options_(thread_options),
+        name_(name),
+        pin_threads_to_cores_(pin_threads_to_cores) {}
 
   EnvThread* CreateThread(std::function<void()> f) {
+    const int cpu_index =
+        pin_threads_to_cores_
+            ? next_pinned_cpu_index.fetch_add(1, std::memory_order_relaxed)
+            : -1;
     return env_->StartThread(thread_options_, name_, [=]() {
       // Set the processor flag to flush denormals to zero.
       port::ScopedFlushDenormal flush;
@@ -58,6 +79,11 @@ struct EigenEnvironment {
       if (thread_options_.numa_node != port::kNUMANoAffinity) {
         port::NUMASetThreadNodeAffinity(thread_options_.numa_node);
       }
+      if (pin_threads_to_cores_ &&
+          !port::PinCurrentThreadToSchedulableCPU(cpu_index)) {
+        VLOG(1) << "Could not pin a thread of " << name_ << " to CPU index "
+                << cpu_index;
+      }
       f();
     });
   }
@@ -87,10 +113,12 @@ struct EigenEnvironment {
 
 struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
   Impl(Env* env, const ThreadOptions& thread_options, const string& name,
-       int num_threads, bool low_latency_hint, Eigen::Allocator* allocator)
+       int num_threads, const SchedulingPolicy& policy,
+       Eigen::Allocator* allocator)
       : Eigen::ThreadPoolTempl<EigenEnvironment>(
-            num_threads, low_latency_hint,
-            EigenEnvironment(env, thread_options, name)),
+            num_threads, policy.spin_before_park,
+            EigenEnvironment(env, thread_options, name,
+                             policy.pin_threads_to_cores)),
         allocator_(allocator) {}
 
   void ParallelFor(int64 total, int64 cost_per_unit,
@@ -106,6 +134,16 @@ struct ThreadPool::Impl : Eigen::ThreadPoolTempl<EigenEnvironment> {
   Eigen::Allocator* allocator_;
 };
 
+namespace {
+
+SchedulingPolicy PolicyFromLatencyHint(bool low_latency_hint) {
+  SchedulingPolicy policy;
+  policy.spin_before_park = low_latency_hint;
+  return policy;
+}
+
+}  // namespace
+
 ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
     : ThreadPool(env, ThreadOptions(), name, num_threads, true, nullptr) {}
 
@@ -115,19 +153,63 @@ ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
 
 ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
                        const string& name, int num_threads,
-                       bool low_latency_hint, Eigen::Allocator* allocator) {
+                       bool low_latency_hint, Eigen::Allocator* allocator)
+    : ThreadPool(env, thread_options, name, num_threads,
+                 PolicyFromLatencyHint(low_latency_hint), allocator) {}
+
+ThreadPool::ThreadPool(Env* env, const ThreadOptions& thread_options,
+                       const string& name, int num_threads,
+                       const SchedulingPolicy& policy,
+                       Eigen::Allocator* allocator)
+    : policy_(policy) {
   CHECK_GE(num_threads, 1);
+  policy_.wake_batch_size = std::max(policy_.wake_batch_size, 1);
   impl_.reset(new ThreadPool::Impl(env, thread_options, "tf_" + name,
-                                   num_threads, low_latency_hint, allocator));
+                                   num_threads, policy_, allocator));
+}
+
+ThreadPool::ThreadPool(Eigen::ThreadPoolInterface* user_threadpool,
+                       int max_parallelism)
+    : underlying_threadpool_(user_threadpool) {
+  CHECK(user_threadpool != nullptr);
+  CHECK_GT(max_parallelism, 0);
+  underlying_threadpool_device_.reset(
+      new Eigen::ThreadPoolDevice(user_threadpool, max_parallelism));
 }
 
 ThreadPool::~ThreadPool() {}
 
 void ThreadPool::Schedule(std::function<void()> fn) {
   CHECK(fn != nullptr);
+  if (underlying_threadpool_ != nullptr) {
+    underlying_threadpool_->Schedule(std::move(fn));
+    return;
+  }
   impl_->Schedule(std::move(fn));
 }
 
+void ThreadPool::ScheduleBatch(std::vector<std::function<void()>> fns) {
+  const int64 num_fns = fns.size();
+  const int64 batch_size = policy_.wake_batch_size;
+  if (num_fns <= 1 || batch_size <= 1) {
+    for (auto& fn : fns) Schedule(std::move(fn));
+    return;
+  }
+  // Every thread woken up runs its own "batch_size" closures of the batch,
+  // one after another.
+  std::shared_ptr<std::vector<std::function<void()>>> batch(
+      new std::vector<std::function<void()>>(std::move(fns)));
+  for (int64 start = 0; start < num_fns; start += batch_size) {
+    const int64 limit = std::min(start + batch_size, num_fns);
+    Schedule([batch, start, limit]() {
+      for (int64 i = start; i < limit; ++i) {
+        (*batch)[i]();
+        (*batch)[i] = nullptr;
+      }
+    });
+  }
+}
+
 int ThreadPool::NumShardsUsedByTransformRangeConcurrently(
     const int64 block_size, const int64 total) {
   if (block_size <= 0 || total <= 1 || total <= block_size ||
@@ -178,38 +260,60 @@ void ThreadPool::TransformRangeConcurrently(
 
 void ThreadPool::ParallelFor(int64 total, int64 cost_per_unit,
                              std::function<void(int64, int64)> fn) {
+  if (underlying_threadpool_ != nullptr) {
+    CHECK_GE(total, 0);
+    underlying_threadpool_device_->parallelFor(
+        total, Eigen::TensorOpCost(0, 0, cost_per_unit),
+        [&fn](Eigen::Index first, Eigen::Index last) { fn(first, last); });
+    return;
+  }
   impl_->ParallelFor(total, cost_per_unit, std::move(fn));
 }
 
 void ThreadPool::ParallelForWithWorkerId(
     int64 total, int64 cost_per_unit,
     const std::function<void(int64, int64, int)>& fn) {
-  impl_->ParallelFor(total, cost_per_unit,
-                     [this, &fn](int64 start, int64 limit) {
-                       // ParallelFor may use the current thread to do some
-                       // work synchronously. When calling CurrentThreadId()
-                       // from outside of the thread pool, we get -1, so we can
-                       // shift every id up by 1.
-                       int id = CurrentThreadId() + 1;
-                       fn(start, limit, id);
-                     });
+  ParallelFor(total, cost_per_unit, [this, &fn](int64 start, int64 limit) {
+    // ParallelFor may use the current thread to do some work synchronously.
+    // When calling CurrentThreadId() from outside of the thread pool, we get
+    // -1, so we can shift every id up by 1.
+    int id = CurrentThreadId() + 1;
+    fn(start, limit, id);
+  });
 }
 
-int ThreadPool::NumThreads() const { return impl_->NumThreads(); }
+int ThreadPool::NumThreads() const {
+  if (underlying_threadpool_ != nullptr) {
+    return underlying_threadpool_->NumThreads();
+  }
+  return impl_->NumThreads();
+}
 
-int ThreadPool::CurrentThreadId() const { return impl_->CurrentThreadId(); }
+int ThreadPool::CurrentThreadId() const {
+  if (underlying_threadpool_ != nullptr) {
+    return underlying_threadpool_->CurrentThreadId();
+  }
+  return impl_->CurrentThreadId();
+}
 
 void ThreadPool::ScheduleWithHint(std::function<void()> fn, int start,
                                   int limit) {
+  if (underlying_threadpool_ != nullptr) {
+    underlying_threadpool_->ScheduleWithHint(std::move(fn), start, limit);
+    return;
+  }
   impl_->ScheduleWithHint(std::move(fn), start, limit);
 }
 
 void ThreadPool::SetStealPartitions(
     const std::vector<std::pair<unsigned, unsigned>>& partitions) {
+  // The steal partitions of a user thread pool are up to its owner.
+  if (underlying_threadpool_ != nullptr) return;
   impl_->SetStealPartitions(partitions);
 }
 
 Eigen::ThreadPoolInterface* ThreadPool::AsEigenThreadPool() {
+  if (underlying_threadpool_ != nullptr) return underlying_threadpool_;
   DCHECK(impl_ != nullptr);
   return impl_.get();
 }
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
@@ -26,10 +27,30 @@ limitations under the License.
 namespace Eigen {
 class Allocator;
 class ThreadPoolInterface;
+struct ThreadPoolDevice;
 }  // namespace Eigen
 namespace tensorflow {
 namespace thread {
 
+// Controls how the threads of a ThreadPool wait for work and are woken up.
+struct SchedulingPolicy {
+  // If true, an idle thread spins for a while looking for work before it
+  // parks, trading CPU time for a lower schedule-to-run latency.  How long it
+  // spins is up to the underlying implementation.
+  bool spin_before_park = true;
+
+  // ScheduleBatch() wakes up one thread per "wake_batch_size" closures, and
+  // each thread it wakes up runs "wake_batch_size" closures of the batch.
+  // With 1, every closure wakes up a thread of its own.
+  int wake_batch_size = 1;
+
+  // If true, every thread of the pool is pinned to one of the CPUs the
+  // process may run on.  The threads of all pinned pools of the process take
+  // the CPUs in turn, so that different pools use different CPUs while there
+  // are enough of them.  Ignored where pinning is not supported.
+  bool pin_threads_to_cores = false;
+};
+
 class ThreadPool {
  public:
   // Constructs a pool that contains "num_threads" threads with specified
@@ -45,6 +66,14 @@ class ThreadPool {
              int num_threads, bool low_latency_hint,
              Eigen::Allocator* allocator = nullptr);
 
+  // Like above, but with the given scheduling "policy" instead of a latency
+  // hint.  "low_latency_hint" corresponds to policy.spin_before_park.
+  //
+  // REQUIRES: num_threads > 0
+  ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
+             int num_threads, const SchedulingPolicy& policy,
+             Eigen::Allocator* allocator = nullptr);
+
   // Constructs a pool for low-latency ops that contains "num_threads" threads
   // with specified "name". env->StartThread() is used to create individual
   // threads.
@@ -58,6 +87,12 @@ class ThreadPool {
   ThreadPool(Env* env, const ThreadOptions& thread_options, const string& name,
              int num_threads);
 
+  // Constructs a pool that schedules work on "user_threadpool", which it does
+  // not own and which must outlive it.  This lets a pool share the threads
+  // of another, e.g. with a different scheduling policy.  ParallelFor() splits
+  // work for at most "max_parallelism" threads at once.
+  ThreadPool(Eigen::ThreadPoolInterface* user_threadpool, int max_parallelism);
+
   // Waits until all scheduled work has finished and then destroy the
   // set of threads.
   ~ThreadPool();
@@ -65,6 +100,11 @@ class ThreadPool {
   // Schedules fn() for execution in the pool of threads.
   void Schedule(std::function<void()> fn);
 
+  // Schedules every closure in "fns" for execution in the pool of threads,
+  // waking up threads as the scheduling policy says.  Up to wake_batch_size
+  // closures of the batch run one after another on the same thread.
+  void ScheduleBatch(std::vector<std::function<void()>> fns);
+
   void SetStealPartitions(
       const std::vector<std::pair<unsigned, unsigned>>& partitions);
 
@@ -127,10 +167,20 @@ class ThreadPool {
   // pointer points to, and should not attempt to delete.
   Eigen::ThreadPoolInterface* AsEigenThreadPool();
 
+  // Returns the scheduling policy the pool was constructed with.  A pool
+  // sharing the threads of a user thread pool has the default policy.
+  const SchedulingPolicy& scheduling_policy() const { return policy_; }
+
   struct Impl;
 
  private:
+  SchedulingPolicy policy_;
+
+  // Exactly one of the two is non-null.
   std::unique_ptr<Impl> impl_;
+  Eigen::ThreadPoolInterface* underlying_threadpool_ = nullptr;  // Not owned.
+  // Used by ParallelFor() on underlying_threadpool_.
+  std::unique_ptr<Eigen::ThreadPoolDevice> underlying_threadpool_device_;
   TF_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
 
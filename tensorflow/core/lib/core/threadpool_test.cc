@@ -16,8 +16,12 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 #include <atomic>
+#include <set>
 
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -190,6 +194,170 @@ TEST(ThreadPool, ParallelForWithWorkerId) {
   }
 }
 
+TEST(ThreadPool, UserThreadPool) {
+  ThreadPool underlying(Env::Default(), "test", kNumThreads);
+  ThreadPool pool(underlying.AsEigenThreadPool(), 2);
+  EXPECT_EQ(kNumThreads, pool.NumThreads());
+  EXPECT_EQ(-1, pool.CurrentThreadId());
+  const int kWorkItems = 15;
+  std::atomic<bool> work[kWorkItems];
+  for (int i = 0; i < kWorkItems; i++) {
+    work[i] = false;
+  }
+  std::atomic<int> num_shards(0);
+  pool.ParallelFor(kWorkItems, 1 << 30,
+                   [&work, &num_shards](int64 begin, int64 end) {
+                     ++num_shards;
+                     for (int64 i = begin; i < end; ++i) {
+                       ASSERT_FALSE(work[i].exchange(true));
+                     }
+                   });
+  for (int i = 0; i < kWorkItems; i++) {
+    ASSERT_TRUE(work[i]);
+  }
+  // The work is split for 2 threads, with Eigen's oversharding of up to 4
+  // shards per thread, rather than for all threads of the underlying pool.
+  EXPECT_LE(num_shards, 4 * 2);
+  mutex mu;
+  condition_variable done;
+  int num_done = 0;
+  for (int i = 0; i < kWorkItems; i++) {
+    pool.Schedule([&]() {
+      EXPECT_LE(0, pool.CurrentThreadId());
+      mutex_lock l(mu);
+      ++num_done;
+      done.notify_all();
+    });
+  }
+  mutex_lock l(mu);
+  while (num_done < kWorkItems) done.wait(l);
+}
+
+TEST(ThreadPool, ScheduleBatch) {
+  for (int wake_batch_size : {1, 2, 4, 100}) {
+    SchedulingPolicy policy;
+    policy.wake_batch_size = wake_batch_size;
+    policy.pin_threads_to_cores = true;
+    const int kWorkItems = 50;
+    std::atomic<bool> work[kWorkItems];
+    for (int i = 0; i < kWorkItems; i++) {
+      work[i] = false;
+    }
+    {
+      ThreadPool pool(Env::Default(), ThreadOptions(), "test", 4, policy);
+      EXPECT_EQ(wake_batch_size, pool.scheduling_policy().wake_batch_size);
+      std::vector<std::function<void()>> fns;
+      for (int i = 0; i < kWorkItems; i++) {
+        fns.push_back([&pool, &work, i]() {
+          EXPECT_LE(0, pool.CurrentThreadId());
+          ASSERT_FALSE(work[i].exchange(true));
+        });
+      }
+      pool.ScheduleBatch(std::move(fns));
+    }
+    for (int i = 0; i < kWorkItems; i++) {
+      ASSERT_TRUE(work[i]);
+    }
+  }
+}
+
+// Lets closures wait until "n" of them have started, so that they must run
+// on different threads.  Gives up after a while, so that a test that fails
+// does not hang.
+class StartBarrier {
+ public:
+  explicit StartBarrier(int n) : n_(n) {}
+
+  // Returns false if fewer than n closures had started when it gave up.
+  bool Arrive() {
+    mutex_lock l(mu_);
+    if (++num_started_ >= n_) cv_.notify_all();
+    while (num_started_ < n_) {
+      if (WaitForMilliseconds(&l, &cv_, 10000) == kCond_Timeout) {
+        return num_started_ >= n_;
+      }
+    }
+    return true;
+  }
+
+ private:
+  const int n_;
+  mutex mu_;
+  condition_variable cv_;
+  int num_started_ GUARDED_BY(mu_) = 0;
+};
+
+TEST(ThreadPool, ScheduleBatchWakesOneThreadPerWakeBatch) {
+  SchedulingPolicy policy;
+  policy.wake_batch_size = 4;
+  ThreadPool pool(Env::Default(), ThreadOptions(), "test", 4, policy);
+  // The first closure of every 4 waits for those of the other 3, which is
+  // only possible if each group of 4 closures woke up a thread of its own.
+  const int kWorkItems = 16;
+  StartBarrier barrier(4);
+  BlockingCounter done(kWorkItems);
+  mutex mu;
+  std::set<int> thread_ids;
+  int num_timed_out = 0;
+  std::vector<std::function<void()>> fns;
+  for (int i = 0; i < kWorkItems; i++) {
+    fns.push_back([&]() {
+      const bool started = barrier.Arrive();
+      {
+        mutex_lock l(mu);
+        thread_ids.insert(pool.CurrentThreadId());
+        if (!started) ++num_timed_out;
+      }
+      done.DecrementCount();
+    });
+  }
+  pool.ScheduleBatch(std::move(fns));
+  done.Wait();
+  EXPECT_EQ(0, num_timed_out);
+  EXPECT_EQ(4, thread_ids.size());
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+TEST(ThreadPool, PinnedPoolsUseDifferentCPUs) {
+  const int kThreadsPerPool = 2;
+  if (port::NumSchedulableCPUs() < 2 * kThreadsPerPool) {
+    LOG(INFO) << "Skipping test: too few CPUs";
+    return;
+  }
+  SchedulingPolicy policy;
+  policy.pin_threads_to_cores = true;
+  ThreadPool pool1(Env::Default(), ThreadOptions(), "test1", kThreadsPerPool,
+                   policy);
+  ThreadPool pool2(Env::Default(), ThreadOptions(), "test2", kThreadsPerPool,
+                   policy);
+  // Occupy every thread of both pools at once, and see where each one runs.
+  StartBarrier barrier(2 * kThreadsPerPool);
+  BlockingCounter done(2 * kThreadsPerPool);
+  mutex mu;
+  std::set<int> cpus;
+  int num_timed_out = 0;
+  int num_unpinned = 0;
+  for (ThreadPool* pool : {&pool1, &pool2}) {
+    for (int i = 0; i < kThreadsPerPool; ++i) {
+      pool->Schedule([&]() {
+        const bool started = barrier.Arrive();
+        {
+          mutex_lock l(mu);
+          if (!started) ++num_timed_out;
+          if (port::NumSchedulableCPUs() != 1) ++num_unpinned;
+          cpus.insert(port::GetCurrentCPU());
+        }
+        done.DecrementCount();
+      });
+    }
+  }
+  done.Wait();
+  EXPECT_EQ(0, num_timed_out);
+  EXPECT_EQ(0, num_unpinned);
+  EXPECT_EQ(2 * kThreadsPerPool, cpus.size());
+}
+#endif
+
 static void BM_Sequential(int iters) {
   ThreadPool pool(Env::Default(), "test", kNumThreads);
   // Decrement count sequentially until 0.
@@ -273,5 +441,62 @@ BENCHMARK(BM_ParallelFor)
     ->ArgPair(1 << 10, 1 << 30)
     ->ArgPair(1 << 20, 1 << 30);
 
+// Measures the time from scheduling a burst of "burst_size" closures on an
+// idle pool to running them, with and without spinning and wakeup batching.
+static void ScheduleToRunLatency(int iters, bool spin, int burst_size,
+                                 int wake_batch_size) {
+  testing::StopTiming();
+  SchedulingPolicy policy;
+  policy.spin_before_park = spin;
+  policy.wake_batch_size = wake_batch_size;
+  ThreadPool pool(Env::Default(), ThreadOptions(), "test", 8, policy);
+  Env* env = Env::Default();
+  std::atomic<int64> total_latency_nsec(0);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    mutex mu;
+    condition_variable done;
+    int num_done = 0;
+    std::vector<std::function<void()>> fns;
+    const uint64 scheduled_nsec = env->NowNanos();
+    for (int j = 0; j < burst_size; ++j) {
+      fns.push_back([&]() {
+        total_latency_nsec += env->NowNanos() - scheduled_nsec;
+        mutex_lock l(mu);
+        if (++num_done == burst_size) done.notify_all();
+      });
+    }
+    pool.ScheduleBatch(std::move(fns));
+    mutex_lock l(mu);
+    while (num_done < burst_size) done.wait(l);
+  }
+  testing::StopTiming();
+  testing::ItemsProcessed(static_cast<int64>(iters) * burst_size);
+  testing::SetLabel(strings::StrCat(
+      spin ? "spin" : "park", " wake_batch=", wake_batch_size,
+      " mean_latency_ns=",
+      total_latency_nsec / (static_cast<int64>(iters) * burst_size)));
+}
+
+static void BM_ScheduleToRunLatencySpin(int iters, int burst_size,
+                                        int wake_batch_size) {
+  ScheduleToRunLatency(iters, true, burst_size, wake_batch_size);
+}
+BENCHMARK(BM_ScheduleToRunLatencySpin)
+    ->ArgPair(1, 1)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 4)
+    ->ArgPair(16, 16);
+
+static void BM_ScheduleToRunLatencyPark(int iters, int burst_size,
+                                        int wake_batch_size) {
+  ScheduleToRunLatency(iters, false, burst_size, wake_batch_size);
+}
+BENCHMARK(BM_ScheduleToRunLatencyPark)
+    ->ArgPair(1, 1)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 4)
+    ->ArgPair(16, 16);
+
 }  // namespace thread
 }  // namespace tensorflow
@@ -0,0 +1,200 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ReadaheadInputStream::ReadaheadInputStream(RandomAccessFile* file,
+                                           size_t block_bytes, int num_blocks)
+    : file_(file),
+      block_bytes_(std::max<size_t>(block_bytes, 1)),
+      num_blocks_(std::max(num_blocks, 1)) {
+  std::vector<Block*> to_read;
+  {
+    mutex_lock l(mu_);
+    ScheduleBlocksLocked(&to_read);
+  }
+  ReadBlocks(to_read);
+}
+
+ReadaheadInputStream::~ReadaheadInputStream() {
+  mutex_lock l(mu_);
+  while (num_reads_in_flight_ > 0) {
+    cond_var_.wait(l);
+  }
+}
+
+Status ReadaheadInputStream::ReadNBytes(int64 bytes_to_read, string* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->reserve(bytes_to_read);
+  while (static_cast<int64>(result->size()) < bytes_to_read) {
+    int64 bytes_consumed;
+    std::vector<Block*> to_read;
+    Status s = ConsumeFrontBlock(bytes_to_read - result->size(), result,
+                                 &bytes_consumed, &to_read);
+    ReadBlocks(to_read);
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+Status ReadaheadInputStream::SkipNBytes(int64 bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  {
+    std::vector<Block*> to_read;
+    {
+      mutex_lock l(mu_);
+      if (!reached_eof_ && pos_ + bytes_to_skip >= next_offset_) {
+        RestartLocked(pos_ + bytes_to_skip, &l, &to_read);
+        bytes_to_skip = 0;
+      }
+    }
+    ReadBlocks(to_read);
+  }
+  while (bytes_to_skip > 0) {
+    int64 bytes_consumed;
+    std::vector<Block*> to_read;
+    Status s =
+        ConsumeFrontBlock(bytes_to_skip, nullptr, &bytes_consumed, &to_read);
+    ReadBlocks(to_read);
+    TF_RETURN_IF_ERROR(s);
+    bytes_to_skip -= bytes_consumed;
+  }
+  return Status::OK();
+}
+
+int64 ReadaheadInputStream::Tell() const {
+  mutex_lock l(mu_);
+  return pos_;
+}
+
+Status ReadaheadInputStream::Reset() {
+  std::vector<Block*> to_read;
+  {
+    mutex_lock l(mu_);
+    RestartLocked(0, &l, &to_read);
+  }
+  ReadBlocks(to_read);
+  return Status::OK();
+}
+
+Status ReadaheadInputStream::ConsumeFrontBlock(int64 max_bytes, string* result,
+                                               int64* bytes_consumed,
+                                               std::vector<Block*>* to_read) {
+  mutex_lock l(mu_);
+  *bytes_consumed = 0;
+  if (blocks_.empty()) {
+    return errors::OutOfRange("reached end of file");
+  }
+  Block* block = blocks_.front().get();
+  while (!block->done) {
+    cond_var_.wait(l);
+  }
+  const RandomAccessFile::ReadRequest& request = block->requests[0];
+  if (!request.status.ok() && !errors::IsOutOfRange(request.status)) {
+    return request.status;
+  }
+  const size_t n =
+      std::min<size_t>(max_bytes, request.result.size() - block->pos);
+  if (result != nullptr) {
+    result->append(request.result.data() + block->pos, n);
+  }
+  block->pos += n;
+  pos_ += n;
+  *bytes_consumed = n;
+  if (block->pos < request.result.size()) {
+    return Status::OK();
+  }
+  const bool eof = request.result.size() < block_bytes_;
+  free_blocks_.push_back(std::move(blocks_.front()));
+  blocks_.pop_front();
+  if (eof) {
+    reached_eof_ = true;
+  } else {
+    ScheduleBlocksLocked(to_read);
+  }
+  if (n == 0) {
+    return errors::OutOfRange("reached end of file");
+  }
+  return Status::OK();
+}
+
+void ReadaheadInputStream::RestartLocked(int64 position, mutex_lock* lock,
+                                         std::vector<Block*>* to_read) {
+  while (num_reads_in_flight_ > 0) {
+    cond_var_.wait(*lock);
+  }
+  while (!blocks_.empty()) {
+    free_blocks_.push_back(std::move(blocks_.front()));
+    blocks_.pop_front();
+  }
+  pos_ = position;
+  next_offset_ = position;
+  reached_eof_ = false;
+  ScheduleBlocksLocked(to_read);
+}
+
+void ReadaheadInputStream::ScheduleBlocksLocked(std::vector<Block*>* to_read) {
+  while (!reached_eof_ && blocks_.size() < static_cast<size_t>(num_blocks_)) {
+    std::unique_ptr<Block> block;
+    if (free_blocks_.empty()) {
+      block.reset(new Block);
+      block->buffer.resize(block_bytes_);
+      block->requests.resize(1);
+    } else {
+      block = std::move(free_blocks_.back());
+      free_blocks_.pop_back();
+    }
+    block->done = false;
+    block->pos = 0;
+    RandomAccessFile::ReadRequest& request = block->requests[0];
+    request.offset = next_offset_;
+    request.n = block_bytes_;
+    request.scratch = &block->buffer[0];
+    request.result = StringPiece();
+    request.status = Status::OK();
+    next_offset_ += block_bytes_;
+    ++num_reads_in_flight_;
+    to_read->push_back(block.get());
+    blocks_.push_back(std::move(block));
+  }
+}
+
+void ReadaheadInputStream::ReadBlocks(const std::vector<Block*>& blocks) {
+  for (Block* block : blocks) {
+    file_->ReadAsync(&block->requests, [this, block]() {
+      mutex_lock l(mu_);
+      block->done = true;
+      --num_reads_in_flight_;
+      cond_var_.notify_all();
+    });
+  }
+}
+
+}  // namespace io
+}  // namespace tensorflow
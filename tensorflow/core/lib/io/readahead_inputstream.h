@@ -0,0 +1,116 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a RandomAccessFile sequentially while keeping asynchronous reads of
+// the next `num_blocks` blocks of `block_bytes` bytes in flight (see
+// `RandomAccessFile::ReadAsync`), so that reading the file overlaps with
+// processing its contents without a thread per outstanding read.
+//
+// A single instance of ReadaheadInputStream is NOT safe for concurrent use by
+// multiple threads.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  ReadaheadInputStream(RandomAccessFile* file, size_t block_bytes,
+                       int num_blocks);
+
+  // Waits for the reads in flight.
+  ~ReadaheadInputStream() override;
+
+  Status ReadNBytes(int64 bytes_to_read, string* result) override;
+
+  // Skips within the blocks read ahead, or restarts reading ahead from the new
+  // position without reading the skipped bytes. In the latter case, skipping
+  // past the end of the file is only detected by the next read.
+  Status SkipNBytes(int64 bytes_to_skip) override;
+
+  int64 Tell() const override;
+
+  Status Reset() override;
+
+ private:
+  struct Block {
+    // Holds the single read of the block, as `ReadAsync` takes a batch.
+    std::vector<RandomAccessFile::ReadRequest> requests;
+    string buffer;
+    // Whether the read has completed.
+    bool done = false;
+    // The number of bytes of the block already returned by the stream.
+    size_t pos = 0;
+  };
+
+  // Consumes up to `max_bytes` bytes from the first block, appending them to
+  // `*result` unless it is null, and stores their number in
+  // `*bytes_consumed`. Waits for the read of the block if needed. Stores the
+  // blocks to read next in `*to_read`.
+  Status ConsumeFrontBlock(int64 max_bytes, string* result,
+                           int64* bytes_consumed, std::vector<Block*>* to_read)
+      LOCKS_EXCLUDED(mu_);
+
+  // Discards the blocks, after waiting for their reads, and starts reading
+  // ahead from `position`.
+  void RestartLocked(int64 position, mutex_lock* lock,
+                     std::vector<Block*>* to_read)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Adds blocks until `num_blocks_` are read ahead, unless the end of the
+  // file was reached.
+  void ScheduleBlocksLocked(std::vector<Block*>* to_read)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Starts the reads of `blocks`. `done` may be called before `ReadAsync`
+  // returns, so this must be called without holding `mu_`.
+  void ReadBlocks(const std::vector<Block*>& blocks) LOCKS_EXCLUDED(mu_);
+
+  RandomAccessFile* const file_;  // not owned.
+  const size_t block_bytes_;
+  const int num_blocks_;
+
+  mutable mutex mu_;
+  condition_variable cond_var_;
+  // The blocks read ahead, in file order. The first block holds `pos_`.
+  std::deque<std::unique_ptr<Block>> blocks_ GUARDED_BY(mu_);
+  // Consumed blocks, reused to avoid reallocating their buffers.
+  std::vector<std::unique_ptr<Block>> free_blocks_ GUARDED_BY(mu_);
+  int64 pos_ GUARDED_BY(mu_) = 0;
+  // The offset of the next block to read.
+  int64 next_offset_ GUARDED_BY(mu_) = 0;
+  // Set when a block ends before `block_bytes_`, to stop reading ahead.
+  bool reached_eof_ GUARDED_BY(mu_) = false;
+  int64 num_reads_in_flight_ GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReadaheadInputStream);
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,161 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+static std::vector<int> BlockSizes() { return {1, 2, 3, 7, 10, 64, 65536}; }
+
+static std::vector<int> NumBlocks() { return {1, 2, 4}; }
+
+TEST(ReadaheadInputStream, ReadNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    for (auto num_blocks : NumBlocks()) {
+      ReadaheadInputStream in(file.get(), block_size, num_blocks);
+      string read;
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "012");
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(0, &read));
+      EXPECT_EQ(read, "");
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "3456");
+      EXPECT_EQ(7, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(3, &read));
+      EXPECT_EQ(read, "789");
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(5, &read)));
+      EXPECT_EQ(read, "");
+      EXPECT_EQ(10, in.Tell());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, ReadPastEndOfFile) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    for (auto num_blocks : NumBlocks()) {
+      ReadaheadInputStream in(file.get(), block_size, num_blocks);
+      string read;
+      TF_ASSERT_OK(in.ReadNBytes(6, &read));
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(6, &read)));
+      EXPECT_EQ(read, "6789");
+      EXPECT_EQ(10, in.Tell());
+      // A second call should also return end of file.
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_EQ(read, "");
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SkipNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    for (auto num_blocks : NumBlocks()) {
+      ReadaheadInputStream in(file.get(), block_size, num_blocks);
+      string read;
+      TF_ASSERT_OK(in.SkipNBytes(3));
+      EXPECT_EQ(3, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "34");
+      TF_ASSERT_OK(in.SkipNBytes(0));
+      TF_ASSERT_OK(in.SkipNBytes(1));
+      EXPECT_EQ(6, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "67");
+      TF_ASSERT_OK(in.SkipNBytes(2));
+      EXPECT_EQ(10, in.Tell());
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      EXPECT_FALSE(in.SkipNBytes(-1).ok());
+    }
+  }
+}
+
+TEST(ReadaheadInputStream, SkipPastReadahead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  string contents;
+  for (int i = 0; i < 1000; ++i) contents += static_cast<char>('a' + i % 26);
+  TF_ASSERT_OK(WriteStringToFile(env, fname, contents));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  ReadaheadInputStream in(file.get(), 16, 2);
+  string read;
+  TF_ASSERT_OK(in.ReadNBytes(5, &read));
+  EXPECT_EQ(contents.substr(0, 5), read);
+  // Skips beyond the 32 bytes read ahead.
+  TF_ASSERT_OK(in.SkipNBytes(500));
+  EXPECT_EQ(505, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(100, &read));
+  EXPECT_EQ(contents.substr(505, 100), read);
+  TF_ASSERT_OK(in.SkipNBytes(3));
+  TF_ASSERT_OK(in.ReadNBytes(392, &read));
+  EXPECT_EQ(contents.substr(608), read);
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+}
+
+TEST(ReadaheadInputStream, Reset) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto block_size : BlockSizes()) {
+    for (auto num_blocks : NumBlocks()) {
+      ReadaheadInputStream in(file.get(), block_size, num_blocks);
+      string read;
+      TF_ASSERT_OK(in.ReadNBytes(4, &read));
+      EXPECT_EQ(read, "0123");
+      TF_ASSERT_OK(in.Reset());
+      EXPECT_EQ(0, in.Tell());
+      TF_ASSERT_OK(in.ReadNBytes(10, &read));
+      EXPECT_EQ(read, "0123456789");
+      EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+      TF_ASSERT_OK(in.Reset());
+      TF_ASSERT_OK(in.ReadNBytes(2, &read));
+      EXPECT_EQ(read, "01");
+    }
+  }
+}
+
+}  // anonymous namespace
+}  // namespace io
+}  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -59,7 +60,11 @@ RecordReader::RecordReader(RandomAccessFile* file,
     : options_(options),
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.buffer_size > 0 && options.readahead_blocks > 0) {
+    input_stream_.reset(new ReadaheadInputStream(
+        file, options.buffer_size / options.readahead_blocks,
+        options.readahead_blocks));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
@@ -80,7 +85,8 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
-// stored in the last 4 bytes and store the first n bytes in *result.
+// stored in the last 4 bytes (unless options_.verify_checksums is false) and
+// store the first n bytes in *result.
 //
 // offset corresponds to the user-provided value to ReadRecord()
 // and is used only in error messages.
@@ -100,9 +106,11 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n, string* result) {
     }
   }
 
-  const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
-  if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
-    return errors::DataLoss("corrupted record at ", offset);
+  if (options_.verify_checksums) {
+    const uint32 masked_crc = core::DecodeFixed32(result->data() + n);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(result->data(), n)) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
   }
   result->resize(n);
   return Status::OK();
@@ -202,5 +210,77 @@ SequentialRecordReader::SequentialRecordReader(
     RandomAccessFile* file, const RecordReaderOptions& options)
     : underlying_(file, options), offset_(0) {}
 
+MemoryMappedRecordReader::MemoryMappedRecordReader(
+    std::unique_ptr<ReadOnlyMemoryRegion> region, bool verify_checksums)
+    : region_(std::move(region)),
+      data_(region_ ? static_cast<const char*>(region_->data()) : nullptr),
+      size_(region_ ? region_->length() : 0),
+      verify_checksums_(verify_checksums) {}
+
+MemoryMappedRecordReader::~MemoryMappedRecordReader() = default;
+
+Status MemoryMappedRecordReader::New(
+    Env* env, const string& filename, bool verify_checksums,
+    std::unique_ptr<MemoryMappedRecordReader>* reader) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename, &file_size));
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  // Empty files cannot be mapped.
+  if (file_size > 0) {
+    TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(filename, &region));
+  }
+  reader->reset(new MemoryMappedRecordReader(std::move(region),
+                                             verify_checksums));
+  return Status::OK();
+}
+
+Status MemoryMappedRecordReader::ReadRecord(StringPiece* record) {
+  if (offset_ >= size_) {
+    return errors::OutOfRange("eof");
+  }
+  const uint64 remaining = size_ - offset_;
+  if (remaining < RecordReader::kHeaderSize) {
+    return errors::DataLoss("truncated record at ", offset_);
+  }
+
+  // Read header data.
+  const char* header = data_ + offset_;
+  if (verify_checksums_) {
+    const uint32 masked_crc = core::DecodeFixed32(header + sizeof(uint64));
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(header, sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", offset_);
+    }
+  }
+  const uint64 length = core::DecodeFixed64(header);
+
+  // Read data
+  if (length > remaining - RecordReader::kHeaderSize ||
+      remaining - RecordReader::kHeaderSize - length <
+          RecordReader::kFooterSize) {
+    return errors::DataLoss("truncated record at ", offset_);
+  }
+  const char* data = header + RecordReader::kHeaderSize;
+  if (verify_checksums_) {
+    const uint32 masked_crc = core::DecodeFixed32(data + length);
+    if (crc32c::Unmask(masked_crc) != crc32c::Value(data, length)) {
+      return errors::DataLoss("corrupted record at ", offset_);
+    }
+  }
+
+  *record = StringPiece(data, length);
+  offset_ += RecordReader::kHeaderSize + length + RecordReader::kFooterSize;
+  return Status::OK();
+}
+
+Status MemoryMappedRecordReader::SeekOffset(uint64 offset) {
+  if (offset > size_) {
+    return errors::InvalidArgument("Trying to seek offset: ", offset,
+                                   " which is beyond the end of the file: ",
+                                   size_);
+  }
+  offset_ = offset;
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
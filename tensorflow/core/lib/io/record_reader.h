@@ -28,7 +28,9 @@ limitations under the License.
 
 namespace tensorflow {
 
+class Env;
 class RandomAccessFile;
+class ReadOnlyMemoryRegion;
 
 namespace io {
 
@@ -42,6 +44,14 @@ class RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64 buffer_size = 0;
 
+  // If non-zero and buffer_size is non-zero, the buffer is split into this
+  // many blocks, which are read ahead of the records asynchronously (see
+  // ReadaheadInputStream).
+  int readahead_blocks = 0;
+
+  // If false, the masked crcs of the records are not checked.
+  bool verify_checksums = true;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
@@ -152,6 +162,49 @@ class SequentialRecordReader {
   uint64 offset_ = 0;
 };
 
+// Reads the records of an uncompressed TFRecord file from a read-only memory
+// mapping of the file. Records are returned as views of the mapping instead of
+// being copied.
+//
+// Note: this class is not thread safe; external synchronization required.
+class MemoryMappedRecordReader {
+ public:
+  // Create a reader that will return the records in "*region", which may be
+  // nullptr for an empty file. If "verify_checksums" is false, the masked crcs
+  // of the records are not checked.
+  MemoryMappedRecordReader(std::unique_ptr<ReadOnlyMemoryRegion> region,
+                           bool verify_checksums = true);
+
+  ~MemoryMappedRecordReader();
+
+  // Maps the file "filename" into memory and creates a reader of its records
+  // in "*reader". Returns UNIMPLEMENTED if the file system of "filename" does
+  // not support memory mapping.
+  static Status New(Env* env, const string& filename, bool verify_checksums,
+                    std::unique_ptr<MemoryMappedRecordReader>* reader);
+
+  // Reads the next record in the file into *record, which remains valid as
+  // long as this reader. Returns OK on success, OUT_OF_RANGE for end of file,
+  // or something else for an error.
+  Status ReadRecord(StringPiece* record);
+
+  // Returns the current offset in the file.
+  uint64 TellOffset() const { return offset_; }
+
+  // Seek to this offset within the file and set this offset as the current
+  // offset.
+  Status SeekOffset(uint64 offset);
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const uint64 size_;
+  const bool verify_checksums_;
+  uint64 offset_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryMappedRecordReader);
+};
+
 }  // namespace io
 }  // namespace tensorflow
 
@@ -196,6 +196,155 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestReadahead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_readahead_test";
+
+  std::vector<string> records;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 100; ++i) {
+      records.push_back(string(i * 7, 'a' + i % 26));
+      TF_EXPECT_OK(writer.WriteRecord(records.back()));
+    }
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  for (auto buf_size : BufferSizes()) {
+    io::RecordReaderOptions options;
+    options.buffer_size = buf_size;
+    options.readahead_blocks = 4;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    uint64 offset_of_tenth = 0;
+    string record;
+    for (size_t i = 0; i < records.size(); ++i) {
+      if (i == 10) offset_of_tenth = offset;
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(records[i], record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+    // Seeking backwards restarts the readahead.
+    TF_CHECK_OK(reader.ReadRecord(&offset_of_tenth, &record));
+    EXPECT_EQ(records[10], record);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestMemoryMapped) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_EXPECT_OK(writer.WriteRecord(""));
+    TF_EXPECT_OK(writer.WriteRecord("defg"));
+    TF_CHECK_OK(writer.Flush());
+  }
+
+  std::unique_ptr<io::MemoryMappedRecordReader> reader;
+  TF_CHECK_OK(io::MemoryMappedRecordReader::New(
+      env, fname, /*verify_checksums=*/true, &reader));
+  StringPiece record;
+  TF_CHECK_OK(reader->ReadRecord(&record));
+  EXPECT_EQ("abc", record);
+  const uint64 offset = reader->TellOffset();
+  EXPECT_EQ(19, offset);
+  TF_CHECK_OK(reader->ReadRecord(&record));
+  EXPECT_EQ("", record);
+  TF_CHECK_OK(reader->ReadRecord(&record));
+  EXPECT_EQ("defg", record);
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadRecord(&record)));
+
+  // Records can be read again after seeking back.
+  TF_CHECK_OK(reader->SeekOffset(offset));
+  TF_CHECK_OK(reader->ReadRecord(&record));
+  EXPECT_EQ("", record);
+}
+
+TEST(RecordReaderWriterTest, TestMemoryMappedCorruptedAndTruncated) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_mmap_corrupt_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_CHECK_OK(writer.Flush());
+  }
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  // Corrupt the data of the record.
+  contents[io::RecordReader::kHeaderSize] = 'x';
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  StringPiece record;
+  std::unique_ptr<io::MemoryMappedRecordReader> reader;
+  TF_CHECK_OK(io::MemoryMappedRecordReader::New(
+      env, fname, /*verify_checksums=*/true, &reader));
+  EXPECT_TRUE(errors::IsDataLoss(reader->ReadRecord(&record)));
+
+  // The corruption goes unnoticed without checksum verification.
+  TF_CHECK_OK(io::MemoryMappedRecordReader::New(
+      env, fname, /*verify_checksums=*/false, &reader));
+  TF_CHECK_OK(reader->ReadRecord(&record));
+  EXPECT_EQ("xbc", record);
+
+  // Drop the footer of the record.
+  contents.resize(contents.size() - io::RecordReader::kFooterSize);
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+  TF_CHECK_OK(io::MemoryMappedRecordReader::New(
+      env, fname, /*verify_checksums=*/false, &reader));
+  EXPECT_TRUE(errors::IsDataLoss(reader->ReadRecord(&record)));
+
+  // Empty files have no records.
+  TF_CHECK_OK(WriteStringToFile(env, fname, ""));
+  TF_CHECK_OK(io::MemoryMappedRecordReader::New(
+      env, fname, /*verify_checksums=*/true, &reader));
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadRecord(&record)));
+}
+
+TEST(RecordReaderWriterTest, TestCorruptedWithoutVerifyingChecksums) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_no_verify_test";
+
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_CHECK_OK(writer.Flush());
+  }
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  // Corrupt the data of the record.
+  contents[io::RecordReader::kHeaderSize] = 'x';
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  string record;
+  {
+    io::SequentialRecordReader reader(read_file.get());
+    EXPECT_TRUE(errors::IsDataLoss(reader.ReadRecord(&record)));
+  }
+  {
+    io::RecordReaderOptions options;
+    options.verify_checksums = false;
+    io::SequentialRecordReader reader(read_file.get(), options);
+    TF_CHECK_OK(reader.ReadRecord(&record));
+    EXPECT_EQ("xbc", record);
+  }
+}
+
 TEST(RecordReaderWriterTest, TestUseAfterClose) {
   Env* env = Env::Default();
   string fname = testing::TmpDir() + "/record_reader_writer_flush_close_test";
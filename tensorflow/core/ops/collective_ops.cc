@@ -30,6 +30,8 @@ REGISTER_OP("CollectiveReduce")
     .Attr("final_op: {'Id', 'Div'}")
     .Attr("subdiv_offsets: list(int)")
     .Attr("wait_for: list(int) = []")
+    .Attr("compression: {'none', 'bf16', 'fp16', 'topk'} = 'none'")
+    .Attr("topk_ratio: float = 0.01")
     .SetIsStateful()
     .SetShapeFn(shape_inference::UnchangedShape);
 
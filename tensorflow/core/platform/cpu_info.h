@@ -58,6 +58,12 @@ int NumTotalCPUs();
 // identified.  If successful, the return value will be in [0, NumTotalCPUs()).
 int GetCurrentCPU();
 
+// Pins the calling thread to the "index"-th (modulo their number) of the CPUs
+// this process may be scheduled on, as given by the affinity of the process
+// rather than by that of the calling thread.  Returns false if that is not
+// supported on this platform or fails.
+bool PinCurrentThreadToSchedulableCPU(int index);
+
 // Returns an estimate of the number of hyperthreads per physical core
 // on the CPU
 int NumHyperthreadsPerCore();
@@ -65,6 +65,14 @@ def tf_additional_gdr_deps():
         "//conditions:default": [],
     })
 
+def tf_additional_shm_deps():
+    return select({
+        str(Label("//tensorflow:with_shm_support")): [
+            str(Label("//tensorflow/contrib/shm:shm_server_lib")),
+        ],
+        "//conditions:default": [],
+    })
+
 # Include specific extra dependencies when building statically, or
 # another set of dependencies otherwise. If "macos" is provided, that
 # dependency list is used when using the framework_shared_object config
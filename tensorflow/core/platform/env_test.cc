@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -90,6 +91,67 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+// Forwards `Read` to another file, so that `ReadAsync` uses the default
+// implementation.
+class ForwardingRandomAccessFile : public RandomAccessFile {
+ public:
+  explicit ForwardingRandomAccessFile(const RandomAccessFile* file)
+      : file_(file) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    return file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  const RandomAccessFile* const file_;
+};
+
+void ExpectReadAsync(const RandomAccessFile& file, const string& input) {
+  // More reads than the posix file system submits to the kernel at once,
+  // including reads past EOF and empty reads.
+  const int kNumReads = 1000;
+  std::vector<RandomAccessFile::ReadRequest> requests(kNumReads);
+  std::vector<string> scratch(kNumReads);
+  for (int i = 0; i < kNumReads; ++i) {
+    scratch[i].resize((i * 37) % 300);
+    requests[i].offset = (i * 7919) % (input.size() + 200);
+    requests[i].n = scratch[i].size();
+    requests[i].scratch = &scratch[i][0];
+  }
+  Notification done;
+  file.ReadAsync(&requests, [&done]() { done.Notify(); });
+  done.WaitForNotification();
+  for (const RandomAccessFile::ReadRequest& request : requests) {
+    const size_t available =
+        request.offset < input.size() ? input.size() - request.offset : 0;
+    const size_t expected = std::min(request.n, available);
+    EXPECT_EQ(StringPiece(input).substr(
+                  std::min<size_t>(request.offset, input.size()), expected),
+              request.result);
+    if (expected < request.n) {
+      EXPECT_EQ(error::OUT_OF_RANGE, request.status.code());
+    } else {
+      TF_EXPECT_OK(request.status);
+    }
+  }
+
+  // An empty batch completes immediately.
+  std::vector<RandomAccessFile::ReadRequest> no_requests;
+  Notification empty_done;
+  file.ReadAsync(&no_requests, [&empty_done]() { empty_done.Notify(); });
+  empty_done.WaitForNotification();
+}
+
+TEST_F(DefaultEnvTest, ReadAsync) {
+  const string filename = io::JoinPath(BaseDir(), "read_async");
+  const string input = CreateTestFile(env_, filename, 100000);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_ASSERT_OK(env_->NewRandomAccessFile(filename, &f));
+  ExpectReadAsync(*f, input);
+  ExpectReadAsync(ForwardingRandomAccessFile(f.get()), input);
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1, (256 << 20) + 100}) {
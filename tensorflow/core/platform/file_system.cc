@@ -15,9 +15,12 @@ limitations under the License.
 
 #include <sys/stat.h>
 #include <algorithm>
+#include <atomic>
 #include <deque>
+#include <memory>
 
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -51,6 +54,28 @@ void FileSystem::FlushCaches() {}
 
 RandomAccessFile::~RandomAccessFile() {}
 
+void RandomAccessFile::ReadAsync(std::vector<ReadRequest>* requests,
+                                 std::function<void()> done) const {
+  // The threads serving the asynchronous reads of all files that do not
+  // implement them natively.
+  static constexpr int kNumAsyncReadThreads = 64;
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "async_read", kNumAsyncReadThreads);
+  if (requests->empty()) {
+    done();
+    return;
+  }
+  auto pending = std::make_shared<std::atomic<size_t>>(requests->size());
+  auto shared_done = std::make_shared<std::function<void()>>(std::move(done));
+  for (ReadRequest& request : *requests) {
+    pool->Schedule([this, &request, pending, shared_done]() {
+      request.status =
+          Read(request.offset, request.n, &request.result, request.scratch);
+      if (pending->fetch_sub(1) == 1) (*shared_done)();
+    });
+  }
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
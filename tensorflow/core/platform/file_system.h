@@ -260,6 +260,35 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief A read of up to `n` bytes from the file starting at `offset`
+  /// into `scratch[0..n-1]`, submitted with `ReadAsync`.
+  ///
+  /// `result` and `status` are set when the read completes, as `Read` sets
+  /// its `*result` and returns its status.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    char* scratch = nullptr;
+    StringPiece result;
+    Status status;
+  };
+
+  /// \brief Submits the reads in `*requests` and calls `done` once all of
+  /// them have completed.
+  ///
+  /// The reads may be served concurrently and in any order, so that a single
+  /// caller can keep many reads outstanding. This file, `*requests` and the
+  /// `scratch` buffers must remain live until `done` is called. `done` may be
+  /// called on any thread, possibly before `ReadAsync` returns.
+  ///
+  /// The default implementation serves the reads with `Read` on a shared
+  /// pool of threads. File systems with native asynchronous I/O should
+  /// override it.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadAsync(std::vector<ReadRequest>* requests,
+                         std::function<void()> done) const;
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
@@ -0,0 +1,368 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/posix/io_uring_reader.h"
+
+// Android's seccomp policy kills processes that call the io_uring syscalls.
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/syscall.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup) && \
+    defined(__NR_io_uring_enter)
+#define TF_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef TF_HAS_IO_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/posix/error.h"
+#endif
+
+namespace tensorflow {
+
+#ifdef TF_HAS_IO_URING
+namespace {
+
+// The maximum number of reads submitted to the kernel at the same time.
+constexpr unsigned kRingEntries = 256;
+
+int IoUringSetup(unsigned entries, struct io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags,
+                 nullptr, 0);
+}
+
+class IoUringReaderImpl : public IoUringReader {
+ public:
+  // Returns nullptr if the kernel does not support io_uring.
+  static IoUringReaderImpl* Create() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const int ring_fd = IoUringSetup(kRingEntries, &params);
+    if (ring_fd < 0) {
+      VLOG(1) << "io_uring is not available: " << strerror(errno);
+      return nullptr;
+    }
+    const size_t sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    const size_t cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_SHARED | MAP_POPULATE;
+    void* sq_ring =
+        mmap(nullptr, sq_ring_size, prot, flags, ring_fd, IORING_OFF_SQ_RING);
+    void* cq_ring =
+        mmap(nullptr, cq_ring_size, prot, flags, ring_fd, IORING_OFF_CQ_RING);
+    void* sqes =
+        mmap(nullptr, sqes_size, prot, flags, ring_fd, IORING_OFF_SQES);
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+      VLOG(1) << "Failed to map the io_uring: " << strerror(errno);
+      if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+      if (cq_ring != MAP_FAILED) munmap(cq_ring, cq_ring_size);
+      if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+      close(ring_fd);
+      return nullptr;
+    }
+    return new IoUringReaderImpl(ring_fd, params, static_cast<char*>(sq_ring),
+                                 static_cast<char*>(cq_ring),
+                                 static_cast<struct io_uring_sqe*>(sqes));
+  }
+
+  void Read(int fd, const string& filename,
+            std::vector<RandomAccessFile::ReadRequest>* requests,
+            std::function<void()> done) override {
+    Batch* batch = new Batch;
+    batch->fd = fd;
+    batch->filename = filename;
+    batch->done = std::move(done);
+    batch->ops.reserve(requests->size());
+    for (RandomAccessFile::ReadRequest& request : *requests) {
+      if (request.n == 0) {
+        request.result = StringPiece();
+        request.status = Status::OK();
+        continue;
+      }
+      batch->ops.emplace_back();
+      Op& op = batch->ops.back();
+      op.batch = batch;
+      op.request = &request;
+      op.iov.iov_base = request.scratch;
+      op.iov.iov_len = request.n;
+    }
+    if (batch->ops.empty()) {
+      batch->done();
+      delete batch;
+      return;
+    }
+    batch->pending = batch->ops.size();
+    std::vector<Batch*> completed;
+    {
+      // The completion thread may delete `batch` as soon as `mu_` is
+      // released.
+      mutex_lock l(mu_);
+      for (Op& op : batch->ops) {
+        queued_.push_back(&op);
+      }
+      SubmitQueuedLocked(&completed);
+    }
+    RunDone(completed);
+  }
+
+  bool ok() const override { return !failed_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Batch;
+
+  // A read submitted to the ring, and resubmitted after short reads.
+  struct Op {
+    Batch* batch = nullptr;
+    RandomAccessFile::ReadRequest* request = nullptr;
+    size_t bytes_read = 0;
+    struct iovec iov;
+  };
+
+  // The reads of a call to `Read`.
+  struct Batch {
+    int fd = -1;
+    string filename;
+    std::vector<Op> ops;
+    // The number of ops that have not completed. Only accessed by the
+    // completion thread once the ops are submitted.
+    size_t pending = 0;
+    std::function<void()> done;
+  };
+
+  IoUringReaderImpl(int ring_fd, const struct io_uring_params& params,
+                    char* sq_ring, char* cq_ring, struct io_uring_sqe* sqes)
+      : ring_fd_(ring_fd),
+        sq_entries_(params.sq_entries),
+        sq_mask_(
+            *reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask)),
+        sq_tail_(reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail)),
+        sq_array_(reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array)),
+        sqes_(sqes),
+        cq_mask_(
+            *reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask)),
+        cq_head_(reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head)),
+        cq_tail_(reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail)),
+        cqes_(reinterpret_cast<struct io_uring_cqe*>(cq_ring +
+                                                     params.cq_off.cqes)) {
+    completion_thread_.reset(
+        Env::Default()->StartThread(ThreadOptions(), "io_uring_completion",
+                                    [this]() { ReapCompletions(); }));
+  }
+
+  // Moves queued ops to the submission ring while it has room, and submits
+  // them to the kernel. Once the ring has failed, fails the queued ops
+  // instead. Adds the batches that this completes to `completed`.
+  void SubmitQueuedLocked(std::vector<Batch*>* completed)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (failed_errno_ != 0) {
+      while (!queued_.empty()) {
+        FailOpLocked(queued_.front(), completed);
+        queued_.pop_front();
+      }
+      return;
+    }
+    unsigned tail = *sq_tail_;
+    unsigned to_submit = 0;
+    // The completion ring holds at least `sq_entries_` completions, so
+    // bounding the number of ops in flight also prevents it from overflowing.
+    while (!queued_.empty() && num_in_flight_ < sq_entries_) {
+      Op* op = queued_.front();
+      queued_.pop_front();
+      const unsigned index = tail & sq_mask_;
+      struct io_uring_sqe* sqe = &sqes_[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = op->batch->fd;
+      sqe->off = op->request->offset + op->bytes_read;
+      sqe->addr = reinterpret_cast<uint64>(&op->iov);
+      sqe->len = 1;
+      sqe->user_data = reinterpret_cast<uint64>(op);
+      sq_array_[index] = index;
+      ++tail;
+      ++to_submit;
+      ++num_in_flight_;
+    }
+    if (to_submit == 0) return;
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    while (to_submit > 0) {
+      const int submitted = IoUringEnter(ring_fd_, to_submit, 0, 0);
+      if (submitted < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+        SetFailedLocked(errno);
+        // The kernel consumes the submission ring in order, so the last
+        // `to_submit` entries were not submitted, and never will be.
+        for (; to_submit > 0; --to_submit) {
+          const unsigned index = (tail - to_submit) & sq_mask_;
+          --num_in_flight_;
+          FailOpLocked(reinterpret_cast<Op*>(sqes_[index].user_data),
+                       completed);
+        }
+        SubmitQueuedLocked(completed);
+        return;
+      }
+      to_submit -= submitted;
+    }
+  }
+
+  void SetFailedLocked(int err) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    LOG(ERROR) << "io_uring_enter failed, reading files through the thread "
+               << "pool from now on: " << strerror(err);
+    failed_errno_ = err;
+    failed_.store(true, std::memory_order_relaxed);
+  }
+
+  // Fails the request of `op`, which is not in flight, with the error of
+  // the ring.
+  void FailOpLocked(Op* op, std::vector<Batch*>* completed)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    op->request->status = IOError(op->batch->filename, failed_errno_);
+    op->request->result = StringPiece(op->request->scratch, op->bytes_read);
+    if (--op->batch->pending == 0) {
+      completed->push_back(op->batch);
+    }
+  }
+
+  static void RunDone(const std::vector<Batch*>& completed) {
+    for (Batch* batch : completed) {
+      batch->done();
+      delete batch;
+    }
+  }
+
+  // Records the result `res` of `op`. Returns false if `op` must be
+  // resubmitted to read the rest of its request.
+  bool CompleteOp(Op* op, int res) {
+    RandomAccessFile::ReadRequest* request = op->request;
+    if (res > 0) {
+      op->bytes_read += res;
+      if (op->bytes_read < request->n) {
+        op->iov.iov_base = request->scratch + op->bytes_read;
+        op->iov.iov_len = request->n - op->bytes_read;
+        return false;
+      }
+      request->status = Status::OK();
+    } else if (res == 0) {
+      request->status =
+          Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    } else if (res == -EINTR || res == -EAGAIN) {
+      return false;
+    } else {
+      request->status = IOError(op->batch->filename, -res);
+    }
+    request->result = StringPiece(request->scratch, op->bytes_read);
+    return true;
+  }
+
+  // Runs on `completion_thread_`: waits for completions, records them,
+  // refills the submission ring and calls the `done` callbacks of the
+  // completed batches. Once the ring has failed, polls for the completions
+  // of the reads still in flight, and returns when there are none left.
+  void ReapCompletions() {
+    std::vector<Batch*> completed;
+    while (true) {
+      if (ok()) {
+        if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+            errno != EINTR) {
+          const int err = errno;
+          mutex_lock l(mu_);
+          SetFailedLocked(err);
+        }
+      } else {
+        {
+          mutex_lock l(mu_);
+          if (num_in_flight_ == 0) return;
+        }
+        Env::Default()->SleepForMicroseconds(1000);
+      }
+      {
+        mutex_lock l(mu_);
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+          const struct io_uring_cqe& cqe = cqes_[head & cq_mask_];
+          Op* op = reinterpret_cast<Op*>(cqe.user_data);
+          --num_in_flight_;
+          if (!CompleteOp(op, cqe.res)) {
+            queued_.push_front(op);
+          } else if (--op->batch->pending == 0) {
+            completed.push_back(op->batch);
+          }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        SubmitQueuedLocked(&completed);
+      }
+      RunDone(completed);
+      completed.clear();
+    }
+  }
+
+  const int ring_fd_;
+  const unsigned sq_entries_;
+  const unsigned sq_mask_;
+  unsigned* const sq_tail_;
+  unsigned* const sq_array_;
+  struct io_uring_sqe* const sqes_;
+  const unsigned cq_mask_;
+  unsigned* const cq_head_;
+  unsigned* const cq_tail_;
+  struct io_uring_cqe* const cqes_;
+
+  mutex mu_;
+  // Ops waiting for room in the submission ring, in submission order.
+  std::deque<Op*> queued_ GUARDED_BY(mu_);
+  unsigned num_in_flight_ GUARDED_BY(mu_) = 0;
+  // The error of the io_uring_enter call that failed, or 0.
+  int failed_errno_ GUARDED_BY(mu_) = 0;
+  // Whether `failed_errno_` is set. Read without `mu_` by ok().
+  std::atomic<bool> failed_{false};
+  std::unique_ptr<Thread> completion_thread_;
+};
+
+}  // namespace
+
+IoUringReader* IoUringReader::Get() {
+  static IoUringReader* reader = IoUringReaderImpl::Create();
+  return reader;
+}
+
+#else  // TF_HAS_IO_URING
+
+IoUringReader* IoUringReader::Get() { return nullptr; }
+
+#endif  // TF_HAS_IO_URING
+
+}  // namespace tensorflow
@@ -0,0 +1,54 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_READER_H_
+#define TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_READER_H_
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Serves asynchronous reads of POSIX files with a Linux io_uring, so that
+// many reads can be outstanding while a single thread reaps their
+// completions.
+class IoUringReader {
+ public:
+  virtual ~IoUringReader() {}
+
+  // Returns the process-wide reader, or nullptr if io_uring is not supported
+  // by this build or by the running kernel.
+  static IoUringReader* Get();
+
+  // Returns false once the ring has failed, after which every read fails
+  // and callers should read the file some other way.
+  virtual bool ok() const = 0;
+
+  // Submits the reads in `*requests` from the file descriptor `fd` of the
+  // file `filename`, and calls `done` once all of them have completed.
+  // Reads beyond the capacity of the ring are queued, so this never blocks
+  // on I/O. `fd`, `*requests` and the `scratch` buffers must remain valid
+  // until `done` is called.
+  virtual void Read(int fd, const string& filename,
+                    std::vector<RandomAccessFile::ReadRequest>* requests,
+                    std::function<void()> done) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_POSIX_IO_URING_READER_H_
@@ -37,6 +37,7 @@ limitations under the License.
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <vector>
 #ifdef TF_USE_SNAPPY
 #include "snappy.h"
 #endif
@@ -116,6 +117,42 @@ int GetCurrentCPU() {
   return kUnknownCPU;
 }
 
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Returns the CPUs the process may run on, or an empty vector if they are not
+// known.  Read once, from the main thread, so that threads that are already
+// pinned do not narrow down the CPUs other threads are pinned to.
+const std::vector<int>& ProcessSchedulableCPUs() {
+  static const std::vector<int>* cpus = [] {
+    std::vector<int>* cpus = new std::vector<int>;
+    cpu_set_t cpuset;
+    if (sched_getaffinity(getpid(), sizeof(cpu_set_t), &cpuset) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuset)) cpus->push_back(cpu);
+      }
+    }
+    return cpus;
+  }();
+  return *cpus;
+}
+
+}  // namespace
+#endif
+
+bool PinCurrentThreadToSchedulableCPU(int index) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  const std::vector<int>& cpus = ProcessSchedulableCPUs();
+  if (index < 0 || cpus.empty()) return false;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpus[index % cpus.size()], &cpuset);
+  return sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
 int NumHyperthreadsPerCore() {
   static const int ht_per_core = tensorflow::port::CPUIDNumSMT();
   return (ht_per_core > 0) ? ht_per_core : 1;
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/platform/file_system_helper.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/posix/error.h"
+#include "tensorflow/core/platform/posix/io_uring_reader.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -88,6 +89,16 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+  void ReadAsync(std::vector<ReadRequest>* requests,
+                 std::function<void()> done) const override {
+    IoUringReader* reader = IoUringReader::Get();
+    if (reader == nullptr || !reader->ok()) {
+      RandomAccessFile::ReadAsync(requests, std::move(done));
+      return;
+    }
+    reader->Read(fd_, filename_, requests, std::move(done));
+  }
 };
 
 class PosixWritableFile : public WritableFile {
@@ -81,6 +81,11 @@ int GetCurrentCPU() {
   return GetCurrentProcessorNumber();
 }
 
+bool PinCurrentThreadToSchedulableCPU(int index) {
+  // Not yet implemented.
+  return false;
+}
+
 bool NUMAEnabled() {
   // Not yet implemented: coming soon.
   return false;
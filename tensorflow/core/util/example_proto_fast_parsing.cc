@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
 #include <vector>
 
 #include "absl/base/casts.h"
@@ -64,6 +65,52 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Returns the number of varints in the packed buffer [begin, end), which is
+// the number of bytes without the continuation bit set. The loop has no
+// branches so that the compiler can vectorize it.
+inline size_t CountPackedVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p < end; ++p) {
+    count += *p < 0x80;
+  }
+  return count;
+}
+
+// Decodes the packed varints in [begin, end), storing the first `out_size`
+// values in `out` and checking that the remaining ones are well formed.
+// Returns false if the buffer is not a sequence of 64-bit varints.
+inline bool DecodePackedVarints(const uint8* begin, const uint8* end,
+                                int64* out, size_t out_size) {
+  constexpr uint64 kContinuationBits = 0x8080808080808080ULL;
+  const uint8* p = begin;
+  size_t n = 0;
+  while (p < end) {
+    // Decode eight single-byte varints at a time, which is the common case
+    // for small ids and labels.
+    while (end - p >= 8 && n + 8 <= out_size) {
+      uint64 word;
+      std::memcpy(&word, p, sizeof(word));
+      if (word & kContinuationBits) break;
+      for (int i = 0; i < 8; ++i) {
+        out[n + i] = p[i];
+      }
+      p += 8;
+      n += 8;
+    }
+    if (p == end) break;
+    uint64 byte = *p++;
+    uint64 value = byte & 0x7f;
+    for (int shift = 7; byte >= 0x80; shift += 7) {
+      if (p == end || shift > 63) return false;
+      byte = *p++;
+      value |= (byte & 0x7f) << shift;
+    }
+    if (n < out_size) out[n] = static_cast<int64>(value);
+    ++n;
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -117,6 +164,73 @@ class Feature {
     return true;
   }
 
+  // Counts the values of a float list without decoding them.
+  bool GetNumElementsInFloatList(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      uint8 peek_tag = PeekTag(&stream);
+      if (peek_tag == kDelimitedTag(1)) {  // packed
+        if (!stream.ExpectTag(kDelimitedTag(1))) return false;
+        uint32 packed_length = 0;
+        if (!stream.ReadVarint32(&packed_length)) return false;
+        *num_elements = packed_length / sizeof(float);
+      } else if (peek_tag == kFixed32Tag(1)) {  // non-packed
+        // 1 byte for the tag and 4 bytes for the value.
+        *num_elements = stream.BytesUntilLimit() / (1 + sizeof(float));
+      } else {
+        return false;
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
+  // Counts the values of an int64 list. Packed values are counted without
+  // being decoded.
+  bool GetNumElementsInInt64List(int* num_elements) {
+    protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8*>(serialized_.data()), serialized_.size());
+    EnableAliasing(&stream);
+    uint32 length = 0;
+    if (!stream.ReadVarint32(&length)) return false;
+    auto limit = stream.PushLimit(length);
+    *num_elements = 0;
+    if (!stream.ExpectAtEnd()) {
+      uint8 peek_tag = PeekTag(&stream);
+      if (peek_tag == kDelimitedTag(1)) {  // packed
+        if (!stream.ExpectTag(kDelimitedTag(1))) return false;
+        uint32 packed_length = 0;
+        if (!stream.ReadVarint32(&packed_length)) return false;
+        const void* packed_data = nullptr;
+        int available = 0;
+        if (packed_length > 0 &&
+            (!stream.GetDirectBufferPointer(&packed_data, &available) ||
+             static_cast<uint32>(available) < packed_length)) {
+          return false;
+        }
+        const uint8* begin = static_cast<const uint8*>(packed_data);
+        *num_elements = CountPackedVarints(begin, begin + packed_length);
+      } else if (peek_tag == kVarintTag(1)) {  // non-packed
+        while (!stream.ExpectAtEnd()) {
+          if (!stream.ExpectTag(kVarintTag(1))) return false;
+          protobuf_uint64 n;
+          if (!stream.ReadVarint64(&n)) return false;
+          ++*num_elements;
+        }
+      } else {
+        return false;
+      }
+    }
+    stream.PopLimit(limit);
+    return true;
+  }
+
   template <typename Result>
   bool ParseBytesList(Result* bytes_list) {
     DCHECK(bytes_list != nullptr);
@@ -238,15 +352,28 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
 
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
+        // Decode the packed values straight from the serialized buffer, after
+        // counting them to resize the output once.
+        const void* packed_data = nullptr;
+        int available = 0;
+        if (packed_length > 0 &&
+            (!stream.GetDirectBufferPointer(&packed_data, &available) ||
+             static_cast<uint32>(available) < packed_length)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
+        const uint8* begin = static_cast<const uint8*>(packed_data);
+        const uint8* end = begin + packed_length;
+        const size_t initial_size = int64_list->size();
+        int64_list->resize(initial_size + CountPackedVarints(begin, end));
+        // The output may have less room than requested in case of a
+        // LimitedArraySlice.
+        if (!DecodePackedVarints(begin, end,
+                                 int64_list->data() + initial_size,
+                                 int64_list->size() - initial_size)) {
+          return false;
+        }
+        if (!stream.Skip(packed_length)) return false;
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -462,17 +589,22 @@ void ParallelFor(const std::function<void(size_t)>& f, size_t n,
 
 enum class Type { Sparse, Dense };
 
-struct SparseBuffer {
-  // Features are in one of the 3 vectors below depending on config's dtype.
-  // Other 2 vectors remain empty.
-  SmallVector<string> bytes_list;
-  SmallVector<float> float_list;
-  SmallVector<int64> int64_list;
-
-  // Features of example i are elements with indices
-  // from example_end_indices[i-1] to example_end_indices[i]-1 on the
-  // appropriate xxxxx_list
-  std::vector<size_t> example_end_indices;
+// A variable length dense or sparse feature of every example of a batch.
+// FastParseExample first locates and counts the values of the feature in each
+// example, so that its output tensors can be allocated with their final
+// shape, and then parses the values directly into them.
+struct VarLenFeatureValues {
+  explicit VarLenFeatureValues(size_t batch_size)
+      : features(batch_size), num_values(batch_size, 0) {}
+
+  // The serialized values of the feature in each example, after the data type
+  // tag. Empty if the example does not have values for the feature.
+  std::vector<parsed::Feature> features;
+  // The number of values of the feature in each example.
+  std::vector<size_t> num_values;
+  // For sparse features, the position of the first value of each example in
+  // the output values.
+  std::vector<size_t> offsets;
 };
 
 struct SeededHasher {
@@ -541,13 +673,47 @@ void LogSparseFeatureDataLoss(StringPiece feature_name) {
   duplicated_sparse_feature->GetCell()->IncrementBy(1);
 }
 
+// Counts the values of `feature`, whose data type has been parsed as `dtype`.
+bool CountFeatureValues(DataType dtype, parsed::Feature* feature,
+                        int* num_values) {
+  switch (dtype) {
+    case DT_INVALID:
+      *num_values = 0;
+      return true;
+    case DT_INT64:
+      return feature->GetNumElementsInInt64List(num_values);
+    case DT_FLOAT:
+      return feature->GetNumElementsInFloatList(num_values);
+    case DT_STRING:
+      return feature->GetNumElementsInBytesList(num_values);
+    default:
+      LOG(FATAL) << "Should not happen.";
+  }
+  return false;
+}
+
+// Returns the name of the values of `dtype` used in error messages.
+const char* ValuesTypeString(DataType dtype) {
+  switch (dtype) {
+    case DT_INT64:
+      return "int64";
+    case DT_FLOAT:
+      return "float";
+    case DT_STRING:
+      return "bytes";
+    default:
+      LOG(FATAL) << "Should not happen.";
+  }
+  return "";
+}
+
 Status FastParseSerializedExample(
     const string& serialized_example, const string& example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
     SeededHasher hasher, std::vector<Tensor>* output_dense,
-    std::vector<SparseBuffer>* output_varlen_dense,
-    std::vector<SparseBuffer>* output_sparse,
+    std::vector<VarLenFeatureValues>* output_varlen_dense,
+    std::vector<VarLenFeatureValues>* output_sparse,
     PerExampleFeatureStats* output_stats) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
@@ -678,7 +844,7 @@ Status FastParseSerializedExample(
             LOG(FATAL) << "Should not happen.";
         }
       } else {  // if variable length
-        SparseBuffer& out = (*output_varlen_dense)[d];
+        VarLenFeatureValues& out = (*output_varlen_dense)[d];
 
         const std::size_t num_elements = config.dense[d].elements_per_stride;
 
@@ -689,70 +855,25 @@ Status FastParseSerializedExample(
               "Expected type: ", DataTypeString(config.dense[d].dtype)));
         }
 
-        auto shape_error = [&](size_t size, StringPiece type_str) {
+        int num_values = 0;
+        if (!CountFeatureValues(example_dtype, &feature, &num_values)) {
+          return parse_error();
+        }
+        if (num_values % num_elements != 0) {
           return example_error(strings::StrCat(
-              "Number of ", type_str,
-              " values is not a multiple of stride length. Saw ", size,
+              "Number of ", ValuesTypeString(config.dense[d].dtype),
+              " values is not a multiple of stride length. Saw ", num_values,
               " values but output shape is: ",
               config.dense[d].shape.DebugString()));
-        };
-
-        switch (config.dense[d].dtype) {
-          case DT_INT64: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseInt64List(&out.int64_list)) {
-                return parse_error();
-              }
-              if (out.int64_list.size() % num_elements != 0) {
-                return shape_error(out.int64_list.size(), "int64");
-              }
-            }
-            out.example_end_indices.push_back(out.int64_list.size());
-            break;
-          }
-          case DT_FLOAT: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseFloatList(&out.float_list)) {
-                return parse_error();
-              }
-              if (out.float_list.size() % num_elements != 0) {
-                return shape_error(out.float_list.size(), "float");
-              }
-            }
-            out.example_end_indices.push_back(out.float_list.size());
-            break;
-          }
-          case DT_STRING: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseBytesList(&out.bytes_list)) {
-                return parse_error();
-              }
-              if (out.bytes_list.size() % num_elements != 0) {
-                return shape_error(out.bytes_list.size(), "bytes");
-              }
-            }
-            out.example_end_indices.push_back(out.bytes_list.size());
-            break;
-          }
-          default:
-            LOG(FATAL) << "Should not happen.";
         }
+        out.features[example_index] = feature;
+        out.num_values[example_index] = num_values;
 
         if (output_stats) {
-          // Use `out.example_end_indices` to determine the feature-value count
-          // for this feature, because the preceding switch statement pushes
-          // the length of the appropriate feature list to that vector.
           // TODO(b/111553342): If desirable, we could add support for counting
           // elements in the features that aren't parsed, but this could add
           // considerable runtime cost.
-          const size_t out_examples_count = out.example_end_indices.size();
-          if (out_examples_count == 1) {
-            output_stats->feature_values_count += out.example_end_indices[0];
-          } else {
-            output_stats->feature_values_count +=
-                out.example_end_indices[out_examples_count - 1] -
-                out.example_end_indices[out_examples_count - 2];
-          }
+          output_stats->feature_values_count += num_values;
         }
       }
     } else {
@@ -765,7 +886,7 @@ Status FastParseSerializedExample(
       sparse_feature_last_example[d] = example_index;
 
       // Handle sparse features.
-      SparseBuffer& out = (*output_sparse)[d];
+      VarLenFeatureValues& out = (*output_sparse)[d];
       if (example_dtype != DT_INVALID &&
           example_dtype != config.sparse[d].dtype) {
         return example_error(strings::StrCat(
@@ -774,53 +895,18 @@ Status FastParseSerializedExample(
             ", Actual type: ", DataTypeString(example_dtype)));
       }
 
-      switch (config.sparse[d].dtype) {
-        case DT_INT64: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseInt64List(&out.int64_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.int64_list.size());
-          break;
-        }
-        case DT_FLOAT: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseFloatList(&out.float_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.float_list.size());
-          break;
-        }
-        case DT_STRING: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseBytesList(&out.bytes_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.bytes_list.size());
-          break;
-        }
-        default:
-          LOG(FATAL) << "Should not happen.";
+      int num_values = 0;
+      if (!CountFeatureValues(example_dtype, &feature, &num_values)) {
+        return parse_error();
       }
+      out.features[example_index] = feature;
+      out.num_values[example_index] = num_values;
 
       if (output_stats) {
-        // Use `out.example_end_indices` to determine the feature-value count
-        // for this feature, because the preceding switch statement pushes
-        // the length of the appropriate feature list to that vector.
         // TODO(b/111553342): If desirable, we could add support for counting
         // elements in the features that aren't parsed, but this could add
         // considerable runtime cost.
-        const size_t out_examples_count = out.example_end_indices.size();
-        if (out_examples_count == 1) {
-          output_stats->feature_values_count += out.example_end_indices[0];
-        } else {
-          output_stats->feature_values_count +=
-              out.example_end_indices[out_examples_count - 1] -
-              out.example_end_indices[out_examples_count - 2];
-        }
+        output_stats->feature_values_count += num_values;
       }
     }
   }
@@ -861,25 +947,8 @@ Status FastParseSerializedExample(
     }
   }
 
-  // Handle missing varlen dense features.
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    if (!config.dense[d].variable_length) continue;
-    if (dense_feature_last_example[d] == example_index) continue;
-    SparseBuffer& out = (*output_varlen_dense)[d];
-    size_t prev_example_end_index =
-        out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
-    out.example_end_indices.push_back(prev_example_end_index);
-  }
-
-  // Handle missing sparse features.
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    if (sparse_feature_last_example[d] == example_index) continue;
-    SparseBuffer& out = (*output_sparse)[d];
-    size_t prev_example_end_index =
-        out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
-    out.example_end_indices.push_back(prev_example_end_index);
-  }
-
+  // Missing varlen dense and sparse features have no values, and are padded
+  // or skipped when the values are filled in.
   return Status::OK();
 }
 
@@ -896,72 +965,152 @@ Status CheckConfigDataType(DataType dtype) {
 }
 
 template <typename T>
-const SmallVector<T>& GetListFromBuffer(const SparseBuffer& buffer);
+void CopyOrMoveBlock(const T* b, const T* e, T* t) {
+  std::copy(b, e, t);
+}
+template <>
+void CopyOrMoveBlock(const string* b, const string* e, string* t) {
+  std::move(b, e, t);
+}
+
+template <typename T>
+bool ParseValues(parsed::Feature* feature, LimitedArraySlice<T>* values);
 
 template <>
-const SmallVector<int64>& GetListFromBuffer<int64>(const SparseBuffer& buffer) {
-  return buffer.int64_list;
+bool ParseValues<int64>(parsed::Feature* feature,
+                        LimitedArraySlice<int64>* values) {
+  return feature->ParseInt64List(values);
 }
 template <>
-const SmallVector<float>& GetListFromBuffer<float>(const SparseBuffer& buffer) {
-  return buffer.float_list;
+bool ParseValues<float>(parsed::Feature* feature,
+                        LimitedArraySlice<float>* values) {
+  return feature->ParseFloatList(values);
 }
 template <>
-const SmallVector<string>& GetListFromBuffer<string>(
-    const SparseBuffer& buffer) {
-  return buffer.bytes_list;
+bool ParseValues<string>(parsed::Feature* feature,
+                         LimitedArraySlice<string>* values) {
+  return feature->ParseBytesList(values);
 }
 
+// Parses the `num_values` values of `feature` into `out`, which has exactly
+// that much room.
 template <typename T>
-void CopyOrMoveBlock(const T* b, const T* e, T* t) {
-  std::copy(b, e, t);
+bool ParseValuesInto(parsed::Feature feature, size_t num_values, T* out) {
+  if (feature.GetSerialized().empty()) return num_values == 0;
+  LimitedArraySlice<T> slice(out, num_values);
+  return ParseValues(&feature, &slice) && slice.EndDistance() == 0;
 }
-template <>
-void CopyOrMoveBlock(const string* b, const string* e, string* t) {
-  std::move(b, e, t);
+
+// Parses the values of a variable length dense feature of an example into
+// its row of the batched output, padding the rest of the row with the default
+// value.
+template <typename T>
+bool FillVarLenDenseRow(const VarLenFeatureValues& values,
+                        const size_t example_index, const size_t row_size,
+                        const Tensor& default_value, Tensor* out) {
+  const size_t num_values = values.num_values[example_index];
+  T* row = out->flat<T>().data() + example_index * row_size;
+  if (!ParseValuesInto(values.features[example_index], num_values, row)) {
+    return false;
+  }
+  std::fill(row + num_values, row + row_size, default_value.flat<T>()(0));
+  return true;
 }
 
+// Parses the values of a sparse feature of an example into its slice of the
+// batched values, and writes their indices.
 template <typename T>
-void FillAndCopyVarLen(
-    const int d, const size_t num_elements,
-    const size_t num_elements_per_minibatch, const Config& config,
-    const std::vector<std::vector<SparseBuffer>>& varlen_dense_buffers,
-    Tensor* values) {
-  const Tensor& default_value = config.dense[d].default_value;
-
-  // Copy-fill the tensors (creating the zero/fill-padding)
-  std::fill(values->flat<T>().data(), values->flat<T>().data() + num_elements,
-            default_value.flat<T>()(0));
-
-  // Data is [batch_size, max_num_elements, data_stride_size]
-  //   and num_elements_per_minibatch = max_num_elements * data_stride_size
-  auto data = values->flat<T>().data();
-
-  // Iterate over minibatch elements
-  for (size_t i = 0; i < varlen_dense_buffers.size(); ++i) {
-    const SparseBuffer& buffer = varlen_dense_buffers[i][d];
-    // Number of examples being stored in this buffer
-    const auto& end_indices = buffer.example_end_indices;
-    const size_t examples_in_buffer = end_indices.size();
-    // const size_t stride_size = config.dense[d].elements_per_stride;
-
-    const auto& list = GetListFromBuffer<T>(buffer);
-    auto list_ptr = list.begin();
-
-    size_t elements_tally = 0;
-    // Iterate through all the examples stored in this buffer.
-    for (size_t j = 0; j < examples_in_buffer; ++j) {
-      // Number of elements stored for this example.
-      const size_t num_elems = end_indices[j] - elements_tally;
-      CopyOrMoveBlock(list_ptr, list_ptr + num_elems, data);
-      // Move forward this many elements in the varlen buffer.
-      list_ptr += num_elems;
-      // Move forward to the next minibatch entry in the values output.
-      data += num_elements_per_minibatch;
-      elements_tally = end_indices[j];
+bool FillSparseValues(const VarLenFeatureValues& values,
+                      const size_t example_index, Tensor* out_indices,
+                      Tensor* out_values) {
+  const size_t num_values = values.num_values[example_index];
+  const size_t offset = values.offsets[example_index];
+  if (num_values > 0) {
+    int64* ix_p = &out_indices->matrix<int64>()(offset, 0);
+    for (size_t i = 0; i < num_values; ++i) {
+      // Column 0: example index
+      *ix_p = example_index;
+      // Column 1: the feature index within the example
+      *(ix_p + 1) = i;
+      ix_p += 2;
+    }
+  }
+  return ParseValuesInto(values.features[example_index], num_values,
+                         out_values->flat<T>().data() + offset);
+}
+
+// Parses the values of the variable length dense and sparse features of an
+// example, located by FastParseSerializedExample, into the outputs of `result`
+// allocated for the whole batch.
+Status FillVarLenValues(
+    const string& example_name, const size_t example_index,
+    const Config& config,
+    const std::vector<VarLenFeatureValues>& varlen_dense_values,
+    const std::vector<VarLenFeatureValues>& sparse_values, Result* result) {
+  auto parse_error = [&](const string& feature_name) {
+    return errors::InvalidArgument("Name: ", example_name,
+                                   ", Key: ", feature_name,
+                                   ", Index: ", example_index,
+                                   ".  Can't parse serialized Example.");
+  };
+
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    if (!config.dense[d].variable_length) continue;
+    Tensor* out = &result->dense_values[d];
+    // Nothing to write.
+    if (out->NumElements() == 0) continue;
+    const size_t row_size = out->NumElements() / out->dim_size(0);
+    const Tensor& default_value = config.dense[d].default_value;
+    bool ok = false;
+    switch (config.dense[d].dtype) {
+      case DT_INT64: {
+        ok = FillVarLenDenseRow<int64>(varlen_dense_values[d], example_index,
+                                       row_size, default_value, out);
+        break;
+      }
+      case DT_FLOAT: {
+        ok = FillVarLenDenseRow<float>(varlen_dense_values[d], example_index,
+                                       row_size, default_value, out);
+        break;
+      }
+      case DT_STRING: {
+        ok = FillVarLenDenseRow<string>(varlen_dense_values[d], example_index,
+                                        row_size, default_value, out);
+        break;
+      }
+      default:
+        LOG(FATAL) << "Should not happen.";
+    }
+    if (!ok) return parse_error(config.dense[d].feature_name);
+  }
+
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
+    Tensor* out_indices = &result->sparse_indices[d];
+    Tensor* out_values = &result->sparse_values[d];
+    bool ok = false;
+    switch (config.sparse[d].dtype) {
+      case DT_INT64: {
+        ok = FillSparseValues<int64>(sparse_values[d], example_index,
+                                     out_indices, out_values);
+        break;
+      }
+      case DT_FLOAT: {
+        ok = FillSparseValues<float>(sparse_values[d], example_index,
+                                     out_indices, out_values);
+        break;
+      }
+      case DT_STRING: {
+        ok = FillSparseValues<string>(sparse_values[d], example_index,
+                                      out_indices, out_values);
+        break;
+      }
+      default:
+        LOG(FATAL) << "Should not happen.";
     }
-    DCHECK(elements_tally == list.size());
+    if (!ok) return parse_error(config.sparse[d].feature_name);
   }
+
+  return Status::OK();
 }
 
 // Thin vector like interface wrapper around a Tensor. This enable us to
@@ -1093,13 +1242,22 @@ Status FastParseExample(const Config& config,
   //   in small batches.
   //   Maybe accept outside parameter #num_minibatches?
 
-  // Do minibatches in parallel.
-  std::vector<std::vector<SparseBuffer>> sparse_buffers(num_minibatches);
-  std::vector<std::vector<SparseBuffer>> varlen_dense_buffers(num_minibatches);
+  // Do minibatches in parallel, in two passes. The first pass parses the
+  // fixed length dense features into their outputs, and locates and counts
+  // the values of the variable length dense and sparse features. Once the
+  // shapes of their outputs are known, the second pass parses their values
+  // directly into the outputs.
+  const size_t batch_size = serialized.size();
+  std::vector<VarLenFeatureValues> varlen_dense_values;
+  varlen_dense_values.reserve(config.dense.size());
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    varlen_dense_values.emplace_back(
+        config.dense[d].variable_length ? batch_size : 0);
+  }
+  std::vector<VarLenFeatureValues> sparse_values(
+      config.sparse.size(), VarLenFeatureValues(batch_size));
   std::vector<Status> status_of_minibatch(num_minibatches);
   auto ProcessMiniBatch = [&](size_t minibatch) {
-    sparse_buffers[minibatch].resize(config.sparse.size());
-    varlen_dense_buffers[minibatch].resize(config.dense.size());
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
     for (size_t e = start; e < end; ++e) {
@@ -1110,8 +1268,8 @@ Status FastParseExample(const Config& config,
       status_of_minibatch[minibatch] = FastParseSerializedExample(
           serialized[e],
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
-          config_index, hasher, &fixed_dense_values,
-          &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch], stats);
+          config_index, hasher, &fixed_dense_values, &varlen_dense_values,
+          &sparse_values, stats);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
@@ -1126,147 +1284,75 @@ Status FastParseExample(const Config& config,
     result->dense_values.push_back(std::move(fixed_dense_values[d]));
   }
 
-  // Merge SparseBuffers from all minibatches for every config.sparse.
-  auto MergeSparseMinibatches = [&](size_t d) {
-    // Loop over minibatches
+  // Allocate the outputs of every config.dense having variable_length, padded
+  // to the largest number of values in the batch.
+  bool has_varlen_values = !config.sparse.empty();
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    if (!config.dense[d].variable_length) continue;
+    has_varlen_values = true;
+    const std::vector<size_t>& num_values = varlen_dense_values[d].num_values;
+    const size_t max_num_features =
+        num_values.empty()
+            ? 0
+            : *std::max_element(num_values.begin(), num_values.end());
+
+    const size_t stride_size = config.dense[d].elements_per_stride;
+    const size_t max_num_elements = max_num_features / stride_size;
+    TensorShape values_shape;
+    DCHECK_EQ(max_num_features % stride_size, 0);
+    values_shape.AddDim(batch_size);
+    values_shape.AddDim(max_num_elements);
+    for (int i = 1; i < config.dense[d].shape.dims(); ++i) {
+      values_shape.AddDim(config.dense[d].shape.dim_size(i));
+    }
+    result->dense_values[d] = Tensor(config.dense[d].dtype, values_shape);
+  }
+
+  // Allocate the outputs of every config.sparse, and assign each example its
+  // slice of the values.
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
+    VarLenFeatureValues& values = sparse_values[d];
+    values.offsets.resize(batch_size);
     size_t total_num_features = 0;
     size_t max_num_features = 0;
-    for (auto& sparse_values_tmp : sparse_buffers) {
-      const std::vector<size_t>& end_indices =
-          sparse_values_tmp[d].example_end_indices;
-      total_num_features += end_indices.back();
-      max_num_features = std::max(max_num_features, end_indices[0]);
-      for (size_t i = 1; i < end_indices.size(); ++i) {
-        size_t example_size = end_indices[i] - end_indices[i - 1];
-        max_num_features = std::max(max_num_features, example_size);
-      }
+    for (size_t e = 0; e < batch_size; ++e) {
+      values.offsets[e] = total_num_features;
+      total_num_features += values.num_values[e];
+      max_num_features = std::max(max_num_features, values.num_values[e]);
     }
 
     TensorShape indices_shape;
     indices_shape.AddDim(total_num_features);
     indices_shape.AddDim(2);
     result->sparse_indices.emplace_back(DT_INT64, indices_shape);
-    Tensor* indices = &result->sparse_indices.back();
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
     result->sparse_values.emplace_back(config.sparse[d].dtype, values_shape);
-    Tensor* values = &result->sparse_values.back();
 
     result->sparse_shapes.emplace_back(DT_INT64, TensorShape({2}));
     auto shapes_shape_t = result->sparse_shapes.back().vec<int64>();
-    shapes_shape_t(0) = serialized.size();
+    shapes_shape_t(0) = batch_size;
     shapes_shape_t(1) = max_num_features;
+  }
 
-    size_t offset = 0;
-    for (size_t i = 0; i < sparse_buffers.size(); ++i) {
-      const SparseBuffer& buffer = sparse_buffers[i][d];
-
-      // Update indices.
-      int64* ix_p = &indices->matrix<int64>()(offset, 0);
-      size_t delta = 0;
-      size_t example_index = first_example_of_minibatch(i);
-      for (size_t example_end_index : buffer.example_end_indices) {
-        size_t feature_index = 0;
-        for (; delta < example_end_index; ++delta) {
-          // Column 0: example index
-          *ix_p = example_index;
-          // Column 1: the feature index buffer example
-          *(ix_p + 1) = feature_index;
-          ix_p += 2;
-          ++feature_index;
-        }
-        ++example_index;
-      }
-
-      // Copy values over.
-      switch (config.sparse[d].dtype) {
-        case DT_INT64: {
-          std::copy(buffer.int64_list.begin(), buffer.int64_list.end(),
-                    values->flat<int64>().data() + offset);
-          break;
-        }
-        case DT_FLOAT: {
-          std::copy(buffer.float_list.begin(), buffer.float_list.end(),
-                    values->flat<float>().data() + offset);
-          break;
-        }
-        case DT_STRING: {
-          std::move(buffer.bytes_list.begin(), buffer.bytes_list.end(),
-                    values->flat<string>().data() + offset);
-          break;
-        }
-        default:
-          LOG(FATAL) << "Should not happen.";
-      }
-
-      offset += delta;
-    }
-  };
-
-  // Merge SparseBuffers from all minibatches for every config.dense having
-  // variable_length.
-  auto MergeDenseVarLenMinibatches = [&](size_t d) {
-    if (!config.dense[d].variable_length) return;
-
-    // Loop over minibatches
-    size_t max_num_features = 0;
-    for (auto& dense_values_tmp : varlen_dense_buffers) {
-      std::vector<size_t>& end_indices =
-          dense_values_tmp[d].example_end_indices;
-      max_num_features = std::max(max_num_features, end_indices[0]);
-      for (size_t i = 1; i < end_indices.size(); ++i) {
-        size_t example_size = end_indices[i] - end_indices[i - 1];
-        max_num_features = std::max(max_num_features, example_size);
-      }
-    }
-
-    const size_t stride_size = config.dense[d].elements_per_stride;
-    const size_t max_num_elements = max_num_features / stride_size;
-    TensorShape values_shape;
-    DCHECK_EQ(max_num_features % config.dense[d].elements_per_stride, 0);
-    const size_t batch_size = serialized.size();
-    values_shape.AddDim(batch_size);
-    values_shape.AddDim(max_num_elements);
-    for (int i = 1; i < config.dense[d].shape.dims(); ++i) {
-      values_shape.AddDim(config.dense[d].shape.dim_size(i));
-    }
-    Tensor values(config.dense[d].dtype, values_shape);
-    result->dense_values[d] = values;
-    const size_t num_elements = values.NumElements();
-
-    // Nothing to write, exit early.
-    if (num_elements == 0) return;
-
-    const size_t num_elements_per_minibatch = num_elements / batch_size;
+  if (!has_varlen_values) return Status::OK();
 
-    switch (config.dense[d].dtype) {
-      case DT_INT64: {
-        FillAndCopyVarLen<int64>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
-      }
-      case DT_FLOAT: {
-        FillAndCopyVarLen<float>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
-      }
-      case DT_STRING: {
-        FillAndCopyVarLen<string>(d, num_elements, num_elements_per_minibatch,
-                                  config, varlen_dense_buffers, &values);
-        break;
-      }
-      default:
-        LOG(FATAL) << "Should not happen.";
+  auto FillMiniBatch = [&](size_t minibatch) {
+    size_t start = first_example_of_minibatch(minibatch);
+    size_t end = first_example_of_minibatch(minibatch + 1);
+    for (size_t e = start; e < end; ++e) {
+      status_of_minibatch[minibatch] = FillVarLenValues(
+          (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
+          varlen_dense_values, sparse_values, result);
+      if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
 
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    MergeDenseVarLenMinibatches(d);
-  }
+  ParallelFor(FillMiniBatch, num_minibatches, thread_pool);
 
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    MergeSparseMinibatches(d);
+  for (Status& status : status_of_minibatch) {
+    TF_RETURN_IF_ERROR(status);
   }
 
   return Status::OK();
@@ -321,6 +321,92 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+TEST(TestFastParseExample, VarLenAndSparseBatch) {
+  // Values that need one to ten bytes as varints, and runs of small values.
+  const std::vector<std::vector<int64>> int64_values = {
+      {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12},
+      {},
+      {-1, 300, 1LL << 40, 127, 128, 0},
+      {42}};
+  const std::vector<std::vector<float>> float_values = {
+      {1.5}, {}, {2.5, -3.5, 4.5}, {}};
+  std::vector<string> serialized;
+  for (size_t i = 0; i < int64_values.size(); ++i) {
+    Example example;
+    auto& features = *example.mutable_features()->mutable_feature();
+    for (int64 value : int64_values[i]) {
+      features["int64_list"].mutable_int64_list()->add_value(value);
+    }
+    for (float value : float_values[i]) {
+      features["float_list"].mutable_float_list()->add_value(value);
+    }
+    serialized.push_back(Serialize(example));
+  }
+
+  FastParseExampleConfig config;
+  AddDenseFeature("int64_list", DT_INT64, {-1}, true, 1, &config);
+  config.dense.back().default_value = Tensor(int64{-7});
+  AddSparseFeature("float_list", DT_FLOAT, &config);
+  AddSparseFeature("int64_list", DT_INT64, &config);
+
+  Result result;
+  TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr, &result));
+
+  const Tensor& dense = result.dense_values[0];
+  ASSERT_EQ(TensorShape({4, 12}), dense.shape());
+  for (size_t i = 0; i < int64_values.size(); ++i) {
+    for (size_t j = 0; j < 12; ++j) {
+      const int64 expected =
+          j < int64_values[i].size() ? int64_values[i][j] : -7;
+      EXPECT_EQ(expected, dense.matrix<int64>()(i, j));
+    }
+  }
+
+  for (int d = 0; d < 2; ++d) {
+    std::vector<std::pair<int64, int64>> expected_indices;
+    std::vector<double> expected_values;
+    size_t max_num_values = 0;
+    for (size_t i = 0; i < int64_values.size(); ++i) {
+      const size_t num_values =
+          d == 0 ? float_values[i].size() : int64_values[i].size();
+      max_num_values = std::max(max_num_values, num_values);
+      for (size_t j = 0; j < num_values; ++j) {
+        expected_indices.emplace_back(i, j);
+        expected_values.push_back(d == 0 ? float_values[i][j]
+                                         : int64_values[i][j]);
+      }
+    }
+    const Tensor& indices = result.sparse_indices[d];
+    const Tensor& values = result.sparse_values[d];
+    ASSERT_EQ(expected_values.size(), values.NumElements());
+    for (size_t k = 0; k < expected_values.size(); ++k) {
+      EXPECT_EQ(expected_indices[k].first, indices.matrix<int64>()(k, 0));
+      EXPECT_EQ(expected_indices[k].second, indices.matrix<int64>()(k, 1));
+      EXPECT_EQ(expected_values[k], d == 0 ? values.flat<float>()(k)
+                                           : values.flat<int64>()(k));
+    }
+    EXPECT_EQ(4, result.sparse_shapes[d].vec<int64>()(0));
+    EXPECT_EQ(max_num_values, result.sparse_shapes[d].vec<int64>()(1));
+  }
+}
+
+TEST(TestFastParseExample, TruncatedPackedInt64) {
+  // An example whose int64 feature ends in the middle of a varint.
+  Example example;
+  (*example.mutable_features()->mutable_feature())["int64_list"]
+      .mutable_int64_list()
+      ->add_value(300);
+  string serialized = Serialize(example);
+  // The last byte is the second byte of the varint; make it a continuation.
+  serialized.back() |= 0x80;
+
+  FastParseExampleConfig config;
+  AddSparseFeature("int64_list", DT_INT64, &config);
+  Result result;
+  Status status = FastParseExample(config, {serialized}, {}, nullptr, &result);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -15,13 +15,91 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <algorithm>
+#include <tuple>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
 /* ABSL_CONST_INIT */ thread_local int per_thread_max_parallism = 1000000;
 
+/* ABSL_CONST_INIT */ thread_local AdaptiveShardCost* per_thread_shard_cost =
+    nullptr;
+
+namespace {
+
+// If total * cost_per_unit is small, it is not worth shard too
+// much. Let us assume each cost unit is 1ns, kMinCostPerShard=10000
+// is 10us.
+const int64 kMinCostPerShard = 10000;
+
+// Runs "work" over [0, total) in "num_shards" shards of equal size, the first
+// one on the calling thread and the others through "runner".
+void RunShards(int num_shards, int64 total, const Sharder::Work& work,
+               const Sharder::Runner& runner) {
+  // Each shard contains up to "block_size" units. [0, total) is sharded
+  // into:
+  //   [0, block_size), [block_size, 2*block_size), ...
+  // The 1st shard is done by the caller thread and the other shards
+  // are dispatched to the worker threads. The last shard may be smaller than
+  // block_size.
+  const int64 block_size = (total + num_shards - 1) / num_shards;
+  CHECK_GT(block_size, 0);  // total > 0 guarantees this.
+  if (block_size >= total) {
+    work(0, total);
+    return;
+  }
+  const int num_shards_used = (total + block_size - 1) / block_size;
+  BlockingCounter counter(num_shards_used - 1);
+  for (int64 start = block_size; start < total; start += block_size) {
+    auto limit = std::min(start + block_size, total);
+    runner([&work, &counter, start, limit]() {
+      work(start, limit);        // Compute the shard.
+      counter.DecrementCount();  // The shard is done.
+    });
+  }
+
+  // Inline execute the 1st shard.
+  work(0, std::min(block_size, total));
+  counter.Wait();
+}
+
+void ShardAdaptively(AdaptiveShardCost* cost, int max_parallelism,
+                     thread::ThreadPool* workers, int64 total,
+                     int64 cost_per_unit,
+                     const std::function<void(int64, int64)>& work) {
+  double nsec_per_unit = cost->nsec_per_unit();
+  if (nsec_per_unit < 0) {
+    nsec_per_unit = std::max(int64{1}, cost_per_unit);
+  }
+  const int num_shards = static_cast<int>(std::max(
+      1.0, std::min<double>(max_parallelism,
+                            total * nsec_per_unit / kMinCostPerShard)));
+  const Sharder::Runner runner = [workers](Sharder::Closure c) {
+    workers->Schedule(std::move(c));
+  };
+  if (!cost->StartCall()) {
+    RunShards(num_shards, total, work, runner);
+    return;
+  }
+  std::atomic<int64> elapsed_nsec(0);
+  Env* env = cost->env();
+  RunShards(num_shards, total,
+            [&work, &elapsed_nsec, env](int64 start, int64 limit) {
+              const uint64 start_nsec = env->NowNanos();
+              work(start, limit);
+              elapsed_nsec.fetch_add(env->NowNanos() - start_nsec,
+                                     std::memory_order_relaxed);
+            },
+            runner);
+  cost->RecordMeasurement(total, elapsed_nsec.load());
+}
+
+}  // namespace
+
 void SetPerThreadMaxParallelism(int max_parallelism) {
   CHECK_LE(0, max_parallelism);
   per_thread_max_parallism = max_parallelism;
@@ -36,6 +114,11 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
     return;
   }
   max_parallelism = std::min(max_parallelism, GetPerThreadMaxParallelism());
+  if (per_thread_shard_cost != nullptr) {
+    ShardAdaptively(per_thread_shard_cost, max_parallelism, workers, total,
+                    cost_per_unit, work);
+    return;
+  }
   if (max_parallelism <= 1) {
     // Just inline the whole work since we only have 1 thread (core).
     work(0, total);
@@ -57,40 +140,76 @@ void Sharder::Do(int64 total, int64 cost_per_unit, const Work& work,
   cost_per_unit = std::max(int64{1}, cost_per_unit);
   // We shard [0, total) into "num_shards" shards.
   //   1 <= num_shards <= num worker threads
-  //
-  // If total * cost_per_unit is small, it is not worth shard too
-  // much. Let us assume each cost unit is 1ns, kMinCostPerShard=10000
-  // is 10us.
-  static const int64 kMinCostPerShard = 10000;
   const int num_shards =
       std::max<int>(1, std::min(static_cast<int64>(max_parallelism),
                                 total * cost_per_unit / kMinCostPerShard));
+  RunShards(num_shards, total, work, runner);
+}
 
-  // Each shard contains up to "block_size" units. [0, total) is sharded
-  // into:
-  //   [0, block_size), [block_size, 2*block_size), ...
-  // The 1st shard is done by the caller thread and the other shards
-  // are dispatched to the worker threads. The last shard may be smaller than
-  // block_size.
-  const int64 block_size = (total + num_shards - 1) / num_shards;
-  CHECK_GT(block_size, 0);  // total > 0 guarantees this.
-  if (block_size >= total) {
-    work(0, total);
-    return;
-  }
-  const int num_shards_used = (total + block_size - 1) / block_size;
-  BlockingCounter counter(num_shards_used - 1);
-  for (int64 start = block_size; start < total; start += block_size) {
-    auto limit = std::min(start + block_size, total);
-    runner([&work, &counter, start, limit]() {
-      work(start, limit);        // Compute the shard.
-      counter.DecrementCount();  // The shard is done.
-    });
+AdaptiveShardCost::AdaptiveShardCost() : env_(Env::Default()) {}
+
+AdaptiveShardCost::AdaptiveShardCost(Env* env) : env_(env) {}
+
+bool AdaptiveShardCost::StartCall() {
+  const int64 call = num_calls_.fetch_add(1, std::memory_order_relaxed);
+  return num_measured_calls() < kMinMeasuredCalls ||
+         call % kMeasurementPeriod == 0;
+}
+
+void AdaptiveShardCost::RecordMeasurement(int64 total, int64 elapsed_nsec) {
+  const double sample = static_cast<double>(elapsed_nsec) / total;
+  const int64 num_measured =
+      num_measured_calls_.fetch_add(1, std::memory_order_relaxed);
+  // Concurrent updates may lose a sample, which the average can afford.
+  const double previous = nsec_per_unit_.load(std::memory_order_relaxed);
+  nsec_per_unit_.store(
+      num_measured == 0 ? sample : previous + (sample - previous) / 8,
+      std::memory_order_relaxed);
+}
+
+AdaptiveShardCostRegistry* AdaptiveShardCostRegistry::Global() {
+  static AdaptiveShardCostRegistry* registry = new AdaptiveShardCostRegistry;
+  return registry;
+}
+
+void AdaptiveShardCostRegistry::Register(const string& kernel_name,
+                                         const string& op_type, DataType dtype,
+                                         const AdaptiveShardCost* cost) {
+  mutex_lock l(mu_);
+  costs_[cost] = {kernel_name, op_type, dtype};
+}
+
+void AdaptiveShardCostRegistry::Unregister(const AdaptiveShardCost* cost) {
+  mutex_lock l(mu_);
+  costs_.erase(cost);
+}
+
+std::vector<AdaptiveShardCostRegistry::Entry>
+AdaptiveShardCostRegistry::GetEntries() const {
+  std::vector<Entry> entries;
+  {
+    mutex_lock l(mu_);
+    for (const auto& it : costs_) {
+      entries.push_back({it.second.kernel_name, it.second.op_type,
+                         it.second.dtype, it.first->num_calls(),
+                         it.first->nsec_per_unit()});
+    }
   }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return std::tie(a.kernel_name, a.op_type, a.dtype) <
+                     std::tie(b.kernel_name, b.op_type, b.dtype);
+            });
+  return entries;
+}
 
-  // Inline execute the 1st shard.
-  work(0, std::min(block_size, total));
-  counter.Wait();
+ScopedAdaptiveShardCost::ScopedAdaptiveShardCost(AdaptiveShardCost* cost)
+    : previous_(per_thread_shard_cost) {
+  per_thread_shard_cost = cost;
+}
+
+ScopedAdaptiveShardCost::~ScopedAdaptiveShardCost() {
+  per_thread_shard_cost = previous_;
 }
 
 }  // end namespace tensorflow
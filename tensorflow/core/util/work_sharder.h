@@ -16,9 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
+#include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -50,6 +57,10 @@ namespace tensorflow {
 // call SetMaxParallelism() so that all Shard() calls later limits the
 // thread parallelism.
 //
+// If an AdaptiveShardCost is installed on the calling thread by a
+// ScopedAdaptiveShardCost, "cost_per_unit" is only used until the cost of
+// the work has been measured; see AdaptiveShardCost.
+//
 // REQUIRES: max_parallelism >= 0
 // REQUIRES: workers != nullptr
 // REQUIRES: total >= 0
@@ -82,6 +93,106 @@ class ScopedPerThreadMaxParallelism {
   int previous_ = -1;
 };
 
+// The cost of a unit of work of one kind of Shard() call, e.g. those made by
+// one kernel, measured at runtime.
+//
+// While a ScopedAdaptiveShardCost installs it on a thread, the Shard() calls
+// of that thread time their shards: every call until kMinMeasuredCalls were
+// measured, then one call in kMeasurementPeriod.  Once the cost is known,
+// they pick the number of shards from the measured cost instead of the
+// caller's estimate, so that each shard costs at least as much as waking up
+// a thread.
+//
+// This class is thread safe.
+class AdaptiveShardCost {
+ public:
+  static const int64 kMinMeasuredCalls = 4;
+  static const int64 kMeasurementPeriod = 16;
+
+  // Times the shards with Env::Default()->NowNanos().
+  AdaptiveShardCost();
+  // Times the shards with env->NowNanos().  "env" must outlive this object.
+  explicit AdaptiveShardCost(Env* env);
+
+  // Returns the measured cost of a unit of work in nanoseconds, or -1 if
+  // fewer than kMinMeasuredCalls calls were measured.
+  double nsec_per_unit() const {
+    if (num_measured_calls() < kMinMeasuredCalls) return -1;
+    return nsec_per_unit_.load(std::memory_order_relaxed);
+  }
+
+  int64 num_calls() const { return num_calls_.load(std::memory_order_relaxed); }
+  int64 num_measured_calls() const {
+    return num_measured_calls_.load(std::memory_order_relaxed);
+  }
+
+  Env* env() const { return env_; }
+
+  // Counts a call and returns true if it should be measured.
+  bool StartCall();
+
+  // Records that "total" units of work took "elapsed_nsec" nanoseconds,
+  // summed over all shards.
+  void RecordMeasurement(int64 total, int64 elapsed_nsec);
+
+ private:
+  Env* const env_;
+  std::atomic<int64> num_calls_{0};
+  std::atomic<int64> num_measured_calls_{0};
+  // A moving average over the measured calls.
+  std::atomic<double> nsec_per_unit_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveShardCost);
+};
+
+// The live AdaptiveShardCosts of the process, which can be inspected to see
+// what the kernels actually cost.
+class AdaptiveShardCostRegistry {
+ public:
+  static AdaptiveShardCostRegistry* Global();
+
+  // Adds "cost", the cost of the Shard() calls of the kernel "kernel_name"
+  // of "op_type" and "dtype".  "cost" must be unregistered before it is
+  // deleted.
+  void Register(const string& kernel_name, const string& op_type,
+                DataType dtype, const AdaptiveShardCost* cost);
+  void Unregister(const AdaptiveShardCost* cost);
+
+  struct Entry {
+    string kernel_name;
+    string op_type;
+    DataType dtype;
+    int64 num_calls;
+    // -1 if not measured yet.
+    double nsec_per_unit;
+  };
+  // Returns the current costs, sorted by kernel name, op type and dtype.
+  std::vector<Entry> GetEntries() const;
+
+ private:
+  struct Key {
+    string kernel_name;
+    string op_type;
+    DataType dtype;
+  };
+
+  mutable mutex mu_;
+  std::unordered_map<const AdaptiveShardCost*, Key> costs_ GUARDED_BY(mu_);
+};
+
+// Installs "cost", which may be null, as the AdaptiveShardCost of the
+// Shard() calls made by the current thread while in scope.
+class ScopedAdaptiveShardCost {
+ public:
+  explicit ScopedAdaptiveShardCost(AdaptiveShardCost* cost);
+  ~ScopedAdaptiveShardCost();
+
+ private:
+  AdaptiveShardCost* const previous_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedAdaptiveShardCost);
+};
+
 // Implementation details for Shard().
 class Sharder {
  public:
@@ -18,6 +18,7 @@ limitations under the License.
 #include <atomic>
 #include <vector>
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
@@ -89,6 +90,82 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+// An Env whose clock advances by kStepNsec on every reading, separately on
+// each thread, so that every shard seems to take kStepNsec.
+class FakeClockEnv : public EnvWrapper {
+ public:
+  static const uint64 kStepNsec = 1000;
+
+  FakeClockEnv() : EnvWrapper(Env::Default()) {}
+
+  uint64 NowNanos() const override {
+    static thread_local uint64 now_nsec = 0;
+    return now_nsec += kStepNsec;
+  }
+};
+
+TEST(Shard, Adaptive) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  FakeClockEnv env;
+  AdaptiveShardCost cost(&env);
+  ScopedAdaptiveShardCost scoped(&cost);
+  // Work that claims to be expensive is split in 16 shards while its cost is
+  // unknown.  Each of them seems to take 1us, i.e. 16ns per unit, which is
+  // too cheap to split once it is measured.
+  const int64 total = 1000;
+  for (int i = 0; i < 2 * AdaptiveShardCost::kMeasurementPeriod; ++i) {
+    std::atomic<int64> num_shards(0);
+    std::atomic<int64> num_done_work(0);
+    Shard(16, &threads, total, 1000000,
+          [&num_shards, &num_done_work](int64 start, int64 limit) {
+            ++num_shards;
+            num_done_work += limit - start;
+          });
+    EXPECT_EQ(total, num_done_work.load());
+    if (i < AdaptiveShardCost::kMinMeasuredCalls) {
+      EXPECT_EQ(16, num_shards.load());
+    } else {
+      EXPECT_EQ(1, num_shards.load());
+    }
+    if (i == AdaptiveShardCost::kMinMeasuredCalls - 1) {
+      EXPECT_EQ(16, cost.nsec_per_unit());
+    }
+  }
+  EXPECT_EQ(2 * AdaptiveShardCost::kMeasurementPeriod, cost.num_calls());
+  // The 16th call was measured again, with a single shard of 1ns per unit.
+  EXPECT_EQ(AdaptiveShardCost::kMinMeasuredCalls + 1,
+            cost.num_measured_calls());
+  EXPECT_EQ(16 + (1 - 16) / 8.0, cost.nsec_per_unit());
+}
+
+TEST(Shard, AdaptiveShardCostRegistry) {
+  AdaptiveShardCostRegistry* registry = AdaptiveShardCostRegistry::Global();
+  AdaptiveShardCost cost_a;
+  AdaptiveShardCost cost_b;
+  registry->Register("b", "ShardTestOp", DT_FLOAT, &cost_b);
+  registry->Register("a", "ShardTestOp", DT_FLOAT, &cost_a);
+  {
+    thread::ThreadPool threads(Env::Default(), "test", 4);
+    ScopedAdaptiveShardCost scoped(&cost_b);
+    Shard(4, &threads, 100, 1, [](int64 start, int64 limit) {});
+  }
+  std::vector<string> kernel_names;
+  for (const auto& entry : registry->GetEntries()) {
+    if (entry.op_type != "ShardTestOp") continue;
+    kernel_names.push_back(entry.kernel_name);
+    EXPECT_EQ(DT_FLOAT, entry.dtype);
+    EXPECT_EQ(entry.kernel_name == "b" ? 1 : 0, entry.num_calls);
+    EXPECT_EQ(-1, entry.nsec_per_unit);
+  }
+  EXPECT_EQ(std::vector<string>({"a", "b"}), kernel_names);
+
+  registry->Unregister(&cost_a);
+  registry->Unregister(&cost_b);
+  for (const auto& entry : registry->GetEntries()) {
+    EXPECT_NE("ShardTestOp", entry.op_type);
+  }
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
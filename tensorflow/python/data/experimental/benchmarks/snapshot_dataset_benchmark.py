@@ -42,7 +42,7 @@ class SnapshotDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
     os.mkdir(tmp_dir)
     return tmp_dir
 
-  def _createSimpleDataset(self, num_elems, tmp_dir=None):
+  def _createSimpleDataset(self, num_elems, tmp_dir=None, **snapshot_kwargs):
     if not tmp_dir:
       tmp_dir = self._makeSnapshotDirectory()
 
@@ -50,7 +50,7 @@ class SnapshotDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
     dataset = dataset.map(
         lambda x: gen_array_ops.broadcast_to(x, [50, 50, 3]))
     dataset = dataset.repeat(num_elems)
-    dataset = dataset.apply(snapshot.snapshot(tmp_dir))
+    dataset = dataset.apply(snapshot.snapshot(tmp_dir, **snapshot_kwargs))
 
     return dataset
 
@@ -83,6 +83,17 @@ class SnapshotDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
 
     self.run_and_report_benchmark(dataset, num_elems, "passthrough_simple")
 
+  def benchmarkWriteSnapshotParallelSnappy(self):
+    num_elems = 500000
+    dataset = self._createSimpleDataset(
+        num_elems,
+        compression=snapshot.COMPRESSION_SNAPPY,
+        num_writer_threads=4,
+        writer_buffer_size=16)
+
+    self.run_and_report_benchmark(dataset, num_elems, "write_parallel_snappy",
+                                  warmup=False, iters=1)
+
   def benchmarkReadSnapshotSimple(self):
     num_elems = 100000
     tmp_dir = self._makeSnapshotDirectory()
@@ -93,6 +104,24 @@ class SnapshotDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
 
     self.run_and_report_benchmark(dataset, num_elems, "read_simple")
 
+  def benchmarkReadSnapshotParallelSnappy(self):
+    num_elems = 100000
+    tmp_dir = self._makeSnapshotDirectory()
+    dataset = self._createSimpleDataset(
+        num_elems,
+        tmp_dir,
+        compression=snapshot.COMPRESSION_SNAPPY,
+        shard_size_bytes=64 * 1024 * 1024,
+        num_reader_threads=4,
+        reader_buffer_size=16,
+        num_writer_threads=4,
+        writer_buffer_size=16)
+
+    # consume all the elements to let snapshot write things to disk
+    self._consumeDataset(dataset, num_elems)
+
+    self.run_and_report_benchmark(dataset, num_elems, "read_parallel_snappy")
+
 
 if __name__ == "__main__":
   test.main()
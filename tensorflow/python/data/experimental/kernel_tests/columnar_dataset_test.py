@@ -0,0 +1,185 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for `ColumnarDataset`."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+import struct
+
+from absl.testing import parameterized
+import numpy as np
+
+from tensorflow.core.protobuf.data.experimental import columnar_pb2
+from tensorflow.python.data.experimental.ops import columnar
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class ColumnarDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  def _writeFile(self, index, num_rows, row_group_size):
+    filename = os.path.join(self.get_temp_dir(), "columnar.%d" % index)
+    ids = np.arange(index * num_rows, (index + 1) * num_rows, dtype=np.int64)
+    columnar.write_columnar(
+        filename, {
+            "id": ids,
+            "score": (ids * 0.5).astype(np.float32),
+            "bucket": (ids % 4).astype(np.int32),
+            "name": np.array([b"name_%d" % i for i in ids]),
+        },
+        row_group_size=row_group_size)
+    return filename
+
+  def _writeRawFile(self, name, columns, num_rows):
+    """Writes `columns`, a list of (name, array) pairs, as one row group."""
+    filename = os.path.join(self.get_temp_dir(), name)
+    footer = columnar_pb2.ColumnarFooter()
+    row_group = footer.row_group.add(num_rows=num_rows)
+    data = b""
+    for column, array in columns:
+      footer.column.add(
+          name=column, dtype=dtypes.as_dtype(array.dtype).as_datatype_enum)
+      row_group.chunk.add(offset=len(data), size_bytes=array.nbytes)
+      data += array.tobytes()
+    serialized_footer = footer.SerializeToString()
+    with open(filename, "wb") as f:
+      f.write(data + serialized_footer)
+      f.write(struct.pack("<Q", len(serialized_footer)))
+      f.write(b"TFCF")
+    return filename
+
+  def _expectedBatches(self, ids, batch_size, columns):
+    values = {
+        "id": [i for i in ids],
+        "score": [i * 0.5 for i in ids],
+        "bucket": [i % 4 for i in ids],
+        "name": [b"name_%d" % i for i in ids],
+    }
+    return [
+        tuple(values[column][start:start + batch_size] for column in columns)
+        for start in range(0, len(ids), batch_size)
+    ]
+
+  @parameterized.named_parameters(
+      ("BatchWithinRowGroup", 4, 10),
+      ("BatchAcrossRowGroups", 7, 10),
+      ("BatchLargerThanFile", 64, 10),
+      ("SingleRowGroup", 5, 100),
+  )
+  def testReadAllColumns(self, batch_size, row_group_size):
+    filenames = [self._writeFile(i, 25, row_group_size) for i in range(2)]
+    columns = ["id", "score", "bucket", "name"]
+    dataset = columnar.ColumnarDataset(
+        filenames, columns,
+        (dtypes.int64, dtypes.float32, dtypes.int32, dtypes.string),
+        batch_size)
+    # Batches span row groups and files.
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=self._expectedBatches(range(50), batch_size, columns))
+
+  def testReadColumnSubset(self):
+    filename = self._writeFile(0, 30, 8)
+    dataset = columnar.ColumnarDataset(filename, ["name", "id"],
+                                       (dtypes.string, dtypes.int64), 10)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=self._expectedBatches(range(30), 10, ["name", "id"]))
+
+  @parameterized.named_parameters(
+      ("Equal", [("bucket", "==", 2)], lambda i: i % 4 == 2),
+      ("NotEqual", [("bucket", "!=", 2)], lambda i: i % 4 != 2),
+      ("Less", [("id", "<", 13)], lambda i: i < 13),
+      ("LessEqual", [("id", "<=", 13)], lambda i: i <= 13),
+      ("Greater", [("score", ">", 10.)], lambda i: i * 0.5 > 10.),
+      ("GreaterEqual", [("id", ">=", 37)], lambda i: i >= 37),
+      ("Conjunction", [("id", ">=", 5), ("id", "<", 35), ("bucket", "==", 1)],
+       lambda i: 5 <= i < 35 and i % 4 == 1),
+      ("NoMatch", [("id", ">", 100)], lambda i: False),
+  )
+  def testFilters(self, filters, predicate):
+    filename = self._writeFile(0, 40, 8)
+    dataset = columnar.ColumnarDataset(
+        filename, ["id", "name"], (dtypes.int64, dtypes.string), 6,
+        filters=filters)
+    ids = [i for i in range(40) if predicate(i)]
+    self.assertDatasetProduces(
+        dataset, expected_output=self._expectedBatches(ids, 6, ["id", "name"]))
+
+  def testEmptyFile(self):
+    filename = os.path.join(self.get_temp_dir(), "empty")
+    columnar.write_columnar(filename, {"id": np.array([], dtype=np.int64)})
+    dataset = columnar.ColumnarDataset(filename, ["id"], (dtypes.int64,), 4)
+    self.assertDatasetProduces(dataset, expected_output=[])
+
+  def testMissingColumn(self):
+    filename = self._writeFile(0, 10, 4)
+    dataset = columnar.ColumnarDataset(filename, ["age"], (dtypes.int64,), 4)
+    self.assertDatasetProduces(
+        dataset,
+        expected_error=(errors.InvalidArgumentError, "Column age not found"))
+
+  def testMismatchedType(self):
+    filename = self._writeFile(0, 10, 4)
+    dataset = columnar.ColumnarDataset(filename, ["id"], (dtypes.int32,), 4)
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.InvalidArgumentError, "has type"))
+
+  def testStringFilterColumn(self):
+    filename = self._writeFile(0, 10, 4)
+    dataset = columnar.ColumnarDataset(
+        filename, ["id"], (dtypes.int64,), 4, filters=[("name", "==", 1)])
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.InvalidArgumentError, "numeric"))
+
+  def testFilterOnNarrowType(self):
+    # The writer only produces 32 and 64 bit numbers, but other writers may
+    # store any numeric type.
+    filename = self._writeRawFile(
+        "int16", [("id", np.arange(4, dtype="<i8")),
+                  ("x", np.array([3, -1, 7, 2], dtype="<i2"))], 4)
+    dataset = columnar.ColumnarDataset(
+        filename, ["id"], (dtypes.int64,), 4, filters=[("x", ">", 2)])
+    self.assertDatasetProduces(dataset, expected_output=[([0, 2],)])
+
+  @parameterized.named_parameters(
+      ("Negative", -1),
+      ("LargerThanChunk", 5),
+      ("Overflowing", 2**62),
+  )
+  def testInvalidRowCount(self, num_rows):
+    filename = self._writeRawFile(
+        "rows", [("id", np.arange(4, dtype="<i8"))], num_rows)
+    dataset = columnar.ColumnarDataset(filename, ["id"], (dtypes.int64,), 4)
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.DataLossError, "Invalid (chunk|row group)"))
+
+  def testNotColumnarFile(self):
+    filename = os.path.join(self.get_temp_dir(), "not_columnar")
+    with open(filename, "wb") as f:
+      f.write(b"this is not a columnar file")
+    dataset = columnar.ColumnarDataset(filename, ["id"], (dtypes.int64,), 4)
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.DataLossError, "not a columnar file"))
+
+
+if __name__ == "__main__":
+  test.main()
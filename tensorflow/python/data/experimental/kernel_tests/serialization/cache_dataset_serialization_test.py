@@ -37,15 +37,17 @@ class CacheDatasetSerializationTest(
     self.num_outputs = self.range_size * self.num_repeats
     self.cache_file_prefix = 'test'
 
-  def make_dataset_fn(self, is_memory):
+  def make_dataset_fn(self, is_memory, memory_budget=0):
     if is_memory:
       filename = ''
     else:
       filename = os.path.join(self.get_temp_dir(), self.cache_file_prefix)
 
+    # With a memory budget of 16 bytes, 2 elements are cached in memory and
+    # the others are spilled to disk.
     def ds_fn():
-      return dataset_ops.Dataset.range(self.range_size).cache(filename).repeat(
-          self.num_repeats)
+      return dataset_ops.Dataset.range(self.range_size).cache(
+          filename, memory_budget=memory_budget).repeat(self.num_repeats)
 
     return ds_fn
 
@@ -55,9 +57,10 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointBeforeOneEpoch(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointBeforeOneEpoch(self, is_memory, memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Generate 5 entries from iterator and save checkpoint.
     outputs = self.gen_outputs(ds_fn, [], 5, verify_exhausted=False)
@@ -76,9 +79,12 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointBeforeOneEpochThenRunFewSteps(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointBeforeOneEpochThenRunFewSteps(self,
+                                                  is_memory,
+                                                  memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Generate 8 entries from iterator but save checkpoint after producing 5.
     outputs = self.gen_outputs(
@@ -107,9 +113,10 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointAfterOneEpoch(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointAfterOneEpoch(self, is_memory, memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Generate 15 entries from iterator and save checkpoint.
     outputs = self.gen_outputs(ds_fn, [], 15, verify_exhausted=False)
@@ -128,9 +135,12 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointAfterOneEpochThenRunFewSteps(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointAfterOneEpochThenRunFewSteps(self,
+                                                 is_memory,
+                                                 memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Generate 18 entries from iterator but save checkpoint after producing 15.
     outputs = self.gen_outputs(
@@ -147,9 +157,12 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointBeforeOneEpochButRunCompleteEpoch(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointBeforeOneEpochButRunCompleteEpoch(self,
+                                                      is_memory,
+                                                      memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Generate 13 entries from iterator but save checkpoint after producing 5.
     outputs = self.gen_outputs(
@@ -171,9 +184,10 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointUnusedWriterIterator(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointUnusedWriterIterator(self, is_memory, memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Checkpoint before get_next is called even once.
     outputs = self.gen_outputs(ds_fn, [], 0, verify_exhausted=False)
@@ -186,9 +200,12 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testCheckpointUnusedMidwayWriterIterator(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testCheckpointUnusedMidwayWriterIterator(self,
+                                               is_memory,
+                                               memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Produce 5 elements and checkpoint.
     outputs = self.gen_outputs(ds_fn, [], 5, verify_exhausted=False)
@@ -211,9 +228,10 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testUnusedCheckpointError(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testUnusedCheckpointError(self, is_memory, memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Produce 5 elements and save ckpt.
     outputs = self.gen_outputs(ds_fn, [], 5, verify_exhausted=False)
@@ -234,9 +252,10 @@ class CacheDatasetSerializationTest(
   @parameterized.named_parameters(
       ('Memory', True),
       ('File', False),
+      ('Hybrid', True, 16),
   )
-  def testIgnoreCheckpointIfCacheWritten(self, is_memory):
-    ds_fn = self.make_dataset_fn(is_memory)
+  def testIgnoreCheckpointIfCacheWritten(self, is_memory, memory_budget=0):
+    ds_fn = self.make_dataset_fn(is_memory, memory_budget)
 
     # Produce 15 elements and save ckpt. This will write the complete cache.
     outputs = self.gen_outputs(ds_fn, [], 15, verify_exhausted=False)
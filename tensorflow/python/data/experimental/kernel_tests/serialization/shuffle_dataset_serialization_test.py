@@ -143,6 +143,22 @@ class ShuffleDatasetSerializationTest(
             actual = [self.evaluate(get_next_ops) for _ in range(num_outputs)]
             self.match(expected, actual)
 
+  def testAsyncShuffle(self):
+    range_limit = 10
+    num_repeats = 2
+    num_outputs = range_limit * num_repeats
+
+    def ds_fn():
+      return dataset_ops.Dataset.range(range_limit).shuffle(
+          5, seed=55, num_producers=2).repeat(num_repeats)
+
+    # The order depends on the timing of the producers, but every element must
+    # be produced exactly once across the checkpoints.
+    for break_points in [[0], [3], [5, 12], [num_outputs]]:
+      outputs = self.gen_outputs(ds_fn, break_points, num_outputs)
+      self.assertCountEqual(list(range(range_limit)) * num_repeats, outputs)
+    self.verify_exhausted_iterator(ds_fn, num_outputs)
+
 
 if __name__ == "__main__":
   test.main()
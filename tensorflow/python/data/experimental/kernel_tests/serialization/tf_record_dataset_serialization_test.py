@@ -35,7 +35,8 @@ class TFRecordDatasetSerializationTest(
                             num_epochs,
                             batch_size=1,
                             compression_type=None,
-                            buffer_size=None):
+                            buffer_size=None,
+                            use_mmap=False):
     filenames = self._createFiles()
     if compression_type == "ZLIB":
       zlib_files = []
@@ -59,8 +60,8 @@ class TFRecordDatasetSerializationTest(
       filenames = gzip_files
 
     return core_readers.TFRecordDataset(
-        filenames, compression_type,
-        buffer_size=buffer_size).repeat(num_epochs).batch(batch_size)
+        filenames, compression_type, buffer_size=buffer_size,
+        use_mmap=use_mmap).repeat(num_epochs).batch(batch_size)
 
   def testTFRecordWithoutBufferCore(self):
     num_epochs = 5
@@ -84,6 +85,14 @@ class TFRecordDatasetSerializationTest(
                         lambda: self._build_iterator_graph(num_epochs * 2),
                         num_outputs)
 
+  def testTFRecordWithMmapCore(self):
+    num_epochs = 5
+    num_outputs = num_epochs * self._num_files * self._num_records
+    self.run_core_tests(
+        lambda: self._build_iterator_graph(num_epochs, use_mmap=True),
+        lambda: self._build_iterator_graph(num_epochs * 2, use_mmap=True),
+        num_outputs)
+
   def testTFRecordWithCompressionCore(self):
     num_epochs = 5
     num_outputs = num_epochs * self._num_files * self._num_records
@@ -19,6 +19,8 @@ from __future__ import print_function
 
 import os
 
+from absl.testing import parameterized
+
 from tensorflow.python.data.experimental.kernel_tests import reader_dataset_ops_test_base
 from tensorflow.python.data.experimental.ops import snapshot
 from tensorflow.python.data.ops import dataset_ops
@@ -29,7 +31,8 @@ from tensorflow.python.platform import test
 
 
 @test_util.run_all_in_graph_and_eager_modes
-class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase):
+class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase,
+                          parameterized.TestCase):
 
   def setUp(self):
     super(SnapshotDatasetTest, self).setUp()
@@ -52,7 +55,8 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase):
     return tmpdir
 
   def assertSnapshotDirectoryContains(
-      self, directory, num_fingerprints, num_runs_per_fp, num_snapshot_files):
+      self, directory, num_fingerprints, num_runs_per_fp, num_snapshot_files,
+      num_writer_threads=1):
     dirlist = os.listdir(directory)
     self.assertEqual(len(dirlist), num_fingerprints)
 
@@ -68,10 +72,13 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase):
         run_dirlist = sorted(os.listdir(run_dir))
         self.assertEqual(len(run_dirlist), num_snapshot_files)
 
-        file_counter = 0
+        # Every writer thread writes its own sequence of shard files.
         for filename in run_dirlist:
-          self.assertEqual(filename, "%08d.snapshot" % file_counter)
-          file_counter += 1
+          thread_index, shard_index = filename[:-len(".snapshot")].split("_")
+          self.assertLess(int(thread_index), num_writer_threads)
+          self.assertEqual(
+              filename, "%08d_%08d.snapshot" % (int(thread_index),
+                                                int(shard_index)))
 
   def testWriteDifferentPipelinesInOneDirectory(self):
     tmpdir = self.makeSnapshotDirectory()
@@ -128,11 +135,74 @@ class SnapshotDatasetTest(reader_dataset_ops_test_base.TFRecordDatasetTestBase):
     tmpdir = self.makeSnapshotDirectory()
 
     dataset = dataset_ops.Dataset.range(20000)
-    dataset = dataset.apply(snapshot.snapshot(tmpdir))
+    dataset = dataset.apply(snapshot.snapshot(tmpdir, shard_size_bytes=200000))
     self.assertDatasetProduces(dataset, list(range(20000)))
 
     self.assertSnapshotDirectoryContains(tmpdir, 1, 1, 2)
 
+  def testWriteSnapshotMultipleWriterThreads(self):
+    tmpdir = self.makeSnapshotDirectory()
+
+    dataset = dataset_ops.Dataset.range(20000)
+    dataset = dataset.apply(
+        snapshot.snapshot(
+            tmpdir,
+            shard_size_bytes=200000,
+            num_writer_threads=2,
+            writer_buffer_size=16))
+    self.assertDatasetProduces(dataset, list(range(20000)))
+
+    # How the elements are spread over the writers is not deterministic, but
+    # each writer produces at most two shards.
+    fingerprint_dir = os.path.join(tmpdir, os.listdir(tmpdir)[0])
+    run_dir = [
+        os.path.join(fingerprint_dir, d)
+        for d in os.listdir(fingerprint_dir)
+        if d != "snapshot.metadata"
+    ][0]
+    num_files = len(os.listdir(run_dir))
+    self.assertGreaterEqual(num_files, 2)
+    self.assertLessEqual(num_files, 4)
+    self.assertSnapshotDirectoryContains(
+        tmpdir, 1, 1, num_files, num_writer_threads=2)
+
+    # Reading the snapshot back produces all the elements.
+    self.assertDatasetProduces(
+        dataset, list(range(20000)), assert_items_equal=True)
+
+  @parameterized.parameters(None,
+                            snapshot.COMPRESSION_NONE,
+                            snapshot.COMPRESSION_GZIP,
+                            snapshot.COMPRESSION_SNAPPY)
+  def testReadSnapshotBackAfterWriteWithCompression(self, compression):
+    tmpdir = self.makeSnapshotDirectory()
+
+    dataset = dataset_ops.Dataset.range(1000)
+    dataset = dataset.map(lambda x: (x, string_ops.as_string(x)))
+    dataset = dataset.apply(snapshot.snapshot(tmpdir, compression=compression))
+    expected = [(x, b"%d" % x) for x in range(1000)]
+    self.assertDatasetProduces(dataset, expected)
+
+    # The second pipeline reads the elements back from the snapshot.
+    self.assertDatasetProduces(dataset, expected)
+    self.assertSnapshotDirectoryContains(tmpdir, 1, 1, 1)
+
+  def testReadSnapshotBackWithMultipleThreads(self):
+    tmpdir = self.makeSnapshotDirectory()
+
+    dataset = dataset_ops.Dataset.range(1000)
+    dataset = dataset.apply(
+        snapshot.snapshot(
+            tmpdir,
+            shard_size_bytes=1000,
+            num_reader_threads=4,
+            reader_buffer_size=8,
+            num_writer_threads=4))
+    self.assertDatasetProduces(
+        dataset, list(range(1000)), assert_items_equal=True)
+    self.assertDatasetProduces(
+        dataset, list(range(1000)), assert_items_equal=True)
+
   def testReadSnapshotBackAfterWrite(self):
     self.setUpTFRecord()
     filenames = self.test_filenames
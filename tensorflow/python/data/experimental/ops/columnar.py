@@ -0,0 +1,193 @@
+# Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Reading and writing of columnar files."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import struct
+
+import numpy as np
+
+from tensorflow.core.protobuf.data.experimental import columnar_pb2
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.util import structure
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
+from tensorflow.python.platform import gfile
+from tensorflow.python.util import compat
+
+
+_MAGIC = b"TFCF"
+_NUMERIC_TYPES = (dtypes.float32, dtypes.float64, dtypes.int32, dtypes.int64)
+_FILTER_OPS = ("==", "!=", "<", "<=", ">", ">=")
+
+
+class ColumnarDataset(dataset_ops.DatasetSource):
+  """A `Dataset` of batches of rows read from columnar files.
+
+  Columnar files store the values of each column of a row group contiguously
+  (see `tensorflow/core/protobuf/data/experimental/columnar.proto`), so that
+  only the requested columns are read and decoded. Files can be written with
+  `write_columnar()`.
+
+  For example:
+
+  ```python
+  write_columnar("/path/to/file", {"id": ids, "age": ages, "name": names})
+  dataset = ColumnarDataset("/path/to/file", ["name", "age"],
+                            (tf.string, tf.int64), batch_size=1024,
+                            filters=[("age", ">=", 18)])
+  ```
+
+  Each element of the dataset is a tuple with one vector per requested column,
+  holding up to `batch_size` rows.
+  """
+
+  def __init__(self,
+               filenames,
+               columns,
+               output_types,
+               batch_size,
+               filters=None):
+    """Creates a `ColumnarDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames.
+      columns: A list of the names of the columns to read.
+      output_types: A tuple of `tf.DType` objects representing the types of the
+        `columns`. Supported types are `tf.float32`, `tf.float64`, `tf.int32`,
+        `tf.int64` and `tf.string`.
+      batch_size: A `tf.int64` scalar `tf.Tensor`, representing the maximum
+        number of rows in each batch.
+      filters: (Optional.) A list of `(column, op, value)` tuples. Only the
+        rows for which `column op value` holds for every filter are produced,
+        where `column` is the name of a numeric column, which need not be one
+        of the `columns`, `op` is one of "==", "!=", "<", "<=", ">" and ">=",
+        and `value` is a number. Row groups whose column statistics show that
+        no row can pass the filters are not read.
+    """
+    filters = filters or []
+    for _, op, _ in filters:
+      if op not in _FILTER_OPS:
+        raise ValueError("Unsupported filter operation: %s" % op)
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._columns = ops.convert_to_tensor(
+        columns, dtype=dtypes.string, name="columns")
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._filter_columns = ops.convert_to_tensor(
+        [column for column, _, _ in filters],
+        dtype=dtypes.string,
+        name="filter_columns")
+    self._filter_ops = ops.convert_to_tensor(
+        [op for _, op, _ in filters], dtype=dtypes.string, name="filter_ops")
+    self._filter_values = ops.convert_to_tensor(
+        [value for _, _, value in filters],
+        dtype=dtypes.float64,
+        name="filter_values")
+    self._structure = structure.NestedStructure(
+        tuple(
+            structure.TensorStructure(dtypes.as_dtype(dtype), [None])
+            for dtype in output_types))
+    variant_tensor = ged_ops.columnar_dataset(
+        self._filenames,
+        self._columns,
+        self._batch_size,
+        self._filter_columns,
+        self._filter_ops,
+        self._filter_values,
+        **dataset_ops.flat_structure(self))
+    super(ColumnarDataset, self).__init__(variant_tensor)
+
+  @property
+  def _element_structure(self):
+    return self._structure
+
+
+def _encode_chunk(values, dtype):
+  """Returns the encoding of a column chunk and its statistics."""
+  chunk = columnar_pb2.ColumnChunk()
+  if dtype == dtypes.string:
+    strings = [compat.as_bytes(v) for v in values]
+    offsets = np.cumsum([len(s) for s in strings], dtype=np.uint64)
+    data = offsets.astype("<u8").tobytes() + b"".join(strings)
+  else:
+    little_endian = np.dtype(dtype.as_numpy_dtype).newbyteorder("<")
+    data = np.asarray(values).astype(little_endian).tobytes()
+    if values.size:
+      chunk.has_statistics = True
+      chunk.min_value = float(np.min(values))
+      chunk.max_value = float(np.max(values))
+  chunk.size_bytes = len(data)
+  return chunk, data
+
+
+def write_columnar(filename, columns, row_group_size=64 * 1024):
+  """Writes a table to a columnar file that `ColumnarDataset` can read.
+
+  Args:
+    filename: The name of the file to write.
+    columns: A dictionary mapping column names to 1-D numpy arrays (or lists)
+      of the same length. Arrays of numbers are stored with their type, which
+      must be one of float32, float64, int32 and int64; arrays of strings or
+      bytes are stored as `tf.string`.
+    row_group_size: The maximum number of rows in each row group. Smaller row
+      groups make filters on sorted columns more selective, larger ones make
+      reads more efficient.
+
+  Raises:
+    ValueError: If the columns have different lengths or unsupported types.
+  """
+  names = sorted(columns)
+  arrays = []
+  types = []
+  for name in names:
+    array = np.asarray(columns[name])
+    if array.ndim != 1:
+      raise ValueError("Column %s must be one-dimensional." % name)
+    if array.dtype.kind in ("S", "U", "O"):
+      dtype = dtypes.string
+    else:
+      dtype = dtypes.as_dtype(array.dtype)
+      if dtype not in _NUMERIC_TYPES:
+        raise ValueError("Column %s has unsupported type %s." % (name, dtype))
+    arrays.append(array)
+    types.append(dtype)
+  num_rows = {len(array) for array in arrays}
+  if len(num_rows) > 1:
+    raise ValueError("All columns must have the same length.")
+  num_rows = num_rows.pop() if num_rows else 0
+
+  footer = columnar_pb2.ColumnarFooter()
+  for name, dtype in zip(names, types):
+    footer.column.add(name=name, dtype=dtype.as_datatype_enum)
+  offset = 0
+  with gfile.GFile(filename, "wb") as f:
+    for start in range(0, num_rows, row_group_size):
+      end = min(start + row_group_size, num_rows)
+      row_group = footer.row_group.add(num_rows=end - start)
+      for array, dtype in zip(arrays, types):
+        chunk, data = _encode_chunk(array[start:end], dtype)
+        chunk.offset = offset
+        row_group.chunk.extend([chunk])
+        f.write(data)
+        offset += len(data)
+    serialized_footer = footer.SerializeToString()
+    f.write(serialized_footer)
+    f.write(struct.pack("<Q", len(serialized_footer)))
+    f.write(_MAGIC)
@@ -23,21 +23,60 @@ from tensorflow.python.framework import ops
 from tensorflow.python.ops import gen_experimental_dataset_ops as ged_ops
 
 
+COMPRESSION_GZIP = "GZIP"
+COMPRESSION_SNAPPY = "SNAPPY"
+COMPRESSION_NONE = ""
+
+
 class _SnapshotDataset(dataset_ops.UnaryUnchangedStructureDataset):
   """A Dataset that captures a snapshot or reads from a snapshot."""
 
-  def __init__(self, input_dataset, path):
+  def __init__(self,
+               input_dataset,
+               path,
+               compression=None,
+               shard_size_bytes=None,
+               num_reader_threads=None,
+               reader_buffer_size=None,
+               num_writer_threads=None,
+               writer_buffer_size=None):
+
+    self._compression = (
+        compression if compression is not None else COMPRESSION_GZIP)
+    self._shard_size_bytes = (
+        shard_size_bytes if shard_size_bytes is not None else 10 * 1024**3)
+    self._num_reader_threads = (
+        num_reader_threads if num_reader_threads is not None else 1)
+    self._reader_buffer_size = (
+        reader_buffer_size if reader_buffer_size is not None else 1)
+    self._num_writer_threads = (
+        num_writer_threads if num_writer_threads is not None else 1)
+    self._writer_buffer_size = (
+        writer_buffer_size if writer_buffer_size is not None else 1)
+
     self._input_dataset = input_dataset
     self._path = ops.convert_to_tensor(path, dtype=dtypes.string, name="path")
 
     variant_tensor = ged_ops.snapshot_dataset(
         self._input_dataset._variant_tensor,  # pylint: disable=protected-access
         path=self._path,
+        compression=self._compression,
+        shard_size_bytes=self._shard_size_bytes,
+        num_reader_threads=self._num_reader_threads,
+        reader_buffer_size=self._reader_buffer_size,
+        num_writer_threads=self._num_writer_threads,
+        writer_buffer_size=self._writer_buffer_size,
         **dataset_ops.flat_structure(self))
     super(_SnapshotDataset, self).__init__(input_dataset, variant_tensor)
 
 
-def snapshot(path):
+def snapshot(path,
+             compression=None,
+             shard_size_bytes=None,
+             num_reader_threads=None,
+             reader_buffer_size=None,
+             num_writer_threads=None,
+             writer_buffer_size=None):
   """Writes to/reads from a snapshot of a dataset.
 
   This function attempts to determine whether a valid snapshot exists at the
@@ -45,9 +84,28 @@ def snapshot(path):
   preprocessing pipeline as usual, and write out a snapshot of the data
   processed for future use.
 
+  Elements are written by `num_writer_threads` background threads, each of
+  which produces its own sequence of shard files, and read back by
+  `num_reader_threads` background threads. With more than one reader or writer
+  thread, the order of the elements read back from the snapshot is not
+  deterministic.
+
   Args:
     path: A directory where we want to save our snapshots and/or read from a
       previously saved snapshot.
+    compression: The type of compression to apply to the snapshot written to
+      disk. Supported options are `"GZIP"`, `"SNAPPY"` or `""` for no
+      compression. Defaults to `"GZIP"`.
+    shard_size_bytes: The size of each shard to be written by the snapshot
+      dataset op. Defaults to 10 GiB.
+    num_reader_threads: The number of threads to parallelize reading from
+      the snapshot. Defaults to 1.
+    reader_buffer_size: The maximum number of elements buffered per reader
+      thread. Defaults to 1.
+    num_writer_threads: The number of threads to parallelize writing the
+      snapshot. Defaults to 1.
+    writer_buffer_size: The maximum number of elements buffered per writer
+      thread. Defaults to 1.
 
   Returns:
     A `Dataset` transformation function, which can be passed to
@@ -55,6 +113,8 @@ def snapshot(path):
   """
 
   def _apply_fn(dataset):
-    return _SnapshotDataset(dataset, path)
+    return _SnapshotDataset(dataset, path, compression, shard_size_bytes,
+                            num_reader_threads, reader_buffer_size,
+                            num_writer_threads, writer_buffer_size)
 
   return _apply_fn
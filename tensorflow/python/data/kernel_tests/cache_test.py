@@ -17,6 +17,7 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
 from os import path
 import shutil
 import tempfile
@@ -30,8 +31,11 @@ from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import test_util
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import string_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
+from tensorflow.python.util import compat
 
 
 @test_util.run_all_in_graph_and_eager_modes
@@ -249,5 +253,83 @@ class MemoryCacheTest(test_base.DatasetTestBase):
     self.assertDatasetProduces(dataset, expected_output=expected_output)
 
 
+
+@test_util.run_all_in_graph_and_eager_modes
+class HybridCacheTest(test_base.DatasetTestBase):
+
+  def setUp(self):
+    self.tmp_dir = tempfile.mkdtemp()
+    self.cache_prefix = path.join(self.tmp_dir, "cache")
+
+  def tearDown(self):
+    if self.tmp_dir:
+      shutil.rmtree(self.tmp_dir, ignore_errors=True)
+
+  def _dataset(self, num_elements):
+    return dataset_ops.Dataset.range(num_elements).map(
+        lambda x: (x, string_ops.as_string(x), array_ops.fill([3], x)))
+
+  def _expected_output(self, num_elements):
+    return [(i, compat.as_bytes(str(i)), [i, i, i])
+            for i in range(num_elements)]
+
+  def testCacheDatasetPassthrough(self):
+    # Only the first few elements fit in the budget, the rest are spilled.
+    dataset = self._dataset(100).cache(memory_budget=512).repeat(3)
+    self.assertDatasetProduces(
+        dataset, expected_output=self._expected_output(100) * 3)
+
+  def testAllElementsSpilled(self):
+    dataset = self._dataset(10).cache(
+        self.cache_prefix, memory_budget=1).repeat(2)
+    self.assertDatasetProduces(
+        dataset, expected_output=self._expected_output(10) * 2)
+
+  def testNoElementsSpilled(self):
+    dataset = self._dataset(10).cache(
+        self.cache_prefix, memory_budget=1 << 20).repeat(2)
+    self.assertDatasetProduces(
+        dataset, expected_output=self._expected_output(10) * 2)
+    self.assertEqual([], os.listdir(self.tmp_dir))
+
+  def testEmptyCacheReading(self):
+    dataset = self._dataset(0).cache(memory_budget=1).repeat(2)
+    self.assertDatasetProduces(dataset, expected_output=[])
+
+  def testConcurrentReaders(self):
+    dataset = dataset_ops.Dataset.range(5).cache(memory_budget=16)
+    d1 = dataset.map(lambda x: x + 1)
+    d2 = dataset.map(lambda x: x + 6)
+
+    get_next1 = self.getNext(d1)
+
+    self.assertEqual(1, self.evaluate(get_next1()))
+    self.assertEqual(2, self.evaluate(get_next1()))
+    self.assertEqual(3, self.evaluate(get_next1()))
+
+    get_next2 = self.getNext(d2)
+
+    self.assertEqual(6, self.evaluate(get_next2()))
+    self.assertEqual(7, self.evaluate(get_next2()))
+    self.assertEqual(4, self.evaluate(get_next1()))  # interleave execution
+    self.assertEqual([8, 5],
+                     [self.evaluate(get_next2()),
+                      self.evaluate(get_next1())])
+    self.assertEqual(9, self.evaluate(get_next2()))
+    self.assertEqual(10, self.evaluate(get_next2()))
+
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(get_next2())
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(get_next1())
+
+  def testCacheTakeRepeat(self):
+    dataset = dataset_ops.Dataset.range(10).cache(memory_budget=16).take(
+        5).repeat(2)
+
+    expected_output = [0, 1, 2, 3, 4, 0, 1, 2, 3, 4]
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+
 if __name__ == "__main__":
   test.main()
@@ -184,6 +184,28 @@ class InterleaveTest(test_base.DatasetTestBase, parameterized.TestCase):
     with self.assertRaises(errors.OutOfRangeError):
       self.evaluate(get_next())
 
+  @parameterized.named_parameters(
+      ("1", np.int64([4, 5, 6]), 2, 1, 2, 1),
+      ("2", np.int64([4, 5, 6]), 2, 3, 2, 4),
+      ("3", np.int64([4, 5, 6]), 7, 2, 3, 8),
+      ("4", np.int64([4, 5, 6]), 7, 2, 7, 100),
+      ("5", np.int64([4, 0, 6]), 2, 3, 2, 4),
+  )
+  def testReorderWindowInterleaveDataset(self, input_values, cycle_length,
+                                         block_length, num_parallel_calls,
+                                         reorder_window_size):
+    count = 2
+    dataset = dataset_ops.Dataset.from_tensor_slices(input_values).repeat(
+        count).interleave(
+            lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x),
+            cycle_length, block_length, num_parallel_calls,
+            reorder_window_size)
+    expected_output = [
+        element for element in _interleave(
+            _repeat(input_values, count), cycle_length, block_length)
+    ]
+    self.assertDatasetProduces(dataset, expected_output)
+
   def testInterleaveSparse(self):
 
     def _map_fn(i):
@@ -31,6 +31,7 @@ from tensorflow.python.framework import ops
 from tensorflow.python.framework import random_seed
 from tensorflow.python.framework import test_util
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 
 
@@ -240,5 +241,41 @@ class ShuffleTest(test_base.DatasetTestBase, parameterized.TestCase):
         self.assertNotEqual(results[0], results[1])
 
 
+  @parameterized.named_parameters(
+      ("OneProducer", 1, 10),
+      ("MultipleProducers", 4, 10),
+      ("MoreProducersThanBuffer", 16, 10),
+      ("BufferLargerThanInput", 4, 1000),
+  )
+  def testAsyncShuffleProducesAllElements(self, num_producers, buffer_size):
+    dataset = dataset_ops.Dataset.range(100).shuffle(
+        buffer_size, num_producers=num_producers).repeat(2)
+    next_element = self.getNext(dataset)
+
+    results = [self.evaluate(next_element()) for _ in range(200)]
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(next_element())
+    self.assertCountEqual(list(range(100)) * 2, results)
+    self.assertNotEqual(results[:100], list(range(100)))
+
+  def testAsyncShuffleEmptyInput(self):
+    dataset = dataset_ops.Dataset.range(0).shuffle(10, num_producers=2)
+    self.assertDatasetProduces(dataset, expected_output=[])
+
+  def testAsyncShuffleInputError(self):
+    dataset = dataset_ops.Dataset.range(10).map(
+        lambda x: array_ops.check_numerics(
+            1. / math_ops.cast(x, dtypes.float32), "error")).shuffle(
+                20, num_producers=2)
+    next_element = self.getNext(dataset)
+
+    with self.assertRaises(errors.InvalidArgumentError):
+      self.evaluate(next_element())
+    results = [self.evaluate(next_element()) for _ in range(9)]
+    with self.assertRaises(errors.OutOfRangeError):
+      self.evaluate(next_element())
+    self.assertAllClose(sorted(1. / np.arange(1, 10)), sorted(results))
+
+
 if __name__ == "__main__":
   test.main()
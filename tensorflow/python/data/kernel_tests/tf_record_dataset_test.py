@@ -24,6 +24,7 @@ import zlib
 from tensorflow.python.data.kernel_tests import test_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import readers
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import test_util
 from tensorflow.python.lib.io import python_io
 from tensorflow.python.platform import test
@@ -146,6 +147,64 @@ class TFRecordDatasetTest(test_base.DatasetTestBase):
           [self._record(j, i) for i in range(self._num_records)])
     self.assertDatasetProduces(dataset, expected_output=expected_output)
 
+  def testReadWithMmap(self):
+    empty_file = os.path.join(self.get_temp_dir(), "empty.tfrecord")
+    python_io.TFRecordWriter(empty_file).close()
+    dataset = readers.TFRecordDataset(
+        self.test_filenames + [empty_file], use_mmap=True)
+    expected_output = []
+    for j in range(self._num_files):
+      expected_output.extend(
+          [self._record(j, i) for i in range(self._num_records)])
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  def testReadZlibFilesWithMmap(self):
+    # Compressed files are read through the buffer.
+    zlib_files = []
+    for i, fn in enumerate(self.test_filenames):
+      with open(fn, "rb") as f:
+        zfn = os.path.join(self.get_temp_dir(), "tfrecord_%s.z" % i)
+        with open(zfn, "wb") as zf:
+          zf.write(zlib.compress(f.read()))
+        zlib_files.append(zfn)
+    dataset = readers.TFRecordDataset(
+        zlib_files, compression_type="ZLIB", use_mmap=True)
+    expected_output = []
+    for j in range(self._num_files):
+      expected_output.extend(
+          [self._record(j, i) for i in range(self._num_records)])
+    self.assertDatasetProduces(dataset, expected_output=expected_output)
+
+  def testReadCorruptedFileWithMmap(self):
+    with open(self.test_filenames[0], "rb") as f:
+      data = bytearray(f.read())
+    # Corrupt the data of the first record.
+    data[12] ^= 0xFF
+    corrupted_file = os.path.join(self.get_temp_dir(), "corrupted.tfrecord")
+    with open(corrupted_file, "wb") as f:
+      f.write(data)
+    dataset = readers.TFRecordDataset(corrupted_file, use_mmap=True)
+    self.assertDatasetProduces(
+        dataset, expected_error=(errors.DataLossError, "corrupted record"))
+
+  def testReadCorruptedFileWithoutVerifyingChecksums(self):
+    with open(self.test_filenames[0], "rb") as f:
+      data = bytearray(f.read())
+    # Corrupt the data of the first record.
+    data[12] ^= 0xFF
+    corrupted_file = os.path.join(self.get_temp_dir(), "corrupted.tfrecord")
+    with open(corrupted_file, "wb") as f:
+      f.write(data)
+    corrupted_record = bytearray(self._record(0, 0))
+    corrupted_record[0] ^= 0xFF
+    expected_output = [bytes(corrupted_record)] + [
+        self._record(0, i) for i in range(1, self._num_records)
+    ]
+    for use_mmap in [False, True]:
+      dataset = readers.TFRecordDataset(
+          corrupted_file, use_mmap=use_mmap, verify_checksums=False)
+      self.assertDatasetProduces(dataset, expected_output=expected_output)
+
   def testReadFromDatasetOfFiles(self):
     files = dataset_ops.Dataset.from_tensor_slices(self.test_filenames)
     expected_output = []
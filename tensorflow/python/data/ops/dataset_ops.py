@@ -256,14 +256,17 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
 
     autotune = True
     cpu_budget = 0  # Indicates that all CPU cores should be used.
+    ram_budget = 0  # Indicates that half of the available RAM should be used.
     if options.experimental_optimization is not None:
       if options.experimental_optimization.autotune is False:  # pylint: disable=g-bool-id-comparison
         autotune = False
       if options.experimental_optimization.autotune_cpu_budget is not None:
         cpu_budget = options.experimental_optimization.autotune_cpu_budget
+      if options.experimental_optimization.autotune_ram_budget is not None:
+        ram_budget = options.experimental_optimization.autotune_ram_budget
 
     if autotune:
-      dataset = _ModelDataset(dataset, cpu_budget)
+      dataset = _ModelDataset(dataset, cpu_budget, ram_budget)
 
     if options.experimental_stats and options.experimental_stats.aggregator:  # pylint: disable=line-too-long
       dataset = _SetStatsAggregatorDataset(  # pylint: disable=protected-access
@@ -849,7 +852,11 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
     max_value = np.iinfo(dtypes.int64.as_numpy_dtype).max
     return Dataset.zip((Dataset.range(start, max_value), self))
 
-  def shuffle(self, buffer_size, seed=None, reshuffle_each_iteration=None):
+  def shuffle(self,
+              buffer_size,
+              seed=None,
+              reshuffle_each_iteration=None,
+              num_producers=None):
     """Randomly shuffles the elements of this dataset.
 
     This dataset fills a buffer with `buffer_size` elements, then randomly
@@ -872,24 +879,38 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
       reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
         that the dataset should be pseudorandomly reshuffled each time it is
         iterated over. (Defaults to `True`.)
+      num_producers: (Optional.) A Python integer, representing the number of
+        background threads that refill the buffer. If set, the buffer is split
+        into `num_producers` shards that are refilled asynchronously, so that
+        producing an element does not wait for the input unless the buffer is
+        empty. The order of the elements then depends on the timing of the
+        threads, even if `seed` is set, and saving the state of an iterator
+        pauses the threads until the buffer is saved. If not set, the buffer
+        is refilled synchronously.
 
     Returns:
       Dataset: A `Dataset`.
     """
-    return ShuffleDataset(self, buffer_size, seed, reshuffle_each_iteration)
+    return ShuffleDataset(self, buffer_size, seed, reshuffle_each_iteration,
+                          num_producers)
 
-  def cache(self, filename=""):
+  def cache(self, filename="", memory_budget=None):
     """Caches the elements in this dataset.
 
     Args:
       filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
         directory on the filesystem to use for caching tensors in this Dataset.
         If a filename is not provided, the dataset will be cached in memory.
+      memory_budget: (Optional.) A Python integer, representing the maximum
+        number of bytes of elements to cache in memory. If set, the elements
+        that do not fit in the budget are spilled to a temporary file (next to
+        `filename`, if provided), which is deleted along with the cache. A
+        cache with a memory budget cannot be checkpointed.
 
     Returns:
       Dataset: A `Dataset`.
     """
-    return CacheDataset(self, filename)
+    return CacheDataset(self, filename, memory_budget)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -1195,7 +1216,8 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
                  map_func,
                  cycle_length,
                  block_length=1,
-                 num_parallel_calls=None):
+                 num_parallel_calls=None,
+                 reorder_window_size=None):
     """Maps `map_func` across this dataset, and interleaves the results.
 
     For example, you can use `Dataset.interleave()` to process many input files
@@ -1260,6 +1282,13 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
         from cycle elements synchronously with no parallelism. If the value
         `tf.data.experimental.AUTOTUNE` is used, then the number of parallel
         calls is set dynamically based on available CPU.
+      reorder_window_size: (Optional.) A Python integer, representing the
+        number of elements that cycle elements may buffer, in total, beyond
+        their next block when `num_parallel_calls` is specified.
+        A larger window keeps the threadpool busy while the output waits for a
+        slow cycle element, at the cost of memory, without changing the order
+        of the produced elements. Defaults to 0, which only buffers the next
+        block of each cycle element.
 
     Returns:
       Dataset: A `Dataset`.
@@ -1268,7 +1297,8 @@ class DatasetV2(tracking_base.Trackable, composite_tensor.CompositeTensor):
       return InterleaveDataset(self, map_func, cycle_length, block_length)
     else:
       return ParallelInterleaveDataset(self, map_func, cycle_length,
-                                       block_length, num_parallel_calls)
+                                       block_length, num_parallel_calls,
+                                       reorder_window_size)
 
   def filter(self, predicate):
     """Filters this dataset according to `predicate`.
@@ -1763,13 +1793,18 @@ class DatasetV1(DatasetV2):
     return DatasetV1Adapter(super(DatasetV1, self).repeat(count))
 
   @functools.wraps(DatasetV2.shuffle)
-  def shuffle(self, buffer_size, seed=None, reshuffle_each_iteration=None):
+  def shuffle(self,
+              buffer_size,
+              seed=None,
+              reshuffle_each_iteration=None,
+              num_producers=None):
     return DatasetV1Adapter(super(DatasetV1, self).shuffle(
-        buffer_size, seed, reshuffle_each_iteration))
+        buffer_size, seed, reshuffle_each_iteration, num_producers))
 
   @functools.wraps(DatasetV2.cache)
-  def cache(self, filename=""):
-    return DatasetV1Adapter(super(DatasetV1, self).cache(filename))
+  def cache(self, filename="", memory_budget=None):
+    return DatasetV1Adapter(
+        super(DatasetV1, self).cache(filename, memory_budget))
 
   @functools.wraps(DatasetV2.take)
   def take(self, count):
@@ -1853,9 +1888,11 @@ class DatasetV1(DatasetV2):
                  map_func,
                  cycle_length,
                  block_length=1,
-                 num_parallel_calls=None):
+                 num_parallel_calls=None,
+                 reorder_window_size=None):
     return DatasetV1Adapter(super(DatasetV1, self).interleave(
-        map_func, cycle_length, block_length, num_parallel_calls))
+        map_func, cycle_length, block_length, num_parallel_calls,
+        reorder_window_size))
 
   @functools.wraps(DatasetV2.filter)
   def filter(self, predicate):
@@ -2819,7 +2856,7 @@ class RangeDataset(DatasetSource):
 class CacheDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that caches elements of its input."""
 
-  def __init__(self, input_dataset, filename):
+  def __init__(self, input_dataset, filename, memory_budget=None):
     """See `Dataset.cache()` for details."""
     self._input_dataset = input_dataset
     self._filename = ops.convert_to_tensor(
@@ -2827,6 +2864,7 @@ class CacheDataset(UnaryUnchangedStructureDataset):
     variant_tensor = gen_dataset_ops.cache_dataset(
         input_dataset._variant_tensor,  # pylint: disable=protected-access
         filename=self._filename,
+        memory_budget=memory_budget or 0,
         **self._flat_structure)
     super(CacheDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -2838,7 +2876,8 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
                input_dataset,
                buffer_size,
                seed=None,
-               reshuffle_each_iteration=None):
+               reshuffle_each_iteration=None,
+               num_producers=None):
     """Randomly shuffles the elements of this dataset.
 
     Args:
@@ -2851,6 +2890,9 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
       reshuffle_each_iteration: (Optional.) A boolean, which if true indicates
         that the dataset should be pseudorandomly reshuffled each time it is
         iterated over. (Defaults to `True`.)
+      num_producers: (Optional.) A Python integer, representing the number of
+        background threads that refill the buffer. If not set, the buffer is
+        refilled synchronously.
 
     Returns:
       A `Dataset`.
@@ -2873,6 +2915,7 @@ class ShuffleDataset(UnaryUnchangedStructureDataset):
         seed=self._seed,
         seed2=self._seed2,
         reshuffle_each_iteration=self._reshuffle_each_iteration,
+        num_producers=num_producers or 0,
         **self._flat_structure)
     super(ShuffleDataset, self).__init__(input_dataset, variant_tensor)
 
@@ -3331,7 +3374,7 @@ class ParallelInterleaveDataset(UnaryDataset):
   """A `Dataset` that maps a function over its input and interleaves the result."""
 
   def __init__(self, input_dataset, map_func, cycle_length, block_length,
-               num_parallel_calls):
+               num_parallel_calls, reorder_window_size=None):
     """See `Dataset.interleave()` for details."""
     self._input_dataset = input_dataset
     self._map_func = StructuredFunctionWrapper(
@@ -3354,6 +3397,7 @@ class ParallelInterleaveDataset(UnaryDataset):
         self._block_length,
         self._num_parallel_calls,
         f=self._map_func.function,
+        reorder_window_size=reorder_window_size or 0,
         **self._flat_structure)
     super(ParallelInterleaveDataset, self).__init__(input_dataset,
                                                     variant_tensor)
@@ -3487,11 +3531,12 @@ class _OptionsDataset(UnaryUnchangedStructureDataset):
 class _ModelDataset(UnaryUnchangedStructureDataset):
   """A `Dataset` that acts as an identity, and models performance."""
 
-  def __init__(self, input_dataset, cpu_budget):
+  def __init__(self, input_dataset, cpu_budget, ram_budget):
     self._input_dataset = input_dataset
     variant_tensor = gen_dataset_ops.model_dataset(
         input_dataset._variant_tensor,  # pylint: disable=protected-access
         cpu_budget=cpu_budget,
+        ram_budget=ram_budget,
         **self._flat_structure)
     super(_ModelDataset, self).__init__(input_dataset, variant_tensor)
 
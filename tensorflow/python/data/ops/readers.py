@@ -184,7 +184,12 @@ class TextLineDatasetV1(dataset_ops.DatasetV1Adapter):
 class _TFRecordDataset(dataset_ops.DatasetSource):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None, buffer_size=None):
+  def __init__(self,
+               filenames,
+               compression_type=None,
+               buffer_size=None,
+               use_mmap=False,
+               verify_checksums=True):
     """Creates a `TFRecordDataset`.
 
     Args:
@@ -193,6 +198,10 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         `""` (no compression), `"ZLIB"`, or `"GZIP"`.
       buffer_size: (Optional.) A `tf.int64` scalar representing the number of
         bytes in the read buffer. 0 means no buffering.
+      use_mmap: (Optional.) A Python boolean indicating whether uncompressed
+        files are memory mapped instead of read through the buffer.
+      verify_checksums: (Optional.) A Python boolean indicating whether the
+        checksums of the records are checked.
     """
     self._filenames = filenames
     self._compression_type = convert.optional_param_to_tensor(
@@ -205,7 +214,11 @@ class _TFRecordDataset(dataset_ops.DatasetSource):
         buffer_size,
         argument_default=_DEFAULT_READER_BUFFER_SIZE_BYTES)
     variant_tensor = gen_dataset_ops.tf_record_dataset(
-        self._filenames, self._compression_type, self._buffer_size)
+        self._filenames,
+        self._compression_type,
+        self._buffer_size,
+        use_mmap=use_mmap,
+        verify_checksums=verify_checksums)
     super(_TFRecordDataset, self).__init__(variant_tensor)
 
   @property
@@ -281,7 +294,7 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
   def __init__(self, filenames, compression_type=None, buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None, use_mmap=False, verify_checksums=True):
     """Creates a `TFRecordDataset` to read one or more TFRecord files.
 
     Args:
@@ -299,6 +312,15 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
         input pipeline is I/O bottlenecked, consider setting this parameter to a
         value greater than one to parallelize the I/O. If `None`, files will be
         read sequentially.
+      use_mmap: (Optional.) A Python boolean indicating whether uncompressed
+        files are memory mapped instead of read through a buffer, which saves
+        copying every record for files on local disks. Files on file systems
+        that do not support memory mapping are read through the buffer. Note
+        that changing a file while it is mapped may crash the program.
+      verify_checksums: (Optional.) A Python boolean indicating whether the
+        checksums of the records are checked. Disabling the check saves a pass
+        over every record, but corrupted records are then returned instead of
+        raising a `tf.errors.DataLossError`.
 
     Raises:
       TypeError: If any argument does not have the expected type.
@@ -310,9 +332,12 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
     self._compression_type = compression_type
     self._buffer_size = buffer_size
     self._num_parallel_reads = num_parallel_reads
+    self._use_mmap = use_mmap
+    self._verify_checksums = verify_checksums
 
     def creator_fn(filename):
-      return _TFRecordDataset(filename, compression_type, buffer_size)
+      return _TFRecordDataset(filename, compression_type, buffer_size,
+                              use_mmap, verify_checksums)
 
     self._impl = _create_dataset_reader(creator_fn, filenames,
                                         num_parallel_reads)
@@ -323,11 +348,16 @@ class TFRecordDatasetV2(dataset_ops.DatasetV2):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             use_mmap=None,
+             verify_checksums=None):
+    if verify_checksums is None:
+      verify_checksums = self._verify_checksums
     return TFRecordDatasetV2(filenames or self._filenames,
                              compression_type or self._compression_type,
                              buffer_size or self._buffer_size,
-                             num_parallel_reads or self._num_parallel_reads)
+                             num_parallel_reads or self._num_parallel_reads,
+                             use_mmap or self._use_mmap, verify_checksums)
 
   def _inputs(self):
     return self._impl._inputs()  # pylint: disable=protected-access
@@ -342,9 +372,10 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
   def __init__(self, filenames, compression_type=None, buffer_size=None,
-               num_parallel_reads=None):
+               num_parallel_reads=None, use_mmap=False, verify_checksums=True):
     wrapped = TFRecordDatasetV2(
-        filenames, compression_type, buffer_size, num_parallel_reads)
+        filenames, compression_type, buffer_size, num_parallel_reads, use_mmap,
+        verify_checksums)
     super(TFRecordDatasetV1, self).__init__(wrapped)
   __init__.__doc__ = TFRecordDatasetV2.__init__.__doc__
 
@@ -352,13 +383,18 @@ class TFRecordDatasetV1(dataset_ops.DatasetV1Adapter):
              filenames=None,
              compression_type=None,
              buffer_size=None,
-             num_parallel_reads=None):
+             num_parallel_reads=None,
+             use_mmap=None,
+             verify_checksums=None):
     # pylint: disable=protected-access
+    if verify_checksums is None:
+      verify_checksums = self._dataset._verify_checksums
     return TFRecordDatasetV1(
         filenames or self._dataset._filenames,
         compression_type or self._dataset._compression_type,
         buffer_size or self._dataset._buffer_size,
-        num_parallel_reads or self._dataset._num_parallel_reads)
+        num_parallel_reads or self._dataset._num_parallel_reads,
+        use_mmap or self._dataset._use_mmap, verify_checksums)
 
   @property
   def _filenames(self):
@@ -22,7 +22,7 @@ from tensorflow.python.ops import gen_collective_ops
 
 
 def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
-               subdiv_offsets=(0,)):
+               subdiv_offsets=(0,), compression='none', topk_ratio=0.01):
   """Reduces tensors collectively, across devices.
 
   Args:
@@ -38,6 +38,12 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
     subdiv_offsets: a list of integer offsets into the tensor at which each
       independent subdivision should begin.  Use [0] if no subdivision should
       be done.
+    compression: string naming the lossy encoding of the float32 values sent
+      between CPU devices: 'bf16' or 'fp16' to round them to 16 bits, 'topk'
+      to send only the `topk_ratio` fraction of largest magnitude, or 'none'.
+      The encoding error of the values sent while reducing is carried over to
+      the next execution of the Op.
+    topk_ratio: the fraction of the values sent with 'topk' compression.
 
   Returns:
     An Op implementing the distributed reduction.
@@ -55,7 +61,9 @@ def all_reduce(t, group_size, group_key, instance_key, merge_op, final_op,
                                               instance_key=instance_key,
                                               merge_op=merge_op,
                                               final_op=final_op,
-                                              subdiv_offsets=subdiv_offsets)
+                                              subdiv_offsets=subdiv_offsets,
+                                              compression=compression,
+                                              topk_ratio=topk_ratio)
 
 
 def all_gather(t, group_size, group_key, instance_key):
@@ -31,7 +31,8 @@ from tensorflow.python.platform import test
 
 class CollectiveOpTest(test.TestCase):
 
-  def _testCollectiveReduce(self, t0, t1, expected, set_graph_key):
+  def _testCollectiveReduce(self, t0, t1, expected, set_graph_key,
+                            compression='none'):
     group_key = 1
     instance_key = 1
     with self.session(
@@ -39,11 +40,13 @@ class CollectiveOpTest(test.TestCase):
       with ops.device('/CPU:0'):
         in0 = constant_op.constant(t0)
         colred0 = collective_ops.all_reduce(in0, 2, group_key, instance_key,
-                                            'Add', 'Div')
+                                            'Add', 'Div',
+                                            compression=compression)
       with ops.device('/CPU:1'):
         in1 = constant_op.constant(t1)
         colred1 = collective_ops.all_reduce(in1, 2, group_key, instance_key,
-                                            'Add', 'Div')
+                                            'Add', 'Div',
+                                            compression=compression)
       run_options = config_pb2.RunOptions()
       if set_graph_key:
         run_options.experimental.collective_graph_key = 1
@@ -75,6 +78,16 @@ class CollectiveOpTest(test.TestCase):
                                [0.3, 1.3, 2.3, 3.3, 4.3, 5.3, 6.3, 7.3],
                                [0.2, 1.2, 2.2, 3.2, 4.2, 5.2, 6.2, 7.2], True)
 
+  @test_util.run_deprecated_v1
+  def testCollectiveReduceCompression(self):
+    # The values and their sums are exactly representable in 16 bits.
+    for compression in ['bf16', 'fp16']:
+      with ops.Graph().as_default():
+        self._testCollectiveReduce([1., 2., 3., 4., 5., 6., 7., 8.],
+                                   [3., 4., 5., 6., 7., 8., 9., 10.],
+                                   [2., 3., 4., 5., 6., 7., 8., 9.], True,
+                                   compression=compression)
+
   @test_util.run_deprecated_v1
   def testCollectiveAutoGraphKey(self):
     self._testCollectiveReduce([0.1, 1.1, 2.1, 3.1, 4.1, 5.1, 6.1, 7.1],